@@ -0,0 +1,800 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// AES is in FIPS 197 and GCM is in
+// NIST SP 800-38D.
+
+// The PCLMULQDQ GHASH is from the Intel
+// white paper "Intel Carry-Less
+// Multiplication Instruction and its Usage
+// for Computing the GCM Mode".
+
+
+
+#include "AesGcm.h"
+
+#include <string.h>
+
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+  #define AESGCM_X86 1
+  #include <immintrin.h>
+#endif
+
+
+
+// The S-box is worked out with arithmetic
+// instead of looked up in a table, so the
+// slow version doesn't leak the key through
+// which cache lines it reads.  There are
+// eight bytes at a time, one in each byte
+// lane of a Uint64, and nothing depends on
+// their values.
+
+static const Uint64 LaneLow = 0x0101010101010101ULL;
+static const Uint64 LaneHigh = 0x8080808080808080ULL;
+
+
+
+static inline Uint64 xTimeLanes( const Uint64 x )
+{
+// Times x in GF(2^8) for each lane.
+const Uint64 high = (x & LaneHigh) >> 7;
+return ((x & ~LaneHigh) << 1) ^ (high * 0x1b);
+}
+
+
+
+static Uint64 gfMulLanes( Uint64 a,
+                          const Uint64 b )
+{
+Uint64 result = 0;
+for( Int32 bit = 0; bit < 8; bit++ )
+  {
+  // All ones in a lane if that bit of b
+  // is set.
+  const Uint64 mask = ((b >> bit) & LaneLow) *
+                                        0xff;
+  result ^= a & mask;
+  a = xTimeLanes( a );
+  }
+
+return result;
+}
+
+
+
+static inline Uint64 rotLanes( const Uint64 x,
+                               const Int32 by )
+{
+const Uint64 keepHigh = LaneLow *
+            static_cast<Uint8>( 0xff << by );
+const Uint64 keepLow = LaneLow *
+            static_cast<Uint8>( 0xff >> (8 - by));
+return ((x << by) & keepHigh) |
+       ((x >> (8 - by)) & keepLow);
+}
+
+
+
+static Uint64 sBoxLanes( const Uint64 x )
+{
+// FIPS 197 Section 5.1.1.  The inverse is
+// x^254, and zero goes to zero.
+
+Uint64 power = gfMulLanes( x, x );
+Uint64 inverse = power;
+for( Int32 count = 2; count < 8; count++ )
+  {
+  power = gfMulLanes( power, power );
+  inverse = gfMulLanes( inverse, power );
+  }
+
+return inverse ^ rotLanes( inverse, 1 ) ^
+       rotLanes( inverse, 2 ) ^
+       rotLanes( inverse, 3 ) ^
+       rotLanes( inverse, 4 ) ^
+       (LaneLow * 0x63);
+}
+
+
+
+static void subBytes( Uint8* bytes,
+                      const Int32 howMany )
+{
+for( Int32 where = 0; where < howMany;
+                                   where += 8 )
+  {
+  Int32 chunk = howMany - where;
+  if( chunk > 8 )
+    chunk = 8;
+
+  Uint64 lanes = 0;
+  for( Int32 count = 0; count < chunk; count++ )
+    lanes |= static_cast<Uint64>(
+                    bytes[where + count] ) <<
+                                  (count * 8);
+
+  lanes = sBoxLanes( lanes );
+
+  for( Int32 count = 0; count < chunk; count++ )
+    bytes[where + count] = static_cast<Uint8>(
+                         lanes >> (count * 8));
+
+  }
+}
+
+
+
+static inline Uint8 xTime( const Uint8 x )
+{
+return static_cast<Uint8>( (x << 1) ^
+                       (((x >> 7) & 1) * 0x1b));
+}
+
+
+
+static void expandKey( const Uint8* key,
+                       Uint8* roundKeys )
+{
+// FIPS 197 Section 5.2.  The AES-NI
+// instructions use the round keys in the
+// same byte order, so this is used for both.
+
+static const Uint8 rCon[10] = { 0x01, 0x02,
+                  0x04, 0x08, 0x10, 0x20, 0x40,
+                  0x80, 0x1b, 0x36 };
+
+for( Int32 count = 0; count < 16; count++ )
+  roundKeys[count] = key[count];
+
+for( Int32 word = 4; word < 44; word++ )
+  {
+  Uint8 temp[4];
+  for( Int32 count = 0; count < 4; count++ )
+    temp[count] = roundKeys[((word - 1) * 4) +
+                                       count];
+
+  if( (word % 4) == 0 )
+    {
+    Uint8 first = temp[0];
+    temp[0] = temp[1];
+    temp[1] = temp[2];
+    temp[2] = temp[3];
+    temp[3] = first;
+    subBytes( temp, 4 );
+    temp[0] ^= rCon[(word / 4) - 1];
+    }
+
+  for( Int32 count = 0; count < 4; count++ )
+    roundKeys[(word * 4) + count] =
+            static_cast<Uint8>( temp[count] ^
+            roundKeys[((word - 4) * 4) + count] );
+
+  }
+}
+
+
+
+static void encryptBlockPortable(
+                      const Uint8* roundKeys,
+                      const Uint8* inBlock,
+                      Uint8* outBlock )
+{
+Uint8 state[16];
+for( Int32 count = 0; count < 16; count++ )
+  state[count] = inBlock[count] ^
+                           roundKeys[count];
+
+for( Int32 round = 1; round <= 10; round++ )
+  {
+  // ShiftRows then SubBytes.  They can go
+  // in either order.  The state is in
+  // column order.
+  Uint8 temp[16];
+  for( Int32 col = 0; col < 4; col++ )
+    {
+    for( Int32 row = 0; row < 4; row++ )
+      temp[(col * 4) + row] = state[
+                  (((col + row) % 4) * 4) + row];
+    }
+
+  subBytes( temp, 16 );
+
+  if( round < 10 )
+    {
+    // MixColumns.
+    for( Int32 col = 0; col < 4; col++ )
+      {
+      Uint8* column = temp + (col * 4);
+      Uint8 a0 = column[0];
+      Uint8 a1 = column[1];
+      Uint8 a2 = column[2];
+      Uint8 a3 = column[3];
+      Uint8 all = a0 ^ a1 ^ a2 ^ a3;
+      column[0] ^= all ^ xTime( a0 ^ a1 );
+      column[1] ^= all ^ xTime( a1 ^ a2 );
+      column[2] ^= all ^ xTime( a2 ^ a3 );
+      column[3] ^= all ^ xTime( a3 ^ a0 );
+      }
+    }
+
+  const Uint8* roundKey = roundKeys +
+                                (round * 16);
+  for( Int32 count = 0; count < 16; count++ )
+    state[count] = temp[count] ^
+                               roundKey[count];
+
+  }
+
+for( Int32 count = 0; count < 16; count++ )
+  outBlock[count] = state[count];
+
+}
+
+
+
+static void gfMulPortable( Uint8* x,
+                           const Uint8* h )
+{
+// NIST SP 800-38D Algorithm 1.
+// x = x * h in GF(2^128).
+
+Uint64 zHigh = 0;
+Uint64 zLow = 0;
+Uint64 vHigh = 0;
+Uint64 vLow = 0;
+for( Int32 count = 0; count < 8; count++ )
+  {
+  vHigh = (vHigh << 8) | h[count];
+  vLow = (vLow << 8) | h[count + 8];
+  }
+
+for( Int32 byteIndex = 0; byteIndex < 16;
+                                  byteIndex++ )
+  {
+  for( Int32 bit = 7; bit >= 0; bit-- )
+    {
+    // A mask instead of a branch.
+    Uint64 mask = 0 - static_cast<Uint64>(
+                  (x[byteIndex] >> bit) & 1 );
+    zHigh ^= vHigh & mask;
+    zLow ^= vLow & mask;
+
+    Uint64 lowBit = 0 - (vLow & 1);
+    vLow = (vLow >> 1) | (vHigh << 63);
+    vHigh = (vHigh >> 1) ^
+            (0xE100000000000000ULL & lowBit);
+    }
+  }
+
+for( Int32 count = 0; count < 8; count++ )
+  {
+  x[count] = static_cast<Uint8>(
+                 zHigh >> (8 * (7 - count)));
+  x[count + 8] = static_cast<Uint8>(
+                 zLow >> (8 * (7 - count)));
+  }
+}
+
+
+
+#ifdef AESGCM_X86
+
+
+__attribute__(( target( "aes,sse4.1" )))
+static void encryptBlockNi(
+                      const Uint8* roundKeys,
+                      const Uint8* inBlock,
+                      Uint8* outBlock )
+{
+const __m128i* keys = reinterpret_cast<
+                 const __m128i*>( roundKeys );
+
+__m128i block = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(
+                                   inBlock ));
+
+block = _mm_xor_si128( block,
+                       _mm_load_si128( keys ));
+
+for( Int32 round = 1; round < 10; round++ )
+  block = _mm_aesenc_si128( block,
+              _mm_load_si128( keys + round ));
+
+block = _mm_aesenclast_si128( block,
+               _mm_load_si128( keys + 10 ));
+
+_mm_storeu_si128( reinterpret_cast<__m128i*>(
+                           outBlock ), block );
+}
+
+
+
+__attribute__(( target( "aes,sse4.1" )))
+static void ctrXorNi( const Uint8* roundKeys,
+                      const Uint8* nonce,
+                      const Uint8* in,
+                      const Int32 len,
+                      Uint8* out )
+{
+// Counter mode starting at block 2.
+// Four blocks at a time so the AES
+// instructions can overlap.
+
+const __m128i* keys = reinterpret_cast<
+                 const __m128i*>( roundKeys );
+
+__m128i roundKey[11];
+for( Int32 count = 0; count < 11; count++ )
+  roundKey[count] = _mm_load_si128(
+                               keys + count );
+
+alignas( 16 ) Uint8 counterBlock[16];
+memcpy( counterBlock, nonce, 12 );
+
+Uint32 counter = 2;
+Int32 where = 0;
+
+while( (len - where) >= 64 )
+  {
+  __m128i blocks[4];
+  for( Int32 b = 0; b < 4; b++ )
+    {
+    Uint32 ctr = counter + static_cast<Uint32>( b );
+    counterBlock[12] = static_cast<Uint8>(
+                                    ctr >> 24 );
+    counterBlock[13] = static_cast<Uint8>(
+                                    ctr >> 16 );
+    counterBlock[14] = static_cast<Uint8>(
+                                    ctr >> 8 );
+    counterBlock[15] = static_cast<Uint8>( ctr );
+    blocks[b] = _mm_xor_si128( _mm_load_si128(
+               reinterpret_cast<const __m128i*>(
+                            counterBlock )),
+               roundKey[0] );
+    }
+
+  for( Int32 round = 1; round < 10; round++ )
+    {
+    for( Int32 b = 0; b < 4; b++ )
+      blocks[b] = _mm_aesenc_si128( blocks[b],
+                             roundKey[round] );
+    }
+
+  for( Int32 b = 0; b < 4; b++ )
+    {
+    blocks[b] = _mm_aesenclast_si128( blocks[b],
+                                roundKey[10] );
+
+    __m128i data = _mm_loadu_si128(
+               reinterpret_cast<const __m128i*>(
+                          in + where + (b * 16)));
+
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(
+                       out + where + (b * 16)),
+                _mm_xor_si128( data, blocks[b] ));
+    }
+
+  counter += 4;
+  where += 64;
+  }
+
+while( where < len )
+  {
+  counterBlock[12] = static_cast<Uint8>(
+                                counter >> 24 );
+  counterBlock[13] = static_cast<Uint8>(
+                                counter >> 16 );
+  counterBlock[14] = static_cast<Uint8>(
+                                counter >> 8 );
+  counterBlock[15] = static_cast<Uint8>(
+                                      counter );
+
+  Uint8 keyStream[16];
+  encryptBlockNi( roundKeys, counterBlock,
+                  keyStream );
+
+  Int32 blockLast = len - where;
+  if( blockLast > 16 )
+    blockLast = 16;
+
+  for( Int32 count = 0; count < blockLast;
+                                    count++ )
+    out[where + count] = in[where + count] ^
+                               keyStream[count];
+
+  counter++;
+  where += blockLast;
+  }
+}
+
+
+
+__attribute__(( target( "pclmul,sse4.1" )))
+static inline __m128i gfMulNi( __m128i a,
+                               __m128i b )
+{
+// The values are bit reflected, so the
+// product has to be shifted left one bit
+// and then reduced.
+
+__m128i tmp3 = _mm_clmulepi64_si128( a, b, 0x00 );
+__m128i tmp4 = _mm_clmulepi64_si128( a, b, 0x10 );
+__m128i tmp5 = _mm_clmulepi64_si128( a, b, 0x01 );
+__m128i tmp6 = _mm_clmulepi64_si128( a, b, 0x11 );
+
+tmp4 = _mm_xor_si128( tmp4, tmp5 );
+tmp5 = _mm_slli_si128( tmp4, 8 );
+tmp4 = _mm_srli_si128( tmp4, 8 );
+tmp3 = _mm_xor_si128( tmp3, tmp5 );
+tmp6 = _mm_xor_si128( tmp6, tmp4 );
+
+__m128i tmp7 = _mm_srli_epi32( tmp3, 31 );
+__m128i tmp8 = _mm_srli_epi32( tmp6, 31 );
+tmp3 = _mm_slli_epi32( tmp3, 1 );
+tmp6 = _mm_slli_epi32( tmp6, 1 );
+
+__m128i tmp9 = _mm_srli_si128( tmp7, 12 );
+tmp8 = _mm_slli_si128( tmp8, 4 );
+tmp7 = _mm_slli_si128( tmp7, 4 );
+tmp3 = _mm_or_si128( tmp3, tmp7 );
+tmp6 = _mm_or_si128( tmp6, tmp8 );
+tmp6 = _mm_or_si128( tmp6, tmp9 );
+
+tmp7 = _mm_slli_epi32( tmp3, 31 );
+tmp8 = _mm_slli_epi32( tmp3, 30 );
+tmp9 = _mm_slli_epi32( tmp3, 25 );
+tmp7 = _mm_xor_si128( tmp7, tmp8 );
+tmp7 = _mm_xor_si128( tmp7, tmp9 );
+tmp8 = _mm_srli_si128( tmp7, 4 );
+tmp7 = _mm_slli_si128( tmp7, 12 );
+tmp3 = _mm_xor_si128( tmp3, tmp7 );
+
+__m128i tmp2 = _mm_srli_epi32( tmp3, 1 );
+tmp4 = _mm_srli_epi32( tmp3, 2 );
+tmp5 = _mm_srli_epi32( tmp3, 7 );
+tmp2 = _mm_xor_si128( tmp2, tmp4 );
+tmp2 = _mm_xor_si128( tmp2, tmp5 );
+tmp2 = _mm_xor_si128( tmp2, tmp8 );
+tmp3 = _mm_xor_si128( tmp3, tmp2 );
+tmp6 = _mm_xor_si128( tmp6, tmp3 );
+return tmp6;
+}
+
+
+
+__attribute__(( target( "pclmul,sse4.1" )))
+static void ghashBlocksNi( const Uint8* hKey,
+                           Uint8* state,
+                           const Uint8* data,
+                           const Int32 len )
+{
+// This does the whole blocks and pads the
+// last one with zeros.
+
+const __m128i swapMask = _mm_set_epi8(
+                 0, 1, 2, 3, 4, 5, 6, 7,
+                 8, 9, 10, 11, 12, 13, 14, 15 );
+
+__m128i h = _mm_shuffle_epi8( _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(
+                         hKey )), swapMask );
+
+__m128i y = _mm_shuffle_epi8( _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(
+                         state )), swapMask );
+
+Int32 where = 0;
+while( (len - where) >= 16 )
+  {
+  __m128i block = _mm_shuffle_epi8(
+             _mm_loadu_si128(
+             reinterpret_cast<const __m128i*>(
+                   data + where )), swapMask );
+
+  y = gfMulNi( _mm_xor_si128( y, block ), h );
+  where += 16;
+  }
+
+if( where < len )
+  {
+  alignas( 16 ) Uint8 lastBlock[16] = { 0 };
+  memcpy( lastBlock, data + where,
+          static_cast<size_t>( len - where ));
+
+  __m128i block = _mm_shuffle_epi8(
+             _mm_load_si128(
+             reinterpret_cast<const __m128i*>(
+                     lastBlock )), swapMask );
+
+  y = gfMulNi( _mm_xor_si128( y, block ), h );
+  }
+
+_mm_storeu_si128( reinterpret_cast<__m128i*>(
+                                      state ),
+                  _mm_shuffle_epi8( y, swapMask ));
+}
+
+
+#endif
+
+
+
+static void ghashBlocksPortable(
+                           const Uint8* hKey,
+                           Uint8* state,
+                           const Uint8* data,
+                           const Int32 len )
+{
+Int32 where = 0;
+while( where < len )
+  {
+  Int32 blockLast = len - where;
+  if( blockLast > 16 )
+    blockLast = 16;
+
+  for( Int32 count = 0; count < blockLast;
+                                    count++ )
+    state[count] ^= data[where + count];
+
+  gfMulPortable( state, hKey );
+  where += blockLast;
+  }
+}
+
+
+
+AesGcm::AesGcm( void )
+{
+#ifdef AESGCM_X86
+  __builtin_cpu_init();
+  useNi = __builtin_cpu_supports( "aes" ) &&
+          __builtin_cpu_supports( "pclmul" ) &&
+          __builtin_cpu_supports( "sse4.1" );
+#endif
+}
+
+
+
+AesGcm::~AesGcm( void )
+{
+// Don't leave the keys in memory.
+clearKey();
+}
+
+
+
+void AesGcm::clearKey( void )
+{
+::explicit_bzero( roundKeys, sizeof( roundKeys ));
+::explicit_bzero( hKey, sizeof( hKey ));
+::explicit_bzero( baseIV, sizeof( baseIV ));
+}
+
+
+
+void AesGcm::setKey( const Uint8* key,
+                     const Uint8* iv )
+{
+expandKey( key, roundKeys );
+
+for( Int32 count = 0; count < IVSize; count++ )
+  baseIV[count] = iv[count];
+
+// H is the zero block encrypted.
+Uint8 zero[16] = { 0 };
+encryptBlock( zero, hKey );
+}
+
+
+
+void AesGcm::encryptBlock( const Uint8* inBlock,
+                           Uint8* outBlock ) const
+{
+#ifdef AESGCM_X86
+  if( useNi )
+    {
+    encryptBlockNi( roundKeys, inBlock,
+                               outBlock );
+    return;
+    }
+#endif
+
+encryptBlockPortable( roundKeys, inBlock,
+                                 outBlock );
+}
+
+
+
+void AesGcm::makeNonce( const Uint64 seqNum,
+                        Uint8* nonce ) const
+{
+// RFC 8446 Section 5.3.
+// The 64 bit sequence number in big endian
+// order is padded on the left to 12 bytes
+// and XORed with the IV.
+
+for( Int32 count = 0; count < IVSize; count++ )
+  nonce[count] = baseIV[count];
+
+for( Int32 count = 0; count < 8; count++ )
+  nonce[4 + count] ^= static_cast<Uint8>(
+                seqNum >> (8 * (7 - count)));
+
+}
+
+
+
+void AesGcm::ctrXor( const Uint8* nonce,
+                     const Uint8* in,
+                     const Int32 len,
+                     Uint8* out ) const
+{
+#ifdef AESGCM_X86
+  if( useNi )
+    {
+    ctrXorNi( roundKeys, nonce, in, len, out );
+    return;
+    }
+#endif
+
+Uint8 counterBlock[16];
+for( Int32 count = 0; count < 12; count++ )
+  counterBlock[count] = nonce[count];
+
+Uint32 counter = 2;
+Int32 where = 0;
+while( where < len )
+  {
+  counterBlock[12] = static_cast<Uint8>(
+                                counter >> 24 );
+  counterBlock[13] = static_cast<Uint8>(
+                                counter >> 16 );
+  counterBlock[14] = static_cast<Uint8>(
+                                counter >> 8 );
+  counterBlock[15] = static_cast<Uint8>(
+                                      counter );
+
+  Uint8 keyStream[16];
+  encryptBlockPortable( roundKeys,
+                        counterBlock, keyStream );
+
+  Int32 blockLast = len - where;
+  if( blockLast > 16 )
+    blockLast = 16;
+
+  for( Int32 count = 0; count < blockLast;
+                                    count++ )
+    out[where + count] = in[where + count] ^
+                               keyStream[count];
+
+  counter++;
+  where += blockLast;
+  }
+}
+
+
+
+void AesGcm::ghash( const Uint8* aad,
+                    const Int32 aadLen,
+                    const Uint8* cipher,
+                    const Int32 cipherLen,
+                    Uint8* result ) const
+{
+Uint8 lengths[16];
+const Uint64 aadBits = static_cast<Uint64>(
+                                  aadLen ) * 8;
+const Uint64 cipherBits = static_cast<Uint64>(
+                               cipherLen ) * 8;
+for( Int32 count = 0; count < 8; count++ )
+  {
+  lengths[count] = static_cast<Uint8>(
+                aadBits >> (8 * (7 - count)));
+  lengths[count + 8] = static_cast<Uint8>(
+             cipherBits >> (8 * (7 - count)));
+  }
+
+for( Int32 count = 0; count < 16; count++ )
+  result[count] = 0;
+
+#ifdef AESGCM_X86
+  if( useNi )
+    {
+    ghashBlocksNi( hKey, result, aad, aadLen );
+    ghashBlocksNi( hKey, result, cipher,
+                                 cipherLen );
+    ghashBlocksNi( hKey, result, lengths, 16 );
+    return;
+    }
+#endif
+
+ghashBlocksPortable( hKey, result, aad, aadLen );
+ghashBlocksPortable( hKey, result, cipher,
+                                   cipherLen );
+ghashBlocksPortable( hKey, result, lengths, 16 );
+}
+
+
+
+void AesGcm::seal( const Uint64 seqNum,
+                   const Uint8* aad,
+                   const Int32 aadLen,
+                   const Uint8* plain,
+                   const Int32 len,
+                   Uint8* out ) const
+{
+Uint8 nonce[16];
+makeNonce( seqNum, nonce );
+
+ctrXor( nonce, plain, len, out );
+
+Uint8 tag[16];
+ghash( aad, aadLen, out, len, tag );
+
+// The tag is encrypted with counter 1.
+nonce[12] = 0;
+nonce[13] = 0;
+nonce[14] = 0;
+nonce[15] = 1;
+Uint8 tagMask[16];
+encryptBlock( nonce, tagMask );
+
+for( Int32 count = 0; count < TagSize; count++ )
+  out[len + count] = tag[count] ^
+                               tagMask[count];
+
+}
+
+
+
+bool AesGcm::open( const Uint64 seqNum,
+                   const Uint8* aad,
+                   const Int32 aadLen,
+                   const Uint8* cipher,
+                   const Int32 len,
+                   Uint8* plainOut ) const
+{
+const Int32 cipherLen = len - TagSize;
+if( cipherLen < 0 )
+  return false;
+
+Uint8 nonce[16];
+makeNonce( seqNum, nonce );
+
+Uint8 tag[16];
+ghash( aad, aadLen, cipher, cipherLen, tag );
+
+nonce[12] = 0;
+nonce[13] = 0;
+nonce[14] = 0;
+nonce[15] = 1;
+Uint8 tagMask[16];
+encryptBlock( nonce, tagMask );
+
+// Constant time compare.
+Uint8 diff = 0;
+for( Int32 count = 0; count < TagSize; count++ )
+  diff |= static_cast<Uint8>( (tag[count] ^
+              tagMask[count]) ^
+              cipher[cipherLen + count] );
+
+if( diff != 0 )
+  return false;
+
+ctrXor( nonce, cipher, cipherLen, plainOut );
+return true;
+}
@@ -0,0 +1,115 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// AES-128-GCM for one TLS 1.3 record at a
+// time, with the nonce made from the record
+// sequence number.  RFC 8446 Section 5.3.
+
+// The methods are const after setKey(), so
+// more than one thread can use the same
+// key at the same time.  That is what lets
+// records be decrypted in parallel.
+
+// It uses the AES-NI and PCLMULQDQ
+// instructions if the CPU has them, or else
+// a slow portable version.  That one has no
+// table look ups or branches that depend on
+// the key or the data, so it is safe to
+// use for the decrypt pool too.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+
+
+class AesGcm
+  {
+  private:
+  bool testForCopy = false;
+  bool useNi = false;
+  alignas( 16 ) Uint8 roundKeys[11 * 16] = { 0 };
+  alignas( 16 ) Uint8 hKey[16] = { 0 };
+  Uint8 baseIV[12] = { 0 };
+
+  void encryptBlock( const Uint8* inBlock,
+                     Uint8* outBlock ) const;
+
+  void ghash( const Uint8* aad,
+              const Int32 aadLen,
+              const Uint8* cipher,
+              const Int32 cipherLen,
+              Uint8* result ) const;
+
+  void ctrXor( const Uint8* nonce,
+               const Uint8* in,
+               const Int32 len,
+               Uint8* out ) const;
+
+  void makeNonce( const Uint64 seqNum,
+                  Uint8* nonce ) const;
+
+  public:
+  static const Int32 KeySize = 16;
+  static const Int32 IVSize = 12;
+  static const Int32 TagSize = 16;
+
+  AesGcm( void );
+
+  AesGcm( const AesGcm& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "AesGcm copy constructor.";
+    }
+
+  ~AesGcm( void );
+
+  void setKey( const Uint8* key,
+               const Uint8* iv );
+
+  // Writes over the round keys, H and the
+  // IV.
+  void clearKey( void );
+
+  bool getUseNi( void ) const
+    {
+    return useNi;
+    }
+
+  // out has to have room for len + TagSize.
+  void seal( const Uint64 seqNum,
+             const Uint8* aad,
+             const Int32 aadLen,
+             const Uint8* plain,
+             const Int32 len,
+             Uint8* out ) const;
+
+  // len includes the tag.  It returns false
+  // if the tag doesn't match, and then
+  // plainOut has nothing useful in it.
+  bool open( const Uint64 seqNum,
+             const Uint8* aad,
+             const Int32 aadLen,
+             const Uint8* cipher,
+             const Int32 len,
+             Uint8* plainOut ) const;
+
+  };
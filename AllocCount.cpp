@@ -0,0 +1,59 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "AllocCount.h"
+
+#include <new>
+#include <stdlib.h>
+
+
+
+std::atomic<Uint64> AllocCount::newCalls{ 0 };
+
+
+
+// new[] and the nothrow ones come here
+// too.  The aligned ones don't, and they
+// use their own delete.
+
+void* operator new( size_t howMany )
+{
+AllocCount::addOne();
+
+if( howMany == 0 )
+  howMany = 1;
+
+void* result = ::malloc( howMany );
+if( result == nullptr )
+  throw std::bad_alloc();
+
+return result;
+}
+
+
+
+void operator delete( void* toFree ) noexcept
+{
+::free( toFree );
+}
+
+
+
+void operator delete( void* toFree,
+                      size_t ) noexcept
+{
+::free( toFree );
+}
@@ -0,0 +1,76 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A count of every call to operator new in
+// the process, so OfflineVec can show how
+// many allocations a connection makes with
+// a new TlsMainCl and with one that was
+// reset().  AllocCount.cpp replaces the
+// global operator new and operator delete
+// with ones that call malloc() and free()
+// and add one to a relaxed atomic.  That is
+// all it costs.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+#include <atomic>
+
+
+
+class AllocCount
+  {
+  private:
+  bool testForCopy = false;
+  static std::atomic<Uint64> newCalls;
+
+  public:
+  AllocCount( void )
+    {
+    }
+
+  AllocCount( const AllocCount& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "AllocCount copy constructor.";
+    }
+
+  ~AllocCount( void )
+    {
+    }
+
+  static void addOne( void )
+    {
+    newCalls.fetch_add( 1,
+                  std::memory_order_relaxed );
+    }
+
+  // It is for every thread, so only take
+  // the difference of two of these when
+  // nothing else is running.
+  static Uint64 get( void )
+    {
+    return newCalls.load(
+                  std::memory_order_relaxed );
+    }
+
+  };
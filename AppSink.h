@@ -0,0 +1,58 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Decrypted application data can go to one
+// of these instead of to the appInBuf
+// CircleBuf.  So a big download can go
+// straight to a file, or to a function,
+// or in to memory that the app owns.
+
+// It gets called once per record, not once
+// per byte.
+
+// The owner calls flush() when it is done.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class AppSink
+  {
+  public:
+  virtual ~AppSink( void )
+    {
+    }
+
+  // Returns false if it couldn't take it and
+  // the connection should be shut down.
+  virtual bool write( const CharBuf& plainBuf )
+                                         = 0;
+
+  // How many bytes it can take right now.
+  // If there is not room for a whole record
+  // then TlsMainCl doesn't read any more
+  // from the network until there is.
+  virtual Int64 getRoom( void ) = 0;
+
+  virtual bool flush( void ) = 0;
+
+  };
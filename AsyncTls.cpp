@@ -0,0 +1,178 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "AsyncTls.h"
+
+#include <sys/epoll.h>
+
+
+
+CoExec::FdWait AsyncTls::waitIo( void )
+{
+// If there is work it can do now it just
+// lets the other coroutines run first.
+if( client.hasIncoming() || !appOutBuf.isEmpty())
+  return exec->yield();
+
+Uint32 events = EPOLLIN | EPOLLRDHUP;
+if( client.getPendingOut() > 0 )
+  events |= EPOLLOUT;
+
+return exec->waitFd( client.getSock(), events );
+}
+
+
+
+CoTask<bool> AsyncTls::connect(
+                        const CharBuf& urlDomain,
+                        const CharBuf& port )
+{
+closed = false;
+client.setNonBlocking( true );
+
+// The ClientHello waits in the transport
+// until the connect is done.
+if( !client.startHandshake( urlDomain, port ))
+  co_return false;
+
+for( ;; )
+  {
+  const Int32 status = client.processData(
+                           appOutBuf, appInBuf );
+  if( status < 0 )
+    {
+    closed = true;
+    co_return false;
+    }
+
+  if( client.isHandshakeDone())
+    co_return true;
+
+  if( !co_await waitIo())
+    co_return false;
+
+  }
+}
+
+
+
+CoTask<Int32> AsyncTls::readSome( CharBuf& readBuf,
+                                  const Int32 maxBytes )
+{
+for( ;; )
+  {
+  if( !appInBuf.isEmpty())
+    {
+    Int32 howMany = 0;
+    while( (howMany < maxBytes) &&
+           !appInBuf.isEmpty())
+      {
+      readBuf.appendU8( appInBuf.getU8());
+      howMany++;
+      }
+
+    co_return howMany;
+    }
+
+  if( closed )
+    co_return 0;
+
+  const Int32 status = client.processData(
+                           appOutBuf, appInBuf );
+
+  // It closes after the last of the data is
+  // in appInBuf, so give that out first.
+  if( status < 0 )
+    {
+    closed = true;
+    continue;
+    }
+
+  if( !appInBuf.isEmpty())
+    continue;
+
+  if( !co_await waitIo())
+    co_return -1;
+
+  }
+}
+
+
+
+CoTask<bool> AsyncTls::writeAll(
+                        const CharBuf& writeBuf )
+{
+const Int32 last = writeBuf.getLast();
+Int32 where = 0;
+
+for( ;; )
+  {
+  if( closed )
+    co_return false;
+
+  Int32 room = AppOutSize - 1 -
+                       appOutBuf.getHowMany();
+  while( (room > 0) && (where < last))
+    {
+    appOutBuf.addU8( writeBuf.getU8( where ));
+    where++;
+    room--;
+    }
+
+  // This seals one record each time.
+  const Int32 status = client.processData(
+                           appOutBuf, appInBuf );
+  if( status < 0 )
+    {
+    closed = true;
+    co_return false;
+    }
+
+  if( (where >= last) && appOutBuf.isEmpty() &&
+      (client.getPendingOut() == 0))
+    co_return true;
+
+  if( !co_await waitIo())
+    co_return false;
+
+  }
+}
+
+
+
+CoTask<bool> AsyncTls::shutdown( void )
+{
+if( closed )
+  co_return true;
+
+if( !client.sendCloseNotify())
+  co_return false;
+
+while( client.getPendingOut() > 0 )
+  {
+  if( !co_await exec->waitFd( client.getSock(),
+                              EPOLLOUT ))
+    co_return false;
+
+  if( client.processData( appOutBuf,
+                          appInBuf ) < 0 )
+    break;
+
+  }
+
+closed = true;
+co_return client.getPendingOut() == 0;
+}
@@ -0,0 +1,111 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// ClientTls with C++20 coroutines.  It runs
+// on a CoExec and uses a non-blocking
+// TcpSockCl socket, so the code that uses
+// it looks like plain blocking code:
+
+// CoTask<Int32> getPage( CoExec& exec )
+// {
+// AsyncTls tls( exec );
+// if( !co_await tls.connect( host, port ))
+//   co_return -1;
+//
+// co_await tls.writeAll( requestBuf );
+// CharBuf pageBuf;
+// while( co_await tls.readSome( pageBuf,
+//                               1024 * 16 ) > 0 )
+//   ...
+//
+// co_await tls.shutdown();
+// co_return 0;
+// }
+
+// exec.spawn( getPage( exec ));
+// exec.run();
+
+// The buffers passed in by reference have
+// to be there until the co_await is done.
+
+// The name lookup in connect() still
+// blocks, like getaddrinfo() does.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "../CppBase/CircleBuf.h"
+#include "ClientTls.h"
+#include "CoTask.h"
+#include "CoExec.h"
+
+
+
+class AsyncTls
+  {
+  private:
+  bool testForCopy = false;
+  CoExec* exec = nullptr;
+  ClientTls client;
+  CircleBuf appOutBuf;
+  CircleBuf appInBuf;
+  bool closed = false;
+
+  static const Int32 AppOutSize = 1024 * 64;
+
+  CoExec::FdWait waitIo( void );
+
+  public:
+  AsyncTls( CoExec& setExec )
+    {
+    exec = &setExec;
+    appOutBuf.setSize( AppOutSize );
+    appInBuf.setSize( 1024 * 64 );
+    }
+
+  AsyncTls( const AsyncTls& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "AsyncTls copy constructor.";
+    }
+
+  ~AsyncTls( void )
+    {
+    }
+
+  CoTask<bool> connect( const CharBuf& urlDomain,
+                        const CharBuf& port );
+
+  // It appends up to maxBytes to readBuf.
+  // It returns how many, or zero when the
+  // server is done, or -1 for an error.
+  CoTask<Int32> readSome( CharBuf& readBuf,
+                          const Int32 maxBytes );
+
+  // It is done when the socket took all of it.
+  CoTask<bool> writeAll( const CharBuf& writeBuf );
+
+  // Send close_notify and wait until it went
+  // out.
+  CoTask<bool> shutdown( void );
+
+  };
@@ -0,0 +1,125 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "CertChainView.h"
+#include "../Network/Alerts.h"
+#include "../Network/Results.h"
+
+
+
+Uint32 CertChainView::setFromMsg(
+                        const CharBuf& msgBuf,
+                        const Int32 start )
+{
+// struct {
+//   opaque certificate_request_context<0..2^8-1>;
+//   CertificateEntry certificate_list<0..2^24-1>;
+// } Certificate;
+
+// struct {
+//   opaque cert_data<1..2^24-1>;
+//   Extension extensions<0..2^16-1>;
+// } CertificateEntry;
+
+certLast = 0;
+
+const Int32 last = msgBuf.getLast();
+Int32 where = start;
+
+if( (last - where) < 1 )
+  return Alerts::DecodeError;
+
+// The context is empty from a server, but
+// it gets skipped either way.
+const Int32 contextLength = msgBuf.getU8( where );
+where += 1 + contextLength;
+
+if( (last - where) < 3 )
+  return Alerts::DecodeError;
+
+const Int32 listLength =
+           (msgBuf.getU8( where ) << 16) |
+           (msgBuf.getU8( where + 1 ) << 8) |
+            msgBuf.getU8( where + 2 );
+where += 3;
+
+if( listLength != (last - where))
+  return Alerts::DecodeError;
+
+while( where < last )
+  {
+  if( (last - where) < 3 )
+    return Alerts::DecodeError;
+
+  const Int32 certLength =
+           (msgBuf.getU8( where ) << 16) |
+           (msgBuf.getU8( where + 1 ) << 8) |
+            msgBuf.getU8( where + 2 );
+  where += 3;
+
+  if( (certLength == 0) ||
+      (certLength > (last - where)))
+    return Alerts::DecodeError;
+
+  if( certLast >= MaxCerts )
+    return Alerts::DecodeError;
+
+  certs[certLast].setView( msgBuf, where,
+                           where + certLength );
+  certLast++;
+  where += certLength;
+
+  if( (last - where) < 2 )
+    return Alerts::DecodeError;
+
+  const Int32 extenLength =
+           (msgBuf.getU8( where ) << 8) |
+            msgBuf.getU8( where + 1 );
+  where += 2;
+
+  if( extenLength > (last - where))
+    return Alerts::DecodeError;
+
+  where += extenLength;
+  }
+
+// Section 4.4.2.4.  The server has to send
+// at least one.
+if( certLast == 0 )
+  return Alerts::DecodeError;
+
+return Results::Done;
+}
+
+
+
+const DerView& CertChainView::getCertDer(
+                      const Int32 which ) const
+{
+if( (which < 0) || (which >= certLast))
+  throw "CertChainView cert is out of range.";
+
+return certs[which];
+}
+
+
+
+Uint32 CertChainView::getCert(
+                      const Int32 which,
+                      CertView& cert ) const
+{
+return cert.setFromView( getCertDer( which ));
+}
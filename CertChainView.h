@@ -0,0 +1,93 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The TLS 1.3 Certificate message from the
+// server, read where it is.
+
+// setFromMsg() checks the lengths in RFC
+// 8446 Section 4.4.2 and keeps a view of
+// each certificate.  Nothing inside a
+// certificate is looked at until getCert()
+// is called for it.  The end-entity
+// certificate is number 0.
+
+// The extensions on each CertificateEntry,
+// like OCSP status and SCTs, are skipped.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "DerView.h"
+#include "CertView.h"
+
+
+
+class CertChainView
+  {
+  private:
+  bool testForCopy = false;
+
+  static const Int32 MaxCerts = 16;
+  DerView certs[MaxCerts];
+  Int32 certLast = 0;
+
+  public:
+  CertChainView( void )
+    {
+    }
+
+  CertChainView( const CertChainView& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "CertChainView copy constructor.";
+    }
+
+  ~CertChainView( void )
+    {
+    }
+
+  void clear( void )
+    {
+    certLast = 0;
+    }
+
+  // start is where the message body starts,
+  // after the type and the three length
+  // bytes.  It gives back Results::Done or
+  // Alerts::DecodeError.
+  Uint32 setFromMsg( const CharBuf& msgBuf,
+                     const Int32 start );
+
+  Int32 getCertLast( void ) const
+    {
+    return certLast;
+    }
+
+  // The DER bytes of one certificate.
+  const DerView& getCertDer(
+                      const Int32 which ) const;
+
+  // Results::Done or Alerts::BadCertificate.
+  Uint32 getCert( const Int32 which,
+                  CertView& cert ) const;
+
+  };
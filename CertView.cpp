@@ -0,0 +1,571 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "CertView.h"
+#include "../Network/Alerts.h"
+#include "../Network/Results.h"
+
+
+
+// 2.5.4.3
+static const Uint8 OidCommonName[3] = {
+                         0x55, 0x04, 0x03 };
+
+// 2.5.29.17
+static const Uint8 OidSubjectAltName[3] = {
+                         0x55, 0x1D, 0x11 };
+
+
+
+void CertView::clear( void )
+{
+tbsWhole.clear();
+sigAlgInner.clear();
+issuerWhole.clear();
+validity.clear();
+subjectWhole.clear();
+spkiWhole.clear();
+extensions.clear();
+sigAlg.clear();
+sigValue.clear();
+version = 1;
+extenLast = 0;
+extensIndexed = false;
+}
+
+
+
+Uint32 CertView::setFromView(
+                     const DerView& certWhole )
+{
+clear();
+
+DerView outer = certWhole;
+DerView cert;
+if( !outer.nextTag( DerView::TagSequence, cert ))
+  return Alerts::BadCertificate;
+
+if( !outer.isEmpty())
+  return Alerts::BadCertificate;
+
+Uint8 tag = 0;
+DerView tbs;
+if( !cert.next( tag, tbs, tbsWhole ))
+  return Alerts::BadCertificate;
+
+if( tag != DerView::TagSequence )
+  return Alerts::BadCertificate;
+
+if( !cert.nextTag( DerView::TagSequence, sigAlg ))
+  return Alerts::BadCertificate;
+
+if( !cert.nextTag( DerView::TagBitString,
+                   sigValue ))
+  return Alerts::BadCertificate;
+
+if( !cert.isEmpty())
+  return Alerts::BadCertificate;
+
+// The version is [0] and it is v1 if it
+// isn't there.
+DerView versionView;
+bool found = false;
+if( !tbs.nextIfTag( DerView::TagContext0,
+                    versionView, found ))
+  return Alerts::BadCertificate;
+
+if( found )
+  {
+  DerView versionInt;
+  if( !versionView.nextTag( DerView::TagInteger,
+                            versionInt ))
+    return Alerts::BadCertificate;
+
+  if( versionInt.getLength() != 1 )
+    return Alerts::BadCertificate;
+
+  // It is stored as one less.
+  version = versionInt.getU8( 0 ) + 1;
+  }
+
+DerView serial;
+if( !tbs.nextTag( DerView::TagInteger, serial ))
+  return Alerts::BadCertificate;
+
+if( !tbs.nextTag( DerView::TagSequence,
+                  sigAlgInner ))
+  return Alerts::BadCertificate;
+
+DerView content;
+if( !tbs.next( tag, content, issuerWhole ) ||
+    (tag != DerView::TagSequence))
+  return Alerts::BadCertificate;
+
+if( !tbs.nextTag( DerView::TagSequence,
+                  validity ))
+  return Alerts::BadCertificate;
+
+if( !tbs.next( tag, content, subjectWhole ) ||
+    (tag != DerView::TagSequence))
+  return Alerts::BadCertificate;
+
+if( !tbs.next( tag, content, spkiWhole ) ||
+    (tag != DerView::TagSequence))
+  return Alerts::BadCertificate;
+
+// The unique IDs aren't used, but they
+// might be there before the extensions.
+while( !tbs.isEmpty())
+  {
+  if( !tbs.peekTag( tag ))
+    return Alerts::BadCertificate;
+
+  if( tag == DerView::TagContext3 )
+    {
+    DerView extenWrap;
+    if( !tbs.next( tag, extenWrap ))
+      return Alerts::BadCertificate;
+
+    if( !extenWrap.nextTag( DerView::TagSequence,
+                            extensions ))
+      return Alerts::BadCertificate;
+
+    if( !extenWrap.isEmpty())
+      return Alerts::BadCertificate;
+
+    continue;
+    }
+
+  if( (tag != 0x81) && (tag != 0x82) &&
+      (tag != 0xA1) && (tag != 0xA2))
+    return Alerts::BadCertificate;
+
+  if( !tbs.skip())
+    return Alerts::BadCertificate;
+
+  }
+
+// RFC 5280 Section 4.1.1.2.  The two
+// signature algorithms have to be the same.
+if( sigAlg.getLength() != sigAlgInner.getLength())
+  return Alerts::BadCertificate;
+
+for( Int32 count = 0; count < sigAlg.getLength();
+                                     count++ )
+  {
+  if( sigAlg.getU8( count ) !=
+                     sigAlgInner.getU8( count ))
+    return Alerts::BadCertificate;
+
+  }
+
+return Results::Done;
+}
+
+
+
+bool CertView::getPublicKey( DerView& algOid,
+                             DerView& params,
+                             DerView& keyBytes ) const
+{
+DerView spki = spkiWhole;
+DerView content;
+if( !spki.nextTag( DerView::TagSequence, content ))
+  return false;
+
+DerView algId;
+if( !content.nextTag( DerView::TagSequence, algId ))
+  return false;
+
+if( !algId.nextTag( DerView::TagOid, algOid ))
+  return false;
+
+// The parameters are whatever is left.  It
+// is a NULL for RSA and the curve OID for
+// EC keys.
+params = algId;
+
+DerView bits;
+if( !content.nextTag( DerView::TagBitString, bits ))
+  return false;
+
+// The first byte is how many bits are not
+// used at the end, and a key has none.
+if( bits.getLength() < 2 )
+  return false;
+
+if( bits.getU8( 0 ) != 0 )
+  return false;
+
+keyBytes = bits;
+return keyBytes.dropFront( 1 );
+}
+
+
+
+bool CertView::getTime( DerView& fromView,
+                        Int64& unixTime )
+{
+// RFC 5280 Section 4.1.2.5.  UTCTime is
+// YYMMDDHHMMSSZ and GeneralizedTime is
+// YYYYMMDDHHMMSSZ.
+
+Uint8 tag = 0;
+DerView timeView;
+if( !fromView.next( tag, timeView ))
+  return false;
+
+Int32 yearDigits = 0;
+if( tag == DerView::TagUtcTime )
+  yearDigits = 2;
+else if( tag == DerView::TagGenTime )
+  yearDigits = 4;
+else
+  return false;
+
+const Int32 length = timeView.getLength();
+if( length != (yearDigits + 11))
+  return false;
+
+if( timeView.getU8( length - 1 ) != 'Z' )
+  return false;
+
+Int32 digits[14];
+for( Int32 count = 0; count < (length - 1);
+                                     count++ )
+  {
+  const Uint8 letter = timeView.getU8( count );
+  if( (letter < '0') || (letter > '9'))
+    return false;
+
+  digits[count] = letter - '0';
+  }
+
+Int64 year = 0;
+for( Int32 count = 0; count < yearDigits; count++ )
+  year = (year * 10) + digits[count];
+
+// Section 4.1.2.5.1.
+if( yearDigits == 2 )
+  year += (year >= 50) ? 1900 : 2000;
+
+const Int32* rest = digits + yearDigits;
+const Int64 month = (rest[0] * 10) + rest[1];
+const Int64 day = (rest[2] * 10) + rest[3];
+const Int64 hour = (rest[4] * 10) + rest[5];
+const Int64 minute = (rest[6] * 10) + rest[7];
+const Int64 second = (rest[8] * 10) + rest[9];
+
+if( (month < 1) || (month > 12) ||
+    (day < 1) || (day > 31) ||
+    (hour > 23) || (minute > 59) ||
+    (second > 59))
+  return false;
+
+// Days since 1970 from the proleptic
+// Gregorian calendar, with March as the
+// first month so the leap day is last.
+const Int64 yearMar = (month <= 2) ? year - 1 :
+                                     year;
+const Int64 era = yearMar / 400;
+const Int64 yearOfEra = yearMar - (era * 400);
+const Int64 monthMar = (month + 9) % 12;
+const Int64 dayOfYear = (((153 * monthMar) + 2) /
+                         5) + day - 1;
+const Int64 dayOfEra = (yearOfEra * 365) +
+                       (yearOfEra / 4) -
+                       (yearOfEra / 100) +
+                       dayOfYear;
+const Int64 days = (era * 146097) + dayOfEra -
+                   719468;
+
+unixTime = (days * 86400) + (hour * 3600) +
+           (minute * 60) + second;
+return true;
+}
+
+
+
+bool CertView::getValidity( Int64& notBefore,
+                            Int64& notAfter ) const
+{
+DerView times = validity;
+if( !getTime( times, notBefore ))
+  return false;
+
+if( !getTime( times, notAfter ))
+  return false;
+
+return times.isEmpty();
+}
+
+
+
+bool CertView::getNameCN( const DerView& nameWhole,
+                          DerView& cn )
+{
+// A Name is a SEQUENCE of SETs of
+// SEQUENCEs that each have an OID and a
+// value.  RFC 5280 Section 4.1.2.4.  If
+// there is more than one CN this gives the
+// last one, which is the most specific.
+
+DerView outer = nameWhole;
+DerView rdnList;
+if( !outer.nextTag( DerView::TagSequence,
+                    rdnList ))
+  return false;
+
+bool found = false;
+while( !rdnList.isEmpty())
+  {
+  DerView rdn;
+  if( !rdnList.nextTag( DerView::TagSet, rdn ))
+    return false;
+
+  while( !rdn.isEmpty())
+    {
+    DerView attrib;
+    if( !rdn.nextTag( DerView::TagSequence,
+                      attrib ))
+      return false;
+
+    DerView oid;
+    if( !attrib.nextTag( DerView::TagOid, oid ))
+      return false;
+
+    if( !oid.isEqual( OidCommonName, 3 ))
+      continue;
+
+    Uint8 tag = 0;
+    if( !attrib.next( tag, cn ))
+      return false;
+
+    found = true;
+    }
+  }
+
+return found;
+}
+
+
+
+bool CertView::getSubjectCN( DerView& cn ) const
+{
+return getNameCN( subjectWhole, cn );
+}
+
+
+
+bool CertView::getIssuerCN( DerView& cn ) const
+{
+return getNameCN( issuerWhole, cn );
+}
+
+
+
+bool CertView::getSignature( DerView& algOid,
+                             DerView& sigBytes ) const
+{
+DerView algId = sigAlg;
+if( !algId.nextTag( DerView::TagOid, algOid ))
+  return false;
+
+if( sigValue.getLength() < 2 )
+  return false;
+
+if( sigValue.getU8( 0 ) != 0 )
+  return false;
+
+sigBytes = sigValue;
+return sigBytes.dropFront( 1 );
+}
+
+
+
+bool CertView::indexExtens( void )
+{
+// Only where each one is.  Nothing in them
+// gets decoded here.
+if( extensIndexed )
+  return true;
+
+extenLast = 0;
+DerView list = extensions;
+while( !list.isEmpty())
+  {
+  if( extenLast >= MaxExtens )
+    return false;
+
+  DerView exten;
+  if( !list.nextTag( DerView::TagSequence,
+                     exten ))
+    return false;
+
+  ExtenEntry& entry = extenIndex[extenLast];
+  if( !exten.nextTag( DerView::TagOid,
+                      entry.oid ))
+    return false;
+
+  // BOOLEAN DEFAULT FALSE.
+  entry.critical = false;
+  DerView critView;
+  bool found = false;
+  if( !exten.nextIfTag( DerView::TagBoolean,
+                        critView, found ))
+    return false;
+
+  if( found )
+    {
+    if( critView.getLength() != 1 )
+      return false;
+
+    entry.critical = critView.getU8( 0 ) != 0;
+    }
+
+  if( !exten.nextTag( DerView::TagOctetString,
+                      entry.value ))
+    return false;
+
+  if( !exten.isEmpty())
+    return false;
+
+  extenLast++;
+  }
+
+extensIndexed = true;
+return true;
+}
+
+
+
+Int32 CertView::getExtenCount( void )
+{
+if( !indexExtens())
+  return -1;
+
+return extenLast;
+}
+
+
+
+bool CertView::findExten( const Uint8* oid,
+                          const Int32 oidLast,
+                          DerView& value,
+                          bool& critical )
+{
+if( !indexExtens())
+  return false;
+
+for( Int32 count = 0; count < extenLast; count++ )
+  {
+  if( !extenIndex[count].oid.isEqual( oid,
+                                      oidLast ))
+    continue;
+
+  value = extenIndex[count].value;
+  critical = extenIndex[count].critical;
+  return true;
+  }
+
+return false;
+}
+
+
+
+bool CertView::dnsNameMatches(
+                       const DerView& dnsName,
+                       const CharBuf& hostName )
+{
+const Int32 nameLast = dnsName.getLength();
+const Int32 hostLast = hostName.getLast();
+if( (nameLast == 0) || (hostLast == 0))
+  return false;
+
+Int32 nameAt = 0;
+Int32 hostAt = 0;
+
+// *.example.com matches one whole label
+// and nothing else.
+if( (nameLast > 2) &&
+    (dnsName.getU8( 0 ) == '*') &&
+    (dnsName.getU8( 1 ) == '.'))
+  {
+  while( (hostAt < hostLast) &&
+         (hostName.getU8( hostAt ) != '.'))
+    hostAt++;
+
+  // The label can't be empty.
+  if( (hostAt == 0) || (hostAt == hostLast))
+    return false;
+
+  nameAt = 1;
+  }
+
+if( (nameLast - nameAt) != (hostLast - hostAt))
+  return false;
+
+for( ; nameAt < nameLast; nameAt++, hostAt++ )
+  {
+  Uint8 fromName = dnsName.getU8( nameAt );
+  Uint8 fromHost = hostName.getU8( hostAt );
+  if( (fromName >= 'A') && (fromName <= 'Z'))
+    fromName = fromName + ('a' - 'A');
+
+  if( (fromHost >= 'A') && (fromHost <= 'Z'))
+    fromHost = fromHost + ('a' - 'A');
+
+  if( fromName != fromHost )
+    return false;
+
+  }
+
+return true;
+}
+
+
+
+bool CertView::matchesDnsName(
+                       const CharBuf& hostName )
+{
+DerView value;
+bool critical = false;
+if( !findExten( OidSubjectAltName, 3,
+                value, critical ))
+  return false;
+
+DerView names;
+if( !value.nextTag( DerView::TagSequence,
+                    names ))
+  return false;
+
+while( !names.isEmpty())
+  {
+  Uint8 tag = 0;
+  DerView oneName;
+  if( !names.next( tag, oneName ))
+    return false;
+
+  if( tag != DerView::TagImplicit2 )
+    continue;
+
+  if( dnsNameMatches( oneName, hostName ))
+    return true;
+
+  }
+
+return false;
+}
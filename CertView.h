@@ -0,0 +1,167 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// One X.509 certificate, read where it is.
+
+// setFromView() only finds where each part
+// of the certificate is, using RFC 5280
+// Section 4.1.  The public key, the
+// validity times, the names and the
+// signature are only decoded when they are
+// asked for.  The extensions are not decoded
+// at all until one is looked for, and then
+// there is an index of where each one is.
+
+// The views point in to the CharBuf that
+// the certificate came in, so that has to
+// stay the same while this is used.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "DerView.h"
+
+
+
+class CertView
+  {
+  private:
+  bool testForCopy = false;
+
+  // With the tag and length, since that is
+  // what the signature covers.
+  DerView tbsWhole;
+  DerView sigAlgInner;
+  DerView issuerWhole;
+  DerView validity;
+  DerView subjectWhole;
+  DerView spkiWhole;
+  // What is in the [3], or empty.
+  DerView extensions;
+  DerView sigAlg;
+  DerView sigValue;
+  Int32 version = 1;
+
+  class ExtenEntry
+    {
+    public:
+    DerView oid;
+    DerView value;
+    bool critical = false;
+    };
+
+  static const Int32 MaxExtens = 32;
+  ExtenEntry extenIndex[MaxExtens];
+  Int32 extenLast = 0;
+  bool extensIndexed = false;
+
+  bool indexExtens( void );
+  static bool getTime( DerView& fromView,
+                       Int64& unixTime );
+  static bool getNameCN( const DerView& nameWhole,
+                         DerView& cn );
+  static bool dnsNameMatches( const DerView& dnsName,
+                              const CharBuf& hostName );
+
+  public:
+  CertView( void )
+    {
+    }
+
+  CertView( const CertView& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "CertView copy constructor.";
+    }
+
+  ~CertView( void )
+    {
+    }
+
+  void clear( void );
+
+  // certWhole is the whole Certificate
+  // SEQUENCE.  It gives back Results::Done
+  // or Alerts::BadCertificate.
+  Uint32 setFromView( const DerView& certWhole );
+
+  Int32 getVersion( void ) const
+    {
+    return version;
+    }
+
+  const DerView& getTbs( void ) const
+    {
+    return tbsWhole;
+    }
+
+  // The whole Name, to compare or to hash.
+  const DerView& getIssuer( void ) const
+    {
+    return issuerWhole;
+    }
+
+  const DerView& getSubject( void ) const
+    {
+    return subjectWhole;
+    }
+
+  // The whole SubjectPublicKeyInfo.
+  const DerView& getSpki( void ) const
+    {
+    return spkiWhole;
+    }
+
+  // The algorithm OID, the parameters if it
+  // has any, and the key bytes from the BIT
+  // STRING.
+  bool getPublicKey( DerView& algOid,
+                     DerView& params,
+                     DerView& keyBytes ) const;
+
+  // In seconds since 1970.
+  bool getValidity( Int64& notBefore,
+                    Int64& notAfter ) const;
+
+  bool getSubjectCN( DerView& cn ) const;
+  bool getIssuerCN( DerView& cn ) const;
+
+  // The outer signature algorithm OID and
+  // the signature bytes from the BIT STRING.
+  bool getSignature( DerView& algOid,
+                     DerView& sigBytes ) const;
+
+  Int32 getExtenCount( void );
+
+  // oid is only the OID contents, without the
+  // tag and length.
+  bool findExten( const Uint8* oid,
+                  const Int32 oidLast,
+                  DerView& value,
+                  bool& critical );
+
+  // If a dNSName in subjectAltName matches
+  // it, with a wildcard only for the whole
+  // left-most label.  RFC 6125 Section 6.4.
+  bool matchesDnsName( const CharBuf& hostName );
+
+  };
@@ -0,0 +1,282 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "ChaChaRand.h"
+
+#include <atomic>
+#include <mutex>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/random.h>
+
+
+
+// This goes up in the child after each
+// fork().
+static std::atomic<Uint32> forkCounter( 0 );
+static std::once_flag atForkOnce;
+
+static thread_local ChaChaRand threadRand;
+
+
+
+static void atForkChild( void )
+{
+forkCounter.fetch_add( 1,
+                     std::memory_order_relaxed );
+}
+
+
+
+static void setAtFork( void )
+{
+::pthread_atfork( nullptr, nullptr,
+                  atForkChild );
+}
+
+
+
+static inline Uint32 rotateLeft( const Uint32 x,
+                                 const Int32 by )
+{
+return (x << by) | (x >> (32 - by));
+}
+
+
+
+static inline void quarterRound( Uint32* x,
+                                 const Int32 a,
+                                 const Int32 b,
+                                 const Int32 c,
+                                 const Int32 d )
+{
+x[a] += x[b]; x[d] ^= x[a];
+x[d] = rotateLeft( x[d], 16 );
+x[c] += x[d]; x[b] ^= x[c];
+x[b] = rotateLeft( x[b], 12 );
+x[a] += x[b]; x[d] ^= x[a];
+x[d] = rotateLeft( x[d], 8 );
+x[c] += x[d]; x[b] ^= x[c];
+x[b] = rotateLeft( x[b], 7 );
+}
+
+
+
+ChaChaRand::~ChaChaRand( void )
+{
+// Don't leave the key in memory.
+::explicit_bzero( key, sizeof( key ));
+::explicit_bzero( outBytes, sizeof( outBytes ));
+}
+
+
+
+void ChaChaRand::chachaBlock(
+                         const Uint32 counter,
+                         Uint8* block )
+{
+// RFC 8439 Section 2.3.  The nonce is zero
+// since every key is only used for one
+// refill.
+
+Uint32 state[16];
+state[0] = 0x61707865;
+state[1] = 0x3320646e;
+state[2] = 0x79622d32;
+state[3] = 0x6b206574;
+
+for( Int32 count = 0; count < 8; count++ )
+  state[4 + count] = key[count];
+
+state[12] = counter;
+state[13] = 0;
+state[14] = 0;
+state[15] = 0;
+
+Uint32 x[16];
+for( Int32 count = 0; count < 16; count++ )
+  x[count] = state[count];
+
+for( Int32 count = 0; count < 10; count++ )
+  {
+  quarterRound( x, 0, 4, 8, 12 );
+  quarterRound( x, 1, 5, 9, 13 );
+  quarterRound( x, 2, 6, 10, 14 );
+  quarterRound( x, 3, 7, 11, 15 );
+
+  quarterRound( x, 0, 5, 10, 15 );
+  quarterRound( x, 1, 6, 11, 12 );
+  quarterRound( x, 2, 7, 8, 13 );
+  quarterRound( x, 3, 4, 9, 14 );
+  }
+
+for( Int32 count = 0; count < 16; count++ )
+  {
+  const Uint32 word = x[count] + state[count];
+  block[count * 4] = static_cast<Uint8>( word );
+  block[count * 4 + 1] =
+                  static_cast<Uint8>( word >> 8 );
+  block[count * 4 + 2] =
+                  static_cast<Uint8>( word >> 16 );
+  block[count * 4 + 3] =
+                  static_cast<Uint8>( word >> 24 );
+  }
+}
+
+
+
+void ChaChaRand::reseed( void )
+{
+std::call_once( atForkOnce, setAtFork );
+
+Uint8 seedBytes[KeyBytes];
+Int32 where = 0;
+while( where < KeyBytes )
+  {
+  const ssize_t howMany = ::getrandom(
+                 seedBytes + where,
+                 static_cast<size_t>(
+                        KeyBytes - where ), 0 );
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    throw "ChaChaRand getrandom() failed.";
+    }
+
+  where += static_cast<Int32>( howMany );
+  }
+
+// Mix it in to the key it has.  It would
+// be just as good to replace it.
+for( Int32 count = 0; count < 8; count++ )
+  {
+  Uint32 word = seedBytes[count * 4];
+  word |= static_cast<Uint32>(
+                 seedBytes[count * 4 + 1] ) << 8;
+  word |= static_cast<Uint32>(
+                 seedBytes[count * 4 + 2] ) << 16;
+  word |= static_cast<Uint32>(
+                 seedBytes[count * 4 + 3] ) << 24;
+  key[count] ^= word;
+  }
+
+::explicit_bzero( seedBytes, sizeof( seedBytes ));
+
+// Throw away what was made with the old key.
+::explicit_bzero( outBytes, sizeof( outBytes ));
+outWhere = 0;
+outLast = 0;
+
+sinceSeed = 0;
+forkCount = forkCounter.load(
+                    std::memory_order_relaxed );
+seeded = true;
+}
+
+
+
+void ChaChaRand::refill( void )
+{
+for( Int32 count = 0; count < 8; count++ )
+  chachaBlock( static_cast<Uint32>( count ),
+               outBytes + (count * 64) );
+
+// The first 32 bytes are the next key.
+for( Int32 count = 0; count < 8; count++ )
+  {
+  Uint32 word = outBytes[count * 4];
+  word |= static_cast<Uint32>(
+                 outBytes[count * 4 + 1] ) << 8;
+  word |= static_cast<Uint32>(
+                 outBytes[count * 4 + 2] ) << 16;
+  word |= static_cast<Uint32>(
+                 outBytes[count * 4 + 3] ) << 24;
+  key[count] = word;
+  }
+
+::explicit_bzero( outBytes, KeyBytes );
+outWhere = KeyBytes;
+outLast = BlocksBytes;
+}
+
+
+
+void ChaChaRand::fill( Uint8* toFill,
+                       const Int32 howMany )
+{
+if( !seeded || (sinceSeed >= ReseedBytes) ||
+    (forkCount != forkCounter.load(
+                  std::memory_order_relaxed )))
+  reseed();
+
+Int32 where = 0;
+while( where < howMany )
+  {
+  if( outWhere >= outLast )
+    refill();
+
+  Int32 part = outLast - outWhere;
+  if( part > (howMany - where))
+    part = howMany - where;
+
+  ::memcpy( toFill + where, outBytes + outWhere,
+            static_cast<size_t>( part ));
+
+  // The same bytes never get given out
+  // twice, and they aren't left here.
+  ::explicit_bzero( outBytes + outWhere,
+                    static_cast<size_t>( part ));
+
+  outWhere += part;
+  where += part;
+  }
+
+sinceSeed += static_cast<Uint64>( howMany );
+}
+
+
+
+void ChaChaRand::fillBytes( Uint8* toFill,
+                            const Int32 howMany )
+{
+threadRand.fill( toFill, howMany );
+}
+
+
+
+void ChaChaRand::appendBytes( CharBuf& toAdd,
+                              const Int32 howMany )
+{
+Uint8 bytes[64];
+Int32 where = 0;
+while( where < howMany )
+  {
+  Int32 part = howMany - where;
+  if( part > 64 )
+    part = 64;
+
+  threadRand.fill( bytes, part );
+  for( Int32 count = 0; count < part; count++ )
+    toAdd.appendU8( bytes[count] );
+
+  where += part;
+  }
+
+::explicit_bzero( bytes, sizeof( bytes ));
+}
@@ -0,0 +1,94 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Random bytes for the handshake: the
+// client random, the legacy session ID and
+// the private keys.
+
+// Each thread has its own generator, so
+// there is no lock.  It is ChaCha20 with a
+// key that came from getrandom().  It makes
+// 8 blocks at a time.  The first 32 bytes
+// of those become the next key and the rest
+// is given out.  So the key that made bytes
+// that were given out is already gone, and
+// the bytes get set to zero when they are
+// given out.  That is the fast key erasure
+// idea from D. J. Bernstein.
+
+// It gets a new key from getrandom() after
+// ReseedBytes, and in a child process after
+// fork() so the parent and the child don't
+// give out the same bytes.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class ChaChaRand
+  {
+  private:
+  bool testForCopy = false;
+  Uint32 key[8] = { 0 };
+  Uint8 outBytes[8 * 64] = { 0 };
+  Int32 outWhere = 0;
+  Int32 outLast = 0;
+  Uint64 sinceSeed = 0;
+  Uint32 forkCount = 0;
+  bool seeded = false;
+
+  void chachaBlock( const Uint32 counter,
+                    Uint8* block );
+  void reseed( void );
+  void refill( void );
+
+  public:
+  // 32 bytes of key at the start of each
+  // refill.
+  static const Int32 KeyBytes = 32;
+  static const Int32 BlocksBytes = 8 * 64;
+  static const Uint64 ReseedBytes =
+                          1024 * 1024 * 16;
+
+  ChaChaRand( void )
+    {
+    }
+
+  ChaChaRand( const ChaChaRand& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "ChaChaRand copy constructor.";
+    }
+
+  ~ChaChaRand( void );
+
+  void fill( Uint8* toFill, const Int32 howMany );
+
+  // These use the one for this thread.
+  static void fillBytes( Uint8* toFill,
+                         const Int32 howMany );
+  static void appendBytes( CharBuf& toAdd,
+                           const Int32 howMany );
+
+  };
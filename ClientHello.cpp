@@ -12,9 +12,15 @@
 #include "../Network/Alerts.h"
 #include "../Network/Results.h"
 
-#include "../CryptoBase/Randomish.h"
+#include "ChaChaRand.h"
+#include "P256.h"
+#include "MlKem768.h"
+#include "CurveCtx.h"
 
 #include "../CppBase/StIO.h"
+#include "LogCl.h"
+
+#include <string.h>
 
 
 
@@ -35,10 +41,38 @@ throw "ClientHello copy constructor called.";
 
 ClientHello::~ClientHello( void )
 {
+::explicit_bzero( p256Priv, sizeof( p256Priv ));
+::explicit_bzero( mlKemDecapKey,
+                  sizeof( mlKemDecapKey ));
+::explicit_bzero( x25519Priv,
+                  sizeof( x25519Priv ));
 }
 
 
 
+void ClientHello::reset( void )
+{
+msgBytes.clear();
+keyShareBuf.clear();
+p256PubBuf.clear();
+mlKemShareBuf.clear();
+offerP256 = false;
+offerMlKem = false;
+
+::explicit_bzero( p256Priv, sizeof( p256Priv ));
+::explicit_bzero( mlKemDecapKey,
+                  sizeof( mlKemDecapKey ));
+::explicit_bzero( x25519Priv,
+                  sizeof( x25519Priv ));
+
+// ExtenList is in ../Network and has no
+// clear().  It is kept, since
+// makeClHelloBuf() makes all of the
+// extension bytes over from TlsMain and
+// EncryptTls each time.
+}
+
+
 
 Uint32 ClientHello::parseBuffer(
                         const CharBuf& inBuf,
@@ -51,9 +85,21 @@ msgBytes.copy( inBuf );
 
 tlsMain.setClientHelloMsg( msgBytes );
 
-// const Int32 last = msgBytes.getLast();
+const Int32 last = msgBytes.getLast();
+
+LogCl::trace( "Parsing ClientHello." );
 
-StIO::putS( "Parsing ClientHello." );
+// The lengths get checked before they are
+// used so that a short message is an alert
+// and not an exception from getU8().
+
+// Type, length, version, random, and the
+// session ID length.
+if( last < 39 )
+  {
+  LogCl::warn( "ClientHello is too short." );
+  return Alerts::DecodeError;
+  }
 
 // handshake type at 0.
 // length at 1, 2, and 3.
@@ -90,13 +136,11 @@ tlsMain.setClientRandom( randBytes );
 
 const Uint8 sessionIDLength = msgBytes.getU8( 38 );
 
-StIO::printF( "sessionIDLength: " );
-StIO::printFUD( sessionIDLength );
-StIO::putLF();
+LogCl::trace( "sessionIDLength:", sessionIDLength );
 
 if( sessionIDLength > 32 )
   {
-  StIO::putS( "sessionIDLength is too long." );
+  LogCl::warn( "sessionIDLength is too long." );
   return Alerts::DecodeError;
   }
 
@@ -105,6 +149,14 @@ if( sessionIDLength > 32 )
 
 index = 39;
 
+// The session ID and the cipher length.
+if( (index + static_cast<Int32>(
+         sessionIDLength ) + 2) > last )
+  {
+  LogCl::warn( "ClientHello session ID." );
+  return Alerts::DecodeError;
+  }
+
 CharBuf sessionID;
 for( Uint32 countID = 0;
            countID < sessionIDLength; countID++ )
@@ -121,14 +173,22 @@ cipherLength <<= 8;
 cipherLength |= msgBytes.getU8( index );
 index++;
 
-StIO::printF( "cipherLength: " );
-StIO::printFUD( cipherLength );
-StIO::putLF();
+LogCl::trace( "cipherLength:", cipherLength );
 
 // How long should this be?
 if( cipherLength > 16000 )
   {
-  StIO::putS( "cipherLength is too long." );
+  LogCl::warn( "cipherLength is too long." );
+  return Alerts::DecodeError;
+  }
+
+// The suites are two bytes each, and then
+// the compression length.
+if( ((cipherLength & 1) != 0) ||
+    ((index + static_cast<Int32>(
+          cipherLength ) + 1) > last))
+  {
+  LogCl::warn( "ClientHello cipherLength." );
   return Alerts::DecodeError;
   }
 
@@ -171,7 +231,7 @@ for( Uint32 count = 0; count < maxCipher; count++ )
 
 if( !standardCipherFound )
   {
-  StIO::putS( "AES 128 standard was not found." );
+  LogCl::warn( "AES 128 standard was not found." );
   // What alert should this be?
   return Alerts::DecodeError;
   }
@@ -179,15 +239,20 @@ if( !standardCipherFound )
 Uint8 compressionLength = msgBytes.getU8( index );
 index++;
 
+if( (index + compressionLength) > last )
+  {
+  LogCl::warn( "ClientHello compressionLength." );
+  return Alerts::DecodeError;
+  }
+
 if( compressionLength == 1 )
   {
   Uint8 compressionValue = msgBytes.getU8( index );
   index++;
   if( compressionValue != 0 )
     {
-    StIO::printF( "compressionValue is bad: " );
-    StIO::printFUD( compressionValue );
-    StIO::putLF();
+    LogCl::warn( "compressionValue is bad:",
+                 compressionValue );
 
     return Alerts::IllegalParameter;
     }
@@ -198,7 +263,7 @@ else
   // opaque legacy_compression_methods&lt;
   //                             1..2^8-1&gt;;
 
-  StIO::putS(
+  LogCl::warn(
       "Compression method should have 1 byte." );
 
   return Alerts::IllegalParameter;
@@ -207,9 +272,7 @@ else
 
 // Now for the extensions.
 
-StIO::printF( "index for extension is: " );
-StIO::printFD( index );
-StIO::putLF();
+LogCl::trace( "index for extension is:", index );
 
 ExtenList extList;
 Uint32 result = extList.setFromMsg(
@@ -218,7 +281,7 @@ Uint32 result = extList.setFromMsg(
                          tlsMain,
                          false, // isServerMsg.
                          encryptTls );
-StIO::putS( "\nAfter extensions.\n" );
+LogCl::trace( "After extensions." );
 
 return result;
 
@@ -241,40 +304,248 @@ catch( ... )
 
 
 
-void ClientHello::makeHelloBuf(
-                       CharBuf& outBuf,
-                       TlsMain& tlsMain,
-                       EncryptTls& encryptTls )
+void ClientHello::makeRandoms(
+                       CharBuf& randBuf,
+                       CharBuf& sessionIDBuf,
+                       TlsMain& tlsMain )
 {
-StIO::putS( "Top of makeHelloBuf." );
+// Both of them in one call.
+Uint8 randBytes[32 + 32];
+ChaChaRand::fillBytes( randBytes, 32 + 32 );
 
-CharBuf randBytes;
-Randomish::makeRandomBytes( randBytes, 32 + 10 );
-
-CharBuf randBuf;
+randBuf.clear();
 for( Int32 count = 0; count < 32; count++ )
-  {
-  outBuf.appendU8( randBytes.getU8( count ));
-  randBuf.appendU8( randBytes.getU8( count ));
-  }
+  randBuf.appendU8( randBytes[count] );
 
 tlsMain.setClientRandom( randBuf );
 
 // This is set to 32 bytes for compatibility.
-CharBuf sessionIDBuf;
-outBuf.appendU8( 32 ); // Legacy session ID length.
-
-Randomish::makeRandomBytes( randBytes, 32 + 10 );
+sessionIDBuf.clear();
 for( Int32 count = 0; count < 32; count++ )
-  {
-  outBuf.appendU8( randBytes.getU8( count ));
-  sessionIDBuf.appendU8(
-                      randBytes.getU8( count ));
-  }
+  sessionIDBuf.appendU8( randBytes[32 + count] );
 
 // The client makes the Session ID and the
 // server has to echo it back.
 tlsMain.setSessionIDLegacy( sessionIDBuf );
+}
+
+
+
+void ClientHello::setX25519Priv(
+                       const Uint8* keyBytes )
+{
+::memcpy( x25519Priv, keyBytes, 32 );
+}
+
+
+
+void ClientHello::makeKeyShare(
+                       CharBuf& pubKeyBuf,
+                       EncryptTls& encryptTls )
+{
+// See RFC 7748 Section 6.1 for what is
+// sent here.
+
+// A random scalar, clamped like RFC 7748
+// Section 5 says.
+Uint8 keyBytes[32];
+ChaChaRand::fillBytes( keyBytes, 32 );
+
+// The hybrid secret and the capture file
+// need it again.
+::memcpy( x25519Priv, keyBytes, 32 );
+
+Integer k;
+CurveCtx::privKeyToInt( keyBytes, k );
+::explicit_bzero( keyBytes, sizeof( keyBytes ));
+
+Integer pubKey;
+CurveCtx::baseMult( pubKey, k );
+
+// ExtenList takes the key_share bytes from
+// here.  The private key stays in
+// x25519Priv, since HandshakeCl makes the
+// shared secret.
+encryptTls.setClientPubKey( pubKey );
+
+// The bytes that go in the key_share
+// extension.
+pubKeyBuf.clear();
+CurveCtx::intToBytes( pubKey, pubKeyBuf );
+
+if( offerP256 )
+  {
+  Uint8 p256Pub[P256::PointBytes];
+  P256::makeKeyPair( p256Priv, p256Pub );
+
+  p256PubBuf.clear();
+  for( Int32 count = 0; count < P256::PointBytes;
+                                        count++ )
+    p256PubBuf.appendU8( p256Pub[count] );
+
+  }
+
+if( offerMlKem )
+  {
+  // draft-ietf-tls-ecdhe-mlkem Section 3.
+  // The share is the encapsulation key and
+  // then the same X25519 public key.
+  Uint8 encapKey[MlKem768::EncapKeyBytes];
+  MlKem768::makeKeyPair( encapKey,
+                         mlKemDecapKey );
+
+  mlKemShareBuf.clear();
+  for( Int32 count = 0;
+           count < MlKem768::EncapKeyBytes;
+                                        count++ )
+    mlKemShareBuf.appendU8( encapKey[count] );
+
+  mlKemShareBuf.appendCharBuf( pubKeyBuf );
+  }
+}
+
+
+
+bool ClientHello::addKeyShare(
+                         CharBuf& extenListBuf,
+                         const Uint32 group,
+                         const CharBuf& shareBuf )
+{
+// ExtenList only makes the x25519 share, so
+// this adds another group to the end of
+// supported_groups and its share to the end
+// of key_share.  Both lists stay in the same
+// order, and x25519 is still first.
+// RFC 8446 Section 4.2.7 and 4.2.8.
+
+const Uint32 SupportedGroupsID = 10;
+const Uint32 KeyShareID = 51;
+
+const Int32 last = extenListBuf.getLast();
+if( last < 2 )
+  return false;
+
+const Int32 listLength =
+          (extenListBuf.getU8( 0 ) << 8) |
+           extenListBuf.getU8( 1 );
+if( listLength != (last - 2))
+  return false;
+
+CharBuf newBuf;
+newBuf.appendU8( 0 ); // Length for later.
+newBuf.appendU8( 0 );
+
+bool foundShares = false;
+Int32 index = 2;
+while( index < last )
+  {
+  if( (index + 4) > last )
+    return false;
+
+  const Uint32 extType =
+          static_cast<Uint32>(
+          (extenListBuf.getU8( index ) << 8) |
+           extenListBuf.getU8( index + 1 ));
+  const Int32 extLength =
+          (extenListBuf.getU8( index + 2 ) << 8) |
+           extenListBuf.getU8( index + 3 );
+  const Int32 dataAt = index + 4;
+  if( (dataAt + extLength) > last )
+    return false;
+
+  index = dataAt + extLength;
+
+  CharBuf addBuf;
+  if( extType == SupportedGroupsID )
+    {
+    bool hasIt = false;
+    for( Int32 count = dataAt + 2;
+          (count + 1) < (dataAt + extLength);
+                                    count += 2 )
+      {
+      const Uint32 listed = static_cast<Uint32>(
+          (extenListBuf.getU8( count ) << 8) |
+           extenListBuf.getU8( count + 1 ));
+      if( listed == group )
+        hasIt = true;
+
+      }
+
+    if( !hasIt )
+      {
+      addBuf.appendU8( (group >> 8) & 0xFF );
+      addBuf.appendU8( group & 0xFF );
+      }
+    }
+
+  if( extType == KeyShareID )
+    {
+    const Int32 shareLast = shareBuf.getLast();
+    foundShares = true;
+    addBuf.appendU8( (group >> 8) & 0xFF );
+    addBuf.appendU8( group & 0xFF );
+    addBuf.appendU8( (shareLast >> 8) & 0xFF );
+    addBuf.appendU8( shareLast & 0xFF );
+    addBuf.appendCharBuf( shareBuf );
+    }
+
+  const Int32 addLast = addBuf.getLast();
+  if( (addLast > 0) && (extLength < 2))
+    return false;
+
+  const Int32 newLength = extLength + addLast;
+  newBuf.appendU8( (extType >> 8) & 0xFF );
+  newBuf.appendU8( extType & 0xFF );
+  newBuf.appendU8( (newLength >> 8) & 0xFF );
+  newBuf.appendU8( newLength & 0xFF );
+
+  Int32 copyFrom = dataAt;
+  if( addLast > 0 )
+    {
+    // Both of these start with the length
+    // of the list inside.
+    const Int32 innerLength = extLength - 2 +
+                                       addLast;
+    newBuf.appendU8( (innerLength >> 8) & 0xFF );
+    newBuf.appendU8( innerLength & 0xFF );
+    copyFrom += 2;
+    }
+
+  for( Int32 count = copyFrom; count < index;
+                                       count++ )
+    newBuf.appendU8( extenListBuf.getU8( count ));
+
+  newBuf.appendCharBuf( addBuf );
+  }
+
+if( !foundShares )
+  return false;
+
+const Int32 newListLength = newBuf.getLast() - 2;
+newBuf.setU8( 0, (newListLength >> 8) & 0xFF );
+newBuf.setU8( 1, newListLength & 0xFF );
+
+extenListBuf.copy( newBuf );
+return true;
+}
+
+
+
+void ClientHello::makeHelloBuf(
+                       CharBuf& outBuf,
+                       TlsMain& tlsMain,
+                       EncryptTls& encryptTls )
+{
+LogCl::trace( "Top of makeHelloBuf." );
+
+CharBuf randBuf;
+CharBuf sessionIDBuf;
+makeRandoms( randBuf, sessionIDBuf, tlsMain );
+
+outBuf.appendCharBuf( randBuf );
+
+outBuf.appendU8( 32 ); // Legacy session ID length.
+outBuf.appendCharBuf( sessionIDBuf );
 
 
 // Appendix B of RFC 8446 for TLS 1.3 shows
@@ -295,30 +566,29 @@ outBuf.appendU8( 0x00 ); // Compression none.
 
 // Extensions go after compression method.
 
-
-// See RFC 7748 Section 6.1 for what is
-// sent here.
-
-Integer k;
-CharBuf privKeyBuf;
-tlsMain.mCurve.makeRandExponentK( k, privKeyBuf );
-
-Integer U;
-U.setFromLong48( 9 );
-
-Integer pubKey;
-tlsMain.mCurve.montLadder1(
-                     pubKey, U, k,
-                     tlsMain.intMath,
-                     tlsMain.mod );
-
-encryptTls.setClientPrivKey( k );
-encryptTls.setClientPubKey( pubKey );
+makeKeyShare( keyShareBuf, encryptTls );
 
 CharBuf extenListBuf;
 extenList.makeClHelloBuf( extenListBuf,
                           tlsMain,
                           encryptTls );
 
+if( offerP256 && !addKeyShare( extenListBuf,
+                       P256::GroupID, p256PubBuf ))
+  {
+  LogCl::warn(
+        "ClientHello couldn't add P-256." );
+  offerP256 = false;
+  }
+
+if( offerMlKem && !addKeyShare( extenListBuf,
+                       MlKem768::HybridGroupID,
+                       mlKemShareBuf ))
+  {
+  LogCl::warn(
+        "ClientHello couldn't add ML-KEM." );
+  offerMlKem = false;
+  }
+
 outBuf.appendCharBuf( extenListBuf );
 }
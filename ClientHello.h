@@ -17,6 +17,8 @@
 #include "../Network/ExtenList.h"
 #include "../Network/TlsMain.h"
 #include "../Network/EncryptTls.h"
+#include "P256.h"
+#include "MlKem768.h"
 
 
 
@@ -26,11 +28,37 @@ class ClientHello
   bool testForCopy = false;
   CharBuf msgBytes;
   ExtenList extenList;
+  // The key share from the last
+  // makeHelloBuf().
+  CharBuf keyShareBuf;
+
+  // A second key share for servers that
+  // only do P-256.
+  bool offerP256 = false;
+  Uint8 p256Priv[P256::ScalarBytes] = { 0 };
+  CharBuf p256PubBuf;
+
+  // The X25519MLKEM768 hybrid share.  The
+  // X25519 private key is kept for the
+  // X25519 half of the hybrid secret.
+  bool offerMlKem = false;
+  Uint8 mlKemDecapKey[MlKem768::DecapKeyBytes] =
+                                         { 0 };
+  Uint8 x25519Priv[32] = { 0 };
+  CharBuf mlKemShareBuf;
+
+  bool addKeyShare( CharBuf& extenListBuf,
+                    const Uint32 group,
+                    const CharBuf& shareBuf );
 
   public:
   ClientHello( void );
   ClientHello( const ClientHello& in );
   ~ClientHello( void );
+
+  // Back to how it was made, with the
+  // buffers it has now.
+  void reset( void );
   Uint32 parseBuffer( const CharBuf& inBuf,
                       TlsMain& tlsmain,
                       EncryptTls& encryptTls );
@@ -39,5 +67,80 @@ class ClientHello
                      TlsMain& tlsMain,
                      EncryptTls& encryptTls );
 
+  // The client random and the legacy
+  // session ID, 32 bytes each.
+  void makeRandoms( CharBuf& randBuf,
+                    CharBuf& sessionIDBuf,
+                    TlsMain& tlsMain );
+
+  // A new X25519 key pair.  It gives back
+  // the 32 public key bytes.  It makes the
+  // P-256 and the ML-KEM key pairs too if
+  // those are offered.
+  void makeKeyShare( CharBuf& pubKeyBuf,
+                     EncryptTls& encryptTls );
+
+  const CharBuf& getKeyShareBuf( void ) const
+    {
+    return keyShareBuf;
+    }
+
+  // HandshakeCl makes the P-256 secret and
+  // KeySched takes it as bytes.
+  void setOfferP256( const bool setTo )
+    {
+    offerP256 = setTo;
+    }
+
+  bool getOfferP256( void ) const
+    {
+    return offerP256;
+    }
+
+  const CharBuf& getP256PubBuf( void ) const
+    {
+    return p256PubBuf;
+    }
+
+  const Uint8* getP256Priv( void ) const
+    {
+    return p256Priv;
+    }
+
+  // The hybrid secret goes to KeySched as
+  // bytes too.
+  void setOfferMlKem( const bool setTo )
+    {
+    offerMlKem = setTo;
+    }
+
+  bool getOfferMlKem( void ) const
+    {
+    return offerMlKem;
+    }
+
+  // The ML-KEM encapsulation key and then
+  // the X25519 public key.
+  const CharBuf& getMlKemShareBuf( void ) const
+    {
+    return mlKemShareBuf;
+    }
+
+  const Uint8* getMlKemDecapKey( void ) const
+    {
+    return mlKemDecapKey;
+    }
+
+  // The X25519 scalar before it is clamped.
+  const Uint8* getX25519Priv( void ) const
+    {
+    return x25519Priv;
+    }
+
+  // For the test vector and a replay, where
+  // the key doesn't come from
+  // makeKeyShare().
+  void setX25519Priv( const Uint8* keyBytes );
+
 
   };
@@ -11,12 +11,114 @@
 #include "ClientTls.h"
 #include "../Network/TlsOuterRec.h"
 #include "../Network/Handshake.h"
+#include "../Network/Results.h"
 #include "../CppBase/Casting.h"
 #include "../CppBase/CharBuf.h"
 
 
 
 
+void ClientTls::reset( void )
+{
+tlsMainCl.reset();
+}
+
+
+
+void ClientTls::setFastOpen( const bool setTo )
+{
+// Set this before startHandshake().
+tlsMainCl.setFastOpen( setTo );
+}
+
+
+
+void ClientTls::setKernelTls( const bool setTo )
+{
+// Set this before startHandshake().
+tlsMainCl.setKernelTls( setTo );
+}
+
+
+
+void ClientTls::setOfferP256( const bool setTo )
+{
+// Set this before startHandshake().
+tlsMainCl.setOfferP256( setTo );
+}
+
+
+
+void ClientTls::setOfferMlKem( const bool setTo )
+{
+// Set this before startHandshake().
+tlsMainCl.setOfferMlKem( setTo );
+}
+
+
+
+void ClientTls::setNonBlocking( const bool setTo )
+{
+// Set this before startHandshake().
+tlsMainCl.setNonBlocking( setTo );
+}
+
+
+
+void ClientTls::setTransport( Transport* setTo )
+{
+// Set this before startHandshake().  The
+// caller owns it.
+tlsMainCl.setTransport( setTo );
+}
+
+
+
+Int32 ClientTls::getPendingOut( void ) const
+{
+// With a non-blocking socket, wait for it to
+// be writable while this is not zero.
+return tlsMainCl.getPendingOut();
+}
+
+
+
+Int32 ClientTls::getSock( void ) const
+{
+// For epoll.  It is -1 if the transport
+// has no socket.
+return tlsMainCl.getSock();
+}
+
+
+
+bool ClientTls::hasIncoming( void )
+{
+// True if there are bytes from the network
+// that haven't been processed yet, so don't
+// wait for the socket.
+return tlsMainCl.hasIncoming();
+}
+
+
+
+bool ClientTls::sendCloseNotify( void )
+{
+try
+{
+return tlsMainCl.sendCloseNotify();
+}
+catch( const char* in )
+  {
+  StIO::putS(
+      "Exception in ClientTls.sendCloseNotify:" );
+  StIO::putS( in );
+  return false;
+  }
+}
+
+
+
 bool ClientTls::startTestVecHandshake(
                         const CharBuf& urlDomain,
                         const CharBuf& port )
@@ -75,3 +177,110 @@ catch( ... )
   return -1;
   }
 }
+
+
+
+bool ClientTls::startFileUpload(
+                      const CharBuf& fileName )
+{
+// The file gets sent by processData() after
+// the handshake is done.
+return tlsMainCl.startFileUpload( fileName );
+}
+
+
+
+bool ClientTls::startFileUploadFd(
+                             const Int32 fd )
+{
+return tlsMainCl.startFileUploadFd( fd );
+}
+
+
+
+void ClientTls::setUploadProgress(
+                     UploadProgress callBack,
+                     void* context )
+{
+tlsMainCl.setUploadProgress( callBack,
+                             context );
+}
+
+
+
+bool ClientTls::uploadIsActive( void ) const
+{
+return tlsMainCl.uploadIsActive();
+}
+
+
+
+void ClientTls::setAppSink( AppSink* setTo )
+{
+// Decrypted data goes to this sink instead
+// of to the appInBuf in processData().
+tlsMainCl.setAppSink( setTo );
+}
+
+
+
+void ClientTls::setParallelDecrypt(
+                     const Int32 howManyThreads )
+{
+// For one big download.  Zero turns it off.
+tlsMainCl.setParallelDecrypt( howManyThreads );
+}
+
+
+
+bool ClientTls::isHandshakeDone( void )
+{
+return tlsMainCl.isHandshakeDone();
+}
+
+
+
+Int64 ClientTls::getHsPhaseNs(
+                      const Int32 phase ) const
+{
+// For this connection's last handshake.
+return tlsMainCl.getHsPhaseNs( phase );
+}
+
+
+
+void ClientTls::getTrafficSnap(
+                      TrafficSnap& snap ) const
+{
+tlsMainCl.getTrafficSnap( snap );
+}
+
+
+
+Int32 ClientTls::getPeerCertLast( void ) const
+{
+return tlsMainCl.getPeerCertLast();
+}
+
+
+
+bool ClientTls::getPeerCert( const Int32 which,
+                             CertView& cert ) const
+{
+if( (which < 0) ||
+    (which >= tlsMainCl.getPeerCertLast()))
+  return false;
+
+return tlsMainCl.getPeerCert( which, cert ) ==
+                                 Results::Done;
+}
+
+
+
+void ClientTls::setCapture( RecCapture* setTo )
+{
+// Everything this connection sends and
+// gets goes in to the capture file.  The
+// file has the key exchange secret in it.
+tlsMainCl.setCapture( setTo );
+}
@@ -44,6 +44,21 @@ class ClientTls
     {
     }
 
+  // Ready for a new connection, with the
+  // same buffers.  SessionPool uses it.
+  void reset( void );
+
+  void setFastOpen( const bool setTo );
+  void setKernelTls( const bool setTo );
+  void setOfferP256( const bool setTo );
+  void setOfferMlKem( const bool setTo );
+  void setNonBlocking( const bool setTo );
+  void setTransport( Transport* setTo );
+  Int32 getPendingOut( void ) const;
+  Int32 getSock( void ) const;
+  bool hasIncoming( void );
+  bool sendCloseNotify( void );
+
   bool startHandshake(
                    const CharBuf& urlDomain,
                    const CharBuf& port );
@@ -55,4 +70,36 @@ class ClientTls
   Int32 processData( CircleBuf& appOutBuf,
                      CircleBuf& appInBuf );
 
+  bool startFileUpload(
+                      const CharBuf& fileName );
+  bool startFileUploadFd( const Int32 fd );
+  void setUploadProgress(
+                     UploadProgress callBack,
+                     void* context );
+  bool uploadIsActive( void ) const;
+
+  void setAppSink( AppSink* setTo );
+  void setParallelDecrypt(
+                     const Int32 howManyThreads );
+
+  bool isHandshakeDone( void );
+
+  // The phases are in HsTiming.h.  The
+  // histograms for the whole process are
+  // HsTiming::getHisto().
+  Int64 getHsPhaseNs( const Int32 phase ) const;
+
+  // The totals for the process are in
+  // TrafficStats::getTotalSnap() and
+  // TrafficStats::makePromText().
+  void getTrafficSnap( TrafficSnap& snap ) const;
+
+  // After the Certificate message has come.
+  // The end-entity certificate is 0.
+  Int32 getPeerCertLast( void ) const;
+  bool getPeerCert( const Int32 which,
+                    CertView& cert ) const;
+
+  void setCapture( RecCapture* setTo );
+
   };
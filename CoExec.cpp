@@ -0,0 +1,171 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "CoExec.h"
+#include "LogCl.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+
+
+
+CoExec::~CoExec( void )
+{
+if( epollFd >= 0 )
+  ::close( epollFd );
+
+}
+
+
+
+bool CoExec::setup( void )
+{
+if( epollFd >= 0 )
+  return true;
+
+epollFd = ::epoll_create1( EPOLL_CLOEXEC );
+if( epollFd < 0 )
+  {
+  LogCl::error( "CoExec epoll_create1 failed." );
+  return false;
+  }
+
+return true;
+}
+
+
+
+void CoExec::FdWait::await_suspend(
+              std::coroutine_handle<> caller )
+{
+node.handle = caller;
+node.next = nullptr;
+
+if( fd < 0 )
+  {
+  exec->post( &node );
+  return;
+  }
+
+exec->startWait( &node, fd, events, result );
+}
+
+
+
+void CoExec::post( CoWait* node )
+{
+node->next = nullptr;
+if( readyLast == nullptr )
+  {
+  readyFirst = node;
+  readyLast = node;
+  return;
+  }
+
+readyLast->next = node;
+readyLast = node;
+}
+
+
+
+void CoExec::startWait( CoWait* node,
+                        const Int32 fd,
+                        const Uint32 events,
+                        bool& result )
+{
+epoll_event event;
+event.events = events | EPOLLONESHOT;
+event.data.ptr = node;
+
+// The fd stays in the epoll set after the
+// first time, so it is usually MOD.
+Int32 status = ::epoll_ctl( epollFd,
+                     EPOLL_CTL_MOD, fd, &event );
+if( (status != 0) && (errno == ENOENT))
+  status = ::epoll_ctl( epollFd,
+                     EPOLL_CTL_ADD, fd, &event );
+
+if( status != 0 )
+  {
+  LogCl::error( "CoExec epoll_ctl failed." );
+  result = false;
+  post( node );
+  return;
+  }
+
+result = true;
+waiting++;
+}
+
+
+
+bool CoExec::run( void )
+{
+if( !setup())
+  return false;
+
+epoll_event events[MaxEvents];
+
+for( ;; )
+  {
+  // Take the list as it is now.  The ones
+  // that get posted while these run go on
+  // the next time around, so a coroutine
+  // that yields can't starve epoll.
+  CoWait* node = readyFirst;
+  readyFirst = nullptr;
+  readyLast = nullptr;
+
+  while( node != nullptr )
+    {
+    CoWait* next = node->next;
+    // The node is gone after this.
+    node->handle.resume();
+    node = next;
+    }
+
+  if( liveTasks == 0 )
+    return true;
+
+  const bool haveReady = readyFirst != nullptr;
+  if( !haveReady && (waiting == 0))
+    {
+    LogCl::error(
+          "CoExec has tasks nothing can wake." );
+    return false;
+    }
+
+  Int32 howMany = ::epoll_wait( epollFd, events,
+                         MaxEvents,
+                         haveReady ? 0 : -1 );
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    LogCl::error( "CoExec epoll_wait failed." );
+    return false;
+    }
+
+  for( Int32 count = 0; count < howMany; count++ )
+    {
+    waiting--;
+    post( static_cast<CoWait*>(
+                      events[count].data.ptr ));
+    }
+  }
+}
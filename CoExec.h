@@ -0,0 +1,164 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// A small executor for CoTask coroutines.
+// One thread calls run() and every coroutine
+// that was spawned on it runs on that
+// thread.  So thousands of connections can
+// be in flight with no thread for each one.
+
+// A coroutine that has to wait for a socket
+// does co_await waitFd().  That adds the
+// socket to epoll with EPOLLONESHOT and the
+// coroutine gets resumed when epoll says it
+// is ready.  It is not polled.
+
+// The coroutines that are ready to run are
+// on a linked list.  The list nodes are in
+// the awaiters, which are in the coroutine
+// frames while they are suspended, so
+// nothing gets allocated for a wait.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "CoTask.h"
+
+#include <coroutine>
+
+
+
+class CoExec;
+
+
+
+class CoWait
+  {
+  public:
+  std::coroutine_handle<> handle;
+  CoWait* next = nullptr;
+  };
+
+
+
+class CoExec
+  {
+  private:
+  bool testForCopy = false;
+  Int32 epollFd = -1;
+  CoWait* readyFirst = nullptr;
+  CoWait* readyLast = nullptr;
+  Int32 liveTasks = 0;
+  Int32 waiting = 0;
+
+  static const Int32 MaxEvents = 256;
+
+  public:
+  // co_await exec.waitFd( sock, EPOLLIN ).
+  // It is true if the socket is ready, or
+  // false if epoll wouldn't take it.  An fd
+  // of -1 just lets the others run first.
+  class FdWait
+    {
+    private:
+    CoExec* exec;
+    Int32 fd;
+    Uint32 events;
+    bool result = true;
+    CoWait node;
+
+    public:
+    FdWait( CoExec* setExec,
+            const Int32 setFd,
+            const Uint32 setEvents )
+      {
+      exec = setExec;
+      fd = setFd;
+      events = setEvents;
+      }
+
+    bool await_ready( void ) noexcept
+      {
+      return false;
+      }
+
+    void await_suspend(
+              std::coroutine_handle<> caller );
+
+    bool await_resume( void ) noexcept
+      {
+      return result;
+      }
+    };
+
+  CoExec( void )
+    {
+    }
+
+  CoExec( const CoExec& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "CoExec copy constructor.";
+    }
+
+  ~CoExec( void );
+
+  bool setup( void );
+
+  // It starts right away and runs until it
+  // first waits.  The executor owns it
+  // after that.
+  template <typename T>
+  void spawn( CoTask<T>&& task )
+    {
+    std::coroutine_handle<
+        typename CoTask<T>::promise_type> handle =
+                                   task.release();
+    handle.promise().detached = true;
+    handle.promise().liveCount = &liveTasks;
+    liveTasks++;
+    handle.resume();
+    }
+
+  FdWait waitFd( const Int32 fd,
+                 const Uint32 events )
+    {
+    return FdWait( this, fd, events );
+    }
+
+  FdWait yield( void )
+    {
+    return FdWait( this, -1, 0 );
+    }
+
+  void post( CoWait* node );
+  void startWait( CoWait* node,
+                  const Int32 fd,
+                  const Uint32 events,
+                  bool& result );
+
+  // Runs until every spawned coroutine is
+  // done.  It returns false if some are
+  // still there but none of them can ever
+  // be resumed.
+  bool run( void );
+
+  Int32 getLiveTasks( void ) const
+    {
+    return liveTasks;
+    }
+
+  };
@@ -0,0 +1,178 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A C++20 coroutine that returns a value.
+// It doesn't start until something does
+// co_await on it, and then that caller gets
+// resumed when it is done.  So a chain of
+// them runs on whatever thread resumes the
+// bottom one, which is the CoExec thread.
+
+// A top level one is given to
+// CoExec::spawn() and it deletes itself
+// when it is done.
+
+// T can't be void.  Use Int32 or bool.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+#include <coroutine>
+#include <exception>
+
+
+
+template <typename T>
+class CoTask
+  {
+  public:
+  class promise_type
+    {
+    public:
+    T value{};
+    std::coroutine_handle<> continuation;
+    bool detached = false;
+    Int32* liveCount = nullptr;
+    std::exception_ptr error;
+
+    CoTask get_return_object( void )
+      {
+      return CoTask( std::coroutine_handle<
+                promise_type>::from_promise( *this ));
+      }
+
+    std::suspend_always initial_suspend(
+                               void ) noexcept
+      {
+      return {};
+      }
+
+    class FinalAwaiter
+      {
+      public:
+      bool await_ready( void ) noexcept
+        {
+        return false;
+        }
+
+      std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<
+                       promise_type> handle ) noexcept
+        {
+        promise_type& promise = handle.promise();
+        if( promise.continuation )
+          return promise.continuation;
+
+        if( promise.detached )
+          {
+          if( promise.liveCount != nullptr )
+            (*promise.liveCount)--;
+
+          handle.destroy();
+          }
+
+        return std::noop_coroutine();
+        }
+
+      void await_resume( void ) noexcept
+        {
+        }
+      };
+
+    FinalAwaiter final_suspend( void ) noexcept
+      {
+      return {};
+      }
+
+    void return_value( T setTo )
+      {
+      value = setTo;
+      }
+
+    void unhandled_exception( void )
+      {
+      // The one that is waiting for it gets
+      // it.  A top level one has nobody to
+      // give it to.
+      if( detached )
+        std::terminate();
+
+      error = std::current_exception();
+      }
+    };
+
+  private:
+  std::coroutine_handle<promise_type> handle;
+
+  explicit CoTask( std::coroutine_handle<
+                        promise_type> setTo )
+    {
+    handle = setTo;
+    }
+
+  public:
+  CoTask( CoTask&& in ) noexcept
+    {
+    handle = in.handle;
+    in.handle = nullptr;
+    }
+
+  CoTask( const CoTask& in ) = delete;
+  CoTask& operator=( const CoTask& in ) = delete;
+
+  ~CoTask( void )
+    {
+    if( handle )
+      handle.destroy();
+
+    }
+
+  // CoExec::spawn() takes it from here.
+  std::coroutine_handle<promise_type> release(
+                                        void )
+    {
+    std::coroutine_handle<promise_type> result =
+                                       handle;
+    handle = nullptr;
+    return result;
+    }
+
+  bool await_ready( void ) noexcept
+    {
+    return false;
+    }
+
+  std::coroutine_handle<> await_suspend(
+              std::coroutine_handle<> caller )
+    {
+    handle.promise().continuation = caller;
+    return handle;
+    }
+
+  T await_resume( void )
+    {
+    if( handle.promise().error )
+      std::rethrow_exception(
+                    handle.promise().error );
+
+    return handle.promise().value;
+    }
+
+  };
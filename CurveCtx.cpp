@@ -0,0 +1,113 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "CurveCtx.h"
+
+#include <mutex>
+
+
+
+static Integer baseU;
+static std::once_flag baseUOnce;
+
+static thread_local CurveCtx threadCtx;
+
+
+
+static void setBaseU( void )
+{
+baseU.setFromLong48( 9 );
+}
+
+
+
+CurveCtx& CurveCtx::forThread( void )
+{
+return threadCtx;
+}
+
+
+
+void CurveCtx::privKeyToInt( const Uint8* keyBytes,
+                             Integer& k )
+{
+CharBuf keyBuf;
+for( Int32 count = 0; count < 32; count++ )
+  keyBuf.appendU8( keyBytes[count] );
+
+ByteArray cArray;
+keyBuf.copyToCharArray( cArray );
+
+CurveCtx& ctx = forThread();
+ctx.mCurve.clampK( cArray );
+ctx.mCurve.cArrayToInt( cArray, k );
+
+// Both of these have the private key in
+// them.  ByteArray can only be written
+// from a CharBuf, so zero keyBuf and copy
+// it over cArray.
+for( Int32 count = 0; count < 32; count++ )
+  keyBuf.setU8( count, 0 );
+
+keyBuf.copyToCharArray( cArray );
+keyBuf.clear();
+}
+
+
+
+void CurveCtx::bytesToInt( const Uint8* bytes,
+                           Integer& result )
+{
+CharBuf uBuf;
+for( Int32 count = 0; count < 32; count++ )
+  uBuf.appendU8( bytes[count] );
+
+ByteArray cArray;
+uBuf.copyToCharArray( cArray );
+forThread().mCurve.cArrayToInt( cArray, result );
+}
+
+
+
+void CurveCtx::baseMult( Integer& pubKey,
+                         const Integer& k )
+{
+std::call_once( baseUOnce, setBaseU );
+ladder( pubKey, baseU, k );
+}
+
+
+
+void CurveCtx::ladder( Integer& result,
+                       const Integer& uCoord,
+                       const Integer& k )
+{
+CurveCtx& ctx = forThread();
+ctx.mCurve.montLadder1( result, uCoord, k,
+                        ctx.intMath, ctx.mod );
+}
+
+
+
+void CurveCtx::intToBytes( const Integer& uCoord,
+                           CharBuf& toAdd )
+{
+CurveCtx& ctx = forThread();
+ByteArray cArray;
+ctx.mCurve.uCoordTo32Bytes( uCoord, cArray,
+                            ctx.mod, ctx.intMath );
+toAdd.appendCharArray( cArray, 32 );
+}
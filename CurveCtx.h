@@ -0,0 +1,104 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// X25519 for the client without a TlsMain.
+
+// IntegerMath, Mod and MCurve keep scratch
+// numbers in them while they work, so two
+// threads can't use the same ones at the
+// same time.  But one connection doesn't
+// need its own either.  Each thread has one
+// set of them, made the first time that
+// thread uses this, and every connection on
+// that thread uses it.  The base point
+// never changes after it is set, so there
+// is one for the whole process and any
+// thread can read it.
+
+// The client does all of its X25519 math
+// here, the key share and the shared
+// secret.  TlsMain in ../Network still has
+// a set in it, since the server uses them,
+// but the client never touches it.
+// MicroBench montladder times the ladder
+// both ways.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "../CppInt/Integer.h"
+#include "../CppInt/IntegerMath.h"
+#include "../CppInt/Mod.h"
+#include "../CryptoBase/MCurve.h"
+
+
+
+class CurveCtx
+  {
+  private:
+  bool testForCopy = false;
+  IntegerMath intMath;
+  Mod mod;
+  MCurve mCurve;
+
+  static CurveCtx& forThread( void );
+
+  public:
+  // The NamedGroup for x25519.
+  static const Uint32 GroupID = 0x001D;
+
+  CurveCtx( void )
+    {
+    }
+
+  CurveCtx( const CurveCtx& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "CurveCtx copy constructor.";
+    }
+
+  ~CurveCtx( void )
+    {
+    }
+
+  // 32 bytes clamped like RFC 7748 Section 5
+  // says.
+  static void privKeyToInt( const Uint8* keyBytes,
+                            Integer& k );
+
+  // 32 little endian bytes of a u coordinate.
+  static void bytesToInt( const Uint8* bytes,
+                          Integer& result );
+
+  // k times the base point, U = 9.
+  static void baseMult( Integer& pubKey,
+                        const Integer& k );
+
+  static void ladder( Integer& result,
+                      const Integer& uCoord,
+                      const Integer& k );
+
+  // It appends the 32 bytes.
+  static void intToBytes( const Integer& uCoord,
+                          CharBuf& toAdd );
+
+  };
@@ -0,0 +1,280 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "DecryptPool.h"
+#include "../Network/TlsOuterRec.h"
+#include "../CppBase/StIO.h"
+
+#include <string.h>
+
+
+
+void DecryptPool::start(
+                     const Int32 howManyThreads,
+                     const CharBuf& key,
+                     const CharBuf& iv,
+                     const Uint64 startSeq )
+{
+if( started )
+  return;
+
+if( (key.getLast() != AesGcm::KeySize) ||
+    (iv.getLast() != AesGcm::IVSize))
+  throw "DecryptPool key size is not right.";
+
+Uint8 keyBytes[AesGcm::KeySize];
+Uint8 ivBytes[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  keyBytes[count] = key.getU8( count );
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  ivBytes[count] = iv.getU8( count );
+
+aesGcm.setKey( keyBytes, ivBytes );
+
+::explicit_bzero( keyBytes, sizeof( keyBytes ));
+::explicit_bzero( ivBytes, sizeof( ivBytes ));
+
+// The slots from a connection before this
+// one get used again.
+if( slots == nullptr )
+  slots = new DecryptSlot[SlotCount];
+
+for( Int32 count = 0; count < SlotCount; count++ )
+  slots[count].state.store( DecryptSlot::Free,
+                            std::memory_order_relaxed );
+
+nextSeq = startSeq;
+fillIndex = 0;
+drainIndex = 0;
+inFlight = 0;
+published.store( 0 );
+claimed.store( 0 );
+idleWorkers.store( 0 );
+ioWaiting.store( false );
+stopping.store( false );
+
+threadCount = howManyThreads;
+if( threadCount < 1 )
+  threadCount = 1;
+
+workers = new std::thread[threadCount];
+for( Int32 count = 0; count < threadCount;
+                                     count++ )
+  workers[count] = std::thread(
+               &DecryptPool::workerLoop, this );
+
+started = true;
+}
+
+
+
+void DecryptPool::stop( void )
+{
+if( !started )
+  return;
+
+std::unique_lock<std::mutex> lock( waitMutex );
+stopping.store( true );
+lock.unlock();
+
+jobCond.notify_all();
+
+for( Int32 count = 0; count < threadCount;
+                                     count++ )
+  workers[count].join();
+
+delete[] workers;
+workers = nullptr;
+threadCount = 0;
+started = false;
+
+aesGcm.clearKey();
+}
+
+
+
+void DecryptPool::workerLoop( void )
+{
+// The atomics here are all seq_cst.  A
+// side that is about to sleep sets its
+// flag and then looks again, and the
+// other side changes the state and then
+// reads the flag, so one of them always
+// sees the other.
+
+for( ;; )
+  {
+  Uint64 job = claimed.load();
+  if( job < published.load())
+    {
+    if( !claimed.compare_exchange_weak( job,
+                                        job + 1 ))
+      continue;
+
+    DecryptSlot& slot = slots[job % SlotCount];
+    const Int32 last = slot.cipherBuf.getLast();
+    for( Int32 count = 0; count < last; count++ )
+      slot.cipher[count] =
+                   slot.cipherBuf.getU8( count );
+
+    bool good = aesGcm.open( slot.seqNum,
+                             slot.header, 5,
+                             slot.cipher,
+                             slot.cipherLen,
+                             slot.plain );
+
+    slot.plainBuf.clear();
+    if( good )
+      {
+      const Int32 plainLast = slot.cipherLen -
+                                 AesGcm::TagSize;
+      for( Int32 count = 0; count < plainLast;
+                                       count++ )
+        slot.plainBuf.appendU8(
+                             slot.plain[count] );
+
+      }
+
+    slot.state.store( good ? DecryptSlot::Done :
+                             DecryptSlot::Bad );
+
+    if( ioWaiting.load())
+      {
+      // Take the lock so waitNext() can't
+      // miss this.
+      std::unique_lock<std::mutex> lock(
+                                    waitMutex );
+      lock.unlock();
+      doneCond.notify_one();
+      }
+
+    continue;
+    }
+
+  std::unique_lock<std::mutex> lock( waitMutex );
+  idleWorkers.fetch_add( 1 );
+  jobCond.wait( lock, [this]
+         { return stopping.load() || hasJob(); } );
+
+  idleWorkers.fetch_sub( 1 );
+  if( stopping.load())
+    return;
+
+  }
+}
+
+
+
+void DecryptPool::submit(
+                     const CharBuf& recordBytes )
+{
+// recordBytes is the record without the
+// five byte header.
+
+if( !canTake())
+  throw "DecryptPool submit when it is full.";
+
+const Int32 last = recordBytes.getLast();
+if( last > DecryptSlot::MaxCipherLen )
+  throw "DecryptPool record is too long.";
+
+DecryptSlot& slot = slots[fillIndex];
+
+// The header is the additional data.
+slot.header[0] = TlsOuterRec::ApplicationData;
+slot.header[1] = 3;
+slot.header[2] = 3;
+slot.header[3] = static_cast<Uint8>( last >> 8 );
+slot.header[4] = static_cast<Uint8>( last );
+
+slot.cipherBuf.copy( recordBytes );
+slot.cipherLen = last;
+slot.seqNum = nextSeq;
+nextSeq++;
+
+slot.state.store( DecryptSlot::Filled,
+                  std::memory_order_relaxed );
+
+published.fetch_add( 1 );
+
+// Only lock if a worker is asleep.
+if( idleWorkers.load() > 0 )
+  {
+  std::unique_lock<std::mutex> lock( waitMutex );
+  lock.unlock();
+  jobCond.notify_one();
+  }
+
+fillIndex = (fillIndex + 1) % SlotCount;
+inFlight++;
+}
+
+
+
+Int32 DecryptPool::peekNext(
+                      const CharBuf*& plainBuf )
+{
+if( inFlight == 0 )
+  return 0;
+
+DecryptSlot& slot = slots[drainIndex];
+Int32 state = slot.state.load(
+                     std::memory_order_acquire );
+
+if( state == DecryptSlot::Filled )
+  return 0;
+
+if( state == DecryptSlot::Bad )
+  return -1;
+
+plainBuf = &slot.plainBuf;
+return 1;
+}
+
+
+
+void DecryptPool::releaseNext( void )
+{
+if( inFlight == 0 )
+  throw "DecryptPool releaseNext when empty.";
+
+slots[drainIndex].state.store( DecryptSlot::Free,
+                        std::memory_order_relaxed );
+
+drainIndex = (drainIndex + 1) % SlotCount;
+inFlight--;
+}
+
+
+
+void DecryptPool::waitNext( void )
+{
+if( inFlight == 0 )
+  return;
+
+DecryptSlot& slot = slots[drainIndex];
+
+std::unique_lock<std::mutex> lock( waitMutex );
+ioWaiting.store( true );
+doneCond.wait( lock, [&slot]
+       { return slot.state.load() !=
+                DecryptSlot::Filled; } );
+
+ioWaiting.store( false );
+}
@@ -0,0 +1,194 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Each TLS 1.3 record has its own nonce
+// that comes from its sequence number, so
+// the records in one connection can be
+// decrypted at the same time on different
+// cores.
+
+// The I/O thread frames the records and gives
+// each one the next sequence number.  It puts
+// them in a ring of slots.  The worker
+// threads decrypt the slots in any order.
+// Then the I/O thread takes them out of the
+// ring in sequence number order, so the app
+// gets the plain text in the right order.
+
+// If the ring is full, the I/O thread
+// leaves the rest of the bytes where they
+// are until a slot is free.
+
+// The I/O thread only does one copy in to a
+// slot and none out of it.  The byte at a
+// time copies between the CharBufs and the
+// arrays that AesGcm works on are done by
+// the workers.  A worker takes the next job
+// with an atomic counter, and the mutex is
+// only used when a worker or the I/O thread
+// has to sleep.
+
+// MicroBench "pardecrypt" checks the order
+// and the sequence numbers and times it.
+
+// A KeyUpdate from the server changes the
+// keys for the records after it, and those
+// might already be decrypted with the old
+// keys.  So this can't be used with
+// KeyUpdate.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "AesGcm.h"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+
+class DecryptSlot
+  {
+  public:
+  // A TLS 1.3 record can be 2^14 + 256 bytes.
+  static const Int32 MaxCipherLen =
+                           (1024 * 16) + 256;
+
+  static const Int32 Free = 0;
+  static const Int32 Filled = 1;
+  static const Int32 Done = 2;
+  static const Int32 Bad = 3;
+
+  std::atomic<Int32> state{ Free };
+  Uint64 seqNum = 0;
+  Int32 cipherLen = 0;
+  Uint8 header[5] = { 0 };
+
+  // The I/O thread copies the record in to
+  // cipherBuf.  The worker fills plainBuf
+  // and the I/O thread reads it from here.
+  CharBuf cipherBuf;
+  CharBuf plainBuf;
+
+  // What AesGcm works on.
+  Uint8 cipher[MaxCipherLen] = { 0 };
+  Uint8 plain[MaxCipherLen] = { 0 };
+  };
+
+
+
+class DecryptPool
+  {
+  private:
+  static const Int32 SlotCount = 64;
+
+  bool testForCopy = false;
+  AesGcm aesGcm;
+  bool started = false;
+  Uint64 nextSeq = 0;
+  Int32 threadCount = 0;
+  std::thread* workers = nullptr;
+  DecryptSlot* slots = nullptr;
+
+  // These are only used by the I/O thread.
+  Int32 fillIndex = 0;
+  Int32 drainIndex = 0;
+  Int32 inFlight = 0;
+
+  // Slots are filled in order, so job n is
+  // in slot n % SlotCount.  The I/O thread
+  // adds to published and the workers take
+  // jobs by adding to claimed.
+  std::atomic<Uint64> published{ 0 };
+  std::atomic<Uint64> claimed{ 0 };
+
+  // So the other side only locks and
+  // notifies when somebody is asleep.
+  std::atomic<Int32> idleWorkers{ 0 };
+  std::atomic<bool> ioWaiting{ false };
+  std::atomic<bool> stopping{ false };
+
+  std::mutex waitMutex;
+  std::condition_variable jobCond;
+  std::condition_variable doneCond;
+
+  void workerLoop( void );
+  bool hasJob( void ) const
+    {
+    return claimed.load() < published.load();
+    }
+
+  public:
+  DecryptPool( void )
+    {
+    }
+
+  DecryptPool( const DecryptPool& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "DecryptPool copy constructor.";
+    }
+
+  ~DecryptPool( void )
+    {
+    stop();
+    delete[] slots;
+    }
+
+  void start( const Int32 howManyThreads,
+              const CharBuf& key,
+              const CharBuf& iv,
+              const Uint64 startSeq );
+
+  // It keeps the slots for the next start().
+  void stop( void );
+
+  bool isStarted( void ) const
+    {
+    return started;
+    }
+
+  bool canTake( void ) const
+    {
+    return inFlight < SlotCount;
+    }
+
+  bool hasPending( void ) const
+    {
+    return inFlight > 0;
+    }
+
+  void submit( const CharBuf& recordBytes );
+
+  // Returns 1 if the next record in order is
+  // done and plainBuf points to it, 0 if it
+  // isn't done yet, and -1 if it didn't
+  // decrypt.  plainBuf is good until
+  // releaseNext().
+  Int32 peekNext( const CharBuf*& plainBuf );
+  void releaseNext( void );
+
+  void waitNext( void );
+
+  };
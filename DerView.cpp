@@ -0,0 +1,201 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "DerView.h"
+
+
+
+void DerView::setView( const CharBuf& setBuf,
+                       const Int32 setStart,
+                       const Int32 setLast )
+{
+if( (setStart < 0) || (setStart > setLast) ||
+    (setLast > setBuf.getLast()))
+  throw "DerView setView is out of range.";
+
+buf = &setBuf;
+start = setStart;
+last = setLast;
+}
+
+
+
+bool DerView::peekTag( Uint8& tag ) const
+{
+if( isEmpty())
+  return false;
+
+tag = buf->getU8( start );
+return true;
+}
+
+
+
+bool DerView::next( Uint8& tag,
+                    DerView& content )
+{
+DerView whole;
+return next( tag, content, whole );
+}
+
+
+
+bool DerView::next( Uint8& tag,
+                    DerView& content,
+                    DerView& whole )
+{
+// X.690 Section 8.1 and 10.1.
+
+if( (last - start) < 2 )
+  return false;
+
+Int32 where = start;
+tag = buf->getU8( where );
+where++;
+
+// The high tag number form isn't used in
+// anything a client reads.
+if( (tag & 0x1F) == 0x1F )
+  return false;
+
+Int32 length = buf->getU8( where );
+where++;
+
+if( length > 0x7F )
+  {
+  // Indefinite is 0x80 and DER doesn't
+  // allow it.  Three length bytes is more
+  // than a certificate message can hold.
+  const Int32 lengthBytes = length & 0x7F;
+  if( (lengthBytes == 0) || (lengthBytes > 3))
+    return false;
+
+  if( (last - where) < lengthBytes )
+    return false;
+
+  length = 0;
+  for( Int32 count = 0; count < lengthBytes;
+                                     count++ )
+    {
+    length = (length << 8) | buf->getU8( where );
+    where++;
+    }
+
+  // The fewest bytes, like DER says.
+  if( length < 0x80 )
+    return false;
+
+  if( (lengthBytes > 1) &&
+      (length < (1 << (8 * (lengthBytes - 1)))))
+    return false;
+
+  }
+
+if( length > (last - where))
+  return false;
+
+content.buf = buf;
+content.start = where;
+content.last = where + length;
+
+whole.buf = buf;
+whole.start = start;
+whole.last = where + length;
+
+start = where + length;
+return true;
+}
+
+
+
+bool DerView::nextTag( const Uint8 wantTag,
+                       DerView& content )
+{
+Uint8 tag = 0;
+if( !peekTag( tag ))
+  return false;
+
+if( tag != wantTag )
+  return false;
+
+return next( tag, content );
+}
+
+
+
+bool DerView::nextIfTag( const Uint8 wantTag,
+                         DerView& content,
+                         bool& found )
+{
+found = false;
+
+Uint8 tag = 0;
+if( !peekTag( tag ))
+  return true;
+
+if( tag != wantTag )
+  return true;
+
+found = true;
+return next( tag, content );
+}
+
+
+
+bool DerView::skip( void )
+{
+Uint8 tag = 0;
+DerView content;
+return next( tag, content );
+}
+
+
+
+bool DerView::dropFront( const Int32 howMany )
+{
+if( (howMany < 0) || (howMany > (last - start)))
+  return false;
+
+start += howMany;
+return true;
+}
+
+
+
+bool DerView::isEqual( const Uint8* bytes,
+                       const Int32 howMany ) const
+{
+if( howMany != (last - start))
+  return false;
+
+for( Int32 count = 0; count < howMany; count++ )
+  {
+  if( buf->getU8( start + count ) != bytes[count] )
+    return false;
+
+  }
+
+return true;
+}
+
+
+
+void DerView::copyTo( CharBuf& toAdd ) const
+{
+for( Int32 count = start; count < last; count++ )
+  toAdd.appendU8( buf->getU8( count ));
+
+}
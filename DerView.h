@@ -0,0 +1,144 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A DER reader that doesn't copy anything.
+
+// A DerView is a range of bytes in a CharBuf
+// that somebody else owns.  next() reads
+// the tag and the length of the first
+// element and gives back a view of its
+// contents, then this view starts after it.
+// So a certificate gets walked one level at
+// a time, and only the parts that are asked
+// for get looked at.
+
+// The CharBuf has to stay the same while a
+// view of it is used.
+
+// It only takes DER: definite lengths in the
+// fewest bytes, and tags that fit in one
+// byte.  Anything else is false.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class DerView
+  {
+  private:
+  const CharBuf* buf = nullptr;
+  Int32 start = 0;
+  // One past the last byte.
+  Int32 last = 0;
+
+  public:
+  static const Uint8 TagBoolean = 0x01;
+  static const Uint8 TagInteger = 0x02;
+  static const Uint8 TagBitString = 0x03;
+  static const Uint8 TagOctetString = 0x04;
+  static const Uint8 TagNull = 0x05;
+  static const Uint8 TagOid = 0x06;
+  static const Uint8 TagUtf8String = 0x0C;
+  static const Uint8 TagPrintable = 0x13;
+  static const Uint8 TagIa5String = 0x16;
+  static const Uint8 TagUtcTime = 0x17;
+  static const Uint8 TagGenTime = 0x18;
+  static const Uint8 TagSequence = 0x30;
+  static const Uint8 TagSet = 0x31;
+
+  // Context specific and constructed, like
+  // the [0] version and the [3] extensions.
+  static const Uint8 TagContext0 = 0xA0;
+  static const Uint8 TagContext3 = 0xA3;
+
+  // Context specific and primitive, like
+  // the dNSName in subjectAltName.
+  static const Uint8 TagImplicit2 = 0x82;
+
+  void setView( const CharBuf& setBuf,
+                const Int32 setStart,
+                const Int32 setLast );
+
+  void clear( void )
+    {
+    buf = nullptr;
+    start = 0;
+    last = 0;
+    }
+
+  bool isEmpty( void ) const
+    {
+    return start >= last;
+    }
+
+  Int32 getLength( void ) const
+    {
+    return last - start;
+    }
+
+  // Where it starts in the CharBuf.
+  Int32 getStart( void ) const
+    {
+    return start;
+    }
+
+  Uint8 getU8( const Int32 where ) const
+    {
+    return buf->getU8( start + where );
+    }
+
+  bool peekTag( Uint8& tag ) const;
+
+  // The first element.  content is what is
+  // inside it and whole has the tag and
+  // length bytes too.
+  bool next( Uint8& tag, DerView& content );
+  bool next( Uint8& tag, DerView& content,
+             DerView& whole );
+
+  // The same as next() but it has to be
+  // wantTag.
+  bool nextTag( const Uint8 wantTag,
+                DerView& content );
+
+  // If the first element is wantTag then it
+  // reads it and found is true.  If not it
+  // leaves it there.  For the OPTIONAL and
+  // DEFAULT parts.
+  bool nextIfTag( const Uint8 wantTag,
+                  DerView& content,
+                  bool& found );
+
+  bool skip( void );
+
+  // For bytes in front that aren't DER, like
+  // the unused bits byte of a BIT STRING.
+  bool dropFront( const Int32 howMany );
+
+  bool isEqual( const Uint8* bytes,
+                const Int32 howMany ) const;
+
+  // For the few times a caller needs to own
+  // the bytes.
+  void copyTo( CharBuf& toAdd ) const;
+
+  };
@@ -0,0 +1,309 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "FileSend.h"
+#include "LogCl.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+
+
+
+bool FileSend::openPath( const CharBuf& fileName )
+{
+closeFile();
+
+char pathName[4096];
+const Int32 last = fileName.getLast();
+if( last >= 4096 )
+  throw "FileSend file name is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  pathName[count] = static_cast<char>(
+                       fileName.getU8( count ));
+
+pathName[last] = 0;
+
+fileHandle = ::open( pathName,
+                     O_RDONLY | O_CLOEXEC );
+if( fileHandle < 0 )
+  {
+  LogCl::error( "FileSend could not open file." );
+  return false;
+  }
+
+ownsHandle = true;
+return setup();
+}
+
+
+
+bool FileSend::openHandle( const Int32 fd )
+{
+// The caller still owns the handle.
+
+closeFile();
+if( fd < 0 )
+  return false;
+
+fileHandle = fd;
+ownsHandle = false;
+return setup();
+}
+
+
+
+bool FileSend::setup( void )
+{
+struct stat fileStat;
+if( ::fstat( fileHandle, &fileStat ) != 0 )
+  {
+  closeFile();
+  return false;
+  }
+
+// st_size is zero for a pipe or a socket,
+// so it would look like an empty file that
+// got sent.
+if( !S_ISREG( fileStat.st_mode ))
+  {
+  LogCl::error( "FileSend needs a regular file." );
+  closeFile();
+  return false;
+  }
+
+total = fileStat.st_size;
+position = 0;
+
+if( total == 0 )
+  return true;
+
+void* mapPoint = ::mmap( nullptr,
+                 static_cast<size_t>( total ),
+                 PROT_READ, MAP_PRIVATE,
+                 fileHandle, 0 );
+
+if( mapPoint != MAP_FAILED )
+  {
+  ::madvise( mapPoint,
+             static_cast<size_t>( total ),
+             MADV_SEQUENTIAL );
+
+  mapped = static_cast<const Uint8*>(
+                                  mapPoint );
+  return true;
+  }
+
+// It couldn't be mapped so read it in
+// page aligned chunks.
+
+// The buffer from an upload before this
+// one gets used again.
+if( readBuf == nullptr )
+  {
+  void* alignedPoint = nullptr;
+  if( ::posix_memalign( &alignedPoint, 4096,
+                        ReadBufSize ) != 0 )
+    {
+    closeFile();
+    return false;
+    }
+
+  readBuf = static_cast<Uint8*>( alignedPoint );
+  }
+
+readBufStart = 0;
+readBufLast = 0;
+return true;
+}
+
+
+
+void FileSend::closeFile( void )
+{
+if( mapped != nullptr )
+  {
+  ::munmap( const_cast<Uint8*>( mapped ),
+            static_cast<size_t>( total ));
+  mapped = nullptr;
+  }
+
+if( ownsHandle && (fileHandle >= 0))
+  ::close( fileHandle );
+
+fileHandle = -1;
+ownsHandle = false;
+total = 0;
+position = 0;
+readBufStart = 0;
+readBufLast = 0;
+}
+
+
+
+void FileSend::freeReadBuf( void )
+{
+if( readBuf != nullptr )
+  {
+  ::free( readBuf );
+  readBuf = nullptr;
+  }
+}
+
+
+
+bool FileSend::fillReadBuf( void )
+{
+readBufStart = position;
+readBufLast = 0;
+
+while( readBufLast < ReadBufSize )
+  {
+  ssize_t howMany = ::pread( fileHandle,
+                     readBuf + readBufLast,
+                     static_cast<size_t>(
+                     ReadBufSize - readBufLast ),
+                     readBufStart + readBufLast );
+
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    LogCl::error( "FileSend read error." );
+    return false;
+    }
+
+  if( howMany == 0 )
+    break;
+
+  readBufLast += static_cast<Int32>( howMany );
+  }
+
+return readBufLast > 0;
+}
+
+
+
+Int32 FileSend::getChunk( CharBuf& plainBuf,
+                          const Int32 maxLen )
+{
+// This appends up to maxLen bytes from
+// the file to plainBuf.
+
+Int64 left = total - position;
+Int32 howMany = maxLen;
+if( left < howMany )
+  howMany = static_cast<Int32>( left );
+
+if( howMany <= 0 )
+  return 0;
+
+// CharBuf can only add a byte at a time, so
+// this is the one copy out of the mapping.
+// TlsMainCl seals from plainBuf with no
+// other copy of the plain text.
+if( mapped != nullptr )
+  {
+  const Uint8* from = mapped + position;
+  for( Int32 count = 0; count < howMany;
+                                    count++ )
+    plainBuf.appendU8( from[count] );
+
+  position += howMany;
+  return howMany;
+  }
+
+Int32 where = 0;
+while( where < howMany )
+  {
+  Int64 offset = position - readBufStart;
+  if( (offset < 0) || (offset >= readBufLast))
+    {
+    // A read error, or the file got shorter
+    // than fstat() said.
+    if( !fillReadBuf())
+      return -1;
+
+    offset = 0;
+    }
+
+  Int32 inBuf = readBufLast -
+                static_cast<Int32>( offset );
+  Int32 toCopy = howMany - where;
+  if( toCopy > inBuf )
+    toCopy = inBuf;
+
+  const Uint8* from = readBuf + offset;
+  for( Int32 count = 0; count < toCopy;
+                                    count++ )
+    plainBuf.appendU8( from[count] );
+
+  where += toCopy;
+  position += toCopy;
+  }
+
+return where;
+}
+
+
+
+Int32 FileSend::sendFileTo( const Int32 sock,
+                            const Int32 maxLen )
+{
+// With kernel TLS the kernel can make the
+// records straight from the page cache.
+
+Int64 left = total - position;
+Int32 howMany = maxLen;
+if( left < howMany )
+  howMany = static_cast<Int32>( left );
+
+if( howMany <= 0 )
+  return 0;
+
+off_t offset = position;
+ssize_t sent = ::sendfile( sock, fileHandle,
+                           &offset,
+                           static_cast<size_t>(
+                                    howMany ));
+if( sent < 0 )
+  {
+  if( (errno == EAGAIN) || (errno == EINTR))
+    return 0;
+
+  LogCl::error( "FileSend sendfile error." );
+  return -1;
+  }
+
+position += sent;
+return static_cast<Int32>( sent );
+}
+
+
+
+void FileSend::reportProgress( void )
+{
+if( progress != nullptr )
+  progress( position, total, progressContext );
+
+}
@@ -0,0 +1,146 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This is for uploading a big file without
+// putting it through the app CircleBuf.
+// It memory maps the file if it can, or else
+// it reads it in big aligned chunks.  Then
+// TlsMainCl seals records straight from it.
+
+// It has to be a regular file, since the
+// size comes from fstat() and the reads are
+// at an offset.  A pipe or a socket goes
+// through appOutBuf like other app data.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+// This gets called with how many bytes have
+// been sent so far and the total.
+typedef void (*UploadProgress)( Int64 sent,
+                                Int64 total,
+                                void* context );
+
+
+
+class FileSend
+  {
+  private:
+  bool testForCopy = false;
+  Int32 fileHandle = -1;
+  bool ownsHandle = false;
+  const Uint8* mapped = nullptr;
+  Uint8* readBuf = nullptr;
+  Int64 readBufStart = 0;
+  Int32 readBufLast = 0;
+  Int64 total = 0;
+  Int64 position = 0;
+  UploadProgress progress = nullptr;
+  void* progressContext = nullptr;
+
+  // Two megabytes.  A multiple of the page
+  // size.
+  static const Int32 ReadBufSize =
+                             1024 * 1024 * 2;
+
+  bool setup( void );
+  bool fillReadBuf( void );
+
+  public:
+  FileSend( void )
+    {
+    }
+
+  FileSend( const FileSend& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "FileSend copy constructor.";
+    }
+
+  ~FileSend( void )
+    {
+    closeFile();
+    freeReadBuf();
+    }
+
+  bool openPath( const CharBuf& fileName );
+  bool openHandle( const Int32 fd );
+
+  // It keeps the read buffer for the next
+  // file.
+  void closeFile( void );
+  void freeReadBuf( void );
+
+  // For a session that gets used again.
+  void reset( void )
+    {
+    closeFile();
+    progress = nullptr;
+    progressContext = nullptr;
+    }
+
+  bool isActive( void ) const
+    {
+    return fileHandle >= 0;
+    }
+
+  bool isDone( void ) const
+    {
+    return position >= total;
+    }
+
+  Int32 getHandle( void ) const
+    {
+    return fileHandle;
+    }
+
+  Int64 getTotal( void ) const
+    {
+    return total;
+    }
+
+  Int64 getPosition( void ) const
+    {
+    return position;
+    }
+
+  void setProgress( UploadProgress callBack,
+                    void* context )
+    {
+    progress = callBack;
+    progressContext = context;
+    }
+
+  // How many bytes it added, or -1 if the
+  // file couldn't be read or it got shorter.
+  Int32 getChunk( CharBuf& plainBuf,
+                  const Int32 maxLen );
+
+  Int32 sendFileTo( const Int32 sock,
+                    const Int32 maxLen );
+
+  void reportProgress( void );
+
+  };
@@ -13,9 +13,30 @@
 #include "../Network/Results.h"
 #include "../Certificate/CertMesg.h"
 #include "../Certificate/CertVerMesg.h"
-#include "../Network/FinishedMesg.h"
 #include "../CryptoBase/Randomish.h"
 #include "../CppBase/StIO.h"
+#include "LogCl.h"
+#include "HelloCache.h"
+#include "P256.h"
+#include "MlKem768.h"
+#include "CurveCtx.h"
+#include "CertView.h"
+
+#include <string.h>
+
+
+
+static void wipeBuf( CharBuf& toWipe )
+{
+// clear() only sets the length to zero, so
+// the secret bytes are written over first.
+
+const Int32 last = toWipe.getLast();
+for( Int32 count = 0; count < last; count++ )
+  toWipe.setU8( count, 0 );
+
+toWipe.clear();
+}
 
 
 
@@ -37,12 +58,219 @@ throw "HandshakeCl copy constructor called.";
 
 HandshakeCl::~HandshakeCl( void )
 {
+wipeBuf( groupSecret );
+}
+
+
+
+void HandshakeCl::reset( void )
+{
+allBytes.clear();
+recordType = 0;
+recLength = 0;
+hsState.clear();
+action = HsState::Bad;
+srvGroup = 0;
+wipeBuf( groupSecret );
+sessionIDSent.clear();
+certMsgBuf.clear();
+certChain.clear();
+inCertBody = false;
+keySched.clear();
+
+// CircleBuf has no clear() and setSize()
+// would make a new buffer.
+while( !circBufIn.isEmpty())
+  circBufIn.getU8();
+
+clientHello.reset();
+}
+
+
+
+void HandshakeCl::setClHelloSent(
+                       const CharBuf& cHelloMsg )
+{
+keySched.clear();
+keySched.addMsg( cHelloMsg );
+
+// Type, length, version and random, then
+// the session ID with its length.
+sessionIDSent.clear();
+const Int32 last = cHelloMsg.getLast();
+const Int32 idAt = 4 + 2 + 32;
+if( idAt >= last )
+  return;
+
+const Int32 idLast = cHelloMsg.getU8( idAt );
+for( Int32 count = 0; (count < idLast) &&
+           ((idAt + 1 + count) < last); count++ )
+  sessionIDSent.appendU8( cHelloMsg.getU8(
+                          idAt + 1 + count ));
+
+}
+
+
+
+void HandshakeCl::wipeGroupSecret( void )
+{
+wipeBuf( groupSecret );
+}
+
+
+
+Uint32 HandshakeCl::checkSrvHello( void )
+{
+// What RFC 8446 Section 4.1.3 says the
+// client has to check, for every group.
+// ServerHello in ../TlsServer only gets
+// the x25519 share.
+
+// The HelloRetryRequest random from
+// Section 4.1.3.
+static const Uint8 RetryRandom[32] = {
+              0xCF, 0x21, 0xAD, 0x74, 0xE5, 0x9A,
+              0x61, 0x11, 0xBE, 0x1D, 0x8C, 0x02,
+              0x1E, 0x65, 0xB8, 0x91, 0xC2, 0xA2,
+              0x11, 0x16, 0x7A, 0xBB, 0x8C, 0x5E,
+              0x07, 0x9E, 0x09, 0xE2, 0xC8, 0xA8,
+              0x33, 0x9C };
+
+const Int32 last = allBytes.getLast();
+
+// Type, length, version, random and the
+// session ID length.
+if( last < (4 + 2 + 32 + 1))
+  return Alerts::DecodeError;
+
+if( (allBytes.getU8( 4 ) != 3) ||
+    (allBytes.getU8( 5 ) != 3))
+  {
+  LogCl::warn( "ServerHello legacy version." );
+  return Alerts::ProtocolVersion;
+  }
+
+Int32 count = 0;
+for( ; count < 32; count++ )
+  {
+  if( allBytes.getU8( 6 + count ) !=
+                          RetryRandom[count] )
+    break;
+
+  }
+
+if( count == 32 )
+  {
+  // There is only one key share for each
+  // group, so there is nothing else it
+  // could ask for.
+  LogCl::warn( "Got a HelloRetryRequest." );
+  return Alerts::HandshakeFailure;
+  }
+
+Int32 index = 4 + 2 + 32;
+const Int32 idLast = allBytes.getU8( index );
+index++;
+if( idLast != sessionIDSent.getLast())
+  {
+  LogCl::warn( "ServerHello session ID." );
+  return Alerts::IllegalParameter;
+  }
+
+if( (index + idLast + 2 + 1 + 2) > last )
+  return Alerts::DecodeError;
+
+for( count = 0; count < idLast; count++ )
+  {
+  if( allBytes.getU8( index + count ) !=
+                    sessionIDSent.getU8( count ))
+    {
+    LogCl::warn( "ServerHello session ID." );
+    return Alerts::IllegalParameter;
+    }
+  }
+
+index += idLast;
+
+// TLS_AES_128_GCM_SHA256 is the only one
+// offered.
+if( (allBytes.getU8( index ) != 0x13) ||
+    (allBytes.getU8( index + 1 ) != 0x01))
+  {
+  LogCl::warn( "ServerHello cipher suite." );
+  return Alerts::IllegalParameter;
+  }
+
+if( allBytes.getU8( index + 2 ) != 0 )
+  {
+  LogCl::warn( "ServerHello compression." );
+  return Alerts::IllegalParameter;
+  }
+
+index += 3;
+
+const Int32 extEnd = index + 2 +
+               ((allBytes.getU8( index ) << 8) |
+                 allBytes.getU8( index + 1 ));
+if( extEnd > last )
+  return Alerts::DecodeError;
+
+// supported_versions has to say 3.4.
+// Without it this would be TLS 1.2.
+bool gotVersion = false;
+index += 2;
+while( (index + 4) <= extEnd )
+  {
+  const Uint32 extType = static_cast<Uint32>(
+             (allBytes.getU8( index ) << 8) |
+              allBytes.getU8( index + 1 ));
+  const Int32 extLength =
+             (allBytes.getU8( index + 2 ) << 8) |
+              allBytes.getU8( index + 3 );
+  const Int32 dataAt = index + 4;
+  index = dataAt + extLength;
+  if( index > extEnd )
+    return Alerts::DecodeError;
+
+  if( extType != 43 )
+    continue;
+
+  if( (extLength != 2) ||
+      (allBytes.getU8( dataAt ) != 3) ||
+      (allBytes.getU8( dataAt + 1 ) != 4))
+    {
+    LogCl::warn( "ServerHello version is not 1.3." );
+    return Alerts::IllegalParameter;
+    }
+
+  gotVersion = true;
+  }
+
+if( !gotVersion )
+  {
+  LogCl::warn( "ServerHello has no 1.3 version." );
+  return Alerts::ProtocolVersion;
+  }
+
+return Results::Done;
 }
 
 
 
 Uint32 HandshakeCl::accumByte( Uint8 toAdd )
 {
+// After the header of a Certificate
+// message, allBytes has the four header
+// bytes and the rest goes in certMsgBuf.
+if( inCertBody )
+  {
+  certMsgBuf.appendU8( toAdd );
+  if( certMsgBuf.getLast() >= recLength )
+    return Results::Done;
+
+  return Results::Continue;
+  }
+
 allBytes.appendU8( toAdd );
 Int32 last = allBytes.getLast();
 
@@ -65,19 +293,13 @@ if( last == 4 )
     // This is sent by older versions.
     // A hello request is empty.
     recLength = allBytes.getU8( 1 );
-    StIO::printF( "First byte: " );
-    StIO::printFD( recLength );
-    StIO::putLF();
+    LogCl::debug( "First byte:", recLength );
 
     recLength = allBytes.getU8( 2 );
-    StIO::printF( "Second byte: " );
-    StIO::printFD( recLength );
-    StIO::putLF();
+    LogCl::debug( "Second byte:", recLength );
 
     recLength = allBytes.getU8( 3 );
-    StIO::printF( "Third byte: " );
-    StIO::printFD( recLength );
-    StIO::putLF();
+    LogCl::debug( "Third byte:", recLength );
 
     recLength = 0;
     return Results::Done;
@@ -98,14 +320,14 @@ if( last == 4 )
 
   if( recLength == 0 )
     {
-    StIO::putS( "Handshake  length is zero." );
+    LogCl::warn( "Handshake  length is zero." );
     return Alerts::DecodeError;
     }
 
   // What is too long here?
   if( recLength > 0xFFFFFF ) // What max?
     {
-    StIO::printF(
+    LogCl::warn(
            "Handshake recLength is too big." );
     return Alerts::RecordOverflow;
     }
@@ -114,6 +336,13 @@ if( last == 4 )
   // StIO::printFD( recLength );
   // StIO::putLF();
 
+  if( recordType == Handshake::CertificateID )
+    {
+    certChain.clear();
+    certMsgBuf.clear();
+    inCertBody = true;
+    }
+
   return Results::Continue;
   }
 
@@ -132,12 +361,240 @@ return Results::Continue;
 
 
 
+void HandshakeCl::endMsg( void )
+{
+// certMsgBuf is kept, since certChain
+// points in to it.
+allBytes.clear();
+inCertBody = false;
+}
+
+
+
+bool HandshakeCl::makeX25519Secret(
+                            const Int32 keyAt,
+                            CharBuf& secretBuf )
+{
+// RFC 7748 Section 6.1, with the thread's
+// CurveCtx engines.  The 32 bytes at keyAt
+// are the server's u coordinate.
+
+Integer k;
+CurveCtx::privKeyToInt( clientHello.getX25519Priv(),
+                        k );
+
+Uint8 srvPubBytes[32];
+for( Int32 count = 0; count < 32; count++ )
+  srvPubBytes[count] = allBytes.getU8(
+                                keyAt + count );
+
+Integer srvPub;
+CurveCtx::bytesToInt( srvPubBytes, srvPub );
+
+Integer sharedS;
+CurveCtx::ladder( sharedS, srvPub, k );
+
+secretBuf.clear();
+CurveCtx::intToBytes( sharedS, secretBuf );
+
+// RFC 8446 Section 7.4.2.  All zeros means
+// the server sent a point of small order.
+Uint8 allOr = 0;
+for( Int32 count = 0; count < 32; count++ )
+  allOr |= secretBuf.getU8( count );
+
+if( allOr == 0 )
+  {
+  wipeBuf( secretBuf );
+  LogCl::warn( "Server X25519 share is bad." );
+  return false;
+  }
+
+return true;
+}
+
+
+
+Uint32 HandshakeCl::makeHybridSecret(
+                            const Int32 keyAt,
+                            const Int32 keyLength )
+{
+// draft-ietf-tls-ecdhe-mlkem Section 3.  The
+// server share is the ML-KEM ciphertext and
+// then its X25519 public key.  The secret is
+// the ML-KEM secret and then the X25519
+// secret.
+
+if( keyLength != (MlKem768::CipherBytes + 32))
+  return Alerts::IllegalParameter;
+
+Uint8* cipher = new Uint8[MlKem768::CipherBytes];
+for( Int32 count = 0;
+         count < MlKem768::CipherBytes; count++ )
+  cipher[count] = allBytes.getU8( keyAt + count );
+
+Uint8 mlKemSecret[MlKem768::SecretBytes];
+MlKem768::decaps( clientHello.getMlKemDecapKey(),
+                  cipher, mlKemSecret );
+delete[] cipher;
+
+CharBuf x25519Secret;
+if( !makeX25519Secret( keyAt + MlKem768::CipherBytes,
+                       x25519Secret ))
+  {
+  ::explicit_bzero( mlKemSecret,
+                    sizeof( mlKemSecret ));
+  return Alerts::IllegalParameter;
+  }
+
+for( Int32 count = 0;
+         count < MlKem768::SecretBytes; count++ )
+  groupSecret.appendU8( mlKemSecret[count] );
+
+groupSecret.appendCharBuf( x25519Secret );
+
+::explicit_bzero( mlKemSecret,
+                  sizeof( mlKemSecret ));
+wipeBuf( x25519Secret );
+return Results::Done;
+}
+
+
+
+Uint32 HandshakeCl::checkSrvGroup( void )
+{
+// Find which key share the server picked.
+// RFC 8446 Section 4.1.3 and 4.2.8.  The
+// shared secret for that group is made
+// here.
+
+srvGroup = 0;
+wipeBuf( groupSecret );
+
+const Int32 last = allBytes.getLast();
+
+// Type, length, version and random.
+Int32 index = 4 + 2 + 32;
+if( (index + 1) > last )
+  return Alerts::DecodeError;
+
+// The session ID, the cipher suite and the
+// compression method.
+index += 1 + allBytes.getU8( index ) + 2 + 1;
+if( (index + 2) > last )
+  return Alerts::DecodeError;
+
+const Int32 extEnd = index + 2 +
+               ((allBytes.getU8( index ) << 8) |
+                 allBytes.getU8( index + 1 ));
+if( extEnd > last )
+  return Alerts::DecodeError;
+
+index += 2;
+while( (index + 4) <= extEnd )
+  {
+  const Uint32 extType = static_cast<Uint32>(
+             (allBytes.getU8( index ) << 8) |
+              allBytes.getU8( index + 1 ));
+  const Int32 extLength =
+             (allBytes.getU8( index + 2 ) << 8) |
+              allBytes.getU8( index + 3 );
+  const Int32 dataAt = index + 4;
+  if( (dataAt + extLength) > extEnd )
+    return Alerts::DecodeError;
+
+  index = dataAt + extLength;
+
+  // key_share.  A HelloRetryRequest has just
+  // the group, so it has a length of 2.
+  if( (extType != 51) || (extLength < 4))
+    continue;
+
+  srvGroup = static_cast<Uint32>(
+             (allBytes.getU8( dataAt ) << 8) |
+              allBytes.getU8( dataAt + 1 ));
+
+  const Int32 keyLength =
+             (allBytes.getU8( dataAt + 2 ) << 8) |
+              allBytes.getU8( dataAt + 3 );
+  if( (4 + keyLength) > extLength )
+    return Alerts::DecodeError;
+
+  if( srvGroup == MlKem768::HybridGroupID )
+    {
+    if( !clientHello.getOfferMlKem())
+      {
+      LogCl::warn( "Server picked ML-KEM." );
+      return Alerts::IllegalParameter;
+      }
+
+    return makeHybridSecret( dataAt + 4,
+                             keyLength );
+    }
+
+  if( srvGroup == CurveCtx::GroupID )
+    {
+    if( keyLength != 32 )
+      return Alerts::IllegalParameter;
+
+    if( !makeX25519Secret( dataAt + 4,
+                           groupSecret ))
+      return Alerts::IllegalParameter;
+
+    return Results::Done;
+    }
+
+  if( srvGroup != P256::GroupID )
+    {
+    LogCl::warn( "Server picked a group not offered." );
+    return Alerts::IllegalParameter;
+    }
+
+  if( !clientHello.getOfferP256())
+    {
+    LogCl::warn( "Server picked P-256." );
+    return Alerts::IllegalParameter;
+    }
+
+  if( keyLength != P256::PointBytes )
+    return Alerts::IllegalParameter;
+
+  Uint8 srvPub[P256::PointBytes];
+  for( Int32 count = 0; count < keyLength;
+                                     count++ )
+    srvPub[count] = allBytes.getU8(
+                           dataAt + 4 + count );
+
+  Uint8 secret[P256::ScalarBytes];
+  if( !P256::sharedSecret(
+                   clientHello.getP256Priv(),
+                   srvPub, secret ))
+    {
+    ::explicit_bzero( secret, sizeof( secret ));
+    LogCl::warn( "Server P-256 share is bad." );
+    return Alerts::IllegalParameter;
+    }
+
+  for( Int32 count = 0; count < P256::ScalarBytes;
+                                     count++ )
+    groupSecret.appendU8( secret[count] );
+
+  ::explicit_bzero( secret, sizeof( secret ));
+  return Results::Done;
+  }
+
+LogCl::warn( "ServerHello has no key_share." );
+return Alerts::MissingExtension;
+}
+
+
+
 Uint32 HandshakeCl::parseMessage(
                       TlsMain& tlsMain,
                       Uint8& MsgID,
                       EncryptTls& encryptTls )
 {
-StIO::putS( "Doing HandShakeCl parseMessage()." );
+LogCl::trace( "Doing HandShakeCl parseMessage()." );
 
 // const Int32 last = allBytes.getLast();
 // StIO::printF( "HandshakeCl parse last: " );
@@ -148,7 +605,7 @@ recordType = allBytes.getU8( 0 );
 
 if( !Handshake::recordTypeGood( recordType ))
   {
-  StIO::putS(
+  LogCl::warn(
        "The HandshakeCl record type is bad." );
   return Alerts::UnexpectedMessage;
   }
@@ -156,7 +613,7 @@ if( !Handshake::recordTypeGood( recordType ))
 if( recordType ==
            Handshake::HelloRequestRESERVED )
   {
-  StIO::putS( "\nHelloRequestRESERVED." );
+  LogCl::debug( "HelloRequestRESERVED." );
   return Results::Done;
   }
 
@@ -177,14 +634,14 @@ if( recordType == Handshake::ClientHelloID )
 
 if( recordType == Handshake::ServerHelloID )
   {
-  StIO::putS( "Got a ServerHelloID" );
-  Uint32 parseResult = serverHello.parseBuffer(
-              allBytes, tlsMain, encryptTls );
+  LogCl::debug( "Got a ServerHelloID" );
+  Uint32 helloResult = checkSrvHello();
+  if( helloResult < Results::AlertTop )
+    return helloResult;
 
-  if( parseResult < Results::AlertTop )
-    return parseResult;
-
-  tlsMain.setServerHelloMsg( allBytes );
+  Uint32 groupResult = checkSrvGroup();
+  if( groupResult < Results::AlertTop )
+    return groupResult;
 
   MsgID = Handshake::ServerHelloID;
   return Results::Done;
@@ -192,7 +649,7 @@ if( recordType == Handshake::ServerHelloID )
 
 if( recordType == Handshake::NewSessionTicketID )
   {
-  StIO::putS( "NewSessionTicketID" );
+  LogCl::debug( "NewSessionTicketID" );
 
   // StIO::putLF();
   // StIO::putS( "NewSessionTicketID hex:" );
@@ -205,7 +662,7 @@ if( recordType == Handshake::NewSessionTicketID )
 
 if( recordType == Handshake::EndOfEarlyDataID )
   {
-  StIO::putS( "EndOfEarlyDataID" );
+  LogCl::debug( "EndOfEarlyDataID" );
 
   MsgID = Handshake::EndOfEarlyDataID;
   return Results::Done;
@@ -214,13 +671,15 @@ if( recordType == Handshake::EndOfEarlyDataID )
 if( recordType ==
            Handshake::EncryptedExtensionsID )
   {
-  StIO::putS( "EncryptedExtensionsID" );
-
-  tlsMain.setEncExtenMsg( allBytes );
+  LogCl::debug( "EncryptedExtensionsID" );
 
   if( Handshake::EncryptedExtensionsID !=
                          allBytes.getU8( 0 ))
-    throw "EncryptedExtensionsID first byte.";
+    {
+    LogCl::warn(
+           "EncryptedExtensionsID first byte." );
+    return Alerts::DecodeError;
+    }
 
   // Three length bytes.
   // allBytes.getU8( 1 ))
@@ -251,28 +710,36 @@ if( recordType ==
 
 if( recordType == Handshake::CertificateID )
   {
-  StIO::putLF();
-  StIO::putS( "CertificateID" );
+  LogCl::debug( "CertificateID" );
 
-  tlsMain.setCertificateMsg( allBytes );
+  // accumByte() put the body in certMsgBuf,
+  // where it stays for certChain.
+  CertMesg certMesg;
+  Uint32 result = certMesg.parseCertMsg(
+                            certMsgBuf, tlsMain );
+  if( result != Results::Done )
+    return result;
 
-  CharBuf certBuf;
-  Int32 max = allBytes.getLast();
+  result = certChain.setFromMsg( certMsgBuf, 0 );
+  if( result != Results::Done )
+    return result;
 
-  // Start at 4, past the handshake header.
-  for( Int32 count = 4; count < max; count++ )
-    certBuf.appendU8( allBytes.getU8( count ));
+  // Only the outline of the end-entity
+  // certificate is checked now.  The rest of
+  // it is read if something asks for it.
+  CertView leaf;
+  result = certChain.getCert( 0, leaf );
+  if( result != Results::Done )
+    return result;
 
   MsgID = Handshake::CertificateID;
-  CertMesg certMesg;
-  return certMesg.parseCertMsg( certBuf,
-                                tlsMain );
+  return Results::Done;
   }
 
 if( recordType ==
             Handshake::CertificateRequestID )
   {
-  StIO::putS( "CertificateRequestID" );
+  LogCl::debug( "CertificateRequestID" );
 
   MsgID = Handshake::CertificateRequestID;
   return Results::Done;
@@ -281,9 +748,7 @@ if( recordType ==
 if( recordType ==
             Handshake::CertificateVerifyID )
   {
-  StIO::putS( "CertificateVerifyID" );
-
-  tlsMain.setCertVerifyMsg( allBytes );
+  LogCl::debug( "CertificateVerifyID" );
 
   CertVerMesg certVerMesg;
   certVerMesg.parseCertVerMsg( allBytes,
@@ -295,14 +760,16 @@ if( recordType ==
 
 if( recordType == Handshake::FinishedID )
   {
-  // StIO::putS( "FinishedID" );
+  LogCl::debug( "FinishedID" );
 
-  // It came from the server.
-  tlsMain.setSrvWriteFinishedMsg( allBytes );
-
-  FinishedMesg finishedMesg;
-  finishedMesg.parseMsg( allBytes,
-                         tlsMain );
+  // It came from the server.  RFC 8446
+  // Section 4.4.4.  The transcript doesn't
+  // have this message in it yet.
+  if( !keySched.checkSrvFinished( allBytes ))
+    {
+    LogCl::warn( "Server Finished is not right." );
+    return Alerts::DecryptError;
+    }
 
   MsgID = Handshake::FinishedID;
   return Results::Done;
@@ -310,7 +777,7 @@ if( recordType == Handshake::FinishedID )
 
 if( recordType == Handshake::KeyUpdateID )
   {
-  StIO::putS( "KeyUpdateID" );
+  LogCl::debug( "KeyUpdateID" );
 
   MsgID = Handshake::KeyUpdateID;
   return Results::Done;
@@ -318,7 +785,7 @@ if( recordType == Handshake::KeyUpdateID )
 
 if( recordType == Handshake::MessageHashID )
   {
-  StIO::putS( "MessageHashID" );
+  LogCl::debug( "MessageHashID" );
 
   MsgID = Handshake::MessageHashID;
   return Results::Done;
@@ -330,7 +797,7 @@ if( recordType == Handshake::MessageHashID )
 if( recordType ==
        Handshake::HelloRetryRequestRESERVED )
   {
-  StIO::putS( "HelloRetryRequestRESERVED" );
+  LogCl::debug( "HelloRetryRequestRESERVED" );
 
   MsgID = Handshake::HelloRetryRequestRESERVED;
   return Results::Done;
@@ -343,7 +810,7 @@ if( recordType ==
 // CertificateStatusRESERVED
 // SupplementalDataRESERVED
 
-StIO::putS(
+LogCl::warn(
   "HandshakeCl.parseMessage unexpected type." );
 
 return Alerts::UnexpectedMessage;
@@ -357,7 +824,7 @@ Uint32 HandshakeCl::processInBuf(
                      Uint8& MsgID,
                      EncryptTls& encryptTls )
 {
-StIO::putS( "HandshakeCl processInBuf." );
+LogCl::trace( "HandshakeCl processInBuf." );
 
 // StIO::printFStack();
 
@@ -388,28 +855,55 @@ for( Int32 count = 0; count < max; count++ )
   Uint8 aByte = circBufIn.getU8();
   Uint32 accumResult = accumByte( aByte );
 
+  // Check the order on the type byte, before
+  // anything else gets spent on it.
+  if( (allBytes.getLast() == 1) &&
+      !hsState.canTake( recordType ))
+    {
+    LogCl::warn(
+           "Handshake message out of order:",
+           recordType );
+    endMsg();
+    return Alerts::UnexpectedMessage;
+    }
+
   if( accumResult == Results::Continue )
     continue;  // Keep adding more bytes.
 
   if( accumResult < Results::AlertTop )
     {
-    allBytes.clear();
-    StIO::putS(
+    endMsg();
+    LogCl::warn(
            "Error in HandshakeCl accumByte." );
     return accumResult;
     }
 
   if( accumResult == Results::Done )
     {
-    StIO::putLF();
-    StIO::putS( "Collected a Handshake message." );
+    LogCl::trace( "Collected a Handshake message." );
     Uint32 parseResult = parseMessage(
                                 tlsMain,
                                 MsgID,
                                 encryptTls );
 
+    // Every message up to the server Finished
+    // goes in the transcript, and nothing
+    // after that.
+    if( (parseResult == Results::Done) &&
+        !keySched.getAppKeysSet())
+      {
+      keySched.addMsg( allBytes );
+      if( inCertBody )
+        keySched.addMsg( certMsgBuf );
+
+      }
+
     // Clear it for a new message.
-    allBytes.clear();
+    endMsg();
+
+    if( parseResult == Results::Done )
+      action = hsState.advance( recordType );
+
     return parseResult;
     }
   }
@@ -420,7 +914,7 @@ for( Int32 count = 0; count < max; count++ )
 // too big for one outer rec.
 
 if( allBytes.getLast() > 0 )
-  StIO::putS( "allBytes has a partial message." );
+  LogCl::trace( "allBytes has a partial message." );
 
 return Results::Continue;
 }
@@ -468,3 +962,152 @@ outBuf.setU8( 1,  (lengthMsg >> 16) & 0xFF );
 outBuf.setU8( 2,  (lengthMsg >> 8) & 0xFF );
 outBuf.setU8( 3,  lengthMsg & 0xFF );
 }
+
+
+
+static void patchBytes( Uint8* helloBytes,
+                        const Int32 where,
+                        const CharBuf& fromBuf )
+{
+const Int32 last = fromBuf.getLast();
+for( Int32 count = 0; count < last; count++ )
+  helloBytes[where + count] = fromBuf.getU8( count );
+
+}
+
+
+
+void HandshakeCl::makeClHelloCached(
+                     CharBuf& outBuf,
+                     const CharBuf& serverName,
+                     TlsMain& tlsMain,
+                     EncryptTls& encryptTls )
+{
+Uint32 settings = 0;
+if( clientHello.getOfferP256())
+  settings |= HelloCache::SetOfferP256;
+
+if( clientHello.getOfferMlKem())
+  settings |= HelloCache::SetOfferMlKem;
+
+// On a hit this does what makeClHelloBuf()
+// does except for ExtenList::makeClHelloBuf().
+// That only writes the extension bytes, and
+// they are in the template.  makeRandoms()
+// sets the client random and the session ID
+// in tlsMain, makeKeyShare() sets the keys
+// in encryptTls and in clientHello, and the
+// transcript starts from outBuf, the bytes
+// that are sent.  clientHello.extenList
+// isn't used again after it makes the
+// bytes.  OfflineVec::cacheCheck() does a
+// whole handshake on a hit to show that.
+
+Uint8 helloBytes[HelloCache::MaxHelloLast];
+Int32 helloLast = 0;
+Int32 keyShareAt = -1;
+Int32 p256At = -1;
+Int32 mlKemAt = -1;
+if( HelloCache::get( serverName, settings,
+                     helloBytes, helloLast,
+                     keyShareAt, p256At,
+                     mlKemAt ))
+  {
+  // If makeClHelloBuf() had to turn an offer
+  // off, the template doesn't have that
+  // share.  Turn it off here the same way,
+  // so it doesn't make a key for it or take
+  // that group from the server.
+  if( p256At < 0 )
+    clientHello.setOfferP256( false );
+
+  if( mlKemAt < 0 )
+    clientHello.setOfferMlKem( false );
+
+  // Everything else is the same as the
+  // template.
+  CharBuf randBuf;
+  CharBuf sessionIDBuf;
+  clientHello.makeRandoms( randBuf,
+                           sessionIDBuf,
+                           tlsMain );
+
+  CharBuf keyShareBuf;
+  clientHello.makeKeyShare( keyShareBuf,
+                            encryptTls );
+
+  patchBytes( helloBytes, HelloCache::RandomAt,
+              randBuf );
+  patchBytes( helloBytes, HelloCache::SessionIDAt,
+              sessionIDBuf );
+  patchBytes( helloBytes, keyShareAt,
+              keyShareBuf );
+
+  if( p256At >= 0 )
+    patchBytes( helloBytes, p256At,
+                clientHello.getP256PubBuf());
+
+  // It has a copy of the X25519 key share.
+  if( mlKemAt >= 0 )
+    patchBytes( helloBytes, mlKemAt,
+                clientHello.getMlKemShareBuf());
+
+  outBuf.clear();
+  for( Int32 count = 0; count < helloLast; count++ )
+    outBuf.appendU8( helloBytes[count] );
+
+  return;
+  }
+
+// The first one for this server.
+makeClHelloBuf( outBuf, tlsMain, encryptTls );
+
+// The X25519 share is first in key_share,
+// so this finds it and not the copy at the
+// end of the hybrid share.
+keyShareAt = HelloCache::findKeyShare( outBuf,
+                    clientHello.getKeyShareBuf());
+
+// It might have turned an offer off if it
+// couldn't add it.  It still goes in under
+// the settings that were asked for, so the
+// next lookup finds it, and the -1 says
+// that share isn't there.
+if( clientHello.getOfferP256())
+  {
+  p256At = HelloCache::findKeyShare( outBuf,
+                    clientHello.getP256PubBuf());
+
+  // A -1 here would look like the offer was
+  // turned off.
+  if( p256At < 0 )
+    {
+    LogCl::warn( "ClientHello P-256 share not found." );
+    return;
+    }
+  }
+else if( (settings & HelloCache::SetOfferP256)
+                                        != 0 )
+  {
+  LogCl::warn( "Cached ClientHello has no P-256." );
+  }
+
+if( clientHello.getOfferMlKem())
+  {
+  mlKemAt = HelloCache::findKeyShare( outBuf,
+                clientHello.getMlKemShareBuf());
+  if( mlKemAt < 0 )
+    {
+    LogCl::warn( "ClientHello ML-KEM share not found." );
+    return;
+    }
+  }
+else if( (settings & HelloCache::SetOfferMlKem)
+                                        != 0 )
+  {
+  LogCl::warn( "Cached ClientHello has no ML-KEM." );
+  }
+
+HelloCache::put( serverName, settings, outBuf,
+                 keyShareAt, p256At, mlKemAt );
+}
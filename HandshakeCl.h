@@ -20,7 +20,9 @@
 #include "../CppInt/Mod.h"
 #include "../CryptoBase/MCurve.h"
 #include "ClientHello.h"
-#include "../TlsServer/ServerHello.h"
+#include "HsState.h"
+#include "CertChainView.h"
+#include "KeySched.h"
 #include "../Network/TlsMain.h"
 
 
@@ -33,28 +35,109 @@ class HandshakeCl
   Uint8 recordType = 0;
   Int32 recLength = 0;
   CircleBuf circBufIn;
+  HsState hsState;
+  Uint8 action = HsState::Bad;
+
+  // The group of the server key share and
+  // the secret if it was P-256 or the
+  // X25519MLKEM768 hybrid.
+  Uint32 srvGroup = 0;
+  CharBuf groupSecret;
+
+  // The server has to echo it back.
+  CharBuf sessionIDSent;
+
+  // The body of the server's Certificate
+  // message, and where each certificate in
+  // it is.  accumByte() puts the body here
+  // and not in allBytes, so it never gets
+  // copied.
+  CharBuf certMsgBuf;
+  CertChainView certChain;
+  bool inCertBody = false;
 
   Uint32 accumByte( Uint8 toAdd );
+  void endMsg( void );
+
+  Uint32 checkSrvHello( void );
+  Uint32 checkSrvGroup( void );
+  bool makeX25519Secret( const Int32 keyAt,
+                         CharBuf& secretBuf );
+  Uint32 makeHybridSecret( const Int32 keyAt,
+                           const Int32 keyLength );
 
   Uint32 parseMessage( TlsMain& tlsMain,
                        Uint8& MsgID,
                        EncryptTls& encryptTls );
 
+  // To time accumByte() by itself.
+  friend class MicroBench;
+
   public:
   ClientHello clientHello;
-  ServerHello serverHello;
+  KeySched keySched;
 
   HandshakeCl( void );
   HandshakeCl( const HandshakeCl& in );
   ~HandshakeCl( void );
 
+  // Ready for a new handshake.  It keeps
+  // the buffers it has.
+  void reset( void );
+
+  // The ClientHello message that was sent.
+  // It starts the transcript over.
+  void setClHelloSent( const CharBuf& cHelloMsg );
+
   Uint32 processInBuf( const CharBuf& hsBuf,
                        TlsMain& tlsMain,
                        Uint8& MsgID,
                        EncryptTls& encryptTls );
 
+  // What to do with the message that
+  // processInBuf() just gave back.
+  Uint8 getAction( void ) const
+    {
+    return action;
+    }
+
+  Uint8 getHsState( void ) const
+    {
+    return hsState.getState();
+    }
+
+  Uint32 getSrvGroup( void ) const
+    {
+    return srvGroup;
+    }
+
+  // The shared secret for the group the
+  // server picked, as bytes for KeySched.
+  const CharBuf& getGroupSecret( void ) const
+    {
+    return groupSecret;
+    }
+
+  // After the key schedule has it.
+  void wipeGroupSecret( void );
+
+  // It is empty until the Certificate
+  // message has come.
+  const CertChainView& getCertChain( void ) const
+    {
+    return certChain;
+    }
+
   void makeClHelloBuf( CharBuf& outBuf,
                     TlsMain& tlsMain,
                     EncryptTls& encryptTls );
 
+  // The same as makeClHelloBuf() but it
+  // uses the HelloCache template for this
+  // server if there is one.
+  void makeClHelloCached( CharBuf& outBuf,
+                    const CharBuf& serverName,
+                    TlsMain& tlsMain,
+                    EncryptTls& encryptTls );
+
   };
@@ -0,0 +1,242 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "HelloCache.h"
+#include "LogCl.h"
+
+#include <string.h>
+#include <mutex>
+
+
+
+class HelloEntry
+  {
+  public:
+  CharBuf serverName;
+  Uint32 settings = 0;
+  Uint8 helloBytes[HelloCache::MaxHelloLast];
+  Int32 helloLast = 0;
+  Int32 keyShareAt = -1;
+  Int32 p256At = -1;
+  Int32 mlKemAt = -1;
+  Uint64 lastUsed = 0;
+  };
+
+
+
+static std::mutex cacheMutex;
+static HelloEntry entries[HelloCache::MaxEntries];
+static Int32 entriesLast = 0;
+static Uint64 useCount = 0;
+static bool enabled = true;
+
+
+
+static bool sameBytes( const CharBuf& left,
+                       const CharBuf& right )
+{
+const Int32 last = left.getLast();
+if( right.getLast() != last )
+  return false;
+
+for( Int32 count = 0; count < last; count++ )
+  {
+  if( left.getU8( count ) != right.getU8( count ))
+    return false;
+
+  }
+
+return true;
+}
+
+
+
+bool HelloCache::get( const CharBuf& serverName,
+                      const Uint32 settings,
+                      Uint8* helloBytes,
+                      Int32& helloLast,
+                      Int32& keyShareAt,
+                      Int32& p256At,
+                      Int32& mlKemAt )
+{
+std::unique_lock<std::mutex> lock( cacheMutex );
+
+if( !enabled )
+  return false;
+
+for( Int32 count = 0; count < entriesLast; count++ )
+  {
+  HelloEntry& entry = entries[count];
+  if( entry.settings != settings )
+    continue;
+
+  if( !sameBytes( entry.serverName, serverName ))
+    continue;
+
+  useCount++;
+  entry.lastUsed = useCount;
+  ::memcpy( helloBytes, entry.helloBytes,
+            static_cast<size_t>( entry.helloLast ));
+  helloLast = entry.helloLast;
+  keyShareAt = entry.keyShareAt;
+  p256At = entry.p256At;
+  mlKemAt = entry.mlKemAt;
+  return true;
+  }
+
+return false;
+}
+
+
+
+Int32 HelloCache::findKeyShare(
+                      const CharBuf& helloBuf,
+                      const CharBuf& keyShareBuf )
+{
+const Int32 keyLast = keyShareBuf.getLast();
+const Int32 max = helloBuf.getLast() - keyLast;
+
+if( keyLast < FieldLast )
+  return -1;
+
+// It is somewhere in the extensions.
+for( Int32 where = ExtensionsAfter;
+                      where <= max; where++ )
+  {
+  Int32 count = 0;
+  for( ; count < keyLast; count++ )
+    {
+    if( helloBuf.getU8( where + count ) !=
+                     keyShareBuf.getU8( count ))
+      break;
+
+    }
+
+  if( count == keyLast )
+    return where;
+
+  }
+
+return -1;
+}
+
+
+
+void HelloCache::put( const CharBuf& serverName,
+                      const Uint32 settings,
+                      const CharBuf& helloBuf,
+                      const Int32 keyShareAt,
+                      const Int32 p256At,
+                      const Int32 mlKemAt )
+{
+std::unique_lock<std::mutex> lock( cacheMutex );
+
+if( !enabled )
+  return;
+
+const Int32 helloLast = helloBuf.getLast();
+if( helloLast > MaxHelloLast )
+  {
+  LogCl::warn( "HelloCache ClientHello is too long." );
+  return;
+  }
+
+if( keyShareAt < ExtensionsAfter )
+  {
+  LogCl::warn(
+       "HelloCache didn't find the key share." );
+  return;
+  }
+
+// -1 is a share that was asked for in
+// settings but isn't in the template.
+if( (p256At != -1) &&
+    (p256At < ExtensionsAfter))
+  {
+  LogCl::warn(
+       "HelloCache P-256 share is not right." );
+  return;
+  }
+
+if( (mlKemAt != -1) &&
+    (mlKemAt < ExtensionsAfter))
+  {
+  LogCl::warn(
+       "HelloCache ML-KEM share is not right." );
+  return;
+  }
+
+// Use a free one, or the one that was used
+// the longest time ago.
+Int32 which = entriesLast;
+if( entriesLast < MaxEntries )
+  {
+  entriesLast++;
+  }
+else
+  {
+  which = 0;
+  for( Int32 count = 1; count < MaxEntries;
+                                     count++ )
+    {
+    if( entries[count].lastUsed <
+                        entries[which].lastUsed )
+      which = count;
+
+    }
+  }
+
+HelloEntry& entry = entries[which];
+useCount++;
+entry.serverName.copy( serverName );
+entry.settings = settings;
+for( Int32 count = 0; count < helloLast; count++ )
+  entry.helloBytes[count] = helloBuf.getU8( count );
+
+entry.helloLast = helloLast;
+entry.keyShareAt = keyShareAt;
+entry.p256At = p256At;
+entry.mlKemAt = mlKemAt;
+entry.lastUsed = useCount;
+}
+
+
+
+void HelloCache::setEnabled( const bool setTo )
+{
+std::unique_lock<std::mutex> lock( cacheMutex );
+enabled = setTo;
+}
+
+
+
+void HelloCache::clear( void )
+{
+std::unique_lock<std::mutex> lock( cacheMutex );
+
+for( Int32 count = 0; count < entriesLast; count++ )
+  {
+  entries[count].serverName.clear();
+  entries[count].helloLast = 0;
+  entries[count].settings = 0;
+  entries[count].keyShareAt = -1;
+  entries[count].p256At = -1;
+  entries[count].mlKemAt = -1;
+  entries[count].lastUsed = 0;
+  }
+
+entriesLast = 0;
+}
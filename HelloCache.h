@@ -0,0 +1,103 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// ClientHello messages that were already
+// encoded, one for each server name and
+// settings.  The whole message is the same
+// for every connection to a server except
+// for the client random, the legacy session
+// ID and the key shares.  So a new
+// connection copies the template and writes
+// over those.
+
+// The key is the server name and a settings
+// word, which has a bit for each setting
+// that changes the extensions.  If
+// something else gets added that changes
+// the encoding, like ALPN, it has to go in
+// the settings too.
+
+// It is shared by all of the threads.  The
+// lock is only held to copy the template
+// out with one memcpy(), and the patching
+// is done on that copy.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class HelloCache
+  {
+  public:
+  // Where these are in the handshake
+  // message.  It starts with the type, the
+  // 3 length bytes and the legacy version.
+  static const Int32 RandomAt = 6;
+  static const Int32 SessionIDAt = 6 + 32 + 1;
+  static const Int32 ExtensionsAfter =
+                          SessionIDAt + 32;
+  static const Int32 FieldLast = 32;
+
+  static const Int32 MaxEntries = 64;
+
+  // The hybrid share makes it about 1,500
+  // bytes.  A longer one doesn't get cached.
+  static const Int32 MaxHelloLast = 1024 * 2;
+
+  static const Uint32 SetOfferP256 = 1;
+  static const Uint32 SetOfferMlKem = 2;
+
+  // It copies the template to helloBytes,
+  // which has room for MaxHelloLast.
+  // p256At and mlKemAt are -1 if those
+  // shares aren't in it.
+  static bool get( const CharBuf& serverName,
+                   const Uint32 settings,
+                   Uint8* helloBytes,
+                   Int32& helloLast,
+                   Int32& keyShareAt,
+                   Int32& p256At,
+                   Int32& mlKemAt );
+
+  // Where the key share bytes are in
+  // helloBuf.  It returns -1 if it's not
+  // found, and then it doesn't get cached.
+  static Int32 findKeyShare(
+                      const CharBuf& helloBuf,
+                      const CharBuf& keyShareBuf );
+
+  // settings is what was asked for.  If
+  // makeClHelloBuf() had to turn an offer
+  // off, that share's place is -1, and get()
+  // gives back the -1 so the caller turns
+  // it off too.
+  static void put( const CharBuf& serverName,
+                   const Uint32 settings,
+                   const CharBuf& helloBuf,
+                   const Int32 keyShareAt,
+                   const Int32 p256At,
+                   const Int32 mlKemAt );
+
+  static void setEnabled( const bool setTo );
+  static void clear( void );
+
+  };
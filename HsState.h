@@ -0,0 +1,201 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The order of the handshake messages the
+// client gets from the server.  It is the
+// client state machine in RFC 8446
+// Appendix A.1, without PSK or
+// HelloRetryRequest, since this client
+// doesn't do those yet.
+
+// WaitServerHello
+//   ServerHello -> WaitEncExten
+// WaitEncExten
+//   EncryptedExtensions -> WaitCertOrReq
+// WaitCertOrReq
+//   Certificate -> WaitCertVerify
+//   CertificateRequest -> WaitCert
+// WaitCert
+//   Certificate -> WaitCertVerify
+// WaitCertVerify
+//   CertificateVerify -> WaitFinished
+// WaitFinished
+//   Finished -> Connected
+// Connected
+//   NewSessionTicket -> Connected
+//   KeyUpdate -> Connected
+
+// The table is made at compile time.  It
+// has a row for each state and a column
+// for each of the 256 message types, so
+// checking a message is one lookup.  It
+// gets checked when the first byte of a
+// message comes in, before the rest of it
+// is collected or parsed.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../Network/Handshake.h"
+
+
+
+class HsState
+  {
+  public:
+  static const Uint8 WaitServerHello = 0;
+  static const Uint8 WaitEncExten = 1;
+  static const Uint8 WaitCertOrReq = 2;
+  static const Uint8 WaitCert = 3;
+  static const Uint8 WaitCertVerify = 4;
+  static const Uint8 WaitFinished = 5;
+  static const Uint8 Connected = 6;
+  static const Uint8 StateLast = 7;
+
+  // There is no move for it from here.
+  static const Uint8 Bad = 0xFF;
+
+  // What TlsMainCl does with a message.
+  // These index its jump table.
+  static const Uint8 ActServerHello = 0;
+  static const Uint8 ActEncExten = 1;
+  static const Uint8 ActCertificate = 2;
+  static const Uint8 ActCertRequest = 3;
+  static const Uint8 ActCertVerify = 4;
+  static const Uint8 ActFinished = 5;
+  static const Uint8 ActNewTicket = 6;
+  static const Uint8 ActKeyUpdate = 7;
+  static const Uint8 ActLast = 8;
+
+  class Move
+    {
+    public:
+    Uint8 next = Bad;
+    Uint8 action = Bad;
+    };
+
+  class Table
+    {
+    public:
+    Move moves[StateLast][256];
+    };
+
+  private:
+  Uint8 state = WaitServerHello;
+
+  static constexpr void setMove( Table& table,
+                                 const Uint8 from,
+                                 const Uint8 msgType,
+                                 const Uint8 to,
+                                 const Uint8 action )
+    {
+    table.moves[from][msgType].next = to;
+    table.moves[from][msgType].action = action;
+    }
+
+  static constexpr Table makeTable( void )
+    {
+    Table table;
+
+    setMove( table, WaitServerHello,
+             Handshake::ServerHelloID,
+             WaitEncExten, ActServerHello );
+
+    setMove( table, WaitEncExten,
+             Handshake::EncryptedExtensionsID,
+             WaitCertOrReq, ActEncExten );
+
+    setMove( table, WaitCertOrReq,
+             Handshake::CertificateID,
+             WaitCertVerify, ActCertificate );
+    setMove( table, WaitCertOrReq,
+             Handshake::CertificateRequestID,
+             WaitCert, ActCertRequest );
+
+    setMove( table, WaitCert,
+             Handshake::CertificateID,
+             WaitCertVerify, ActCertificate );
+
+    setMove( table, WaitCertVerify,
+             Handshake::CertificateVerifyID,
+             WaitFinished, ActCertVerify );
+
+    setMove( table, WaitFinished,
+             Handshake::FinishedID,
+             Connected, ActFinished );
+
+    // RFC 8446 Section 4.6.  Only after the
+    // server Finished.
+    setMove( table, Connected,
+             Handshake::NewSessionTicketID,
+             Connected, ActNewTicket );
+    setMove( table, Connected,
+             Handshake::KeyUpdateID,
+             Connected, ActKeyUpdate );
+
+    return table;
+    }
+
+  public:
+  // Made by makeTable() below the class.
+  static const Table table;
+
+  Uint8 getState( void ) const
+    {
+    return state;
+    }
+
+  bool canTake( const Uint8 msgType ) const
+    {
+    return table.moves[state][msgType].next != Bad;
+    }
+
+  // It returns the action, or Bad if the
+  // message can't come now.
+  Uint8 advance( const Uint8 msgType )
+    {
+    const Move move = table.moves[state][msgType];
+    if( move.next == Bad )
+      return Bad;
+
+    state = move.next;
+    return move.action;
+    }
+
+  void clear( void )
+    {
+    state = WaitServerHello;
+    }
+
+  };
+
+
+
+inline constexpr HsState::Table HsState::table =
+                           HsState::makeTable();
+
+static_assert( HsState::table.moves[
+          HsState::WaitServerHello][
+          Handshake::ServerHelloID].next ==
+                       HsState::WaitEncExten );
+
+static_assert( HsState::table.moves[
+          HsState::WaitServerHello][
+          Handshake::NewSessionTicketID].next ==
+                       HsState::Bad );
@@ -0,0 +1,180 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "HsTiming.h"
+#include "../CppBase/StIO.h"
+
+#include <time.h>
+
+
+
+LatHisto HsTiming::histos[HsTiming::PhaseLast];
+
+
+
+Int64 HsTiming::getNanoSec( void )
+{
+timespec now;
+::clock_gettime( CLOCK_MONOTONIC, &now );
+
+Int64 result = now.tv_sec;
+result *= 1000000000LL;
+result += now.tv_nsec;
+return result;
+}
+
+
+
+void HsTiming::clear( void )
+{
+for( Int32 count = 0; count < PhaseLast;
+                                     count++ )
+  stamps[count] = 0;
+
+finished = false;
+}
+
+
+
+Int64 HsTiming::getPhaseNs(
+                      const Int32 phase ) const
+{
+if( (phase < 0) || (phase >= PhaseLast))
+  throw "HsTiming phase is out of range.";
+
+if( stamps[phase] == 0 )
+  return 0;
+
+if( phase == Start )
+  {
+  if( stamps[ClFinishedSent] == 0 )
+    return 0;
+
+  return stamps[ClFinishedSent] - stamps[Start];
+  }
+
+// Phases like Certificate aren't there
+// with every handshake.
+for( Int32 before = phase - 1; before >= 0;
+                                     before-- )
+  {
+  if( stamps[before] != 0 )
+    return stamps[phase] - stamps[before];
+
+  }
+
+return 0;
+}
+
+
+
+void HsTiming::finish( void )
+{
+if( finished )
+  return;
+
+if( stamps[ClFinishedSent] == 0 )
+  return;
+
+finished = true;
+
+for( Int32 count = 0; count < PhaseLast;
+                                     count++ )
+  {
+  if( stamps[count] == 0 )
+    continue;
+
+  histos[count].record( getPhaseNs( count ));
+  }
+}
+
+
+
+const char* HsTiming::getPhaseName(
+                             const Int32 phase )
+{
+switch( phase )
+  {
+  case Start: return "Total";
+  case Connected: return "Connected";
+  case HelloSent: return "HelloSent";
+  case ServerHello: return "ServerHello";
+  case SharedSecret: return "SharedSecret";
+  case HsKeys: return "HsKeys";
+  case EncExtensions: return "EncExtensions";
+  case Certificate: return "Certificate";
+  case CertVerify: return "CertVerify";
+  case SrvFinished: return "SrvFinished";
+  case AppKeys: return "AppKeys";
+  case ClFinishedSent: return "ClFinishedSent";
+  default: return "Unknown";
+  }
+}
+
+
+
+const LatHisto& HsTiming::getHisto(
+                             const Int32 phase )
+{
+if( (phase < 0) || (phase >= PhaseLast))
+  throw "HsTiming phase is out of range.";
+
+return histos[phase];
+}
+
+
+
+void HsTiming::clearHistos( void )
+{
+for( Int32 count = 0; count < PhaseLast;
+                                     count++ )
+  histos[count].clear();
+
+}
+
+
+
+void HsTiming::showHistos( void )
+{
+// In microseconds.
+
+StIO::putS(
+      "Phase: count, p50, p99, p99.9, max (us)" );
+
+for( Int32 count = 0; count < PhaseLast;
+                                     count++ )
+  {
+  const LatHisto& histo = histos[count];
+  if( histo.getCount() == 0 )
+    continue;
+
+  StIO::printF( getPhaseName( count ));
+  StIO::printF( ": " );
+  StIO::printFUD( histo.getCount());
+  StIO::printF( ", " );
+  StIO::printFUD( histo.getPercentile( 500 )
+                                      / 1000 );
+  StIO::printF( ", " );
+  StIO::printFUD( histo.getPercentile( 990 )
+                                      / 1000 );
+  StIO::printF( ", " );
+  StIO::printFUD( histo.getPercentile( 999 )
+                                      / 1000 );
+  StIO::printF( ", " );
+  StIO::printFUD( histo.getMax() / 1000 );
+  StIO::putLF();
+  }
+}
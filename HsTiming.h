@@ -0,0 +1,118 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Monotonic time stamps for each phase of
+// one handshake.  When the client Finished
+// has been sent, the time each phase took
+// since the phase before it goes in to a
+// histogram for the whole process.
+
+// The phases that wait on the server, like
+// ServerHello and Certificate, are mostly
+// network time.  SharedSecret, HsKeys and
+// AppKeys are crypto time on this side.
+// CertVerify includes checking the
+// signature.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "LatHisto.h"
+
+
+
+class HsTiming
+  {
+  private:
+  bool testForCopy = false;
+  bool finished = false;
+
+  public:
+  // The Start slot in the histograms holds
+  // the whole handshake time.
+  static const Int32 Start = 0;
+  static const Int32 Connected = 1;
+  static const Int32 HelloSent = 2;
+  static const Int32 ServerHello = 3;
+  static const Int32 SharedSecret = 4;
+  static const Int32 HsKeys = 5;
+  static const Int32 EncExtensions = 6;
+  static const Int32 Certificate = 7;
+  static const Int32 CertVerify = 8;
+  static const Int32 SrvFinished = 9;
+  static const Int32 AppKeys = 10;
+  static const Int32 ClFinishedSent = 11;
+  static const Int32 PhaseLast = 12;
+
+  private:
+  Int64 stamps[PhaseLast] = { 0 };
+
+  static LatHisto histos[PhaseLast];
+
+  public:
+  HsTiming( void )
+    {
+    }
+
+  HsTiming( const HsTiming& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "HsTiming copy constructor.";
+    }
+
+  ~HsTiming( void )
+    {
+    }
+
+  static Int64 getNanoSec( void );
+
+  void clear( void );
+
+  void mark( const Int32 phase )
+    {
+    // Only the first time for each phase.
+    if( stamps[phase] == 0 )
+      stamps[phase] = getNanoSec();
+
+    }
+
+  bool isMarked( const Int32 phase ) const
+    {
+    return stamps[phase] != 0;
+    }
+
+  // The time since the phase before it that
+  // was marked.  Zero if it wasn't marked.
+  Int64 getPhaseNs( const Int32 phase ) const;
+
+  // Call this after ClFinishedSent is marked.
+  void finish( void );
+
+  static const char* getPhaseName(
+                            const Int32 phase );
+
+  static const LatHisto& getHisto(
+                            const Int32 phase );
+
+  static void clearHistos( void );
+  static void showHistos( void );
+
+  };
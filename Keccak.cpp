@@ -0,0 +1,292 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "Keccak.h"
+
+#include <string.h>
+
+
+
+// FIPS 202 Section 3.2.5.
+static const Uint64 RoundConst[24] = {
+             0x0000000000000001ULL,
+             0x0000000000008082ULL,
+             0x800000000000808AULL,
+             0x8000000080008000ULL,
+             0x000000000000808BULL,
+             0x0000000080000001ULL,
+             0x8000000080008081ULL,
+             0x8000000000008009ULL,
+             0x000000000000008AULL,
+             0x0000000000000088ULL,
+             0x0000000080008009ULL,
+             0x000000008000000AULL,
+             0x000000008000808BULL,
+             0x800000000000008BULL,
+             0x8000000000008089ULL,
+             0x8000000000008003ULL,
+             0x8000000000008002ULL,
+             0x8000000000000080ULL,
+             0x000000000000800AULL,
+             0x800000008000000AULL,
+             0x8000000080008081ULL,
+             0x8000000000008080ULL,
+             0x0000000080000001ULL,
+             0x8000000080008008ULL };
+
+
+
+static inline Uint64 rotLeft( const Uint64 x,
+                              const Int32 by )
+{
+return (x << by) | (x >> (64 - by));
+}
+
+
+
+Keccak::~Keccak( void )
+{
+::explicit_bzero( state, sizeof( state ));
+}
+
+
+
+void Keccak::permute( Uint64* a )
+{
+// It is written out so that it doesn't
+// depend on the compiler unrolling loops.
+Uint64 b[25];
+
+for( Int32 round = 0; round < 24; round++ )
+  {
+  // Theta.
+  const Uint64 c0 = a[0] ^ a[5] ^ a[10] ^
+                    a[15] ^ a[20];
+  const Uint64 c1 = a[1] ^ a[6] ^ a[11] ^
+                    a[16] ^ a[21];
+  const Uint64 c2 = a[2] ^ a[7] ^ a[12] ^
+                    a[17] ^ a[22];
+  const Uint64 c3 = a[3] ^ a[8] ^ a[13] ^
+                    a[18] ^ a[23];
+  const Uint64 c4 = a[4] ^ a[9] ^ a[14] ^
+                    a[19] ^ a[24];
+
+  const Uint64 d0 = c4 ^ rotLeft( c1, 1 );
+  const Uint64 d1 = c0 ^ rotLeft( c2, 1 );
+  const Uint64 d2 = c1 ^ rotLeft( c3, 1 );
+  const Uint64 d3 = c2 ^ rotLeft( c4, 1 );
+  const Uint64 d4 = c3 ^ rotLeft( c0, 1 );
+
+  // Rho and pi.  Lane x, y goes to lane
+  // y, 2x + 3y.
+  b[0] = a[0] ^ d0;
+  b[1] = rotLeft( a[6] ^ d1, 44 );
+  b[2] = rotLeft( a[12] ^ d2, 43 );
+  b[3] = rotLeft( a[18] ^ d3, 21 );
+  b[4] = rotLeft( a[24] ^ d4, 14 );
+  b[5] = rotLeft( a[3] ^ d3, 28 );
+  b[6] = rotLeft( a[9] ^ d4, 20 );
+  b[7] = rotLeft( a[10] ^ d0, 3 );
+  b[8] = rotLeft( a[16] ^ d1, 45 );
+  b[9] = rotLeft( a[22] ^ d2, 61 );
+  b[10] = rotLeft( a[1] ^ d1, 1 );
+  b[11] = rotLeft( a[7] ^ d2, 6 );
+  b[12] = rotLeft( a[13] ^ d3, 25 );
+  b[13] = rotLeft( a[19] ^ d4, 8 );
+  b[14] = rotLeft( a[20] ^ d0, 18 );
+  b[15] = rotLeft( a[4] ^ d4, 27 );
+  b[16] = rotLeft( a[5] ^ d0, 36 );
+  b[17] = rotLeft( a[11] ^ d1, 10 );
+  b[18] = rotLeft( a[17] ^ d2, 15 );
+  b[19] = rotLeft( a[23] ^ d3, 56 );
+  b[20] = rotLeft( a[2] ^ d2, 62 );
+  b[21] = rotLeft( a[8] ^ d3, 55 );
+  b[22] = rotLeft( a[14] ^ d4, 39 );
+  b[23] = rotLeft( a[15] ^ d0, 41 );
+  b[24] = rotLeft( a[21] ^ d1, 2 );
+
+  // Chi.
+  for( Int32 y = 0; y < 25; y += 5 )
+    {
+    a[y] = b[y] ^ (~b[y + 1] & b[y + 2]);
+    a[y + 1] = b[y + 1] ^ (~b[y + 2] & b[y + 3]);
+    a[y + 2] = b[y + 2] ^ (~b[y + 3] & b[y + 4]);
+    a[y + 3] = b[y + 3] ^ (~b[y + 4] & b[y]);
+    a[y + 4] = b[y + 4] ^ (~b[y] & b[y + 1]);
+    }
+
+  // Iota.
+  a[0] ^= RoundConst[round];
+  }
+}
+
+
+
+void Keccak::xorByte( const Int32 at,
+                      const Uint8 toXor )
+{
+// The lanes are little endian.
+state[at >> 3] ^= static_cast<Uint64>( toXor )
+                               << (8 * (at & 7));
+}
+
+
+
+Uint8 Keccak::getByte( const Int32 at ) const
+{
+return static_cast<Uint8>(
+             state[at >> 3] >> (8 * (at & 7)));
+}
+
+
+
+void Keccak::start( const Int32 setRate,
+                    const Uint8 setPad )
+{
+for( Int32 count = 0; count < 25; count++ )
+  state[count] = 0;
+
+rate = setRate;
+padByte = setPad;
+where = 0;
+squeezing = false;
+}
+
+
+
+void Keccak::absorb( const Uint8* inBytes,
+                     const Int32 howMany )
+{
+if( squeezing )
+  throw "Keccak absorb after squeeze.";
+
+Int32 index = 0;
+while( index < howMany )
+  {
+  // Whole blocks go in a lane at a time.
+  if( (where == 0) &&
+      ((howMany - index) >= rate))
+    {
+    for( Int32 lane = 0; lane < (rate >> 3);
+                                        lane++ )
+      {
+      Uint64 word = 0;
+      for( Int32 count = 7; count >= 0; count-- )
+        word = (word << 8) |
+               inBytes[index + (lane * 8) + count];
+
+      state[lane] ^= word;
+      }
+
+    index += rate;
+    permute( state );
+    continue;
+    }
+
+  xorByte( where, inBytes[index] );
+  index++;
+  where++;
+  if( where == rate )
+    {
+    permute( state );
+    where = 0;
+    }
+  }
+}
+
+
+
+void Keccak::squeeze( Uint8* outBytes,
+                      const Int32 howMany )
+{
+if( !squeezing )
+  {
+  // FIPS 202 Section 5.1 and Appendix B.2.
+  // The domain bits and the first 1 of the
+  // pad go where the input ended, and the
+  // last 1 goes at the end of the block.
+  xorByte( where, padByte );
+  xorByte( rate - 1, 0x80 );
+  permute( state );
+  where = 0;
+  squeezing = true;
+  }
+
+Int32 count = 0;
+while( count < howMany )
+  {
+  if( where == rate )
+    {
+    permute( state );
+    where = 0;
+    }
+
+  // A lane at a time when it can.
+  if( ((where & 7) == 0) &&
+      ((howMany - count) >= 8))
+    {
+    const Uint64 word = state[where >> 3];
+    for( Int32 shift = 0; shift < 8; shift++ )
+      outBytes[count + shift] =
+           static_cast<Uint8>( word >> (8 * shift));
+
+    count += 8;
+    where += 8;
+    continue;
+    }
+
+  outBytes[count] = getByte( where );
+  count++;
+  where++;
+  }
+}
+
+
+
+void Keccak::sha3256( const Uint8* inBytes,
+                      const Int32 howMany,
+                      Uint8* hash )
+{
+Keccak keccak;
+keccak.start( RateSha3256, PadSha3 );
+keccak.absorb( inBytes, howMany );
+keccak.squeeze( hash, 32 );
+}
+
+
+
+void Keccak::sha3512( const Uint8* inBytes,
+                      const Int32 howMany,
+                      Uint8* hash )
+{
+Keccak keccak;
+keccak.start( RateSha3512, PadSha3 );
+keccak.absorb( inBytes, howMany );
+keccak.squeeze( hash, 64 );
+}
+
+
+
+void Keccak::shake256( const Uint8* inBytes,
+                       const Int32 howMany,
+                       Uint8* outBytes,
+                       const Int32 outLast )
+{
+Keccak keccak;
+keccak.startShake256();
+keccak.absorb( inBytes, howMany );
+keccak.squeeze( outBytes, outLast );
+}
@@ -0,0 +1,105 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// SHA-3 and SHAKE from FIPS 202, which is
+// what ML-KEM uses for its hashes and for
+// sampling.
+
+// An object is one sponge.  Call absorb()
+// as many times as needed, then squeeze()
+// as many times as needed.  The first
+// squeeze() adds the padding.  The static
+// methods do a whole hash in one call.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+
+
+class Keccak
+  {
+  private:
+  bool testForCopy = false;
+  Uint64 state[25] = { 0 };
+  Int32 rate = 0;
+  Int32 where = 0;
+  Uint8 padByte = 0;
+  bool squeezing = false;
+
+  static void permute( Uint64* a );
+  void xorByte( const Int32 at,
+                const Uint8 toXor );
+  Uint8 getByte( const Int32 at ) const;
+
+  public:
+  // The rate in bytes for each one.
+  static const Int32 RateShake128 = 168;
+  static const Int32 RateShake256 = 136;
+  static const Int32 RateSha3256 = 136;
+  static const Int32 RateSha3512 = 72;
+
+  // The domain bits and the first pad bit.
+  static const Uint8 PadSha3 = 0x06;
+  static const Uint8 PadShake = 0x1F;
+
+  Keccak( void )
+    {
+    }
+
+  Keccak( const Keccak& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "Keccak copy constructor.";
+    }
+
+  ~Keccak( void );
+
+  void start( const Int32 setRate,
+              const Uint8 setPad );
+
+  void startShake128( void )
+    {
+    start( RateShake128, PadShake );
+    }
+
+  void startShake256( void )
+    {
+    start( RateShake256, PadShake );
+    }
+
+  void absorb( const Uint8* inBytes,
+               const Int32 howMany );
+  void squeeze( Uint8* outBytes,
+                const Int32 howMany );
+
+  static void sha3256( const Uint8* inBytes,
+                       const Int32 howMany,
+                       Uint8* hash );
+  static void sha3512( const Uint8* inBytes,
+                       const Int32 howMany,
+                       Uint8* hash );
+  static void shake256( const Uint8* inBytes,
+                        const Int32 howMany,
+                        Uint8* outBytes,
+                        const Int32 outLast );
+
+  };
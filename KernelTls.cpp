@@ -0,0 +1,303 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "KernelTls.h"
+#include "LogCl.h"
+#include "../Network/TlsOuterRec.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+#include <string.h>
+#include <errno.h>
+
+
+#ifndef SOL_TLS
+  #define SOL_TLS 282
+#endif
+
+
+
+bool KernelTls::setUlp( const Int32 sock )
+{
+if( ulpSet )
+  return true;
+
+// If the tls module isn't there this fails
+// with ENOENT and it just stays in
+// user space.
+
+if( ::setsockopt( sock, SOL_TCP, TCP_ULP,
+                  "tls", sizeof( "tls" )) != 0 )
+  {
+  LogCl::info(
+      "Kernel TLS is not available. "
+      "Staying in user space." );
+  return false;
+  }
+
+ulpSet = true;
+return true;
+}
+
+
+
+bool KernelTls::setCryptoInfo(
+                      const Int32 sock,
+                      const Int32 direction,
+                      const CharBuf& key,
+                      const CharBuf& iv,
+                      const Uint64 seqNum )
+{
+if( key.getLast() !=
+          TLS_CIPHER_AES_GCM_128_KEY_SIZE )
+  throw "KernelTls key size is not right.";
+
+// The 12 byte IV for TLS 1.3 is the 4 byte
+// salt and then the 8 byte IV.
+if( iv.getLast() !=
+        (TLS_CIPHER_AES_GCM_128_SALT_SIZE +
+         TLS_CIPHER_AES_GCM_128_IV_SIZE))
+  throw "KernelTls IV size is not right.";
+
+tls12_crypto_info_aes_gcm_128 info;
+::memset( &info, 0, sizeof( info ));
+
+info.info.version = TLS_1_3_VERSION;
+info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+
+for( Int32 count = 0;
+       count < TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+       count++ )
+  info.key[count] = key.getU8( count );
+
+for( Int32 count = 0;
+       count < TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+       count++ )
+  info.salt[count] = iv.getU8( count );
+
+for( Int32 count = 0;
+       count < TLS_CIPHER_AES_GCM_128_IV_SIZE;
+       count++ )
+  info.iv[count] = iv.getU8( count +
+               TLS_CIPHER_AES_GCM_128_SALT_SIZE );
+
+// Big endian sequence number.
+for( Int32 count = 0;
+     count < TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE;
+     count++ )
+  {
+  info.rec_seq[count] = static_cast<Uint8>(
+             seqNum >> (8 * (7 - count)));
+  }
+
+Int32 result = ::setsockopt( sock, SOL_TLS,
+                             direction,
+                             &info, sizeof( info ));
+
+// Don't leave the key on the stack.  A
+// memset here could be taken out, since
+// info isn't read again.
+::explicit_bzero( &info, sizeof( info ));
+
+if( result != 0 )
+  {
+  LogCl::error( "KernelTls setsockopt failed:",
+                errno );
+  return false;
+  }
+
+return true;
+}
+
+
+
+bool KernelTls::installTx( const Int32 sock,
+                           const CharBuf& key,
+                           const CharBuf& iv,
+                           const Uint64 seqNum )
+{
+if( txOn )
+  return true;
+
+if( !setUlp( sock ))
+  return false;
+
+txOn = setCryptoInfo( sock, TLS_TX, key, iv,
+                                      seqNum );
+return txOn;
+}
+
+
+
+bool KernelTls::installRx( const Int32 sock,
+                           const CharBuf& key,
+                           const CharBuf& iv,
+                           const Uint64 seqNum )
+{
+if( rxOn )
+  return true;
+
+if( !setUlp( sock ))
+  return false;
+
+rxOn = setCryptoInfo( sock, TLS_RX, key, iv,
+                                      seqNum );
+return rxOn;
+}
+
+
+
+Int32 KernelTls::sendRec( const Int32 sock,
+                          const CharBuf& plainBuf,
+                          const Uint8 recType )
+{
+// Returns how many bytes were sent, or
+// -1 if it failed.
+
+const Int32 last = plainBuf.getLast();
+if( last == 0 )
+  return 0;
+
+if( last > RecvSize )
+  throw "KernelTls sendRec is too long.";
+
+char chunk[RecvSize];
+for( Int32 count = 0; count < last; count++ )
+  chunk[count] = static_cast<char>(
+                         plainBuf.getU8( count ));
+
+// Application data is the default.  Anything
+// else needs a control message with the
+// record type.
+
+char cmsgBuf[CMSG_SPACE( sizeof( Uint8 ))];
+::memset( cmsgBuf, 0, sizeof( cmsgBuf ));
+
+Int32 where = 0;
+while( where < last )
+  {
+  iovec iov;
+  iov.iov_base = chunk + where;
+  iov.iov_len = static_cast<size_t>(
+                               last - where );
+
+  msghdr msg;
+  ::memset( &msg, 0, sizeof( msg ));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  if( recType != TlsOuterRec::ApplicationData )
+    {
+    msg.msg_control = cmsgBuf;
+    msg.msg_controllen = sizeof( cmsgBuf );
+    cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN( sizeof( Uint8 ));
+    *CMSG_DATA( cmsg ) = recType;
+    }
+
+  ssize_t howMany = ::sendmsg( sock, &msg,
+                               MSG_NOSIGNAL );
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    LogCl::error( "KernelTls sendmsg error:",
+                  errno );
+    return -1;
+    }
+
+  where += static_cast<Int32>( howMany );
+  }
+
+return where;
+}
+
+
+
+Int32 KernelTls::recvRec( const Int32 sock,
+                          CharBuf& plainBuf,
+                          Uint8& recType )
+{
+// Returns how many plain text bytes it got
+// for one record type.  Zero if nothing
+// is there yet.  -1 if the connection is
+// closed and -2 if a record didn't decrypt.
+
+char chunk[RecvSize];
+char cmsgBuf[CMSG_SPACE( sizeof( Uint8 ))];
+
+iovec iov;
+iov.iov_base = chunk;
+iov.iov_len = RecvSize;
+
+msghdr msg;
+::memset( &msg, 0, sizeof( msg ));
+msg.msg_iov = &iov;
+msg.msg_iovlen = 1;
+msg.msg_control = cmsgBuf;
+msg.msg_controllen = sizeof( cmsgBuf );
+
+ssize_t howMany = 0;
+for( Int32 tries = 0; tries < 8; tries++ )
+  {
+  howMany = ::recvmsg( sock, &msg,
+                       MSG_DONTWAIT );
+  if( (howMany < 0) && (errno == EINTR))
+    continue;
+
+  break;
+  }
+
+if( howMany == 0 )
+  return -1;
+
+if( howMany < 0 )
+  {
+  if( (errno == EAGAIN) ||
+      (errno == EWOULDBLOCK))
+    return 0;
+
+  if( errno == EBADMSG )
+    {
+    LogCl::error( "KernelTls bad record." );
+    return -2;
+    }
+
+  LogCl::error( "KernelTls recvmsg error:",
+                errno );
+  return -1;
+  }
+
+recType = TlsOuterRec::ApplicationData;
+
+cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+if( (cmsg != nullptr) &&
+    (cmsg->cmsg_level == SOL_TLS) &&
+    (cmsg->cmsg_type == TLS_GET_RECORD_TYPE))
+  recType = *CMSG_DATA( cmsg );
+
+for( Int32 count = 0; count < howMany; count++ )
+  plainBuf.appendU8( static_cast<Uint8>(
+                                chunk[count] ));
+
+return static_cast<Int32>( howMany );
+}
@@ -0,0 +1,118 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Kernel TLS.  After the application data
+// keys are set, the keys and sequence numbers
+// can be handed to the Linux kernel with
+// setsockopt( SOL_TLS ).  Then plain send()
+// and recv() on the socket carry the
+// records and the kernel does the AES-GCM.
+
+// See the Linux kernel file
+// Documentation/networking/tls.rst.
+
+// The kernel only gives back one record type
+// at a time.  Records that are not
+// application data come back with a control
+// message that has the record type, so
+// handshake messages like NewSessionTicket
+// still go through processHandshake().
+
+// The kernel can't do a KeyUpdate for the
+// receive side, so a KeyUpdate from the
+// server will end the connection with a
+// decrypt error.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class KernelTls
+  {
+  private:
+  bool testForCopy = false;
+  bool ulpSet = false;
+  bool txOn = false;
+  bool rxOn = false;
+
+  static const Int32 RecvSize = 1024 * 17;
+
+  bool setUlp( const Int32 sock );
+  bool setCryptoInfo( const Int32 sock,
+                      const Int32 direction,
+                      const CharBuf& key,
+                      const CharBuf& iv,
+                      const Uint64 seqNum );
+
+  public:
+  KernelTls( void )
+    {
+    }
+
+  KernelTls( const KernelTls& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "KernelTls copy constructor.";
+    }
+
+  ~KernelTls( void )
+    {
+    }
+
+  bool getTxOn( void ) const
+    {
+    return txOn;
+    }
+
+  bool getRxOn( void ) const
+    {
+    return rxOn;
+    }
+
+  bool installTx( const Int32 sock,
+                  const CharBuf& key,
+                  const CharBuf& iv,
+                  const Uint64 seqNum );
+
+  bool installRx( const Int32 sock,
+                  const CharBuf& key,
+                  const CharBuf& iv,
+                  const Uint64 seqNum );
+
+  Int32 sendRec( const Int32 sock,
+                 const CharBuf& plainBuf,
+                 const Uint8 recType );
+
+  Int32 recvRec( const Int32 sock,
+                 CharBuf& plainBuf,
+                 Uint8& recType );
+
+  void clear( void )
+    {
+    ulpSet = false;
+    txOn = false;
+    rxOn = false;
+    }
+
+  };
@@ -0,0 +1,432 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "KeySched.h"
+#include "../Network/Handshake.h"
+
+#include <string.h>
+
+
+
+KeySched::~KeySched( void )
+{
+clear();
+}
+
+
+
+void KeySched::clear( void )
+{
+::explicit_bzero( masterSecret,
+                  sizeof( masterSecret ));
+::explicit_bzero( clHsTraffic,
+                  sizeof( clHsTraffic ));
+::explicit_bzero( srvHsTraffic,
+                  sizeof( srvHsTraffic ));
+::explicit_bzero( clAppTraffic,
+                  sizeof( clAppTraffic ));
+::explicit_bzero( srvAppTraffic,
+                  sizeof( srvAppTraffic ));
+
+hsKeysSet = false;
+appKeysSet = false;
+transcript.start();
+}
+
+
+
+void KeySched::hmac( const Uint8* key,
+                     const Int32 keyLast,
+                     const Uint8* data,
+                     const Int32 dataLast,
+                     Uint8* result )
+{
+// RFC 2104.
+
+Uint8 keyBlock[Sha256Cl::BlockSize] = { 0 };
+if( keyLast > Sha256Cl::BlockSize )
+  Sha256Cl::hash( key, keyLast, keyBlock );
+else
+  ::memcpy( keyBlock, key,
+            static_cast<size_t>( keyLast ));
+
+Uint8 pad[Sha256Cl::BlockSize];
+for( Int32 count = 0; count < Sha256Cl::BlockSize;
+                                        count++ )
+  pad[count] = keyBlock[count] ^ 0x36;
+
+Uint8 innerHash[Sha256Cl::HashSize];
+Sha256Cl inner;
+inner.add( pad, Sha256Cl::BlockSize );
+inner.add( data, dataLast );
+inner.getHash( innerHash );
+
+for( Int32 count = 0; count < Sha256Cl::BlockSize;
+                                        count++ )
+  pad[count] = keyBlock[count] ^ 0x5c;
+
+Sha256Cl outer;
+outer.add( pad, Sha256Cl::BlockSize );
+outer.add( innerHash, Sha256Cl::HashSize );
+outer.getHash( result );
+
+::explicit_bzero( keyBlock, sizeof( keyBlock ));
+::explicit_bzero( pad, sizeof( pad ));
+::explicit_bzero( innerHash, sizeof( innerHash ));
+}
+
+
+
+void KeySched::extract( const Uint8* salt,
+                        const Uint8* inKey,
+                        const Int32 inKeyLast,
+                        Uint8* result )
+{
+// RFC 5869 Section 2.2.
+hmac( salt, Sha256Cl::HashSize, inKey,
+      inKeyLast, result );
+}
+
+
+
+void KeySched::expandLabel( const Uint8* secret,
+                            const char* label,
+                            const Uint8* context,
+                            const Int32 contextLast,
+                            Uint8* result,
+                            const Int32 resultLast )
+{
+// RFC 8446 Section 7.1 HKDF-Expand-Label,
+// with HKDF-Expand from RFC 5869 Section
+// 2.3.  The labels here are short and the
+// context is a hash or nothing.
+
+const char* prefix = "tls13 ";
+const Int32 prefixLast = 6;
+const Int32 labelLast = static_cast<Int32>(
+                             ::strlen( label ));
+
+// The previous block, the HkdfLabel and the
+// counter byte.
+Uint8 info[Sha256Cl::HashSize + 4 + 255 + 255];
+Int32 infoLast = Sha256Cl::HashSize;
+
+info[infoLast] = static_cast<Uint8>(
+                               resultLast >> 8 );
+info[infoLast + 1] = static_cast<Uint8>(
+                                    resultLast );
+info[infoLast + 2] = static_cast<Uint8>(
+                        prefixLast + labelLast );
+infoLast += 3;
+
+::memcpy( info + infoLast, prefix, prefixLast );
+infoLast += prefixLast;
+::memcpy( info + infoLast, label,
+          static_cast<size_t>( labelLast ));
+infoLast += labelLast;
+
+info[infoLast] = static_cast<Uint8>(
+                                  contextLast );
+infoLast++;
+if( contextLast > 0 )
+  ::memcpy( info + infoLast, context,
+            static_cast<size_t>( contextLast ));
+
+infoLast += contextLast;
+
+Uint8 block[Sha256Cl::HashSize];
+Int32 where = 0;
+for( Int32 counter = 1; where < resultLast;
+                                    counter++ )
+  {
+  info[infoLast] = static_cast<Uint8>( counter );
+
+  // The first block has no previous block
+  // in front of it.
+  if( counter == 1 )
+    hmac( secret, Sha256Cl::HashSize,
+          info + Sha256Cl::HashSize,
+          infoLast + 1 - Sha256Cl::HashSize,
+          block );
+  else
+    hmac( secret, Sha256Cl::HashSize,
+          info, infoLast + 1, block );
+
+  Int32 toCopy = resultLast - where;
+  if( toCopy > Sha256Cl::HashSize )
+    toCopy = Sha256Cl::HashSize;
+
+  ::memcpy( result + where, block,
+            static_cast<size_t>( toCopy ));
+  ::memcpy( info, block, Sha256Cl::HashSize );
+  where += toCopy;
+  }
+
+::explicit_bzero( block, sizeof( block ));
+::explicit_bzero( info, sizeof( info ));
+}
+
+
+
+void KeySched::deriveSecret( const Uint8* secret,
+                             const char* label,
+                             Uint8* result ) const
+{
+// Derive-Secret() with the transcript
+// that is here now.
+
+Uint8 hash[Sha256Cl::HashSize];
+transcript.getHash( hash );
+expandLabel( secret, label, hash,
+             Sha256Cl::HashSize, result,
+             Sha256Cl::HashSize );
+}
+
+
+
+void KeySched::setHsSecret(
+                     const CharBuf& sharedSecret )
+{
+// The early secret has no PSK, so it is the
+// same every time.
+
+Uint8 zeros[Sha256Cl::HashSize] = { 0 };
+Uint8 emptyHash[Sha256Cl::HashSize];
+Sha256Cl::hash( zeros, 0, emptyHash );
+
+Uint8 secret[Sha256Cl::HashSize];
+extract( zeros, zeros, Sha256Cl::HashSize,
+         secret );
+
+Uint8 derived[Sha256Cl::HashSize];
+expandLabel( secret, "derived", emptyHash,
+             Sha256Cl::HashSize, derived,
+             Sha256Cl::HashSize );
+
+// The hybrid secret is the longest one, at
+// 64 bytes.
+Uint8 shared[128];
+Int32 sharedLast = sharedSecret.getLast();
+if( sharedLast > 128 )
+  throw "KeySched shared secret is too long.";
+
+for( Int32 count = 0; count < sharedLast; count++ )
+  shared[count] = sharedSecret.getU8( count );
+
+extract( derived, shared, sharedLast, secret );
+
+deriveSecret( secret, "c hs traffic",
+              clHsTraffic );
+deriveSecret( secret, "s hs traffic",
+              srvHsTraffic );
+
+expandLabel( secret, "derived", emptyHash,
+             Sha256Cl::HashSize, derived,
+             Sha256Cl::HashSize );
+extract( derived, zeros, Sha256Cl::HashSize,
+         masterSecret );
+
+::explicit_bzero( secret, sizeof( secret ));
+::explicit_bzero( derived, sizeof( derived ));
+::explicit_bzero( shared, sizeof( shared ));
+hsKeysSet = true;
+}
+
+
+
+void KeySched::makeVerifyData(
+                       const Uint8* baseKey,
+                       Uint8* verifyData ) const
+{
+// RFC 8446 Section 4.4.4.
+
+Uint8 finishedKey[Sha256Cl::HashSize];
+expandLabel( baseKey, "finished", nullptr, 0,
+             finishedKey, Sha256Cl::HashSize );
+
+Uint8 hash[Sha256Cl::HashSize];
+transcript.getHash( hash );
+
+hmac( finishedKey, Sha256Cl::HashSize, hash,
+      Sha256Cl::HashSize, verifyData );
+
+::explicit_bzero( finishedKey,
+                  sizeof( finishedKey ));
+}
+
+
+
+bool KeySched::checkFinished(
+                     const Uint8* baseKey,
+                     const CharBuf& finMsg ) const
+{
+if( !hsKeysSet )
+  return false;
+
+if( finMsg.getLast() != (4 + Sha256Cl::HashSize))
+  return false;
+
+if( (finMsg.getU8( 0 ) != Handshake::FinishedID) ||
+    (finMsg.getU8( 1 ) != 0) ||
+    (finMsg.getU8( 2 ) != 0) ||
+    (finMsg.getU8( 3 ) != Sha256Cl::HashSize))
+  return false;
+
+Uint8 verifyData[Sha256Cl::HashSize];
+makeVerifyData( baseKey, verifyData );
+
+// Constant time compare.
+Uint8 diff = 0;
+for( Int32 count = 0; count < Sha256Cl::HashSize;
+                                       count++ )
+  diff |= static_cast<Uint8>( verifyData[count] ^
+                       finMsg.getU8( 4 + count ));
+
+return diff == 0;
+}
+
+
+
+void KeySched::makeFinished(
+                        const Uint8* baseKey,
+                        CharBuf& finMsg ) const
+{
+Uint8 verifyData[Sha256Cl::HashSize];
+makeVerifyData( baseKey, verifyData );
+
+finMsg.clear();
+finMsg.appendU8( Handshake::FinishedID );
+finMsg.appendU8( 0 );
+finMsg.appendU8( 0 );
+finMsg.appendU8( Sha256Cl::HashSize );
+for( Int32 count = 0; count < Sha256Cl::HashSize;
+                                       count++ )
+  finMsg.appendU8( verifyData[count] );
+
+}
+
+
+
+bool KeySched::checkSrvFinished(
+                     const CharBuf& finMsg ) const
+{
+return checkFinished( srvHsTraffic, finMsg );
+}
+
+
+
+void KeySched::makeClFinished(
+                        CharBuf& finMsg ) const
+{
+makeFinished( clHsTraffic, finMsg );
+}
+
+
+
+bool KeySched::checkClFinished(
+                     const CharBuf& finMsg ) const
+{
+return checkFinished( clHsTraffic, finMsg );
+}
+
+
+
+void KeySched::makeSrvFinished(
+                        CharBuf& finMsg ) const
+{
+makeFinished( srvHsTraffic, finMsg );
+}
+
+
+
+void KeySched::setAppSecrets( void )
+{
+deriveSecret( masterSecret, "c ap traffic",
+              clAppTraffic );
+deriveSecret( masterSecret, "s ap traffic",
+              srvAppTraffic );
+
+// There is no resumption or key update
+// yet, so nothing else needs these.
+::explicit_bzero( masterSecret,
+                  sizeof( masterSecret ));
+::explicit_bzero( clHsTraffic,
+                  sizeof( clHsTraffic ));
+::explicit_bzero( srvHsTraffic,
+                  sizeof( srvHsTraffic ));
+
+appKeysSet = true;
+}
+
+
+
+void KeySched::getTrafficKey(
+                      const Uint8* trafficSecret,
+                      CharBuf& key,
+                      CharBuf& iv )
+{
+// RFC 8446 Section 7.3.
+
+Uint8 keyBytes[KeySize];
+Uint8 ivBytes[IVSize];
+expandLabel( trafficSecret, "key", nullptr, 0,
+             keyBytes, KeySize );
+expandLabel( trafficSecret, "iv", nullptr, 0,
+             ivBytes, IVSize );
+
+key.clear();
+for( Int32 count = 0; count < KeySize; count++ )
+  key.appendU8( keyBytes[count] );
+
+iv.clear();
+for( Int32 count = 0; count < IVSize; count++ )
+  iv.appendU8( ivBytes[count] );
+
+::explicit_bzero( keyBytes, sizeof( keyBytes ));
+::explicit_bzero( ivBytes, sizeof( ivBytes ));
+}
+
+
+
+void KeySched::getClHsKey( CharBuf& key,
+                           CharBuf& iv ) const
+{
+getTrafficKey( clHsTraffic, key, iv );
+}
+
+
+
+void KeySched::getSrvHsKey( CharBuf& key,
+                            CharBuf& iv ) const
+{
+getTrafficKey( srvHsTraffic, key, iv );
+}
+
+
+
+void KeySched::getClAppKey( CharBuf& key,
+                            CharBuf& iv ) const
+{
+getTrafficKey( clAppTraffic, key, iv );
+}
+
+
+
+void KeySched::getSrvAppKey( CharBuf& key,
+                             CharBuf& iv ) const
+{
+getTrafficKey( srvAppTraffic, key, iv );
+}
@@ -0,0 +1,166 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The TLS 1.3 key schedule in RFC 8446
+// Section 7.1, for TLS_AES_128_GCM_SHA256,
+// which is the only suite the client
+// offers.
+
+// It keeps its own transcript hash, so
+// HandshakeCl adds each handshake message
+// to it as it comes.  The shared secret
+// comes in as bytes, so it is the same for
+// X25519, P-256 or the X25519MLKEM768
+// hybrid.  OfflineVec checks it against
+// RFC 8448.
+
+// This replaces what EncryptTls did for the
+// client, so the application keys for
+// kernel TLS and the decrypt pool come from
+// here.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "Sha256Cl.h"
+
+
+
+class KeySched
+  {
+  private:
+  bool testForCopy = false;
+  Sha256Cl transcript;
+  bool hsKeysSet = false;
+  bool appKeysSet = false;
+  Uint8 masterSecret[Sha256Cl::HashSize] = { 0 };
+  Uint8 clHsTraffic[Sha256Cl::HashSize] = { 0 };
+  Uint8 srvHsTraffic[Sha256Cl::HashSize] = { 0 };
+  Uint8 clAppTraffic[Sha256Cl::HashSize] = { 0 };
+  Uint8 srvAppTraffic[Sha256Cl::HashSize] = { 0 };
+
+  static void hmac( const Uint8* key,
+                    const Int32 keyLast,
+                    const Uint8* data,
+                    const Int32 dataLast,
+                    Uint8* result );
+
+  static void extract( const Uint8* salt,
+                       const Uint8* inKey,
+                       const Int32 inKeyLast,
+                       Uint8* result );
+
+  static void expandLabel( const Uint8* secret,
+                           const char* label,
+                           const Uint8* context,
+                           const Int32 contextLast,
+                           Uint8* result,
+                           const Int32 resultLast );
+
+  void deriveSecret( const Uint8* secret,
+                     const char* label,
+                     Uint8* result ) const;
+
+  static void getTrafficKey(
+                      const Uint8* trafficSecret,
+                      CharBuf& key,
+                      CharBuf& iv );
+
+  void makeVerifyData( const Uint8* baseKey,
+                       Uint8* verifyData ) const;
+
+  bool checkFinished( const Uint8* baseKey,
+                      const CharBuf& finMsg ) const;
+  void makeFinished( const Uint8* baseKey,
+                     CharBuf& finMsg ) const;
+
+  public:
+  static const Int32 KeySize = 16;
+  static const Int32 IVSize = 12;
+
+  KeySched( void )
+    {
+    }
+
+  KeySched( const KeySched& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "KeySched copy constructor.";
+    }
+
+  ~KeySched( void );
+
+  // It writes over the secrets and starts a
+  // new transcript.
+  void clear( void );
+
+  // The whole handshake message with its
+  // four byte header.
+  void addMsg( const CharBuf& msg )
+    {
+    transcript.addCharBuf( msg );
+    }
+
+  // After the ServerHello was added.
+  void setHsSecret( const CharBuf& sharedSecret );
+
+  // Before the server Finished is added.
+  // It is the whole message.
+  bool checkSrvFinished(
+                     const CharBuf& finMsg ) const;
+
+  // After the server Finished was added.
+  // This is the whole client Finished
+  // message.
+  void makeClFinished( CharBuf& finMsg ) const;
+
+  // The server side of those two, for the
+  // in-memory server in MemSrv.  The client
+  // Finished is checked before it is added,
+  // if it is added at all.
+  bool checkClFinished(
+                     const CharBuf& finMsg ) const;
+  void makeSrvFinished( CharBuf& finMsg ) const;
+
+  // After the server Finished was added.
+  void setAppSecrets( void );
+
+  bool getHsKeysSet( void ) const
+    {
+    return hsKeysSet;
+    }
+
+  bool getAppKeysSet( void ) const
+    {
+    return appKeysSet;
+    }
+
+  void getClHsKey( CharBuf& key,
+                   CharBuf& iv ) const;
+  void getSrvHsKey( CharBuf& key,
+                    CharBuf& iv ) const;
+  void getClAppKey( CharBuf& key,
+                    CharBuf& iv ) const;
+  void getSrvAppKey( CharBuf& key,
+                     CharBuf& iv ) const;
+
+  };
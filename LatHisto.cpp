@@ -0,0 +1,152 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "LatHisto.h"
+
+
+
+void LatHisto::clear( void )
+{
+for( Int32 index = 0; index < CounterLast;
+                                     index++ )
+  counters[index].store( 0,
+                     std::memory_order_relaxed );
+
+count.store( 0, std::memory_order_relaxed );
+sum.store( 0, std::memory_order_relaxed );
+max.store( 0, std::memory_order_relaxed );
+}
+
+
+
+Int32 LatHisto::getIndex( const Uint64 value )
+{
+if( value < LinearLast )
+  return static_cast<Int32>( value );
+
+// The highest bit that is set.  It is at
+// least 6 here.
+Int32 topBit = 63 - __builtin_clzll( value );
+if( topBit > TopBit )
+  return CounterLast - 1;
+
+// The top SubBits + 1 bits of the value.
+// That is from 32 to 63.
+const Int32 shift = topBit - SubBits;
+const Int32 sub = static_cast<Int32>(
+                              value >> shift );
+
+return LinearLast +
+       ((topBit - 6) * (1 << SubBits)) +
+       (sub - (1 << SubBits));
+}
+
+
+
+Uint64 LatHisto::getValueAt( const Int32 index )
+{
+// The middle of the range for that counter.
+
+if( index < LinearLast )
+  return static_cast<Uint64>( index );
+
+const Int32 above = index - LinearLast;
+const Int32 topBit = (above >> SubBits) + 6;
+const Uint64 sub = static_cast<Uint64>(
+         (above & ((1 << SubBits) - 1)) +
+         (1 << SubBits));
+
+const Int32 shift = topBit - SubBits;
+Uint64 low = sub << shift;
+return low + ((1ULL << shift) >> 1);
+}
+
+
+
+void LatHisto::record( const Int64 nanoSec )
+{
+if( nanoSec < 0 )
+  return;
+
+const Uint64 value = static_cast<Uint64>(
+                                   nanoSec );
+
+counters[getIndex( value )].fetch_add( 1,
+                     std::memory_order_relaxed );
+
+count.fetch_add( 1, std::memory_order_relaxed );
+sum.fetch_add( value, std::memory_order_relaxed );
+
+Uint64 oldMax = max.load(
+                     std::memory_order_relaxed );
+while( value > oldMax )
+  {
+  if( max.compare_exchange_weak( oldMax, value,
+                    std::memory_order_relaxed ))
+    break;
+
+  }
+}
+
+
+
+Uint64 LatHisto::getMean( void ) const
+{
+const Uint64 howMany = getCount();
+if( howMany == 0 )
+  return 0;
+
+return sum.load( std::memory_order_relaxed ) /
+                                     howMany;
+}
+
+
+
+Uint64 LatHisto::getPercentile(
+                   const Int32 perThousand ) const
+{
+const Uint64 howMany = getCount();
+if( howMany == 0 )
+  return 0;
+
+if( perThousand >= 1000 )
+  return getMax();
+
+// How many values are at or below it.
+Uint64 target = (howMany * static_cast<Uint64>(
+                    perThousand ) + 999) / 1000;
+if( target < 1 )
+  target = 1;
+
+Uint64 soFar = 0;
+for( Int32 index = 0; index < CounterLast;
+                                     index++ )
+  {
+  soFar += counters[index].load(
+                     std::memory_order_relaxed );
+  if( soFar >= target )
+    {
+    // Don't say more than the biggest one.
+    Uint64 value = getValueAt( index );
+    if( value > getMax())
+      value = getMax();
+
+    return value;
+    }
+  }
+
+return getMax();
+}
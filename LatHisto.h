@@ -0,0 +1,101 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A latency histogram in the style of HDR
+// Histogram.  Values are in nanoseconds.
+// Values below 64 each get their own
+// counter.  Above that each power of two
+// is split in to 32 counters, so any value
+// is within about 3 percent of the middle
+// of its counter.  That goes up to about
+// 2^47 nanoseconds, which is a day and a
+// half.
+
+// The counters are relaxed atomics so any
+// connection on any thread can record to
+// the same histogram without a lock.  A
+// query while others are recording gets
+// a close enough answer.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+#include <atomic>
+
+
+
+class LatHisto
+  {
+  private:
+  bool testForCopy = false;
+
+  static const Int32 SubBits = 5;
+  static const Int32 LinearLast = 64;
+  static const Int32 TopBit = 47;
+  static const Int32 CounterLast = LinearLast +
+                 ((TopBit - 5) * (1 << SubBits));
+
+  std::atomic<Uint64> counters[CounterLast];
+  std::atomic<Uint64> count{ 0 };
+  std::atomic<Uint64> sum{ 0 };
+  std::atomic<Uint64> max{ 0 };
+
+  static Int32 getIndex( const Uint64 value );
+  static Uint64 getValueAt( const Int32 index );
+
+  public:
+  LatHisto( void )
+    {
+    clear();
+    }
+
+  LatHisto( const LatHisto& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "LatHisto copy constructor.";
+    }
+
+  ~LatHisto( void )
+    {
+    }
+
+  void clear( void );
+  void record( const Int64 nanoSec );
+
+  Uint64 getCount( void ) const
+    {
+    return count.load( std::memory_order_relaxed );
+    }
+
+  Uint64 getMax( void ) const
+    {
+    return max.load( std::memory_order_relaxed );
+    }
+
+  Uint64 getMean( void ) const;
+
+  // 500 is the median, 990 is p99, 999 is
+  // p99.9.
+  Uint64 getPercentile(
+                  const Int32 perThousand ) const;
+
+  };
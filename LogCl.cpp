@@ -0,0 +1,297 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "LogCl.h"
+#include "LogRing.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdio.h>
+#include <unistd.h>
+
+
+
+// The list of rings for all threads.  The
+// mutex is only taken when a thread logs
+// for the first time and by the writer.
+static std::mutex ringListMutex;
+static LogRing* ringList = nullptr;
+
+static std::mutex writerMutex;
+static std::thread writerThread;
+static std::atomic<bool> writerOn{ false };
+static std::atomic<bool> writerStopping{ false };
+
+// After stopWriter() it doesn't start again
+// by itself.  Lines get written right away.
+static std::atomic<bool> writerStopped{ false };
+
+static std::atomic<Uint64> droppedLines{ 0 };
+
+
+
+class LogRingOwner
+  {
+  public:
+  LogRing* ring = nullptr;
+
+  ~LogRingOwner( void )
+    {
+    if( ring != nullptr )
+      ring->threadGone.store( true,
+                     std::memory_order_release );
+
+    }
+  };
+
+static thread_local LogRingOwner ringOwner;
+
+
+
+static LogRing* getThreadRing( void )
+{
+if( ringOwner.ring != nullptr )
+  return ringOwner.ring;
+
+LogRing* ring = new LogRing;
+
+std::unique_lock<std::mutex> lock(
+                             ringListMutex );
+ring->next = ringList;
+ringList = ring;
+lock.unlock();
+
+ringOwner.ring = ring;
+return ring;
+}
+
+
+
+static void writeAll( const char* outBuf,
+                      const Int32 outLast )
+{
+Int32 where = 0;
+while( where < outLast )
+  {
+  ssize_t howMany = ::write( STDOUT_FILENO,
+                 outBuf + where,
+                 static_cast<size_t>(
+                         outLast - where ));
+  if( howMany <= 0 )
+    return;
+
+  where += static_cast<Int32>( howMany );
+  }
+}
+
+
+
+static bool drainRings( char* outBuf,
+                        const Int32 outLast )
+{
+// Returns true if it wrote anything.
+
+bool wroteAny = false;
+
+std::unique_lock<std::mutex> lock(
+                             ringListMutex );
+
+LogRing* previous = nullptr;
+LogRing* ring = ringList;
+while( ring != nullptr )
+  {
+  // Read this before emptying it so a line
+  // added just before the thread ended
+  // still gets written.
+  const bool gone = ring->threadGone.load(
+                     std::memory_order_acquire );
+
+  for( ;; )
+    {
+    Int32 howMany = ring->takeLines( outBuf,
+                                     outLast );
+    if( howMany == 0 )
+      break;
+
+    writeAll( outBuf, howMany );
+    wroteAny = true;
+    }
+
+  LogRing* next = ring->next;
+  if( gone && ring->isEmpty())
+    {
+    if( previous == nullptr )
+      ringList = next;
+    else
+      previous->next = next;
+
+    delete ring;
+    }
+  else
+    {
+    previous = ring;
+    }
+
+  ring = next;
+  }
+
+return wroteAny;
+}
+
+
+
+static void writerLoop( void )
+{
+const Int32 outLast = 1024 * 64;
+char* outBuf = new char[outLast];
+
+while( !writerStopping.load(
+                 std::memory_order_acquire ))
+  {
+  if( !drainRings( outBuf, outLast ))
+    std::this_thread::sleep_for(
+                 std::chrono::milliseconds( 1 ));
+
+  }
+
+// Whatever is left.
+drainRings( outBuf, outLast );
+delete[] outBuf;
+}
+
+
+
+void LogCl::startWriter( void )
+{
+std::unique_lock<std::mutex> lock( writerMutex );
+if( writerOn.load())
+  return;
+
+writerStopping.store( false );
+writerStopped.store( false );
+writerThread = std::thread( writerLoop );
+writerOn.store( true,
+                std::memory_order_release );
+}
+
+
+
+void LogCl::stopWriter( void )
+{
+std::unique_lock<std::mutex> lock( writerMutex );
+writerStopped.store( true );
+if( !writerOn.load())
+  return;
+
+writerStopping.store( true,
+                      std::memory_order_release );
+writerThread.join();
+writerOn.store( false );
+}
+
+
+
+Uint64 LogCl::getDropped( void )
+{
+return droppedLines.load(
+                     std::memory_order_relaxed );
+}
+
+
+
+void LogCl::put( const Int32 level,
+                 const char* text,
+                 const bool hasNumber,
+                 const Int64 number )
+{
+static const char* const levelNames[] = {
+                 "T ", "D ", "I ", "W ", "E " };
+
+const char* levelName = "? ";
+if( (level >= Trace) && (level <= Error))
+  levelName = levelNames[level];
+
+if( !writerOn.load( std::memory_order_acquire ))
+  {
+  if( writerStopped.load())
+    {
+    // Past stopWriter(), so it can't go
+    // in a ring.
+    char lineBuf[LogRing::CharLast];
+    Int32 lineLast = hasNumber ?
+        ::snprintf( lineBuf, sizeof( lineBuf ),
+             "%s%s %lld\n", levelName, text,
+             static_cast<long long>( number )) :
+        ::snprintf( lineBuf, sizeof( lineBuf ),
+             "%s%s\n", levelName, text );
+
+    if( lineLast >= LogRing::CharLast )
+      lineLast = LogRing::CharLast - 1;
+
+    writeAll( lineBuf, lineLast );
+    return;
+    }
+
+  startWriter();
+  }
+
+LogRing* ring = getThreadRing();
+char* line = ring->getFreeLine();
+if( line == nullptr )
+  {
+  droppedLines.fetch_add( 1,
+                     std::memory_order_relaxed );
+  return;
+  }
+
+Int32 lineLast = 0;
+if( hasNumber )
+  lineLast = ::snprintf( line, LogRing::CharLast,
+             "%s%s %lld\n", levelName, text,
+             static_cast<long long>( number ));
+else
+  lineLast = ::snprintf( line, LogRing::CharLast,
+             "%s%s\n", levelName, text );
+
+if( lineLast < 0 )
+  return;
+
+// It got cut off.  Keep the line feed.
+if( lineLast >= LogRing::CharLast )
+  {
+  lineLast = LogRing::CharLast - 1;
+  line[lineLast - 1] = '\n';
+  }
+
+ring->commitLine( lineLast );
+}
+
+
+
+class LogWriterAtExit
+  {
+  public:
+  ~LogWriterAtExit( void )
+    {
+    LogCl::stopWriter();
+    }
+  };
+
+// This is defined after the things it uses
+// so it gets destroyed before them.
+static LogWriterAtExit logWriterAtExit;
@@ -0,0 +1,162 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Leveled logging for the data path.
+
+// The level is set when it is compiled,
+// like with -DTLS_CL_LOG_LEVEL=1 for Debug.
+// Anything below that level compiles to
+// nothing.
+
+// A line that is on goes in to a ring that
+// belongs to the thread that logged it.  A
+// background thread takes the lines out and
+// writes them to standard out.  So logging
+// never blocks a connection on terminal
+// I/O.  If a ring is full the line gets
+// dropped and counted.
+
+// Lines from different threads can come
+// out in a different order than they were
+// logged.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+
+#ifndef TLS_CL_LOG_LEVEL
+  // Info.
+  #define TLS_CL_LOG_LEVEL 2
+#endif
+
+
+
+class LogCl
+  {
+  public:
+  static const Int32 Trace = 0;
+  static const Int32 Debug = 1;
+  static const Int32 Info = 2;
+  static const Int32 Warn = 3;
+  static const Int32 Error = 4;
+  static const Int32 Off = 5;
+
+  static constexpr Int32 CompiledLevel =
+                             TLS_CL_LOG_LEVEL;
+
+  private:
+  static void put( const Int32 level,
+                   const char* text,
+                   const bool hasNumber,
+                   const Int64 number );
+
+  public:
+  // For things like showHex() that can't
+  // go through the ring.
+  static constexpr bool isOn( const Int32 level )
+    {
+    return level >= CompiledLevel;
+    }
+
+  static void trace( const char* text )
+    {
+    if constexpr( Trace >= CompiledLevel )
+      put( Trace, text, false, 0 );
+
+    }
+
+  static void trace( const char* text,
+                     const Int64 number )
+    {
+    if constexpr( Trace >= CompiledLevel )
+      put( Trace, text, true, number );
+
+    }
+
+  static void debug( const char* text )
+    {
+    if constexpr( Debug >= CompiledLevel )
+      put( Debug, text, false, 0 );
+
+    }
+
+  static void debug( const char* text,
+                     const Int64 number )
+    {
+    if constexpr( Debug >= CompiledLevel )
+      put( Debug, text, true, number );
+
+    }
+
+  static void info( const char* text )
+    {
+    if constexpr( Info >= CompiledLevel )
+      put( Info, text, false, 0 );
+
+    }
+
+  static void info( const char* text,
+                    const Int64 number )
+    {
+    if constexpr( Info >= CompiledLevel )
+      put( Info, text, true, number );
+
+    }
+
+  static void warn( const char* text )
+    {
+    if constexpr( Warn >= CompiledLevel )
+      put( Warn, text, false, 0 );
+
+    }
+
+  static void warn( const char* text,
+                    const Int64 number )
+    {
+    if constexpr( Warn >= CompiledLevel )
+      put( Warn, text, true, number );
+
+    }
+
+  static void error( const char* text )
+    {
+    if constexpr( Error >= CompiledLevel )
+      put( Error, text, false, 0 );
+
+    }
+
+  static void error( const char* text,
+                     const Int64 number )
+    {
+    if constexpr( Error >= CompiledLevel )
+      put( Error, text, true, number );
+
+    }
+
+  // The writer starts by itself the first
+  // time something is logged.  stopWriter()
+  // writes out what is left.  It gets called
+  // at exit too.
+  static void startWriter( void );
+  static void stopWriter( void );
+
+  static Uint64 getDropped( void );
+
+  };
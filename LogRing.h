@@ -0,0 +1,143 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// One of these belongs to each thread that
+// logs something.  Only that thread adds
+// lines and only the log writer thread
+// takes them out, so it needs no lock.  If
+// it is full the line is dropped.  The
+// thread that is logging never waits.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+#include <atomic>
+#include <string.h>
+
+
+
+class LogRing
+  {
+  private:
+  bool testForCopy = false;
+
+  public:
+  // This has to be a power of 2.
+  static const Int32 LineLast = 1024;
+  static const Int32 CharLast = 128;
+
+  private:
+  char lines[LineLast][CharLast];
+  Int32 lineLasts[LineLast] = { 0 };
+  std::atomic<Uint32> head{ 0 };
+  std::atomic<Uint32> tail{ 0 };
+
+  public:
+  // Set when the thread that owns it ends.
+  // The writer deletes it after it is
+  // empty.
+  std::atomic<bool> threadGone{ false };
+  LogRing* next = nullptr;
+
+  LogRing( void )
+    {
+    }
+
+  LogRing( const LogRing& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "LogRing copy constructor.";
+    }
+
+  ~LogRing( void )
+    {
+    }
+
+  // The owning thread writes the line in
+  // to the slot it gets from here, then
+  // calls commitLine().  It is nullptr if
+  // the ring is full.
+  char* getFreeLine( void )
+    {
+    const Uint32 headNow = head.load(
+                     std::memory_order_relaxed );
+    const Uint32 tailNow = tail.load(
+                     std::memory_order_acquire );
+
+    if( (headNow - tailNow) >=
+                 static_cast<Uint32>( LineLast ))
+      return nullptr;
+
+    return lines[headNow & (LineLast - 1)];
+    }
+
+  void commitLine( const Int32 lineLast )
+    {
+    const Uint32 headNow = head.load(
+                     std::memory_order_relaxed );
+
+    lineLasts[headNow & (LineLast - 1)] =
+                                    lineLast;
+    head.store( headNow + 1,
+                std::memory_order_release );
+    }
+
+  bool isEmpty( void ) const
+    {
+    return head.load(
+                std::memory_order_acquire ) ==
+           tail.load(
+                std::memory_order_relaxed );
+    }
+
+  // For the writer thread.  It copies as
+  // many whole lines as fit in to outBuf and
+  // returns how many bytes it copied.
+  Int32 takeLines( char* outBuf,
+                   const Int32 outLast )
+    {
+    Uint32 tailNow = tail.load(
+                     std::memory_order_relaxed );
+    const Uint32 headNow = head.load(
+                     std::memory_order_acquire );
+
+    Int32 where = 0;
+    while( tailNow != headNow )
+      {
+      const Int32 index = static_cast<Int32>(
+                     tailNow & (LineLast - 1));
+      const Int32 lineLast = lineLasts[index];
+      if( (where + lineLast) > outLast )
+        break;
+
+      ::memcpy( outBuf + where, lines[index],
+                static_cast<size_t>( lineLast ));
+      where += lineLast;
+      tailNow++;
+      }
+
+    tail.store( tailNow,
+                std::memory_order_release );
+    return where;
+    }
+
+  };
@@ -0,0 +1,456 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "LoopBench.h"
+#include "ClientTls.h"
+#include "SessionPool.h"
+#include "SrvStandIn.h"
+#include "SinkCallBack.h"
+#include "TransportUring.h"
+#include "../CppBase/CircleBuf.h"
+#include "../CppBase/StIO.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+
+
+
+Int64 LoopBench::getNanoSec( void )
+{
+timespec now;
+::clock_gettime( CLOCK_MONOTONIC, &now );
+
+Int64 result = now.tv_sec;
+result *= 1000000000LL;
+result += now.tv_nsec;
+return result;
+}
+
+
+
+const char* LoopBench::getTransportName(
+                                   void ) const
+{
+if( uringLoop != nullptr )
+  return "uring";
+
+if( fastOpen && nonBlocking )
+  return "sockTfoNb";
+
+if( fastOpen )
+  return "sockTfo";
+
+if( nonBlocking )
+  return "sockNb";
+
+return "net";
+}
+
+
+
+void LoopBench::makePortBuf( const Int32 port,
+                             CharBuf& portBuf )
+{
+char portChars[16];
+::snprintf( portChars, sizeof( portChars ),
+            "%d", port );
+
+CharBuf numBuf( portChars );
+portBuf.copy( numBuf );
+}
+
+
+
+bool LoopBench::countDownload(
+                        const CharBuf& plainBuf,
+                        void* context )
+{
+LoopBench* bench = static_cast<LoopBench*>(
+                                    context );
+bench->downloadGot += plainBuf.getLast();
+return true;
+}
+
+
+
+bool LoopBench::runHandshakes(
+                           const Int32 port,
+                           const Int32 howMany,
+                           Int64& totalNs )
+{
+CharBuf hostBuf( "127.0.0.1" );
+CharBuf portBuf;
+makePortBuf( port, portBuf );
+
+delete[] latencies;
+latencies = new Int64[howMany];
+latencyLast = 0;
+
+// The session gets used again for each
+// handshake, like a client that makes a
+// lot of connections would do it.
+SessionPool pool( 1 );
+pool.fill( 1 );
+
+tfoAttempts = 0;
+tfoSuccesses = 0;
+
+const Int64 allStart = getNanoSec();
+
+for( Int32 count = 0; count < howMany; count++ )
+  {
+  TransportUring uringTrans;
+  ClientTls* client = pool.take();
+  if( uringLoop != nullptr )
+    {
+    uringTrans.setLoop( uringLoop );
+    client->setTransport( &uringTrans );
+    }
+  else
+    {
+    // reset() turned these off.
+    client->setFastOpen( fastOpen );
+    client->setNonBlocking( nonBlocking );
+    }
+
+  CircleBuf appOutBuf;
+  CircleBuf appInBuf;
+  appOutBuf.setSize( 1024 * 64 );
+  appInBuf.setSize( 1024 * 64 );
+
+  const Int64 start = getNanoSec();
+
+  if( !client->startTestVecHandshake( hostBuf,
+                                      portBuf ))
+    {
+    pool.give( client );
+    return false;
+    }
+
+  for( ;; )
+    {
+    Int32 status = client->processData(
+                          appOutBuf, appInBuf );
+    if( status < 0 )
+      {
+      pool.give( client );
+      return false;
+      }
+
+    if( client->isHandshakeDone())
+      break;
+
+    // Give the server thread the CPU.
+    std::this_thread::yield();
+    }
+
+  latencies[latencyLast] = getNanoSec() - start;
+  latencyLast++;
+
+  // give() resets the counters.
+  TrafficSnap snap;
+  client->getTrafficSnap( snap );
+  tfoAttempts += static_cast<Int64>(
+          snap.counters[TrafficSnap::TfoAttempts] );
+  tfoSuccesses += static_cast<Int64>(
+          snap.counters[TrafficSnap::TfoSuccesses] );
+
+  // Before uringTrans goes away, since the
+  // session points to it until it is reset.
+  pool.give( client );
+  }
+
+totalNs = getNanoSec() - allStart;
+return true;
+}
+
+
+
+bool LoopBench::runDownload( const Int32 port,
+                             const Int64 howMany,
+                             Int64& totalNs )
+{
+CharBuf hostBuf( "127.0.0.1" );
+CharBuf portBuf;
+makePortBuf( port, portBuf );
+
+TransportUring uringTrans;
+ClientTls client;
+if( uringLoop != nullptr )
+  {
+  uringTrans.setLoop( uringLoop );
+  client.setTransport( &uringTrans );
+  }
+
+CircleBuf appOutBuf;
+CircleBuf appInBuf;
+appOutBuf.setSize( 1024 * 64 );
+appInBuf.setSize( 1024 * 64 );
+
+// The sink just counts the bytes so the
+// app side costs nothing.
+SinkCallBack sink;
+sink.setFunction( countDownload, this );
+client.setAppSink( &sink );
+downloadGot = 0;
+
+if( !client.startTestVecHandshake( hostBuf,
+                                   portBuf ))
+  return false;
+
+Int64 start = 0;
+for( ;; )
+  {
+  Int32 status = client.processData(
+                          appOutBuf, appInBuf );
+  if( (start == 0) && client.isHandshakeDone())
+    start = getNanoSec();
+
+  if( downloadGot >= howMany )
+    break;
+
+  if( status < 0 )
+    return false;
+
+  if( status == 0 )
+    std::this_thread::yield();
+
+  }
+
+totalNs = getNanoSec() - start;
+return true;
+}
+
+
+
+bool LoopBench::runUpload( const Int32 port,
+                           const Int64 howMany,
+                           Int64& totalNs )
+{
+CharBuf hostBuf( "127.0.0.1" );
+CharBuf portBuf;
+makePortBuf( port, portBuf );
+
+TransportUring uringTrans;
+ClientTls client;
+if( uringLoop != nullptr )
+  {
+  uringTrans.setLoop( uringLoop );
+  client.setTransport( &uringTrans );
+  }
+
+CircleBuf appOutBuf;
+CircleBuf appInBuf;
+const Int32 outSize = 1024 * 256;
+appOutBuf.setSize( outSize );
+appInBuf.setSize( 1024 * 64 );
+
+// The bytes to send are made here, before
+// the clock starts, so the timed part only
+// adds whole chunks to the out buffer.
+const Int32 chunkSize = 1024 * 16;
+CharBuf chunk;
+for( Int32 count = 0; count < chunkSize; count++ )
+  chunk.appendU8( static_cast<Uint8>( count ));
+
+CharBuf tail;
+const Int32 tailSize = static_cast<Int32>(
+                          howMany % chunkSize );
+for( Int32 count = 0; count < tailSize; count++ )
+  tail.appendU8( static_cast<Uint8>( count ));
+
+if( !client.startTestVecHandshake( hostBuf,
+                                   portBuf ))
+  return false;
+
+Int64 start = 0;
+Int64 added = 0;
+for( ;; )
+  {
+  if( client.isHandshakeDone())
+    {
+    if( start == 0 )
+      start = getNanoSec();
+
+    // Keep the out buffer topped up.
+    Int32 room = outSize - 1 -
+                       appOutBuf.getHowMany();
+    while( added < howMany )
+      {
+      const CharBuf& toAdd =
+              ((howMany - added) >= chunkSize) ?
+                                  chunk : tail;
+      const Int32 toAddLast = toAdd.getLast();
+      if( toAddLast > room )
+        break;
+
+      appOutBuf.addCharBuf( toAdd );
+      added += toAddLast;
+      room -= toAddLast;
+      }
+    }
+
+  // The server closes the connection after
+  // it has read all of it.
+  Int32 status = client.processData(
+                          appOutBuf, appInBuf );
+  if( status < 0 )
+    break;
+
+  }
+
+if( added < howMany )
+  return false;
+
+totalNs = getNanoSec() - start;
+return true;
+}
+
+
+
+Int64 LoopBench::getPercentile(
+                        const Int32 perThousand )
+{
+if( latencyLast == 0 )
+  return 0;
+
+Int64 index = latencyLast;
+index *= perThousand;
+index /= 1000;
+if( index >= latencyLast )
+  index = latencyLast - 1;
+
+return latencies[index];
+}
+
+
+
+bool LoopBench::run( const Int32 handshakes,
+                     const Int64 bulkBytes )
+{
+if( handshakes < 1 )
+  throw "LoopBench needs at least one handshake.";
+
+if( (fastOpen || nonBlocking) &&
+    (uringLoop != nullptr))
+  throw "LoopBench socket options are not for uring.";
+
+Int64 handshakeNs = 0;
+Int64 downloadNs = 0;
+Int64 uploadNs = 0;
+
+SrvStandIn server;
+if( !server.start( 0, 0 ))
+  return false;
+
+if( !runHandshakes( server.getPort(),
+                    handshakes, handshakeNs ))
+  {
+  StIO::putS( "LoopBench handshakes failed." );
+  return false;
+  }
+
+if( server.getBadFinished() != 0 )
+  {
+  StIO::putS(
+         "LoopBench client Finished is wrong." );
+  return false;
+  }
+
+server.stop();
+
+if( bulkBytes > 0 )
+  {
+  SrvStandIn downServer;
+  if( !downServer.start( bulkBytes, 0 ))
+    return false;
+
+  if( !runDownload( downServer.getPort(),
+                    bulkBytes, downloadNs ))
+    {
+    StIO::putS( "LoopBench download failed." );
+    return false;
+    }
+
+  downServer.stop();
+
+  SrvStandIn upServer;
+  if( !upServer.start( 0, bulkBytes ))
+    return false;
+
+  if( !runUpload( upServer.getPort(),
+                  bulkBytes, uploadNs ))
+    {
+    StIO::putS( "LoopBench upload failed." );
+    return false;
+    }
+  }
+
+std::sort( latencies, latencies + latencyLast );
+
+double perSec = 0;
+if( handshakeNs > 0 )
+  perSec = (static_cast<double>( latencyLast ) *
+            1.0e9) / static_cast<double>(
+                                 handshakeNs );
+
+double downMBps = 0;
+if( downloadNs > 0 )
+  downMBps = (static_cast<double>( bulkBytes ) *
+             1000.0) / static_cast<double>(
+                                  downloadNs );
+
+double upMBps = 0;
+if( uploadNs > 0 )
+  upMBps = (static_cast<double>( bulkBytes ) *
+           1000.0) / static_cast<double>(
+                                    uploadNs );
+
+// The handshakes use the RFC 8448 keys, so
+// there is no key generation or key
+// exchange math in them.  hsKind says so,
+// so the number doesn't get compared with
+// a real handshake.
+char jsonChars[512];
+::snprintf( jsonChars, sizeof( jsonChars ),
+       "{\"transport\":\"%s\","
+       "\"hsKind\":\"rfc8448 record layer only\","
+       "\"handshakes\":%d,"
+       "\"handshakesPerSec\":%.1f,"
+       "\"p50Us\":%.1f,"
+       "\"p99Us\":%.1f,"
+       "\"p999Us\":%.1f,"
+       "\"downloadMBps\":%.1f,"
+       "\"uploadMBps\":%.1f,"
+       "\"tfoAttempts\":%lld,"
+       "\"tfoSuccesses\":%lld}",
+       getTransportName(),
+       latencyLast, perSec,
+       static_cast<double>( getPercentile( 500 ))
+                                     / 1000.0,
+       static_cast<double>( getPercentile( 990 ))
+                                     / 1000.0,
+       static_cast<double>( getPercentile( 999 ))
+                                     / 1000.0,
+       downMBps, upMBps,
+       static_cast<long long>( tfoAttempts ),
+       static_cast<long long>( tfoSuccesses ));
+
+StIO::putS( jsonChars );
+return true;
+}
@@ -0,0 +1,146 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This measures the client against
+// SrvStandIn on loopback, so there is no
+// network and no real server in the
+// numbers.  It does a number of full
+// handshakes, then one big download and
+// one big upload.
+
+// It prints one line of JSON so a script
+// can compare one build with another:
+// handshakes per second, the p50, p99 and
+// p99.9 handshake latency in microseconds,
+// and the download and upload rates in
+// megabytes per second.
+
+// SrvStandIn only plays back RFC 8448, so
+// the handshakes here are
+// startTestVecHandshake() with fixed keys.
+// There is no key share, no ML-KEM and no
+// certificate work in them, only the
+// messages and the record layer.  The JSON
+// has "hsKind": "rfc8448 record layer only"
+// so nobody takes it for the cost of
+// startHandshake().  MicroBench has the
+// crypto parts.
+
+// With setUringLoop() every client does its
+// I/O through a TransportUring on that loop,
+// so the two can be compared.
+
+// With setFastOpen() the handshake clients
+// use TCP Fast Open.  The first connection
+// gets the cookie and the rest can send the
+// ClientHello in the SYN.  It says how many
+// tried it and how many the server took.
+// Over loopback it needs:
+// sysctl -w net.ipv4.tcp_fastopen=3
+
+// With setNonBlocking() the handshake
+// clients use a TcpSockCl that doesn't
+// block.  With both set, the first send on
+// a connection with no cookie yet only
+// starts the connect, and the ClientHello
+// waits in the transport until it is done.
+
+// The app's main() calls run().
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "UringLoop.h"
+
+
+
+class LoopBench
+  {
+  private:
+  bool testForCopy = false;
+  Int64* latencies = nullptr;
+  Int32 latencyLast = 0;
+  Int64 downloadGot = 0;
+  UringLoop* uringLoop = nullptr;
+  bool fastOpen = false;
+  bool nonBlocking = false;
+  Int64 tfoAttempts = 0;
+  Int64 tfoSuccesses = 0;
+
+  static Int64 getNanoSec( void );
+  static void makePortBuf( const Int32 port,
+                           CharBuf& portBuf );
+  static bool countDownload(
+                        const CharBuf& plainBuf,
+                        void* context );
+
+  bool runHandshakes( const Int32 port,
+                      const Int32 howMany,
+                      Int64& totalNs );
+  bool runDownload( const Int32 port,
+                    const Int64 howMany,
+                    Int64& totalNs );
+  bool runUpload( const Int32 port,
+                  const Int64 howMany,
+                  Int64& totalNs );
+  Int64 getPercentile( const Int32 perThousand );
+  const char* getTransportName( void ) const;
+
+  public:
+  LoopBench( void )
+    {
+    }
+
+  LoopBench( const LoopBench& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "LoopBench copy constructor.";
+    }
+
+  ~LoopBench( void )
+    {
+    delete[] latencies;
+    }
+
+  // The caller owns the loop.
+  void setUringLoop( UringLoop* setTo )
+    {
+    uringLoop = setTo;
+    }
+
+  // Not with setUringLoop().  It has its own
+  // socket.
+  void setFastOpen( const bool setTo )
+    {
+    fastOpen = setTo;
+    }
+
+  // Not with setUringLoop() either.
+  void setNonBlocking( const bool setTo )
+    {
+    nonBlocking = setTo;
+    }
+
+  bool run( const Int32 handshakes,
+            const Int64 bulkBytes );
+
+  };
@@ -0,0 +1,529 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "MemSrv.h"
+#include "CurveCtx.h"
+#include "P256.h"
+#include "MlKem768.h"
+#include "ChaChaRand.h"
+#include "Rfc8448Vec.h"
+#include "LogCl.h"
+#include "../Network/Handshake.h"
+#include "../Network/TlsOuterRec.h"
+
+#include <string.h>
+
+
+
+bool MemSrv::findShare( const CharBuf& cHelloMsg,
+                        const Uint32 group,
+                        CharBuf& shareBuf )
+{
+// RFC 8446 Section 4.1.2.  This is only
+// for the client in this repository, so it
+// doesn't check much.
+
+shareBuf.clear();
+sessionIDBuf.clear();
+
+const Int32 last = cHelloMsg.getLast();
+
+// Type, length, version and random.
+Int32 index = 4 + 2 + 32;
+if( (index + 1) > last )
+  return false;
+
+const Int32 sessionIDLast = cHelloMsg.getU8( index );
+index++;
+if( (index + sessionIDLast) > last )
+  return false;
+
+for( Int32 count = 0; count < sessionIDLast;
+                                     count++ )
+  sessionIDBuf.appendU8( cHelloMsg.getU8(
+                                 index + count ));
+
+index += sessionIDLast;
+
+// Cipher suites and compression methods.
+if( (index + 2) > last )
+  return false;
+
+index += 2 + ((cHelloMsg.getU8( index ) << 8) |
+               cHelloMsg.getU8( index + 1 ));
+if( (index + 1) > last )
+  return false;
+
+index += 1 + cHelloMsg.getU8( index );
+if( (index + 2) > last )
+  return false;
+
+const Int32 extEnd = index + 2 +
+               ((cHelloMsg.getU8( index ) << 8) |
+                 cHelloMsg.getU8( index + 1 ));
+if( extEnd > last )
+  return false;
+
+index += 2;
+while( (index + 4) <= extEnd )
+  {
+  const Uint32 extType = static_cast<Uint32>(
+             (cHelloMsg.getU8( index ) << 8) |
+              cHelloMsg.getU8( index + 1 ));
+  const Int32 extLength =
+             (cHelloMsg.getU8( index + 2 ) << 8) |
+              cHelloMsg.getU8( index + 3 );
+  const Int32 dataAt = index + 4;
+  index = dataAt + extLength;
+  if( index > extEnd )
+    return false;
+
+  // key_share.
+  if( extType != 51 )
+    continue;
+
+  // The list length comes first.
+  Int32 shareAt = dataAt + 2;
+  while( (shareAt + 4) <= index )
+    {
+    const Uint32 shareGroup = static_cast<Uint32>(
+             (cHelloMsg.getU8( shareAt ) << 8) |
+              cHelloMsg.getU8( shareAt + 1 ));
+    const Int32 keyLast =
+             (cHelloMsg.getU8( shareAt + 2 ) << 8) |
+              cHelloMsg.getU8( shareAt + 3 );
+    shareAt += 4;
+    if( (shareAt + keyLast) > index )
+      return false;
+
+    if( shareGroup == group )
+      {
+      for( Int32 count = 0; count < keyLast;
+                                     count++ )
+        shareBuf.appendU8( cHelloMsg.getU8(
+                               shareAt + count ));
+
+      return true;
+      }
+
+    shareAt += keyLast;
+    }
+  }
+
+return false;
+}
+
+
+
+bool MemSrv::makeSecret( const Uint32 group,
+                         const CharBuf& clShareBuf,
+                         CharBuf& srvShareBuf,
+                         CharBuf& secretBuf )
+{
+srvShareBuf.clear();
+secretBuf.clear();
+
+if( group == P256::GroupID )
+  return makeP256Secret( clShareBuf, srvShareBuf,
+                         secretBuf );
+
+if( group == MlKem768::HybridGroupID )
+  return makeHybridSecret( clShareBuf,
+                           srvShareBuf,
+                           secretBuf );
+
+if( group != CurveCtx::GroupID )
+  return false;
+
+if( clShareBuf.getLast() != 32 )
+  return false;
+
+Uint8 keyBytes[32];
+ChaChaRand::fillBytes( keyBytes, 32 );
+
+Integer k;
+CurveCtx::privKeyToInt( keyBytes, k );
+
+Integer pubKey;
+CurveCtx::baseMult( pubKey, k );
+CurveCtx::intToBytes( pubKey, srvShareBuf );
+
+for( Int32 count = 0; count < 32; count++ )
+  keyBytes[count] = clShareBuf.getU8( count );
+
+Integer clU;
+CurveCtx::bytesToInt( keyBytes, clU );
+
+Integer sharedS;
+CurveCtx::ladder( sharedS, clU, k );
+CurveCtx::intToBytes( sharedS, secretBuf );
+
+::explicit_bzero( keyBytes, sizeof( keyBytes ));
+return true;
+}
+
+
+
+bool MemSrv::makeP256Secret(
+                         const CharBuf& clShareBuf,
+                         CharBuf& srvShareBuf,
+                         CharBuf& secretBuf )
+{
+// The share is the uncompressed point and
+// the secret is the X coordinate.
+
+if( clShareBuf.getLast() != P256::PointBytes )
+  return false;
+
+Uint8 privKey[P256::ScalarBytes];
+Uint8 pubKey[P256::PointBytes];
+P256::makeKeyPair( privKey, pubKey );
+
+for( Int32 count = 0; count < P256::PointBytes;
+                                       count++ )
+  srvShareBuf.appendU8( pubKey[count] );
+
+Uint8 clPub[P256::PointBytes];
+for( Int32 count = 0; count < P256::PointBytes;
+                                       count++ )
+  clPub[count] = clShareBuf.getU8( count );
+
+Uint8 secret[P256::ScalarBytes];
+const bool good = P256::sharedSecret( privKey,
+                                      clPub,
+                                      secret );
+if( good )
+  {
+  for( Int32 count = 0; count < P256::ScalarBytes;
+                                         count++ )
+    secretBuf.appendU8( secret[count] );
+
+  }
+
+::explicit_bzero( privKey, sizeof( privKey ));
+::explicit_bzero( secret, sizeof( secret ));
+return good;
+}
+
+
+
+bool MemSrv::makeHybridSecret(
+                         const CharBuf& clShareBuf,
+                         CharBuf& srvShareBuf,
+                         CharBuf& secretBuf )
+{
+// draft-ietf-tls-ecdhe-mlkem Section 3.
+// The client share is the encapsulation
+// key and then its X25519 key.  The server
+// share is the ciphertext and then its
+// X25519 key, and the secret is the ML-KEM
+// secret and then the X25519 one.
+
+if( clShareBuf.getLast() !=
+              (MlKem768::EncapKeyBytes + 32))
+  return false;
+
+Uint8* encapKey = new Uint8[
+                     MlKem768::EncapKeyBytes];
+for( Int32 count = 0;
+        count < MlKem768::EncapKeyBytes; count++ )
+  encapKey[count] = clShareBuf.getU8( count );
+
+Uint8* cipher = new Uint8[MlKem768::CipherBytes];
+Uint8 mlKemSecret[MlKem768::SecretBytes];
+bool good = MlKem768::encaps( encapKey, cipher,
+                              mlKemSecret );
+delete[] encapKey;
+
+CharBuf clX25519Buf;
+for( Int32 count = 0; count < 32; count++ )
+  clX25519Buf.appendU8( clShareBuf.getU8(
+            MlKem768::EncapKeyBytes + count ));
+
+CharBuf srvX25519Buf;
+CharBuf x25519Secret;
+if( good )
+  good = makeSecret( CurveCtx::GroupID,
+                     clX25519Buf, srvX25519Buf,
+                     x25519Secret );
+
+if( good )
+  {
+  for( Int32 count = 0;
+           count < MlKem768::CipherBytes; count++ )
+    srvShareBuf.appendU8( cipher[count] );
+
+  srvShareBuf.appendCharBuf( srvX25519Buf );
+
+  for( Int32 count = 0;
+           count < MlKem768::SecretBytes; count++ )
+    secretBuf.appendU8( mlKemSecret[count] );
+
+  secretBuf.appendCharBuf( x25519Secret );
+  }
+
+delete[] cipher;
+::explicit_bzero( mlKemSecret,
+                  sizeof( mlKemSecret ));
+for( Int32 count = 0;
+           count < x25519Secret.getLast(); count++ )
+  x25519Secret.setU8( count, 0 );
+
+return good;
+}
+
+
+
+void MemSrv::makeSrvHello( const Uint32 group,
+                           const CharBuf& srvShareBuf,
+                           CharBuf& msgBuf )
+{
+// RFC 8446 Section 4.1.3.
+
+CharBuf bodyBuf;
+bodyBuf.appendU8( 3 );
+bodyBuf.appendU8( 3 );
+ChaChaRand::appendBytes( bodyBuf, 32 );
+
+bodyBuf.appendU8( static_cast<Uint8>(
+                    sessionIDBuf.getLast()));
+bodyBuf.appendCharBuf( sessionIDBuf );
+
+// TLS_AES_128_GCM_SHA256 and no
+// compression.
+bodyBuf.appendU8( 0x13 );
+bodyBuf.appendU8( 0x01 );
+bodyBuf.appendU8( 0 );
+
+const Int32 shareLast = srvShareBuf.getLast();
+CharBuf extBuf;
+
+// supported_versions with 3.4.
+extBuf.appendU8( 0 );
+extBuf.appendU8( 43 );
+extBuf.appendU8( 0 );
+extBuf.appendU8( 2 );
+extBuf.appendU8( 3 );
+extBuf.appendU8( 4 );
+
+// key_share.
+extBuf.appendU8( 0 );
+extBuf.appendU8( 51 );
+extBuf.appendU8( static_cast<Uint8>(
+                      (shareLast + 4) >> 8 ));
+extBuf.appendU8( static_cast<Uint8>(
+                       shareLast + 4 ));
+extBuf.appendU8( static_cast<Uint8>( group >> 8 ));
+extBuf.appendU8( static_cast<Uint8>( group ));
+extBuf.appendU8( static_cast<Uint8>(
+                             shareLast >> 8 ));
+extBuf.appendU8( static_cast<Uint8>( shareLast ));
+extBuf.appendCharBuf( srvShareBuf );
+
+const Int32 extLast = extBuf.getLast();
+bodyBuf.appendU8( static_cast<Uint8>(
+                              extLast >> 8 ));
+bodyBuf.appendU8( static_cast<Uint8>( extLast ));
+bodyBuf.appendCharBuf( extBuf );
+
+const Int32 bodyLast = bodyBuf.getLast();
+msgBuf.clear();
+msgBuf.appendU8( Handshake::ServerHelloID );
+msgBuf.appendU8( static_cast<Uint8>(
+                             bodyLast >> 16 ));
+msgBuf.appendU8( static_cast<Uint8>(
+                             bodyLast >> 8 ));
+msgBuf.appendU8( static_cast<Uint8>( bodyLast ));
+msgBuf.appendCharBuf( bodyBuf );
+}
+
+
+
+bool MemSrv::takeClHello( const CharBuf& clRecBuf,
+                          const Uint32 group,
+                          CharBuf& flightBuf )
+{
+flightBuf.clear();
+finishedOk = false;
+
+const Int32 recLast = clRecBuf.getLast();
+if( (recLast < 5) || (clRecBuf.getU8( 0 ) !=
+                         TlsOuterRec::Handshake))
+  return false;
+
+CharBuf cHelloMsg;
+for( Int32 count = 5; count < recLast; count++ )
+  cHelloMsg.appendU8( clRecBuf.getU8( count ));
+
+CharBuf clShareBuf;
+if( !findShare( cHelloMsg, group, clShareBuf ))
+  {
+  LogCl::warn( "MemSrv has no share for the group." );
+  return false;
+  }
+
+CharBuf srvShareBuf;
+CharBuf secretBuf;
+if( !makeSecret( group, clShareBuf, srvShareBuf,
+                 secretBuf ))
+  return false;
+
+CharBuf sHelloMsg;
+makeSrvHello( group, srvShareBuf, sHelloMsg );
+
+const Int32 sHelloLast = sHelloMsg.getLast();
+flightBuf.appendU8( TlsOuterRec::Handshake );
+flightBuf.appendU8( 3 );
+flightBuf.appendU8( 3 );
+flightBuf.appendU8( static_cast<Uint8>(
+                           sHelloLast >> 8 ));
+flightBuf.appendU8( static_cast<Uint8>(
+                                sHelloLast ));
+flightBuf.appendCharBuf( sHelloMsg );
+
+keySched.clear();
+keySched.addMsg( cHelloMsg );
+keySched.addMsg( sHelloMsg );
+keySched.setHsSecret( secretBuf );
+for( Int32 count = 0; count < secretBuf.getLast();
+                                        count++ )
+  secretBuf.setU8( count, 0 );
+
+CharBuf key;
+CharBuf iv;
+keySched.getSrvHsKey( key, iv );
+srvWrite.setKey( key, iv );
+keySched.getClHsKey( key, iv );
+clRead.setKey( key, iv );
+
+CharBuf plainBuf;
+Rfc8448Vec::getSrvHsPlain( plainBuf );
+keySched.addMsg( plainBuf );
+
+CharBuf finMsg;
+keySched.makeSrvFinished( finMsg );
+keySched.addMsg( finMsg );
+plainBuf.appendCharBuf( finMsg );
+
+srvWrite.seal( plainBuf, TlsOuterRec::Handshake,
+               flightBuf );
+return true;
+}
+
+
+
+bool MemSrv::openRec( const CharBuf& recBuf,
+                      RecCipher& recCipher,
+                      const Uint8 wantType,
+                      CharBuf& plainBuf )
+{
+plainBuf.clear();
+
+const Int32 recLast = recBuf.getLast();
+if( recLast < 5 )
+  return false;
+
+if( recBuf.getU8( 0 ) !=
+                   TlsOuterRec::ApplicationData )
+  return false;
+
+const Int32 length = (recBuf.getU8( 3 ) << 8) |
+                      recBuf.getU8( 4 );
+if( (length + 5) != recLast )
+  return false;
+
+CharBuf cipherBuf;
+for( Int32 count = 5; count < recLast; count++ )
+  cipherBuf.appendU8( recBuf.getU8( count ));
+
+CharBuf innerBuf;
+if( !recCipher.open( cipherBuf, innerBuf ))
+  return false;
+
+// Take off the padding and the content
+// type.  RFC 8446 Section 5.4.
+Int32 innerLast = innerBuf.getLast();
+while( (innerLast > 0) &&
+       (innerBuf.getU8( innerLast - 1 ) == 0))
+  innerLast--;
+
+if( innerLast == 0 )
+  return false;
+
+if( innerBuf.getU8( innerLast - 1 ) != wantType )
+  return false;
+
+innerBuf.truncateLast( innerLast - 1 );
+plainBuf.copy( innerBuf );
+return true;
+}
+
+
+
+bool MemSrv::takeClFinished( const CharBuf& recBuf )
+{
+CharBuf finMsg;
+if( !openRec( recBuf, clRead,
+              TlsOuterRec::Handshake, finMsg ))
+  {
+  LogCl::warn( "MemSrv client Finished record." );
+  return false;
+  }
+
+if( !keySched.checkClFinished( finMsg ))
+  {
+  LogCl::warn( "MemSrv client Finished is not right." );
+  return false;
+  }
+
+keySched.setAppSecrets();
+
+CharBuf key;
+CharBuf iv;
+keySched.getSrvAppKey( key, iv );
+srvWrite.setKey( key, iv );
+keySched.getClAppKey( key, iv );
+clRead.setKey( key, iv );
+
+finishedOk = true;
+return true;
+}
+
+
+
+void MemSrv::sealAppData( const CharBuf& plainBuf,
+                          CharBuf& recBuf )
+{
+if( !finishedOk )
+  throw "MemSrv app data before Finished.";
+
+srvWrite.seal( plainBuf,
+               TlsOuterRec::ApplicationData,
+               recBuf );
+}
+
+
+
+bool MemSrv::openAppData( const CharBuf& recBuf,
+                          CharBuf& plainBuf )
+{
+if( !finishedOk )
+  return false;
+
+return openRec( recBuf, clRead,
+                TlsOuterRec::ApplicationData,
+                plainBuf );
+}
@@ -0,0 +1,114 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The server side of a TLS 1.3 handshake in
+// memory, for the loopback checks in
+// OfflineVec.  Unlike SrvStandIn it makes
+// its own key share and its own keys, so
+// the client can use startHandshake() with
+// a random key.  It sends the
+// EncryptedExtensions, Certificate and
+// CertificateVerify from RFC 8448 with its
+// own handshake key.  The client doesn't
+// check the signature, so that's enough to
+// get through the handshake.
+
+// This is for testing the client.  It is
+// not a real server.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "KeySched.h"
+#include "RecCipher.h"
+
+
+
+class MemSrv
+  {
+  private:
+  bool testForCopy = false;
+  KeySched keySched;
+  RecCipher srvWrite;
+  RecCipher clRead;
+  CharBuf sessionIDBuf;
+  bool finishedOk = false;
+
+  bool findShare( const CharBuf& cHelloMsg,
+                  const Uint32 group,
+                  CharBuf& shareBuf );
+  bool makeSecret( const Uint32 group,
+                   const CharBuf& clShareBuf,
+                   CharBuf& srvShareBuf,
+                   CharBuf& secretBuf );
+  bool makeP256Secret( const CharBuf& clShareBuf,
+                       CharBuf& srvShareBuf,
+                       CharBuf& secretBuf );
+  bool makeHybridSecret(
+                      const CharBuf& clShareBuf,
+                      CharBuf& srvShareBuf,
+                      CharBuf& secretBuf );
+  void makeSrvHello( const Uint32 group,
+                     const CharBuf& srvShareBuf,
+                     CharBuf& msgBuf );
+  bool openRec( const CharBuf& recBuf,
+                RecCipher& recCipher,
+                const Uint8 wantType,
+                CharBuf& plainBuf );
+
+  public:
+  MemSrv( void )
+    {
+    }
+
+  MemSrv( const MemSrv& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "MemSrv copy constructor.";
+    }
+
+  ~MemSrv( void )
+    {
+    }
+
+  // clRecBuf is the ClientHello record.
+  // flightBuf gets the ServerHello record
+  // and then one record with the rest of the
+  // server's flight.  It is false if the
+  // client didn't offer a share for group.
+  bool takeClHello( const CharBuf& clRecBuf,
+                    const Uint32 group,
+                    CharBuf& flightBuf );
+
+  // The client Finished record.  If it is
+  // right then it has the application keys.
+  bool takeClFinished( const CharBuf& recBuf );
+
+  void sealAppData( const CharBuf& plainBuf,
+                    CharBuf& recBuf );
+
+  // One whole record.  plainBuf doesn't have
+  // the content type on it.
+  bool openAppData( const CharBuf& recBuf,
+                    CharBuf& plainBuf );
+
+  };
@@ -0,0 +1,1379 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "MicroBench.h"
+#include "HandshakeCl.h"
+#include "TlsMainCl.h"
+#include "AesGcm.h"
+#include "DecryptPool.h"
+#include "SinkCallBack.h"
+#include "Rfc8448Vec.h"
+#include "ChaChaRand.h"
+#include "P256.h"
+#include "MlKem768.h"
+#include "CurveCtx.h"
+#include "CertChainView.h"
+#include "../Network/TlsMain.h"
+#include "../Network/TlsOuterRec.h"
+#include "../Network/Results.h"
+#include "../Network/ExtenList.h"
+#include "../Network/EncryptTls.h"
+#include "../CppInt/Integer.h"
+#include "../CryptoBase/Randomish.h"
+#include "../CppBase/StIO.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+  #include <x86intrin.h>
+#endif
+
+
+
+Int64 MicroBench::getNanoSec( void )
+{
+timespec now;
+::clock_gettime( CLOCK_MONOTONIC, &now );
+
+Int64 result = now.tv_sec;
+result *= 1000000000LL;
+result += now.tv_nsec;
+return result;
+}
+
+
+
+Uint64 MicroBench::getTicks( void )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+
+
+void MicroBench::timeKernel( const char* name,
+                             BenchKernel kernel,
+                             void* context,
+                             const Int64 bytesPerOp )
+{
+// Warm up for about 50 milliseconds and
+// find out how many calls fit in about
+// 20 milliseconds.
+
+Int64 warmCalls = 0;
+const Int64 warmStart = getNanoSec();
+Int64 warmNs = 0;
+while( warmNs < 50000000LL )
+  {
+  kernel( context );
+  warmCalls++;
+  warmNs = getNanoSec() - warmStart;
+  }
+
+Int64 batchCalls = (warmCalls * 20) / 50;
+if( batchCalls < 1 )
+  batchCalls = 1;
+
+double nsPerOp[Batches];
+double ticksPerOp[Batches];
+
+for( Int32 batch = 0; batch < Batches; batch++ )
+  {
+  const Uint64 ticksStart = getTicks();
+  const Int64 start = getNanoSec();
+
+  for( Int64 count = 0; count < batchCalls;
+                                     count++ )
+    kernel( context );
+
+  const Int64 ns = getNanoSec() - start;
+  const Uint64 ticks = getTicks() - ticksStart;
+
+  nsPerOp[batch] = static_cast<double>( ns ) /
+                   static_cast<double>( batchCalls );
+  ticksPerOp[batch] = static_cast<double>( ticks ) /
+                   static_cast<double>( batchCalls );
+  }
+
+std::sort( nsPerOp, nsPerOp + Batches );
+std::sort( ticksPerOp, ticksPerOp + Batches );
+
+const Int32 middle = Batches / 2;
+
+char lineChars[256];
+Int32 where = ::snprintf( lineChars,
+         sizeof( lineChars ),
+         "%-24s %12.1f ns/op  (min %.1f, max %.1f)",
+         name, nsPerOp[middle], nsPerOp[0],
+         nsPerOp[Batches - 1] );
+
+if( (bytesPerOp > 0) && (ticksPerOp[middle] > 0) &&
+    (where > 0) &&
+    (where < static_cast<Int32>( sizeof( lineChars ))))
+  {
+  ::snprintf( lineChars + where,
+         sizeof( lineChars ) -
+                  static_cast<size_t>( where ),
+         "  %.2f ticks/byte",
+         ticksPerOp[middle] / static_cast<double>(
+                                  bytesPerOp ));
+  }
+
+StIO::putS( lineChars );
+}
+
+
+
+// The kernels and the things they work on.
+
+
+
+class OuterRecBench
+  {
+  public:
+  TlsOuterRec outerRec;
+  CharBuf recordBytes;
+  };
+
+
+
+static void outerRecKernel( void* context )
+{
+OuterRecBench* bench =
+           static_cast<OuterRecBench*>( context );
+
+// Frame one whole record.
+const Int32 last = bench->recordBytes.getLast();
+for( Int32 count = 0; count < last; count++ )
+  {
+  Uint32 result = bench->outerRec.accumByte(
+               bench->recordBytes.getU8( count ));
+  if( result == Results::Continue )
+    continue;
+
+  if( result != Results::Done )
+    throw "MicroBench outerRec not Done.";
+
+  bench->outerRec.clear();
+  }
+}
+
+
+
+void MicroBench::benchOuterRec( void )
+{
+OuterRecBench* bench = new OuterRecBench;
+
+const Int32 dataLast = 1024 * 16;
+bench->recordBytes.appendU8(
+                 TlsOuterRec::ApplicationData );
+bench->recordBytes.appendU8( 3 );
+bench->recordBytes.appendU8( 3 );
+bench->recordBytes.appendU8(
+              static_cast<Uint8>( dataLast >> 8 ));
+bench->recordBytes.appendU8(
+              static_cast<Uint8>( dataLast ));
+
+for( Int32 count = 0; count < dataLast; count++ )
+  bench->recordBytes.appendU8(
+                  static_cast<Uint8>( count ));
+
+timeKernel( "outerrec 16K", outerRecKernel,
+            bench,
+            bench->recordBytes.getLast());
+
+delete bench;
+}
+
+
+
+class HsAccumBench
+  {
+  public:
+  HandshakeCl handshakeCl;
+  CharBuf msgBytes;
+  };
+
+
+
+void MicroBench::hsAccumKernel( void* context )
+{
+HsAccumBench* bench =
+            static_cast<HsAccumBench*>( context );
+
+HandshakeCl& handshakeCl = bench->handshakeCl;
+
+const Int32 last = bench->msgBytes.getLast();
+for( Int32 count = 0; count < last; count++ )
+  {
+  Uint32 result = handshakeCl.accumByte(
+                 bench->msgBytes.getU8( count ));
+  if( result == Results::Continue )
+    continue;
+
+  if( result != Results::Done )
+    throw "MicroBench hsAccum not Done.";
+
+  handshakeCl.endMsg();
+  }
+}
+
+
+
+void MicroBench::benchHandshakeAccum( void )
+{
+HsAccumBench* bench = new HsAccumBench;
+
+// About the size of a Certificate message
+// with a short chain.
+const Int32 bodyLast = 4000;
+bench->msgBytes.appendU8(
+                     Handshake::CertificateID );
+bench->msgBytes.appendU8( 0 );
+bench->msgBytes.appendU8(
+              static_cast<Uint8>( bodyLast >> 8 ));
+bench->msgBytes.appendU8(
+              static_cast<Uint8>( bodyLast ));
+
+for( Int32 count = 0; count < bodyLast; count++ )
+  bench->msgBytes.appendU8(
+                  static_cast<Uint8>( count ));
+
+timeKernel( "hsaccum 4000", hsAccumKernel,
+            bench, bench->msgBytes.getLast());
+
+delete bench;
+}
+
+
+
+class MontLadderBench
+  {
+  public:
+  Integer k;
+  Integer U;
+  Integer result;
+  };
+
+
+
+static void montLadderKernel( void* context )
+{
+MontLadderBench* bench =
+         static_cast<MontLadderBench*>( context );
+
+CurveCtx::ladder( bench->result, bench->U,
+                  bench->k );
+}
+
+
+
+static void montLadderNewKernel( void* context )
+{
+// What it cost when each connection had its
+// own engines, to compare with the one
+// CurveCtx keeps for the thread.
+MontLadderBench* bench =
+         static_cast<MontLadderBench*>( context );
+
+IntegerMath intMath;
+Mod mod;
+MCurve mCurve;
+mCurve.montLadder1( bench->result, bench->U,
+                    bench->k, intMath, mod );
+}
+
+
+
+void MicroBench::benchMontLadder( void )
+{
+MontLadderBench* bench = new MontLadderBench;
+
+// The RFC 8448 client private key.
+CharBuf privKeyStrBuf(
+      "49 af 42 ba 7f 79 94 85"
+      "2d 71 3e f2 78 4b cb ca"
+      "a7 91 1d e2 6a dc 56 42"
+      "cb 63 45 40 e7 ea 50 05" );
+
+CharBuf privKeyBuf;
+privKeyBuf.setFromHexTo256( privKeyStrBuf );
+Uint8 keyBytes[32];
+for( Int32 count = 0; count < 32; count++ )
+  keyBytes[count] = privKeyBuf.getU8( count );
+
+CurveCtx::privKeyToInt( keyBytes, bench->k );
+bench->U.setFromLong48( 9 );
+
+timeKernel( "montladder x25519", montLadderKernel,
+            bench, 0 );
+timeKernel( "montladder new engines",
+            montLadderNewKernel, bench, 0 );
+
+delete bench;
+}
+
+
+
+class AeadBench
+  {
+  public:
+  AesGcm aesGcm;
+  Uint8 header[5] = { 0 };
+  Uint8* plain = nullptr;
+  Uint8* cipher = nullptr;
+  Int32 plainLast = 0;
+  };
+
+
+
+static void sealKernel( void* context )
+{
+AeadBench* bench = static_cast<AeadBench*>(
+                                    context );
+
+bench->aesGcm.seal( 1, bench->header, 5,
+                    bench->plain,
+                    bench->plainLast,
+                    bench->cipher );
+}
+
+
+
+static void openKernel( void* context )
+{
+AeadBench* bench = static_cast<AeadBench*>(
+                                    context );
+
+if( !bench->aesGcm.open( 1, bench->header, 5,
+                 bench->cipher,
+                 bench->plainLast + AesGcm::TagSize,
+                 bench->plain ))
+  throw "MicroBench open failed.";
+
+}
+
+
+
+void MicroBench::benchAead( void )
+{
+AeadBench* bench = new AeadBench;
+
+Uint8 key[AesGcm::KeySize];
+Uint8 iv[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  key[count] = static_cast<Uint8>( count );
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  iv[count] = static_cast<Uint8>( count * 3 );
+
+bench->aesGcm.setKey( key, iv );
+
+const Int32 maxLast = 1024 * 16;
+bench->plain = new Uint8[maxLast];
+bench->cipher = new Uint8[maxLast +
+                             AesGcm::TagSize];
+
+for( Int32 count = 0; count < maxLast; count++ )
+  bench->plain[count] = static_cast<Uint8>(
+                                      count );
+
+const Int32 sizes[] = { 64, 1024, 4096,
+                        1024 * 16 };
+
+for( Int32 size : sizes )
+  {
+  bench->plainLast = size;
+  const Int32 cipherLast = size +
+                            AesGcm::TagSize;
+  bench->header[0] = TlsOuterRec::ApplicationData;
+  bench->header[1] = 3;
+  bench->header[2] = 3;
+  bench->header[3] = static_cast<Uint8>(
+                              cipherLast >> 8 );
+  bench->header[4] = static_cast<Uint8>(
+                                  cipherLast );
+
+  char nameChars[64];
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "aead seal %d", size );
+  timeKernel( nameChars, sealKernel, bench,
+              size );
+
+  // Now cipher has a good record to open.
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "aead open %d", size );
+  timeKernel( nameChars, openKernel, bench,
+              size );
+  }
+
+delete[] bench->plain;
+delete[] bench->cipher;
+delete bench;
+}
+
+
+
+// One operation is RecCount full records
+// through the DecryptPool, in order.  Each
+// plaintext starts with its record number,
+// so a record that comes out in the wrong
+// place or with the wrong sequence number
+// gets counted.  The records were sealed
+// with sequence numbers from zero, so the
+// pool starts over for each operation.
+// That is a thread start per operation, and
+// it is small next to 4 MB of AES-GCM.
+
+class ParDecBench
+  {
+  public:
+  static const Int32 RecCount = 256;
+  static const Int32 PlainLast = 1024 * 16;
+
+  CharBuf key;
+  CharBuf iv;
+  AesGcm aesGcm;
+  CharBuf* records = nullptr;
+  DecryptPool pool;
+  Int32 threads = 0;
+  Int64 errors = 0;
+  Int32 firstBad = -1;
+
+  // For the serial one.
+  Uint8* cipher = nullptr;
+  Uint8* plain = nullptr;
+  CharBuf plainBuf;
+  };
+
+
+
+static bool parDecGood( const CharBuf& plainBuf,
+                        const Int32 which )
+{
+if( plainBuf.getLast() != ParDecBench::PlainLast )
+  return false;
+
+for( Int32 count = 0; count < 4; count++ )
+  {
+  if( plainBuf.getU8( count ) != static_cast<Uint8>(
+                     which >> (24 - (count * 8))))
+    return false;
+
+  }
+
+return plainBuf.getU8( ParDecBench::PlainLast - 1 ) ==
+                 static_cast<Uint8>( which +
+                     ParDecBench::PlainLast - 1 );
+}
+
+
+
+static void parDecSerialKernel( void* context )
+{
+// What the I/O thread does without the
+// pool.
+ParDecBench* bench = static_cast<ParDecBench*>(
+                                       context );
+
+Uint8 header[5];
+header[0] = TlsOuterRec::ApplicationData;
+header[1] = 3;
+header[2] = 3;
+
+for( Int32 which = 0; which < ParDecBench::RecCount;
+                                       which++ )
+  {
+  const CharBuf& record = bench->records[which];
+  const Int32 last = record.getLast();
+  header[3] = static_cast<Uint8>( last >> 8 );
+  header[4] = static_cast<Uint8>( last );
+
+  for( Int32 count = 0; count < last; count++ )
+    bench->cipher[count] = record.getU8( count );
+
+  bench->plainBuf.clear();
+  if( !bench->aesGcm.open(
+                  static_cast<Uint64>( which ),
+                  header, 5, bench->cipher,
+                  last, bench->plain ))
+    {
+    bench->errors++;
+    continue;
+    }
+
+  const Int32 plainLast = last - AesGcm::TagSize;
+  for( Int32 count = 0; count < plainLast; count++ )
+    bench->plainBuf.appendU8( bench->plain[count] );
+
+  if( !parDecGood( bench->plainBuf, which ))
+    bench->errors++;
+
+  }
+}
+
+
+
+static void parDecPoolKernel( void* context )
+{
+ParDecBench* bench = static_cast<ParDecBench*>(
+                                       context );
+
+bench->pool.start( bench->threads, bench->key,
+                   bench->iv, 0 );
+
+Int32 sent = 0;
+Int32 got = 0;
+while( got < ParDecBench::RecCount )
+  {
+  while( (sent < ParDecBench::RecCount) &&
+         bench->pool.canTake())
+    {
+    bench->pool.submit( bench->records[sent] );
+    sent++;
+    }
+
+  const CharBuf* plainBuf = nullptr;
+  Int32 result = bench->pool.peekNext( plainBuf );
+  if( result == 0 )
+    {
+    bench->pool.waitNext();
+    continue;
+    }
+
+  if( result < 0 )
+    {
+    bench->errors++;
+    if( bench->firstBad < 0 )
+      bench->firstBad = got;
+
+    }
+  else
+    {
+    if( !parDecGood( *plainBuf, got ))
+      bench->errors++;
+
+    }
+
+  bench->pool.releaseNext();
+  got++;
+  }
+
+bench->pool.stop();
+}
+
+
+
+void MicroBench::benchParDecrypt( void )
+{
+ParDecBench* bench = new ParDecBench;
+
+Uint8 key[AesGcm::KeySize];
+Uint8 iv[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  {
+  key[count] = static_cast<Uint8>( count );
+  bench->key.appendU8( key[count] );
+  }
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  {
+  iv[count] = static_cast<Uint8>( count * 3 );
+  bench->iv.appendU8( iv[count] );
+  }
+
+bench->aesGcm.setKey( key, iv );
+
+const Int32 cipherLast = ParDecBench::PlainLast +
+                               AesGcm::TagSize;
+bench->cipher = new Uint8[cipherLast];
+bench->plain = new Uint8[cipherLast];
+bench->records = new CharBuf[ParDecBench::RecCount];
+
+Uint8 header[5];
+header[0] = TlsOuterRec::ApplicationData;
+header[1] = 3;
+header[2] = 3;
+header[3] = static_cast<Uint8>( cipherLast >> 8 );
+header[4] = static_cast<Uint8>( cipherLast );
+
+for( Int32 which = 0; which < ParDecBench::RecCount;
+                                       which++ )
+  {
+  for( Int32 count = 0;
+            count < ParDecBench::PlainLast; count++ )
+    bench->plain[count] = static_cast<Uint8>(
+                                 which + count );
+
+  for( Int32 count = 0; count < 4; count++ )
+    bench->plain[count] = static_cast<Uint8>(
+                     which >> (24 - (count * 8)));
+
+  bench->aesGcm.seal( static_cast<Uint64>( which ),
+                      header, 5, bench->plain,
+                      ParDecBench::PlainLast,
+                      bench->cipher );
+
+  for( Int32 count = 0; count < cipherLast; count++ )
+    bench->records[which].appendU8(
+                          bench->cipher[count] );
+
+  }
+
+const Int64 bytesPerOp = static_cast<Int64>(
+                     ParDecBench::RecCount ) *
+                     ParDecBench::PlainLast;
+
+timeKernel( "pardecrypt serial",
+            parDecSerialKernel, bench, bytesPerOp );
+
+const Int32 threadCounts[] = { 1, 2, 4 };
+for( Int32 threads : threadCounts )
+  {
+  bench->threads = threads;
+  char nameChars[64];
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "pardecrypt %d threads", threads );
+  timeKernel( nameChars, parDecPoolKernel, bench,
+              bytesPerOp );
+  }
+
+// A record that was changed has to come out
+// as bad in its own place, and not move the
+// ones before it.
+const Int32 badAt = ParDecBench::RecCount / 2;
+bench->records[badAt].setU8( 100,
+     bench->records[badAt].getU8( 100 ) ^ 1 );
+
+const Int64 goodErrors = bench->errors;
+bench->threads = 4;
+parDecPoolKernel( bench );
+
+char lineChars[128];
+if( (goodErrors == 0) &&
+    (bench->errors == 1) &&
+    (bench->firstBad == badAt))
+  {
+  StIO::putS( "pardecrypt order and sequence "
+              "numbers are right." );
+  }
+else
+  {
+  ::snprintf( lineChars, sizeof( lineChars ),
+              "pardecrypt is wrong: %lld errors, "
+              "bad one at %d.",
+              static_cast<long long>( goodErrors ),
+              bench->firstBad );
+  StIO::putS( lineChars );
+  }
+
+delete[] bench->records;
+delete[] bench->cipher;
+delete[] bench->plain;
+delete bench;
+}
+
+
+
+class ClHelloBench
+  {
+  public:
+  HandshakeCl handshakeCl;
+  TlsMain tlsMain;
+  EncryptTls encryptTls;
+  CharBuf helloBuf;
+  CharBuf serverName;
+  };
+
+
+
+static void clHelloKernel( void* context )
+{
+ClHelloBench* bench =
+           static_cast<ClHelloBench*>( context );
+
+bench->helloBuf.clear();
+bench->handshakeCl.makeClHelloBuf(
+                         bench->helloBuf,
+                         bench->tlsMain,
+                         bench->encryptTls );
+}
+
+
+
+static void clHelloCachedKernel( void* context )
+{
+ClHelloBench* bench =
+           static_cast<ClHelloBench*>( context );
+
+bench->helloBuf.clear();
+bench->handshakeCl.makeClHelloCached(
+                         bench->helloBuf,
+                         bench->serverName,
+                         bench->tlsMain,
+                         bench->encryptTls );
+}
+
+
+
+void MicroBench::benchClHello( void )
+{
+ClHelloBench* bench = new ClHelloBench;
+
+bench->serverName.appendCharBuf(
+                 CharBuf( "www.example.com" ));
+bench->tlsMain.setServerName(
+                         bench->serverName );
+
+// This includes making the key share.
+timeKernel( "makeClHelloBuf", clHelloKernel,
+            bench, 0 );
+
+// Copy the template and patch it.  The key
+// share is still made each time.
+timeKernel( "makeClHelloCached",
+            clHelloCachedKernel, bench, 0 );
+
+delete bench;
+}
+
+
+
+class ExtenListBench
+  {
+  public:
+  TlsMain tlsMain;
+  EncryptTls encryptTls;
+  CharBuf msgBytes;
+  };
+
+
+
+static void extenListKernel( void* context )
+{
+ExtenListBench* bench =
+         static_cast<ExtenListBench*>( context );
+
+// In the RFC 8448 ClientHello the
+// extensions start at 49.
+ExtenList extenList;
+Uint32 result = extenList.setFromMsg(
+                         bench->msgBytes, 49,
+                         bench->tlsMain, false,
+                         bench->encryptTls );
+
+if( result < Results::AlertTop )
+  throw "MicroBench setFromMsg failed.";
+
+}
+
+
+
+void MicroBench::benchExtenList( void )
+{
+ExtenListBench* bench = new ExtenListBench;
+
+// The handshake message without the five
+// byte record header.
+CharBuf recBuf;
+Rfc8448Vec::getClHelloRec( recBuf );
+const Int32 last = recBuf.getLast();
+for( Int32 count = 5; count < last; count++ )
+  bench->msgBytes.appendU8( recBuf.getU8( count ));
+
+timeKernel( "extenlist clhello", extenListKernel,
+            bench, bench->msgBytes.getLast());
+
+delete bench;
+}
+
+
+
+class PadStripBench
+  {
+  public:
+  TlsMainCl tlsMainCl;
+  SinkCallBack sink;
+  CircleBuf appInBuf;
+  CharBuf plainBuf;
+  };
+
+
+
+static bool padStripSink( const CharBuf& plainBuf,
+                          void* context )
+{
+// Just so the app data goes somewhere.
+Int64* bytes = static_cast<Int64*>( context );
+*bytes += plainBuf.getLast();
+return true;
+}
+
+
+
+static void padStripKernel( void* context )
+{
+PadStripBench* bench =
+         static_cast<PadStripBench*>( context );
+
+bench->tlsMainCl.processAppData( bench->plainBuf,
+                                 bench->appInBuf );
+}
+
+
+
+void MicroBench::benchPadStrip( void )
+{
+PadStripBench* bench = new PadStripBench;
+Int64 sinkBytes = 0;
+bench->sink.setFunction( padStripSink,
+                         &sinkBytes );
+bench->tlsMainCl.setAppSink( &bench->sink );
+
+// A full record with no padding, and a
+// short one with a lot of padding.
+const Int32 dataLasts[] = { 1024 * 16, 1024 };
+const Int32 padLasts[] = { 0, 255 };
+
+for( Int32 which = 0; which < 2; which++ )
+  {
+  bench->plainBuf.clear();
+  for( Int32 count = 0; count < dataLasts[which];
+                                     count++ )
+    bench->plainBuf.appendU8(
+              static_cast<Uint8>( count | 1 ));
+
+  bench->plainBuf.appendU8(
+                TlsOuterRec::ApplicationData );
+
+  for( Int32 count = 0; count < padLasts[which];
+                                     count++ )
+    bench->plainBuf.appendU8( 0 );
+
+  char nameChars[64];
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "padstrip %d+%d", dataLasts[which],
+              padLasts[which] );
+
+  timeKernel( nameChars, padStripKernel, bench,
+              bench->plainBuf.getLast());
+  }
+
+delete bench;
+}
+
+
+
+class BadRecBench
+  {
+  public:
+  TlsMainCl tlsMainCl;
+  CircleBuf appInBuf;
+  CharBuf recBuf;
+  CharBuf outBuf;
+  };
+
+
+
+static void badRecKernel( void* context )
+{
+BadRecBench* bench =
+         static_cast<BadRecBench*>( context );
+
+// It starts over at a record boundary each
+// time, so every call does the same thing.
+bench->tlsMainCl.memIn( bench->recBuf );
+bench->tlsMainCl.processIncoming(
+                          bench->appInBuf );
+bench->outBuf.clear();
+bench->tlsMainCl.memTakeOut( bench->outBuf );
+}
+
+
+
+void MicroBench::benchBadRec( void )
+{
+// A record that gets ignored and two that
+// get an alert.  The alert ones should not
+// cost much more than the good one, since
+// nothing gets thrown.
+
+BadRecBench* bench = new BadRecBench;
+bench->appInBuf.setSize( 1024 * 64 );
+bench->tlsMainCl.useMemTransport();
+
+const char* names[] = { "badrec ccs",
+                        "badrec alertlen",
+                        "badrec rectype" };
+
+const Uint8 recTypes[] = {
+                 TlsOuterRec::ChangeCipherSpec,
+                 TlsOuterRec::Alert,
+                 0x55 };
+
+for( Int32 which = 0; which < 3; which++ )
+  {
+  bench->recBuf.clear();
+  bench->recBuf.appendU8( recTypes[which] );
+  bench->recBuf.appendU8( 3 );
+  bench->recBuf.appendU8( 3 );
+  bench->recBuf.appendU8( 0 );
+
+  // An alert has to have a length of 2.
+  bench->recBuf.appendU8( 3 );
+  bench->recBuf.appendU8( 1 );
+  bench->recBuf.appendU8( 1 );
+  bench->recBuf.appendU8( 1 );
+
+  timeKernel( names[which], badRecKernel, bench,
+              bench->recBuf.getLast());
+  }
+
+delete bench;
+}
+
+
+
+static void chaChaRandKernel( void* context )
+{
+Uint8* randBytes = static_cast<Uint8*>( context );
+
+// The client random and the session ID.
+ChaChaRand::fillBytes( randBytes, 64 );
+}
+
+
+
+static void randomishKernel( void* context )
+{
+CharBuf* randBuf = static_cast<CharBuf*>( context );
+
+// The way ClientHello used to get them.
+randBuf->clear();
+Randomish::makeRandomBytes( *randBuf, 32 + 10 );
+Randomish::makeRandomBytes( *randBuf, 32 + 10 );
+}
+
+
+
+void MicroBench::benchRand( void )
+{
+Uint8 randBytes[64];
+timeKernel( "rand chacha 64", chaChaRandKernel,
+            randBytes, 64 );
+
+CharBuf randBuf;
+timeKernel( "rand randomish 2x42",
+            randomishKernel, &randBuf, 64 );
+}
+
+
+
+class P256Bench
+  {
+  public:
+  Uint8 privKey[P256::ScalarBytes];
+  Uint8 pubKey[P256::PointBytes];
+  Uint8 peerPub[P256::PointBytes];
+  Uint8 secret[P256::ScalarBytes];
+  };
+
+
+
+static void p256KeyKernel( void* context )
+{
+P256Bench* bench =
+            static_cast<P256Bench*>( context );
+
+P256::pubFromPriv( bench->privKey,
+                   bench->pubKey );
+}
+
+
+
+static void p256SharedKernel( void* context )
+{
+P256Bench* bench =
+            static_cast<P256Bench*>( context );
+
+P256::sharedSecret( bench->privKey,
+                    bench->peerPub,
+                    bench->secret );
+}
+
+
+
+void MicroBench::benchP256( void )
+{
+// Compare these with montladder x25519,
+// which does one of these for each.
+
+P256Bench* bench = new P256Bench;
+
+Uint8 peerPriv[P256::ScalarBytes];
+P256::makeKeyPair( peerPriv, bench->peerPub );
+P256::makeKeyPair( bench->privKey,
+                   bench->pubKey );
+
+timeKernel( "p256 keygen", p256KeyKernel,
+            bench, 0 );
+timeKernel( "p256 shared", p256SharedKernel,
+            bench, 0 );
+
+delete bench;
+}
+
+
+
+class MlKemBench
+  {
+  public:
+  Uint8 encapKey[MlKem768::EncapKeyBytes];
+  Uint8 decapKey[MlKem768::DecapKeyBytes];
+  Uint8 cipher[MlKem768::CipherBytes];
+  Uint8 secret[MlKem768::SecretBytes];
+  };
+
+
+
+static void mlKemKeyKernel( void* context )
+{
+MlKemBench* bench =
+            static_cast<MlKemBench*>( context );
+
+MlKem768::makeKeyPair( bench->encapKey,
+                       bench->decapKey );
+}
+
+
+
+static void mlKemEncapsKernel( void* context )
+{
+MlKemBench* bench =
+            static_cast<MlKemBench*>( context );
+
+MlKem768::encaps( bench->encapKey,
+                  bench->cipher, bench->secret );
+}
+
+
+
+static void mlKemDecapsKernel( void* context )
+{
+MlKemBench* bench =
+            static_cast<MlKemBench*>( context );
+
+MlKem768::decaps( bench->decapKey,
+                  bench->cipher, bench->secret );
+}
+
+
+
+void MicroBench::benchMlKem( void )
+{
+// The hybrid costs the client one keygen
+// and one decaps on top of the two
+// montladder x25519 that plain x25519
+// does.
+
+MlKemBench* bench = new MlKemBench;
+MlKem768::makeKeyPair( bench->encapKey,
+                       bench->decapKey );
+MlKem768::encaps( bench->encapKey,
+                  bench->cipher, bench->secret );
+
+const bool hadAvx2 = MlKem768::getUseAvx2();
+for( Int32 which = 0; which < 2; which++ )
+  {
+  const bool avx2 = which == 0;
+  if( avx2 && !hadAvx2 )
+    continue;
+
+  MlKem768::setUseAvx2( avx2 );
+  const char* how = avx2 ? "avx2" : "portable";
+
+  char nameChars[64];
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "mlkem keygen %s", how );
+  timeKernel( nameChars, mlKemKeyKernel,
+              bench, 0 );
+
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "mlkem encaps %s", how );
+  timeKernel( nameChars, mlKemEncapsKernel,
+              bench, 0 );
+
+  ::snprintf( nameChars, sizeof( nameChars ),
+              "mlkem decaps %s", how );
+  timeKernel( nameChars, mlKemDecapsKernel,
+              bench, 0 );
+  }
+
+MlKem768::setUseAvx2( hadAvx2 );
+delete bench;
+}
+
+
+
+// A P-256 end-entity certificate with
+// subjectAltName, signed by a P-256 CA.
+static const char* BenchCertHex =
+      "30 82 01 de 30 82 01 84 a0 03 02 01 02 02 14 6b"
+      "04 2f 36 38 77 08 db 4c fd 2b 1b 42 89 04 77 36"
+      "99 3d ad 30 0a 06 08 2a 86 48 ce 3d 04 03 02 30"
+      "2d 31 13 30 11 06 03 55 04 0a 0c 0a 42 65 6e 63"
+      "68 20 52 6f 6f 74 31 16 30 14 06 03 55 04 03 0c"
+      "0d 42 65 6e 63 68 20 52 6f 6f 74 20 43 41 30 1e"
+      "17 0d 32 36 31 30 31 39 31 34 31 39 35 30 5a 17"
+      "0d 33 36 31 30 31 36 31 34 31 39 35 30 5a 30 2d"
+      "31 11 30 0f 06 03 55 04 0a 0c 08 4c 65 61 66 20"
+      "4f 72 67 31 18 30 16 06 03 55 04 03 0c 0f 77 77"
+      "77 2e 65 78 61 6d 70 6c 65 2e 63 6f 6d 30 59 30"
+      "13 06 07 2a 86 48 ce 3d 02 01 06 08 2a 86 48 ce"
+      "3d 03 01 07 03 42 00 04 53 ee ab 18 89 d0 bf b7"
+      "2e 23 f0 82 90 86 2e 3a a5 5a 3d 68 79 8d be 35"
+      "af d4 bc 83 41 d5 8f e0 e3 c5 0e b4 3a d5 2e b7"
+      "03 5d 60 85 c7 73 dd 90 be 5f f5 b3 36 d5 f3 94"
+      "56 a3 70 0e 04 a2 f8 88 a3 81 81 30 7f 30 2f 06"
+      "03 55 1d 11 04 28 30 26 82 0f 77 77 77 2e 65 78"
+      "61 6d 70 6c 65 2e 63 6f 6d 82 0d 2a 2e 65 78 61"
+      "6d 70 6c 65 2e 6f 72 67 87 04 7f 00 00 01 30 0c"
+      "06 03 55 1d 13 01 01 ff 04 02 30 00 30 1d 06 03"
+      "55 1d 0e 04 16 04 14 6f 8b ec fb 28 0c 65 28 18"
+      "bf a9 bd 88 f5 76 54 25 56 20 af 30 1f 06 03 55"
+      "1d 23 04 18 30 16 80 14 ad d3 44 56 46 c7 c5 20"
+      "45 c0 42 7e 19 17 80 53 79 72 80 19 30 0a 06 08"
+      "2a 86 48 ce 3d 04 03 02 03 48 00 30 45 02 20 0b"
+      "ab c3 2f d7 13 fb 1f b4 d4 6d 48 ef d7 0c cb 09"
+      "46 6c cb 3c 28 91 49 02 aa 95 a5 34 fd 8c 3f 02"
+      "21 00 b5 71 20 f0 58 c8 7c 6d 78 d1 3f c6 6e e3"
+      "1b b6 9f 2d 54 f0 52 04 36 ea 74 9d aa 1d ce 37"
+      "4a cc";
+
+
+
+class CertBench
+  {
+  public:
+  CharBuf msgBuf;
+  CharBuf hostName;
+  CertChainView chain;
+  CertView cert;
+  Int64 notBefore = 0;
+  Int64 notAfter = 0;
+  };
+
+
+
+static void certParseKernel( void* context )
+{
+// What a client does with the chain: the
+// lengths, the outline of each one, and the
+// dates, the key and the name for the
+// end-entity one.
+CertBench* bench =
+            static_cast<CertBench*>( context );
+
+if( bench->chain.setFromMsg( bench->msgBuf, 4 ) !=
+                                 Results::Done )
+  throw "certParseKernel setFromMsg.";
+
+const Int32 last = bench->chain.getCertLast();
+for( Int32 count = last - 1; count >= 0; count-- )
+  bench->chain.getCert( count, bench->cert );
+
+DerView algOid;
+DerView params;
+DerView keyBytes;
+bench->cert.getValidity( bench->notBefore,
+                         bench->notAfter );
+bench->cert.getPublicKey( algOid, params,
+                          keyBytes );
+if( !bench->cert.matchesDnsName(
+                            bench->hostName ))
+  throw "certParseKernel name didn't match.";
+
+}
+
+
+
+void MicroBench::benchCertParse( void )
+{
+CertBench* bench = new CertBench;
+
+CharBuf certHex( BenchCertHex );
+CharBuf certBuf;
+certBuf.setFromHexTo256( certHex );
+
+// Four of the same one makes a chain about
+// the size of a real one.
+const Int32 certLength = certBuf.getLast();
+CharBuf listBuf;
+for( Int32 count = 0; count < 4; count++ )
+  {
+  listBuf.appendU8( 0 );
+  listBuf.appendU8( static_cast<Uint8>(
+                              certLength >> 8 ));
+  listBuf.appendU8( static_cast<Uint8>(
+                              certLength ));
+  listBuf.appendCharBuf( certBuf );
+  listBuf.appendU8( 0 ); // No extensions.
+  listBuf.appendU8( 0 );
+  }
+
+const Int32 listLength = listBuf.getLast();
+const Int32 bodyLength = 1 + 3 + listLength;
+
+CharBuf& msgBuf = bench->msgBuf;
+msgBuf.appendU8( Handshake::CertificateID );
+msgBuf.appendU8( static_cast<Uint8>(
+                           bodyLength >> 16 ));
+msgBuf.appendU8( static_cast<Uint8>(
+                           bodyLength >> 8 ));
+msgBuf.appendU8( static_cast<Uint8>(
+                           bodyLength ));
+msgBuf.appendU8( 0 ); // The context.
+msgBuf.appendU8( static_cast<Uint8>(
+                           listLength >> 16 ));
+msgBuf.appendU8( static_cast<Uint8>(
+                           listLength >> 8 ));
+msgBuf.appendU8( static_cast<Uint8>(
+                           listLength ));
+msgBuf.appendCharBuf( listBuf );
+
+CharBuf hostName( "www.example.com" );
+bench->hostName.copy( hostName );
+
+timeKernel( "certparse 4 certs", certParseKernel,
+            bench, msgBuf.getLast());
+
+delete bench;
+}
+
+
+
+bool MicroBench::run( const char* kernelName )
+{
+const bool all = ::strcmp( kernelName,
+                           "all" ) == 0;
+bool found = false;
+
+if( all || (::strcmp( kernelName,
+                      "outerrec" ) == 0))
+  {
+  benchOuterRec();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "hsaccum" ) == 0))
+  {
+  benchHandshakeAccum();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "montladder" ) == 0))
+  {
+  benchMontLadder();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "aead" ) == 0))
+  {
+  benchAead();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "pardecrypt" ) == 0))
+  {
+  benchParDecrypt();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "clhello" ) == 0))
+  {
+  benchClHello();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "extenlist" ) == 0))
+  {
+  benchExtenList();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "padstrip" ) == 0))
+  {
+  benchPadStrip();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "badrec" ) == 0))
+  {
+  benchBadRec();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "rand" ) == 0))
+  {
+  benchRand();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "p256" ) == 0))
+  {
+  benchP256();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "mlkem" ) == 0))
+  {
+  benchMlKem();
+  found = true;
+  }
+
+if( all || (::strcmp( kernelName,
+                      "certparse" ) == 0))
+  {
+  benchCertParse();
+  found = true;
+  }
+
+if( !found )
+  StIO::putS( "MicroBench: unknown kernel." );
+
+return found;
+}
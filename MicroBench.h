@@ -0,0 +1,105 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Microbenchmarks for the small pieces that
+// the client spends its time in.  An end to
+// end test can hide a piece that got slower
+// when something else got faster.
+
+// Each kernel is warmed up, then it is
+// timed in a number of batches.  Each batch
+// runs long enough to get a good number
+// from the clock.  It shows the median
+// nanoseconds per operation with the
+// fastest and slowest batch, and the TSC
+// ticks per byte for the ones that work on
+// bytes.
+
+// The app's main() calls run() with the
+// name of one kernel, or with "all".
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+// One call does one operation.
+typedef void (*BenchKernel)( void* context );
+
+
+
+class MicroBench
+  {
+  private:
+  bool testForCopy = false;
+
+  static const Int32 Batches = 15;
+
+  static Int64 getNanoSec( void );
+  static Uint64 getTicks( void );
+
+  static void timeKernel( const char* name,
+                          BenchKernel kernel,
+                          void* context,
+                          const Int64 bytesPerOp );
+
+  // This one uses HandshakeCl private
+  // parts.
+  static void hsAccumKernel( void* context );
+
+  static void benchOuterRec( void );
+  static void benchHandshakeAccum( void );
+  static void benchMontLadder( void );
+  static void benchAead( void );
+  static void benchParDecrypt( void );
+  static void benchClHello( void );
+  static void benchExtenList( void );
+  static void benchPadStrip( void );
+  static void benchBadRec( void );
+  static void benchRand( void );
+  static void benchP256( void );
+  static void benchMlKem( void );
+  static void benchCertParse( void );
+
+  public:
+  MicroBench( void )
+    {
+    }
+
+  MicroBench( const MicroBench& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "MicroBench copy constructor.";
+    }
+
+  ~MicroBench( void )
+    {
+    }
+
+  // The names are outerrec, hsaccum,
+  // montladder, aead, pardecrypt, clhello,
+  // extenlist, padstrip, badrec, rand, p256,
+  // mlkem, certparse and all.
+  static bool run( const char* kernelName );
+
+  };
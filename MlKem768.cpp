@@ -0,0 +1,1325 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The algorithm numbers are the ones in
+// FIPS 203.  The NTT follows the Kyber
+// reference code: Cooley-Tukey going
+// forward and Gentleman-Sande going back,
+// with the zetas in Montgomery form.
+
+
+
+#include "MlKem768.h"
+#include "Keccak.h"
+#include "ChaChaRand.h"
+
+#include <string.h>
+
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+  #define MLKEM_X86 1
+  #include <immintrin.h>
+#endif
+
+
+
+// q^-1 mod 2^16, as a signed number.
+static const Int16 QInv = -3327;
+
+// About 2^26 / q, for Barrett reduction.
+static const Int32 BarrettV = 20159;
+
+// 2^16 mod q and 2^32 mod q.
+static const Int32 Mont = 2285;
+static const Int16 MontSquared = 1353;
+
+// 2^32 / 128 mod q.  The inverse NTT ends by
+// multiplying by this.  It takes out the
+// 2^-16 from the products and does the
+// divide by 128.
+static const Int16 InvScale = 1441;
+
+static const Int32 PolyBytes = 384;
+static const Int32 UBytes = 320;
+static const Int32 VBytes = 128;
+static const Int32 PkeKeyBytes =
+                   MlKem768::K * PolyBytes;
+
+
+
+class MlKemTables
+  {
+  public:
+  // 17^BitRev7( i ) in Montgomery form.
+  Int16 zetas[128];
+
+  // For the pointwise multiply.  Pair i is
+  // mod X^2 - 17^(2 * BitRev7( i ) + 1).
+  Int16 gammas[128];
+
+  // For the AVX2 code.  The zetas for the
+  // layers with 8, 4 and 2 in a block, in the
+  // order the shuffles put the coefficients.
+  alignas( 32 ) Int16 fwdVec[3][8][16];
+  alignas( 32 ) Int16 invVec[3][8][16];
+
+  // The gammas at the odd places.
+  alignas( 32 ) Int16 gammaVec[256];
+  };
+
+
+
+static constexpr Int32 bitRev7( const Int32 x )
+{
+Int32 result = 0;
+for( Int32 count = 0; count < 7; count++ )
+  {
+  if( ((x >> count) & 1) != 0 )
+    result |= 1 << (6 - count);
+
+  }
+
+return result;
+}
+
+
+
+static constexpr Int16 montPower(
+                             const Int32 power )
+{
+Int32 result = 1;
+for( Int32 count = 0; count < power; count++ )
+  result = (result * 17) % MlKem768::Q;
+
+result = (result * Mont) % MlKem768::Q;
+
+// From -q/2 to q/2.
+if( result > (MlKem768::Q / 2))
+  result -= MlKem768::Q;
+
+return static_cast<Int16>( result );
+}
+
+
+
+// Which coefficient of the 32 in a chunk is
+// at place where in the low half after the
+// shuffle for that block length.  See
+// nttAvx2().
+static constexpr Int32 lowIndex( const Int32 len,
+                                 const Int32 where )
+{
+const Int32 lane = where >> 3;
+const Int32 inLane = where & 7;
+
+if( len == 8 )
+  return (where < 8) ? where : (where + 8);
+
+if( len == 4 )
+  {
+  if( inLane < 4 )
+    return (lane * 8) + inLane;
+
+  return 16 + (lane * 8) + inLane - 4;
+  }
+
+// Two in a block.  The shuffle works on
+// 32 bit words.
+const Int32 word = inLane >> 1;
+const Int32 fromWord = (lane * 4) +
+                       ((word >> 1) * 2);
+const Int32 fromB = ((word & 1) != 0) ? 16 : 0;
+return (fromWord * 2) + (inLane & 1) + fromB;
+}
+
+
+
+static constexpr MlKemTables makeTables( void )
+{
+MlKemTables tables = {};
+
+for( Int32 count = 0; count < 128; count++ )
+  {
+  tables.zetas[count] = montPower(
+                             bitRev7( count ));
+  tables.gammas[count] = montPower(
+                     (2 * bitRev7( count )) + 1 );
+  }
+
+const Int32 lens[3] = { 8, 4, 2 };
+for( Int32 layer = 0; layer < 3; layer++ )
+  {
+  const Int32 len = lens[layer];
+  for( Int32 chunk = 0; chunk < 8; chunk++ )
+    {
+    for( Int32 where = 0; where < 16; where++ )
+      {
+      const Int32 block = ((chunk * 32) +
+                 lowIndex( len, where )) / (2 * len);
+      tables.fwdVec[layer][chunk][where] =
+               tables.zetas[(128 / len) + block];
+      tables.invVec[layer][chunk][where] =
+           tables.zetas[(256 / len) - 1 - block];
+      }
+    }
+  }
+
+for( Int32 count = 0; count < 128; count++ )
+  {
+  tables.gammaVec[count * 2] = 0;
+  tables.gammaVec[(count * 2) + 1] =
+                         tables.gammas[count];
+  }
+
+return tables;
+}
+
+
+static constexpr MlKemTables tables =
+                                  makeTables();
+
+static_assert( tables.zetas[1] == -758 );
+static_assert( tables.zetas[127] == 1628 );
+
+
+
+static inline Int16 montReduce( const Int32 a )
+{
+const Int16 t = static_cast<Int16>(
+                  static_cast<Int16>( a ) * QInv );
+
+return static_cast<Int16>(
+       (a - (static_cast<Int32>( t ) *
+                         MlKem768::Q)) >> 16 );
+}
+
+
+
+static inline Int16 fqMul( const Int16 a,
+                           const Int16 b )
+{
+return montReduce( static_cast<Int32>( a ) * b );
+}
+
+
+
+// The result is from 0 to q.  The AVX2
+// version does the same thing, so it has no
+// rounding constant.
+static inline Int16 barrett( const Int16 a )
+{
+const Int16 t = static_cast<Int16>(
+         (BarrettV * static_cast<Int32>( a )) >> 26 );
+
+return static_cast<Int16>( a - (t * MlKem768::Q));
+}
+
+
+
+// From 0 to q - 1.
+static inline Int16 freeze( const Int16 a )
+{
+Int16 result = static_cast<Int16>(
+                     barrett( a ) - MlKem768::Q );
+result = static_cast<Int16>( result +
+                 ((result >> 15) & MlKem768::Q));
+return result;
+}
+
+
+
+#ifdef MLKEM_X86
+
+
+static bool cpuHasAvx2( void )
+{
+__builtin_cpu_init();
+return __builtin_cpu_supports( "avx2" );
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static inline __m256i fqMulVec( const __m256i a,
+                                const __m256i b )
+{
+const __m256i low = _mm256_mullo_epi16( a, b );
+const __m256i high = _mm256_mulhi_epi16( a, b );
+const __m256i t = _mm256_mullo_epi16( low,
+                      _mm256_set1_epi16( QInv ));
+return _mm256_sub_epi16( high,
+           _mm256_mulhi_epi16( t,
+           _mm256_set1_epi16( MlKem768::Q )));
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static inline __m256i barrettVec( const __m256i a )
+{
+__m256i t = _mm256_mulhi_epi16( a,
+                  _mm256_set1_epi16( BarrettV ));
+t = _mm256_srai_epi16( t, 10 );
+t = _mm256_mullo_epi16( t,
+                _mm256_set1_epi16( MlKem768::Q ));
+return _mm256_sub_epi16( a, t );
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static inline void nttButterfly( __m256i& low,
+                                 __m256i& high,
+                                 const __m256i zeta )
+{
+const __m256i t = fqMulVec( high, zeta );
+high = _mm256_sub_epi16( low, t );
+low = _mm256_add_epi16( low, t );
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static inline void invButterfly( __m256i& low,
+                                 __m256i& high,
+                                 const __m256i zeta )
+{
+const __m256i t = low;
+low = barrettVec( _mm256_add_epi16( t, high ));
+high = fqMulVec( _mm256_sub_epi16( high, t ),
+                 zeta );
+}
+
+
+
+// The shuffles for 8, 4 and 2 in a block.
+// Each one takes the 32 coefficients in a
+// and b and puts the first half of every
+// block in low and the second half in high.
+// Doing it again puts them back.
+
+__attribute__(( target( "avx2" )))
+static inline void shuffle8( __m256i& a,
+                             __m256i& b )
+{
+const __m256i low =
+             _mm256_permute2x128_si256( a, b, 0x20 );
+const __m256i high =
+             _mm256_permute2x128_si256( a, b, 0x31 );
+a = low;
+b = high;
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static inline void shuffle4( __m256i& a,
+                             __m256i& b )
+{
+const __m256i low = _mm256_unpacklo_epi64( a, b );
+const __m256i high = _mm256_unpackhi_epi64( a, b );
+a = low;
+b = high;
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static inline void shuffle2( __m256i& a,
+                             __m256i& b )
+{
+const __m256i low = _mm256_blend_epi32( a,
+                  _mm256_slli_epi64( b, 32 ), 0xAA );
+const __m256i high = _mm256_blend_epi32(
+                  _mm256_srli_epi64( a, 32 ), b, 0xAA );
+a = low;
+b = high;
+}
+
+
+
+static inline __m256i* toVec( Int16* where )
+{
+return reinterpret_cast<__m256i*>( where );
+}
+
+
+
+static inline const __m256i* toVec(
+                          const Int16* where )
+{
+return reinterpret_cast<const __m256i*>( where );
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static void nttAvx2( Int16* coef )
+{
+// The blocks of 16 or more are whole
+// vectors.
+Int32 zetaAt = 1;
+for( Int32 len = 128; len >= 16; len >>= 1 )
+  {
+  for( Int32 start = 0; start < 256;
+                              start += 2 * len )
+    {
+    const __m256i zeta = _mm256_set1_epi16(
+                     tables.zetas[zetaAt] );
+    zetaAt++;
+
+    for( Int32 count = start;
+              count < (start + len); count += 16 )
+      {
+      __m256i low = _mm256_load_si256(
+                            toVec( coef + count ));
+      __m256i high = _mm256_load_si256(
+                      toVec( coef + count + len ));
+      nttButterfly( low, high, zeta );
+      _mm256_store_si256( toVec( coef + count ),
+                          low );
+      _mm256_store_si256(
+                toVec( coef + count + len ), high );
+      }
+    }
+  }
+
+// The last three layers stay inside 32
+// coefficients.
+for( Int32 chunk = 0; chunk < 8; chunk++ )
+  {
+  Int16* at = coef + (chunk * 32);
+  __m256i a = _mm256_load_si256( toVec( at ));
+  __m256i b = _mm256_load_si256(
+                              toVec( at + 16 ));
+
+  shuffle8( a, b );
+  nttButterfly( a, b, _mm256_load_si256(
+               toVec( tables.fwdVec[0][chunk] )));
+  shuffle8( a, b );
+
+  shuffle4( a, b );
+  nttButterfly( a, b, _mm256_load_si256(
+               toVec( tables.fwdVec[1][chunk] )));
+  shuffle4( a, b );
+
+  shuffle2( a, b );
+  nttButterfly( a, b, _mm256_load_si256(
+               toVec( tables.fwdVec[2][chunk] )));
+  shuffle2( a, b );
+
+  _mm256_store_si256( toVec( at ),
+                      barrettVec( a ));
+  _mm256_store_si256( toVec( at + 16 ),
+                      barrettVec( b ));
+  }
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static void invNttAvx2( Int16* coef )
+{
+for( Int32 chunk = 0; chunk < 8; chunk++ )
+  {
+  Int16* at = coef + (chunk * 32);
+  __m256i a = _mm256_load_si256( toVec( at ));
+  __m256i b = _mm256_load_si256(
+                              toVec( at + 16 ));
+
+  shuffle2( a, b );
+  invButterfly( a, b, _mm256_load_si256(
+               toVec( tables.invVec[2][chunk] )));
+  shuffle2( a, b );
+
+  shuffle4( a, b );
+  invButterfly( a, b, _mm256_load_si256(
+               toVec( tables.invVec[1][chunk] )));
+  shuffle4( a, b );
+
+  shuffle8( a, b );
+  invButterfly( a, b, _mm256_load_si256(
+               toVec( tables.invVec[0][chunk] )));
+  shuffle8( a, b );
+
+  _mm256_store_si256( toVec( at ), a );
+  _mm256_store_si256( toVec( at + 16 ), b );
+  }
+
+for( Int32 len = 16; len <= 128; len <<= 1 )
+  {
+  for( Int32 start = 0; start < 256;
+                              start += 2 * len )
+    {
+    const Int32 block = start / (2 * len);
+    const __m256i zeta = _mm256_set1_epi16(
+          tables.zetas[(256 / len) - 1 - block] );
+
+    for( Int32 count = start;
+              count < (start + len); count += 16 )
+      {
+      __m256i low = _mm256_load_si256(
+                            toVec( coef + count ));
+      __m256i high = _mm256_load_si256(
+                      toVec( coef + count + len ));
+      invButterfly( low, high, zeta );
+      _mm256_store_si256( toVec( coef + count ),
+                          low );
+      _mm256_store_si256(
+                toVec( coef + count + len ), high );
+      }
+    }
+  }
+
+const __m256i scale = _mm256_set1_epi16(
+                                     InvScale );
+for( Int32 count = 0; count < 256; count += 16 )
+  _mm256_store_si256( toVec( coef + count ),
+         fqMulVec( _mm256_load_si256(
+                   toVec( coef + count )), scale ));
+
+}
+
+
+
+__attribute__(( target( "avx2" )))
+static void baseMulAccAvx2( Int16* result,
+                            const MlKem768::Poly* a,
+                            const MlKem768::Poly* b )
+{
+// Each pair of coefficients is one
+// product mod X^2 - gamma.  The low one is
+// a0 b0 + a1 b1 gamma and the high one is
+// a0 b1 + a1 b0.  b with the two in each
+// pair swapped gives the second one.
+for( Int32 count = 0; count < 256; count += 16 )
+  {
+  const __m256i gamma = _mm256_load_si256(
+                    toVec( tables.gammaVec + count ));
+  __m256i sum = _mm256_setzero_si256();
+
+  for( Int32 which = 0; which < MlKem768::K;
+                                       which++ )
+    {
+    const __m256i aVec = _mm256_load_si256(
+                     toVec( a[which].c + count ));
+    const __m256i bVec = _mm256_load_si256(
+                     toVec( b[which].c + count ));
+    const __m256i bSwap = _mm256_or_si256(
+                     _mm256_slli_epi32( bVec, 16 ),
+                     _mm256_srli_epi32( bVec, 16 ));
+
+    const __m256i same = fqMulVec( aVec, bVec );
+    const __m256i cross = fqMulVec( aVec, bSwap );
+    const __m256i withGamma = fqMulVec( same,
+                                        gamma );
+
+    const __m256i low = _mm256_add_epi16( same,
+               _mm256_srli_epi32( withGamma, 16 ));
+    const __m256i high = _mm256_add_epi16( cross,
+               _mm256_slli_epi32( cross, 16 ));
+
+    sum = _mm256_add_epi16( sum,
+          _mm256_blend_epi16( low, high, 0xAA ));
+    }
+
+  _mm256_store_si256( toVec( result + count ),
+                      barrettVec( sum ));
+  }
+}
+
+
+#else
+
+
+static bool cpuHasAvx2( void )
+{
+return false;
+}
+
+
+#endif
+
+
+
+bool MlKem768::useAvx2 = cpuHasAvx2();
+
+
+
+void MlKem768::setUseAvx2( const bool setTo )
+{
+useAvx2 = setTo && cpuHasAvx2();
+}
+
+
+
+void MlKem768::ntt( Poly& poly )
+{
+#ifdef MLKEM_X86
+if( useAvx2 )
+  {
+  nttAvx2( poly.c );
+  return;
+  }
+#endif
+
+// Algorithm 9.
+Int16* coef = poly.c;
+Int32 zetaAt = 1;
+for( Int32 len = 128; len >= 2; len >>= 1 )
+  {
+  for( Int32 start = 0; start < N;
+                             start += 2 * len )
+    {
+    const Int16 zeta = tables.zetas[zetaAt];
+    zetaAt++;
+
+    for( Int32 count = start;
+                   count < (start + len); count++ )
+      {
+      const Int16 t = fqMul( coef[count + len],
+                             zeta );
+      coef[count + len] = static_cast<Int16>(
+                                coef[count] - t );
+      coef[count] = static_cast<Int16>(
+                                coef[count] + t );
+      }
+    }
+  }
+
+reducePoly( poly );
+}
+
+
+
+void MlKem768::invNtt( Poly& poly )
+{
+#ifdef MLKEM_X86
+if( useAvx2 )
+  {
+  invNttAvx2( poly.c );
+  return;
+  }
+#endif
+
+// Algorithm 10.
+Int16* coef = poly.c;
+for( Int32 len = 2; len <= 128; len <<= 1 )
+  {
+  for( Int32 start = 0; start < N;
+                             start += 2 * len )
+    {
+    const Int32 block = start / (2 * len);
+    const Int16 zeta = tables.zetas[
+                         (256 / len) - 1 - block];
+
+    for( Int32 count = start;
+                   count < (start + len); count++ )
+      {
+      const Int16 t = coef[count];
+      coef[count] = barrett( static_cast<Int16>(
+                          t + coef[count + len] ));
+      coef[count + len] = fqMul(
+                      static_cast<Int16>(
+                        coef[count + len] - t ),
+                      zeta );
+      }
+    }
+  }
+
+for( Int32 count = 0; count < N; count++ )
+  coef[count] = fqMul( coef[count], InvScale );
+
+}
+
+
+
+void MlKem768::baseMulAcc( Poly& result,
+                           const Poly* a,
+                           const Poly* b )
+{
+#ifdef MLKEM_X86
+if( useAvx2 )
+  {
+  baseMulAccAvx2( result.c, a, b );
+  return;
+  }
+#endif
+
+// Algorithms 11 and 12, added up over the
+// K polynomials.
+for( Int32 pair = 0; pair < 128; pair++ )
+  {
+  const Int32 at = pair * 2;
+  Int16 low = 0;
+  Int16 high = 0;
+  for( Int32 which = 0; which < K; which++ )
+    {
+    const Int16 a0 = a[which].c[at];
+    const Int16 a1 = a[which].c[at + 1];
+    const Int16 b0 = b[which].c[at];
+    const Int16 b1 = b[which].c[at + 1];
+
+    low = static_cast<Int16>( low +
+            fqMul( fqMul( a1, b1 ),
+                   tables.gammas[pair] ) +
+            fqMul( a0, b0 ));
+    high = static_cast<Int16>( high +
+            fqMul( a0, b1 ) + fqMul( a1, b0 ));
+    }
+
+  result.c[at] = barrett( low );
+  result.c[at + 1] = barrett( high );
+  }
+}
+
+
+
+void MlKem768::reducePoly( Poly& poly )
+{
+for( Int32 count = 0; count < N; count++ )
+  poly.c[count] = barrett( poly.c[count] );
+
+}
+
+
+
+void MlKem768::addPoly( Poly& result,
+                        const Poly& toAdd )
+{
+for( Int32 count = 0; count < N; count++ )
+  result.c[count] = static_cast<Int16>(
+              result.c[count] + toAdd.c[count] );
+
+}
+
+
+
+void MlKem768::subPoly( Poly& result,
+                        const Poly& a,
+                        const Poly& b )
+{
+for( Int32 count = 0; count < N; count++ )
+  result.c[count] = static_cast<Int16>(
+                      a.c[count] - b.c[count] );
+
+}
+
+
+
+void MlKem768::toMont( Poly& poly )
+{
+for( Int32 count = 0; count < N; count++ )
+  poly.c[count] = fqMul( poly.c[count],
+                         MontSquared );
+
+}
+
+
+
+void MlKem768::sampleNtt( Poly& poly,
+                          const Uint8* rho,
+                          const Uint8 first,
+                          const Uint8 second )
+{
+// Algorithm 7.  This only depends on the
+// public seed, so the rejection can
+// branch.
+Uint8 seed[34];
+::memcpy( seed, rho, 32 );
+seed[32] = first;
+seed[33] = second;
+
+Keccak keccak;
+keccak.startShake128();
+keccak.absorb( seed, 34 );
+
+// Three blocks is almost always enough.
+Uint8 buf[3 * Keccak::RateShake128];
+Int32 last = 3 * Keccak::RateShake128;
+keccak.squeeze( buf, last );
+
+Int32 where = 0;
+Int32 howMany = 0;
+while( howMany < N )
+  {
+  if( (where + 3) > last )
+    {
+    last = Keccak::RateShake128;
+    keccak.squeeze( buf, last );
+    where = 0;
+    }
+
+  const Int32 d1 = buf[where] |
+                   ((buf[where + 1] & 0x0F) << 8);
+  const Int32 d2 = (buf[where + 1] >> 4) |
+                   (buf[where + 2] << 4);
+  where += 3;
+
+  if( d1 < Q )
+    {
+    poly.c[howMany] = static_cast<Int16>( d1 );
+    howMany++;
+    }
+
+  if( (d2 < Q) && (howMany < N))
+    {
+    poly.c[howMany] = static_cast<Int16>( d2 );
+    howMany++;
+    }
+  }
+}
+
+
+
+void MlKem768::sampleCbd( Poly& poly,
+                          const Uint8* seed,
+                          const Uint8 nonce )
+{
+// Algorithm 8 with eta = 2, which is what
+// ML-KEM-768 uses for both of them.  The
+// PRF is SHAKE256 of the seed and the
+// nonce.
+Uint8 input[33];
+::memcpy( input, seed, 32 );
+input[32] = nonce;
+
+Uint8 buf[64 * 2];
+Keccak::shake256( input, 33, buf, 64 * 2 );
+
+for( Int32 count = 0; count < (N / 8); count++ )
+  {
+  const Uint32 t =
+         static_cast<Uint32>( buf[count * 4] ) |
+        (static_cast<Uint32>( buf[count * 4 + 1] ) << 8) |
+        (static_cast<Uint32>( buf[count * 4 + 2] ) << 16) |
+        (static_cast<Uint32>( buf[count * 4 + 3] ) << 24);
+
+  // Each 2 bits is how many ones were in
+  // those 2 bits.
+  const Uint32 d = (t & 0x55555555) +
+                   ((t >> 1) & 0x55555555);
+
+  for( Int32 which = 0; which < 8; which++ )
+    {
+    const Int32 x = (d >> (4 * which)) & 3;
+    const Int32 y = (d >> ((4 * which) + 2)) & 3;
+    poly.c[(count * 8) + which] =
+                     static_cast<Int16>( x - y );
+    }
+  }
+
+::explicit_bzero( input, sizeof( input ));
+::explicit_bzero( buf, sizeof( buf ));
+}
+
+
+
+void MlKem768::makeMatrix( Poly* matrix,
+                           const Uint8* rho,
+                           const bool transpose )
+{
+// Row i column j of A is from rho, j, i.
+for( Int32 row = 0; row < K; row++ )
+  {
+  for( Int32 col = 0; col < K; col++ )
+    {
+    if( transpose )
+      sampleNtt( matrix[(row * K) + col], rho,
+                 static_cast<Uint8>( row ),
+                 static_cast<Uint8>( col ));
+    else
+      sampleNtt( matrix[(row * K) + col], rho,
+                 static_cast<Uint8>( col ),
+                 static_cast<Uint8>( row ));
+
+    }
+  }
+}
+
+
+
+void MlKem768::encode12( Uint8* bytes,
+                         const Poly& poly )
+{
+for( Int32 count = 0; count < (N / 2); count++ )
+  {
+  const Uint32 a = static_cast<Uint32>(
+                   freeze( poly.c[count * 2] ));
+  const Uint32 b = static_cast<Uint32>(
+                   freeze( poly.c[count * 2 + 1] ));
+
+  bytes[count * 3] = static_cast<Uint8>( a );
+  bytes[count * 3 + 1] = static_cast<Uint8>(
+                             (a >> 8) | (b << 4));
+  bytes[count * 3 + 2] = static_cast<Uint8>(
+                                          b >> 4 );
+  }
+}
+
+
+
+bool MlKem768::decode12( Poly& poly,
+                         const Uint8* bytes )
+{
+// It is false if a value is q or more.
+// That is the modulus check.
+Int32 tooBig = 0;
+for( Int32 count = 0; count < (N / 2); count++ )
+  {
+  const Int32 a = bytes[count * 3] |
+              ((bytes[count * 3 + 1] & 0x0F) << 8);
+  const Int32 b = (bytes[count * 3 + 1] >> 4) |
+              (bytes[count * 3 + 2] << 4);
+
+  tooBig |= (Q - 1 - a) | (Q - 1 - b);
+  poly.c[count * 2] = static_cast<Int16>( a );
+  poly.c[count * 2 + 1] = static_cast<Int16>( b );
+  }
+
+return tooBig >= 0;
+}
+
+
+
+void MlKem768::compressU( Uint8* bytes,
+                          const Poly& poly )
+{
+// 10 bits each.  Section 4.2.1.  The divide
+// by a constant is a multiply.
+for( Int32 count = 0; count < (N / 4); count++ )
+  {
+  Uint32 t[4];
+  for( Int32 which = 0; which < 4; which++ )
+    {
+    const Uint32 x = static_cast<Uint32>(
+             freeze( poly.c[count * 4 + which] ));
+    t[which] = (((x << 10) + (Q / 2)) / Q) &
+                                          0x3FF;
+    }
+
+  Uint8* at = bytes + (count * 5);
+  at[0] = static_cast<Uint8>( t[0] );
+  at[1] = static_cast<Uint8>(
+                      (t[0] >> 8) | (t[1] << 2));
+  at[2] = static_cast<Uint8>(
+                      (t[1] >> 6) | (t[2] << 4));
+  at[3] = static_cast<Uint8>(
+                      (t[2] >> 4) | (t[3] << 6));
+  at[4] = static_cast<Uint8>( t[3] >> 2 );
+  }
+}
+
+
+
+void MlKem768::decompressU( Poly& poly,
+                            const Uint8* bytes )
+{
+for( Int32 count = 0; count < (N / 4); count++ )
+  {
+  const Uint8* at = bytes + (count * 5);
+  Uint32 t[4];
+  t[0] = at[0] | (static_cast<Uint32>(
+                          at[1] & 0x03 ) << 8);
+  t[1] = (at[1] >> 2) | (static_cast<Uint32>(
+                          at[2] & 0x0F ) << 6);
+  t[2] = (at[2] >> 4) | (static_cast<Uint32>(
+                          at[3] & 0x3F ) << 4);
+  t[3] = (at[3] >> 6) | (static_cast<Uint32>(
+                                  at[4] ) << 2);
+
+  for( Int32 which = 0; which < 4; which++ )
+    poly.c[count * 4 + which] =
+            static_cast<Int16>(
+            ((t[which] * Q) + 512) >> 10 );
+
+  }
+}
+
+
+
+void MlKem768::compressV( Uint8* bytes,
+                          const Poly& poly )
+{
+// 4 bits each.
+for( Int32 count = 0; count < (N / 2); count++ )
+  {
+  const Uint32 a = static_cast<Uint32>(
+                   freeze( poly.c[count * 2] ));
+  const Uint32 b = static_cast<Uint32>(
+                   freeze( poly.c[count * 2 + 1] ));
+
+  const Uint32 ta = (((a << 4) + (Q / 2)) / Q) &
+                                           0x0F;
+  const Uint32 tb = (((b << 4) + (Q / 2)) / Q) &
+                                           0x0F;
+  bytes[count] = static_cast<Uint8>(
+                                ta | (tb << 4));
+  }
+}
+
+
+
+void MlKem768::decompressV( Poly& poly,
+                            const Uint8* bytes )
+{
+for( Int32 count = 0; count < (N / 2); count++ )
+  {
+  const Uint32 a = bytes[count] & 0x0F;
+  const Uint32 b = bytes[count] >> 4;
+  poly.c[count * 2] = static_cast<Int16>(
+                             ((a * Q) + 8) >> 4 );
+  poly.c[count * 2 + 1] = static_cast<Int16>(
+                             ((b * Q) + 8) >> 4 );
+  }
+}
+
+
+
+void MlKem768::msgToPoly( Poly& poly,
+                          const Uint8* msg )
+{
+// A one bit is (q + 1) / 2.
+for( Int32 count = 0; count < N; count++ )
+  {
+  const Int16 bit = static_cast<Int16>(
+                (msg[count >> 3] >> (count & 7)) & 1 );
+  poly.c[count] = static_cast<Int16>(
+                         (-bit) & ((Q + 1) / 2));
+  }
+}
+
+
+
+void MlKem768::polyToMsg( Uint8* msg,
+                          const Poly& poly )
+{
+for( Int32 count = 0; count < 32; count++ )
+  msg[count] = 0;
+
+for( Int32 count = 0; count < N; count++ )
+  {
+  const Uint32 x = static_cast<Uint32>(
+                        freeze( poly.c[count] ));
+  const Uint32 bit = (((x << 1) + (Q / 2)) / Q)
+                                            & 1;
+  msg[count >> 3] |= static_cast<Uint8>(
+                            bit << (count & 7));
+  }
+}
+
+
+
+void MlKem768::pkeKeyGen( const Uint8* dSeed,
+                          Uint8* encapKey,
+                          Uint8* pkeKey )
+{
+// Algorithm 13.
+Uint8 seedIn[33];
+::memcpy( seedIn, dSeed, 32 );
+seedIn[32] = K;
+
+Uint8 hash[64];
+Keccak::sha3512( seedIn, 33, hash );
+const Uint8* rho = hash;
+const Uint8* sigma = hash + 32;
+
+Poly matrix[K * K];
+makeMatrix( matrix, rho, false );
+
+Poly s[K];
+Poly e[K];
+Uint8 nonce = 0;
+for( Int32 count = 0; count < K; count++ )
+  {
+  sampleCbd( s[count], sigma, nonce );
+  nonce++;
+  }
+
+for( Int32 count = 0; count < K; count++ )
+  {
+  sampleCbd( e[count], sigma, nonce );
+  nonce++;
+  }
+
+for( Int32 count = 0; count < K; count++ )
+  {
+  ntt( s[count] );
+  ntt( e[count] );
+  }
+
+// t = A s + e.
+for( Int32 count = 0; count < K; count++ )
+  {
+  Poly t;
+  baseMulAcc( t, matrix + (count * K), s );
+  toMont( t );
+  addPoly( t, e[count] );
+  encode12( encapKey + (count * PolyBytes), t );
+  encode12( pkeKey + (count * PolyBytes),
+            s[count] );
+  }
+
+::memcpy( encapKey + PkeKeyBytes, rho, 32 );
+
+::explicit_bzero( seedIn, sizeof( seedIn ));
+::explicit_bzero( hash, sizeof( hash ));
+::explicit_bzero( s, sizeof( s ));
+::explicit_bzero( e, sizeof( e ));
+}
+
+
+
+void MlKem768::pkeEncrypt( const Uint8* encapKey,
+                           const Poly* tHat,
+                           const Uint8* msg,
+                           const Uint8* coins,
+                           Uint8* cipher )
+{
+// Algorithm 14.
+Poly matrix[K * K];
+makeMatrix( matrix, encapKey + PkeKeyBytes,
+            true );
+
+Poly y[K];
+Poly e1[K];
+Poly e2;
+Uint8 nonce = 0;
+for( Int32 count = 0; count < K; count++ )
+  {
+  sampleCbd( y[count], coins, nonce );
+  nonce++;
+  }
+
+for( Int32 count = 0; count < K; count++ )
+  {
+  sampleCbd( e1[count], coins, nonce );
+  nonce++;
+  }
+
+sampleCbd( e2, coins, nonce );
+
+for( Int32 count = 0; count < K; count++ )
+  ntt( y[count] );
+
+// u = A^T y + e1.
+for( Int32 count = 0; count < K; count++ )
+  {
+  Poly u;
+  baseMulAcc( u, matrix + (count * K), y );
+  invNtt( u );
+  addPoly( u, e1[count] );
+  compressU( cipher + (count * UBytes), u );
+  }
+
+// v = t y + e2 + the message.
+Poly v;
+baseMulAcc( v, tHat, y );
+invNtt( v );
+addPoly( v, e2 );
+
+Poly mu;
+msgToPoly( mu, msg );
+addPoly( v, mu );
+compressV( cipher + (K * UBytes), v );
+
+::explicit_bzero( y, sizeof( y ));
+::explicit_bzero( e1, sizeof( e1 ));
+::explicit_bzero( &e2, sizeof( e2 ));
+::explicit_bzero( &mu, sizeof( mu ));
+}
+
+
+
+void MlKem768::pkeDecrypt( const Uint8* pkeKey,
+                           const Uint8* cipher,
+                           Uint8* msg )
+{
+// Algorithm 15.
+Poly u[K];
+Poly s[K];
+for( Int32 count = 0; count < K; count++ )
+  {
+  decompressU( u[count],
+               cipher + (count * UBytes));
+  ntt( u[count] );
+  decode12( s[count],
+            pkeKey + (count * PolyBytes));
+  }
+
+Poly w;
+baseMulAcc( w, s, u );
+invNtt( w );
+
+Poly v;
+decompressV( v, cipher + (K * UBytes));
+
+// w = v - s u.
+subPoly( w, v, w );
+polyToMsg( msg, w );
+
+::explicit_bzero( s, sizeof( s ));
+::explicit_bzero( &w, sizeof( w ));
+}
+
+
+
+void MlKem768::keyPairFromSeed(
+                          const Uint8* d,
+                          const Uint8* z,
+                          Uint8* encapKey,
+                          Uint8* decapKey )
+{
+// The decapsulation key is the K-PKE key,
+// the encapsulation key, its hash and z.
+pkeKeyGen( d, encapKey, decapKey );
+
+Uint8* at = decapKey + PkeKeyBytes;
+::memcpy( at, encapKey, EncapKeyBytes );
+at += EncapKeyBytes;
+
+Keccak::sha3256( encapKey, EncapKeyBytes, at );
+at += 32;
+
+::memcpy( at, z, SeedBytes );
+}
+
+
+
+void MlKem768::makeKeyPair( Uint8* encapKey,
+                            Uint8* decapKey )
+{
+Uint8 seeds[SeedBytes * 2];
+ChaChaRand::fillBytes( seeds, SeedBytes * 2 );
+
+keyPairFromSeed( seeds, seeds + SeedBytes,
+                 encapKey, decapKey );
+
+::explicit_bzero( seeds, sizeof( seeds ));
+}
+
+
+
+bool MlKem768::encapsFromSeed(
+                        const Uint8* encapKey,
+                        const Uint8* msg,
+                        Uint8* cipher,
+                        Uint8* secret )
+{
+Poly tHat[K];
+for( Int32 count = 0; count < K; count++ )
+  {
+  if( !decode12( tHat[count],
+           encapKey + (count * PolyBytes)))
+    return false;
+
+  }
+
+// K and r are G( m, H( ek )).
+Uint8 gIn[64];
+::memcpy( gIn, msg, 32 );
+Keccak::sha3256( encapKey, EncapKeyBytes,
+                 gIn + 32 );
+
+Uint8 gOut[64];
+Keccak::sha3512( gIn, 64, gOut );
+
+pkeEncrypt( encapKey, tHat, msg, gOut + 32,
+            cipher );
+
+::memcpy( secret, gOut, SecretBytes );
+
+::explicit_bzero( gIn, sizeof( gIn ));
+::explicit_bzero( gOut, sizeof( gOut ));
+return true;
+}
+
+
+
+bool MlKem768::encaps( const Uint8* encapKey,
+                       Uint8* cipher,
+                       Uint8* secret )
+{
+Uint8 msg[32];
+ChaChaRand::fillBytes( msg, 32 );
+
+const bool result = encapsFromSeed( encapKey,
+                          msg, cipher, secret );
+
+::explicit_bzero( msg, sizeof( msg ));
+return result;
+}
+
+
+
+void MlKem768::decaps( const Uint8* decapKey,
+                       const Uint8* cipher,
+                       Uint8* secret )
+{
+const Uint8* encapKey = decapKey + PkeKeyBytes;
+const Uint8* ekHash = encapKey + EncapKeyBytes;
+const Uint8* z = ekHash + 32;
+
+Uint8 msg[32];
+pkeDecrypt( decapKey, cipher, msg );
+
+Uint8 gIn[64];
+::memcpy( gIn, msg, 32 );
+::memcpy( gIn + 32, ekHash, 32 );
+
+Uint8 gOut[64];
+Keccak::sha3512( gIn, 64, gOut );
+
+// The implicit rejection secret.
+Uint8 reject[SecretBytes];
+Keccak keccak;
+keccak.startShake256();
+keccak.absorb( z, SeedBytes );
+keccak.absorb( cipher, CipherBytes );
+keccak.squeeze( reject, SecretBytes );
+
+// This key was made here, so it passes the
+// modulus check.
+Poly tHat[K];
+for( Int32 count = 0; count < K; count++ )
+  decode12( tHat[count],
+            encapKey + (count * PolyBytes));
+
+Uint8 again[CipherBytes];
+pkeEncrypt( encapKey, tHat, msg, gOut + 32,
+            again );
+
+Uint32 diff = 0;
+for( Int32 count = 0; count < CipherBytes;
+                                      count++ )
+  diff |= static_cast<Uint32>(
+                     cipher[count] ^ again[count] );
+
+// All ones if they were the same.
+const Uint8 mask = static_cast<Uint8>(
+                              (diff - 1) >> 8 );
+
+for( Int32 count = 0; count < SecretBytes;
+                                      count++ )
+  secret[count] = static_cast<Uint8>(
+           (gOut[count] & mask) |
+           (reject[count] & ~mask));
+
+::explicit_bzero( msg, sizeof( msg ));
+::explicit_bzero( gIn, sizeof( gIn ));
+::explicit_bzero( gOut, sizeof( gOut ));
+::explicit_bzero( reject, sizeof( reject ));
+}
@@ -0,0 +1,175 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// ML-KEM-768 from FIPS 203.  TLS uses it in
+// the X25519MLKEM768 hybrid key share, so
+// the handshake is still safe if either one
+// of them gets broken.  The client makes a
+// key pair and decapsulates the server's
+// ciphertext.  Encapsulation is here too so
+// it can be checked.
+
+// The coefficients are Int16 and the
+// multiplies use Montgomery reduction with
+// R = 2^16, the way the Kyber reference code
+// does it.  So the values can be anything
+// that is the right one mod q until they get
+// encoded, and then they are made to be
+// from 0 to q - 1.
+
+// The NTT, the inverse NTT and the pointwise
+// multiply use AVX2 if the CPU has it, or
+// else the portable code.  They do the same
+// arithmetic in the same order, so they
+// give the same bytes.
+
+// Nothing branches on a secret or uses one
+// as an index.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+
+
+class MlKem768
+  {
+  public:
+  // The NamedGroup for X25519MLKEM768.  The
+  // ML-KEM part comes first in the key
+  // shares and in the shared secret.
+  static const Uint32 HybridGroupID = 0x11EC;
+
+  static const Int32 EncapKeyBytes = 1184;
+  static const Int32 DecapKeyBytes = 2400;
+  static const Int32 CipherBytes = 1088;
+  static const Int32 SecretBytes = 32;
+  static const Int32 SeedBytes = 32;
+
+  static const Int32 K = 3;
+  static const Int32 N = 256;
+  static const Int32 Q = 3329;
+
+  class Poly
+    {
+    public:
+    alignas( 32 ) Int16 c[N];
+    };
+
+  private:
+  static bool useAvx2;
+
+  static void ntt( Poly& poly );
+  static void invNtt( Poly& poly );
+  static void baseMulAcc( Poly& result,
+                          const Poly* a,
+                          const Poly* b );
+  static void reducePoly( Poly& poly );
+  static void addPoly( Poly& result,
+                       const Poly& toAdd );
+  static void subPoly( Poly& result,
+                       const Poly& a,
+                       const Poly& b );
+  static void toMont( Poly& poly );
+
+  static void sampleNtt( Poly& poly,
+                         const Uint8* rho,
+                         const Uint8 first,
+                         const Uint8 second );
+  static void sampleCbd( Poly& poly,
+                         const Uint8* seed,
+                         const Uint8 nonce );
+  static void makeMatrix( Poly* matrix,
+                          const Uint8* rho,
+                          const bool transpose );
+
+  static void encode12( Uint8* bytes,
+                        const Poly& poly );
+  static bool decode12( Poly& poly,
+                        const Uint8* bytes );
+  static void compressU( Uint8* bytes,
+                         const Poly& poly );
+  static void decompressU( Poly& poly,
+                           const Uint8* bytes );
+  static void compressV( Uint8* bytes,
+                         const Poly& poly );
+  static void decompressV( Poly& poly,
+                           const Uint8* bytes );
+  static void msgToPoly( Poly& poly,
+                         const Uint8* msg );
+  static void polyToMsg( Uint8* msg,
+                         const Poly& poly );
+
+  static void pkeKeyGen( const Uint8* dSeed,
+                         Uint8* encapKey,
+                         Uint8* pkeKey );
+  static void pkeEncrypt( const Uint8* encapKey,
+                          const Poly* tHat,
+                          const Uint8* msg,
+                          const Uint8* coins,
+                          Uint8* cipher );
+  static void pkeDecrypt( const Uint8* pkeKey,
+                          const Uint8* cipher,
+                          Uint8* msg );
+
+  public:
+  // FIPS 203 Algorithm 16 with the seeds
+  // given.  d and z are SeedBytes each.
+  static void keyPairFromSeed( const Uint8* d,
+                               const Uint8* z,
+                               Uint8* encapKey,
+                               Uint8* decapKey );
+
+  // The seeds come from ChaChaRand.
+  static void makeKeyPair( Uint8* encapKey,
+                           Uint8* decapKey );
+
+  // Algorithm 17 with the message given.  It
+  // is false if the encapsulation key fails
+  // the modulus check in Section 7.2.
+  static bool encapsFromSeed(
+                        const Uint8* encapKey,
+                        const Uint8* msg,
+                        Uint8* cipher,
+                        Uint8* secret );
+
+  static bool encaps( const Uint8* encapKey,
+                      Uint8* cipher,
+                      Uint8* secret );
+
+  // Algorithm 18.  A bad ciphertext gives a
+  // secret made from z and the ciphertext,
+  // so it fails later, in the Finished
+  // check, and not here.
+  static void decaps( const Uint8* decapKey,
+                      const Uint8* cipher,
+                      Uint8* secret );
+
+  // False makes it use the portable code,
+  // so the two can be compared and timed.
+  // True only works if the CPU has AVX2.
+  // Set it before other threads use this.
+  static void setUseAvx2( const bool setTo );
+
+  static bool getUseAvx2( void )
+    {
+    return useAvx2;
+    }
+
+  };
@@ -0,0 +1,268 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "MlKemVec.h"
+#include "MlKem768.h"
+#include "Keccak.h"
+#include "../CppBase/StIO.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+// The accumulated hash after 100 times
+// around.
+static const char* Accumulated100 =
+      "1114b1b6699ed191734fa339376afa7e"
+      "285c9e6acf6ff0177d346696ce564415";
+
+
+
+bool MlKemVec::sameHex( const char* what,
+                        const Uint8* got,
+                        const Int32 howMany,
+                        const char* want )
+{
+char gotHex[(64 * 2) + 1];
+if( howMany > 64 )
+  throw "MlKemVec sameHex too long.";
+
+for( Int32 count = 0; count < howMany; count++ )
+  ::snprintf( gotHex + (count * 2), 3, "%02x",
+              got[count] );
+
+if( ::strcmp( gotHex, want ) == 0 )
+  return true;
+
+StIO::printF( "MlKemVec does not match: " );
+StIO::putS( what );
+StIO::putS( "Got:" );
+StIO::putS( gotHex );
+StIO::putS( "It should be:" );
+StIO::putS( want );
+return false;
+}
+
+
+
+bool MlKemVec::checkHashes( void )
+{
+Uint8 hash[64];
+
+Keccak::sha3256( nullptr, 0, hash );
+if( !sameHex( "SHA3-256 empty", hash, 32,
+      "a7ffc6f8bf1ed76651c14756a061d662"
+      "f580ff4de43b49fa82d80a4b80f8434a" ))
+  return false;
+
+Keccak::sha3512( nullptr, 0, hash );
+if( !sameHex( "SHA3-512 empty", hash, 64,
+      "a69f73cca23a9ac5c8b567dc185a756e"
+      "97c982164fe25859e0d1dcc1475c80a6"
+      "15b2123af1f5f94c11e3e9402c3ac558"
+      "f500199d95b6d3e301758586281dcd26" ))
+  return false;
+
+Keccak keccak;
+keccak.startShake128();
+keccak.squeeze( hash, 32 );
+if( !sameHex( "SHAKE128 empty", hash, 32,
+      "7f9c2ba4e88f827d616045507605853e"
+      "d73b8093f6efbc88eb1a6eacfa66ef26" ))
+  return false;
+
+Keccak::shake256( nullptr, 0, hash, 64 );
+if( !sameHex( "SHAKE256 empty", hash, 64,
+      "46b9dd2b0ba88d13233b3feb743eeb24"
+      "3fcd52ea62b81b82b50c27646ed5762f"
+      "d75dc4ddd8c0f200cb05019d67b592f6"
+      "fc821c49479ab48640292eacb3b7c4be" ))
+  return false;
+
+// 1600 bits of 0xA3, which is more than one
+// block.
+Uint8 a3Bytes[200];
+for( Int32 count = 0; count < 200; count++ )
+  a3Bytes[count] = 0xA3;
+
+Keccak::sha3256( a3Bytes, 200, hash );
+if( !sameHex( "SHA3-256 0xA3", hash, 32,
+      "79f38adec5c20307a98ef76e8324afbf"
+      "d46cfd81b22e3973c65fa1bd9de31787" ))
+  return false;
+
+return true;
+}
+
+
+
+bool MlKemVec::checkAccumulated( void )
+{
+Keccak source;
+source.startShake128();
+
+Keccak sink;
+sink.startShake128();
+
+// Too big for the stack.
+Uint8* encapKey = new Uint8[
+                      MlKem768::EncapKeyBytes];
+Uint8* decapKey = new Uint8[
+                      MlKem768::DecapKeyBytes];
+Uint8* cipher = new Uint8[MlKem768::CipherBytes];
+Uint8* randCipher = new Uint8[
+                        MlKem768::CipherBytes];
+
+Uint8 seeds[MlKem768::SeedBytes * 2];
+Uint8 msg[32];
+Uint8 secret[MlKem768::SecretBytes];
+Uint8 secretBack[MlKem768::SecretBytes];
+
+bool good = true;
+for( Int32 count = 0; count < 100; count++ )
+  {
+  source.squeeze( seeds, MlKem768::SeedBytes * 2 );
+  MlKem768::keyPairFromSeed( seeds,
+                      seeds + MlKem768::SeedBytes,
+                      encapKey, decapKey );
+  sink.absorb( encapKey, MlKem768::EncapKeyBytes );
+
+  source.squeeze( msg, 32 );
+  if( !MlKem768::encapsFromSeed( encapKey, msg,
+                                 cipher, secret ))
+    good = false;
+
+  sink.absorb( cipher, MlKem768::CipherBytes );
+  sink.absorb( secret, MlKem768::SecretBytes );
+
+  MlKem768::decaps( decapKey, cipher, secretBack );
+  if( ::memcmp( secret, secretBack,
+                MlKem768::SecretBytes ) != 0 )
+    good = false;
+
+  // This goes the implicit rejection way.
+  source.squeeze( randCipher,
+                  MlKem768::CipherBytes );
+  MlKem768::decaps( decapKey, randCipher,
+                    secretBack );
+  sink.absorb( secretBack, MlKem768::SecretBytes );
+  }
+
+delete[] encapKey;
+delete[] decapKey;
+delete[] cipher;
+delete[] randCipher;
+
+if( !good )
+  {
+  StIO::putS(
+        "MlKemVec decaps didn't match encaps." );
+  return false;
+  }
+
+Uint8 hash[32];
+sink.squeeze( hash, 32 );
+return sameHex( "ML-KEM-768 accumulated", hash,
+                32, Accumulated100 );
+}
+
+
+
+bool MlKemVec::checkReject( void )
+{
+Uint8* encapKey = new Uint8[
+                      MlKem768::EncapKeyBytes];
+Uint8* decapKey = new Uint8[
+                      MlKem768::DecapKeyBytes];
+Uint8* cipher = new Uint8[MlKem768::CipherBytes];
+
+MlKem768::makeKeyPair( encapKey, decapKey );
+
+Uint8 secret[MlKem768::SecretBytes];
+Uint8 secretBack[MlKem768::SecretBytes];
+bool good = MlKem768::encaps( encapKey, cipher,
+                              secret );
+
+// One bit changed gives SHAKE256 of z and
+// the ciphertext.
+cipher[100] ^= 0x04;
+MlKem768::decaps( decapKey, cipher, secretBack );
+
+const Uint8* z = decapKey +
+                   MlKem768::DecapKeyBytes -
+                   MlKem768::SeedBytes;
+Uint8 reject[MlKem768::SecretBytes];
+Keccak keccak;
+keccak.startShake256();
+keccak.absorb( z, MlKem768::SeedBytes );
+keccak.absorb( cipher, MlKem768::CipherBytes );
+keccak.squeeze( reject, MlKem768::SecretBytes );
+
+if( ::memcmp( secretBack, reject,
+              MlKem768::SecretBytes ) != 0 )
+  good = false;
+
+// A coefficient of q fails the modulus
+// check.
+encapKey[0] = 0x01;
+encapKey[1] = static_cast<Uint8>(
+                   (encapKey[1] & 0xF0) | 0x0D );
+if( MlKem768::encaps( encapKey, cipher, secret ))
+  good = false;
+
+delete[] encapKey;
+delete[] decapKey;
+delete[] cipher;
+
+if( !good )
+  StIO::putS(
+       "MlKemVec implicit rejection is bad." );
+
+return good;
+}
+
+
+
+bool MlKemVec::runCheck( void )
+{
+if( !checkHashes())
+  return false;
+
+const bool hadAvx2 = MlKem768::getUseAvx2();
+
+MlKem768::setUseAvx2( false );
+bool good = checkAccumulated() && checkReject();
+
+if( good && hadAvx2 )
+  {
+  MlKem768::setUseAvx2( true );
+  good = checkAccumulated() && checkReject();
+  }
+
+MlKem768::setUseAvx2( hadAvx2 );
+
+if( !good )
+  return false;
+
+if( hadAvx2 )
+  StIO::putS(
+       "MlKemVec: all matched, with AVX2 too." );
+else
+  StIO::putS( "MlKemVec: all matched." );
+
+return true;
+}
@@ -0,0 +1,77 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Known answers for Keccak and MlKem768,
+// with no network.
+
+// The hashes are checked against the
+// FIPS 202 examples.  ML-KEM-768 is checked
+// with the accumulated test that the Go
+// crypto library and the C2SP CCTV vectors
+// use.  A SHAKE128 with no input gives the
+// seeds, the messages and some random
+// ciphertexts, and everything that comes
+// out goes in to a second SHAKE128.  So one
+// hash covers key generation, encapsulation
+// and both ways decapsulation can go.  It
+// runs with the portable code and with
+// AVX2.
+
+// The app's main() calls runCheck().
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+
+
+class MlKemVec
+  {
+  private:
+  bool testForCopy = false;
+
+  static bool sameHex( const char* what,
+                       const Uint8* got,
+                       const Int32 howMany,
+                       const char* want );
+  static bool checkHashes( void );
+  static bool checkAccumulated( void );
+  static bool checkReject( void );
+
+  public:
+  MlKemVec( void )
+    {
+    }
+
+  MlKemVec( const MlKemVec& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "MlKemVec copy constructor.";
+    }
+
+  ~MlKemVec( void )
+    {
+    }
+
+  // True if everything matched.
+  static bool runCheck( void );
+
+  };
@@ -0,0 +1,620 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "OfflineVec.h"
+#include "TlsMainCl.h"
+#include "Rfc8448Vec.h"
+#include "AesGcm.h"
+#include "MemSrv.h"
+#include "HelloCache.h"
+#include "CurveCtx.h"
+#include "P256.h"
+#include "MlKem768.h"
+#include "AllocCount.h"
+#include "../Network/TlsOuterRec.h"
+#include "../CppBase/StIO.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <algorithm>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+  #include <x86intrin.h>
+#endif
+
+
+
+bool OfflineVec::sameBytes( const char* what,
+                            const CharBuf& got,
+                            const CharBuf& want )
+{
+const Int32 last = want.getLast();
+bool same = got.getLast() == last;
+
+for( Int32 count = 0; same && (count < last);
+                                     count++ )
+  {
+  if( got.getU8( count ) != want.getU8( count ))
+    same = false;
+
+  }
+
+if( same )
+  return true;
+
+StIO::printF( "OfflineVec does not match: " );
+StIO::putS( what );
+StIO::putS( "Got:" );
+got.showHex();
+StIO::putS( "RFC 8448 has:" );
+want.showHex();
+return false;
+}
+
+
+
+void OfflineVec::feedAll( TlsMainCl& tlsMainCl,
+                          const CharBuf& inBuf,
+                          CircleBuf& appOutBuf,
+                          CircleBuf& appInBuf )
+{
+tlsMainCl.memIn( inBuf );
+
+// processIncoming() returns after each
+// handshake message.
+for( Int32 count = 0; count < 1000; count++ )
+  {
+  if( tlsMainCl.processIncoming( appInBuf ) < 0 )
+    return;
+
+  if( tlsMainCl.processOutgoing( appOutBuf ) < 0 )
+    return;
+
+  if( !tlsMainCl.hasIncoming())
+    return;
+
+  }
+}
+
+
+
+bool OfflineVec::doHandshake( TlsMainCl& tlsMainCl,
+                              CircleBuf& appOutBuf,
+                              CircleBuf& appInBuf )
+{
+tlsMainCl.useMemTransport();
+
+CharBuf hostBuf( "server" );
+CharBuf portBuf( "443" );
+if( !tlsMainCl.startTestVecHandshake( hostBuf,
+                                      portBuf ))
+  return false;
+
+CharBuf outBuf;
+CharBuf wantBuf;
+tlsMainCl.memTakeOut( outBuf );
+Rfc8448Vec::getClHelloRec( wantBuf );
+if( !sameBytes( "ClientHello", outBuf, wantBuf ))
+  return false;
+
+CharBuf flightBuf;
+Rfc8448Vec::getSrvHelloRec( flightBuf );
+CharBuf hsRecBuf;
+Rfc8448Vec::getSrvHsRec( hsRecBuf );
+flightBuf.appendCharBuf( hsRecBuf );
+
+feedAll( tlsMainCl, flightBuf, appOutBuf,
+                               appInBuf );
+
+tlsMainCl.memTakeOut( outBuf );
+Rfc8448Vec::getClFinishedRec( wantBuf );
+if( !sameBytes( "client Finished", outBuf,
+                                   wantBuf ))
+  return false;
+
+return tlsMainCl.isHandshakeDone();
+}
+
+
+
+bool OfflineVec::runCheck( void )
+{
+// It is too big for the stack.
+TlsMainCl* tlsMainCl = new TlsMainCl;
+
+CircleBuf appOutBuf;
+CircleBuf appInBuf;
+appOutBuf.setSize( 1024 * 64 );
+appInBuf.setSize( 1024 * 64 );
+
+if( !doHandshake( *tlsMainCl, appOutBuf,
+                              appInBuf ))
+  {
+  delete tlsMainCl;
+  return false;
+  }
+
+// The NewSessionTicket.
+CharBuf ticketBuf;
+Rfc8448Vec::getSrvTicketRec( ticketBuf );
+feedAll( *tlsMainCl, ticketBuf, appOutBuf,
+                                appInBuf );
+
+// Both sides send the 50 bytes 0 to 49.
+for( Int32 count = 0; count < 50; count++ )
+  appOutBuf.addU8( static_cast<Uint8>( count ));
+
+tlsMainCl->processOutgoing( appOutBuf );
+
+CharBuf outBuf;
+CharBuf wantBuf;
+tlsMainCl->memTakeOut( outBuf );
+Rfc8448Vec::getClAppDataRec( wantBuf );
+if( !sameBytes( "client app data", outBuf,
+                                   wantBuf ))
+  {
+  delete tlsMainCl;
+  return false;
+  }
+
+// The server's app data record is sealed
+// here with the server application key.
+// The ticket used sequence number zero.
+CharBuf key;
+CharBuf iv;
+Rfc8448Vec::getSrvAppKey( key, iv );
+
+Uint8 keyBytes[AesGcm::KeySize];
+Uint8 ivBytes[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  keyBytes[count] = key.getU8( count );
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  ivBytes[count] = iv.getU8( count );
+
+AesGcm aesGcm;
+aesGcm.setKey( keyBytes, ivBytes );
+
+Uint8 plain[51];
+for( Int32 count = 0; count < 50; count++ )
+  plain[count] = static_cast<Uint8>( count );
+
+plain[50] = TlsOuterRec::ApplicationData;
+
+const Int32 cipherLast = 51 + AesGcm::TagSize;
+Uint8 record[5 + cipherLast];
+record[0] = TlsOuterRec::ApplicationData;
+record[1] = 3;
+record[2] = 3;
+record[3] = 0;
+record[4] = static_cast<Uint8>( cipherLast );
+aesGcm.seal( 1, record, 5, plain, 51,
+             record + 5 );
+
+CharBuf srvAppBuf;
+for( Int32 count = 0; count < 5 + cipherLast;
+                                     count++ )
+  srvAppBuf.appendU8( record[count] );
+
+feedAll( *tlsMainCl, srvAppBuf, appOutBuf,
+                                appInBuf );
+
+bool good = appInBuf.getHowMany() == 50;
+for( Int32 count = 0; good && (count < 50);
+                                     count++ )
+  {
+  if( appInBuf.getU8() != count )
+    good = false;
+
+  }
+
+delete tlsMainCl;
+
+if( !good )
+  {
+  StIO::putS(
+      "OfflineVec server app data is not right." );
+  return false;
+  }
+
+StIO::putS( "OfflineVec: RFC 8448 all matched." );
+if( !cacheCheck())
+  return false;
+
+return poolCheck();
+}
+
+
+
+bool OfflineVec::loopHandshake(
+                        TlsMainCl& tlsMainCl,
+                        const CharBuf& serverName,
+                        const Uint32 group,
+                        Uint64& clientAllocs )
+{
+// A whole handshake with MemSrv through
+// startHandshake(), then 50 bytes each way
+// with the application keys.  MemSrv picks
+// group, so the client offers P-256 or the
+// hybrid if that is the one.  clientAllocs
+// only counts what the calls to tlsMainCl
+// allocate.
+
+MemSrv* memSrv = new MemSrv;
+
+CircleBuf appOutBuf;
+CircleBuf appInBuf;
+appOutBuf.setSize( 1024 * 64 );
+appInBuf.setSize( 1024 * 64 );
+
+bool good = false;
+CharBuf portBuf( "443" );
+CharBuf outBuf;
+CharBuf flightBuf;
+CharBuf srvRecBuf;
+CharBuf gotBuf;
+
+CharBuf plainBuf;
+for( Int32 count = 0; count < 50; count++ )
+  plainBuf.appendU8( static_cast<Uint8>( count ));
+
+clientAllocs = 0;
+Uint64 allocStart = AllocCount::get();
+
+tlsMainCl.setOfferP256( group == P256::GroupID );
+tlsMainCl.setOfferMlKem( group ==
+                     MlKem768::HybridGroupID );
+
+tlsMainCl.useMemTransport();
+if( tlsMainCl.startHandshake( serverName,
+                              portBuf ))
+  {
+  tlsMainCl.memTakeOut( outBuf );
+  clientAllocs += AllocCount::get() - allocStart;
+
+  good = memSrv->takeClHello( outBuf, group,
+                              flightBuf );
+  }
+
+if( good )
+  {
+  allocStart = AllocCount::get();
+  feedAll( tlsMainCl, flightBuf, appOutBuf,
+                                 appInBuf );
+  tlsMainCl.memTakeOut( outBuf );
+  clientAllocs += AllocCount::get() - allocStart;
+
+  good = memSrv->takeClFinished( outBuf ) &&
+         tlsMainCl.isHandshakeDone();
+  }
+
+if( good )
+  {
+  memSrv->sealAppData( plainBuf, srvRecBuf );
+
+  allocStart = AllocCount::get();
+  feedAll( tlsMainCl, srvRecBuf, appOutBuf,
+                                 appInBuf );
+  clientAllocs += AllocCount::get() - allocStart;
+
+  good = appInBuf.getHowMany() == 50;
+  for( Int32 count = 0; good && (count < 50);
+                                       count++ )
+    {
+    if( appInBuf.getU8() != count )
+      good = false;
+
+    }
+  }
+
+if( good )
+  {
+  for( Int32 count = 0; count < 50; count++ )
+    appOutBuf.addU8( static_cast<Uint8>( count ));
+
+  allocStart = AllocCount::get();
+  tlsMainCl.processOutgoing( appOutBuf );
+  tlsMainCl.memTakeOut( outBuf );
+  clientAllocs += AllocCount::get() - allocStart;
+
+  good = memSrv->openAppData( outBuf, gotBuf ) &&
+         sameBytes( "loopback app data", gotBuf,
+                                      plainBuf );
+  }
+
+delete memSrv;
+return good;
+}
+
+
+
+bool OfflineVec::cacheCheck( void )
+{
+HelloCache::clear();
+
+CharBuf nameBuf( "loopback.test" );
+if( !cacheTwice( nameBuf, CurveCtx::GroupID ))
+  return false;
+
+// The P-256 share is patched in the
+// template too.
+CharBuf p256NameBuf( "p256.loopback.test" );
+if( !cacheTwice( p256NameBuf, P256::GroupID ))
+  return false;
+
+CharBuf mlKemNameBuf( "mlkem.loopback.test" );
+if( !cacheTwice( mlKemNameBuf,
+                 MlKem768::HybridGroupID ))
+  return false;
+
+HelloCache::clear();
+StIO::putS(
+      "OfflineVec: cached ClientHello handshake." );
+return true;
+}
+
+
+
+bool OfflineVec::cacheTwice(
+                        const CharBuf& nameBuf,
+                        const Uint32 group )
+{
+// The first handshake to this name makes
+// the HelloCache template and the second
+// one is a hit.  Both have to get all the
+// way through with MemSrv.  The second one
+// uses the same TlsMainCl after reset(),
+// like SessionPool does it.
+
+Uint32 settings = 0;
+if( group == P256::GroupID )
+  settings = HelloCache::SetOfferP256;
+
+if( group == MlKem768::HybridGroupID )
+  settings = HelloCache::SetOfferMlKem;
+
+TlsMainCl* tlsMainCl = new TlsMainCl;
+Uint64 clientAllocs = 0;
+if( !loopHandshake( *tlsMainCl, nameBuf, group,
+                    clientAllocs ))
+  {
+  delete tlsMainCl;
+  StIO::putS(
+        "OfflineVec handshake to fill the cache." );
+  return false;
+  }
+
+Uint8 helloBytes[HelloCache::MaxHelloLast];
+Int32 helloLast = 0;
+Int32 keyShareAt = -1;
+Int32 p256At = -1;
+Int32 mlKemAt = -1;
+if( !HelloCache::get( nameBuf, settings,
+                      helloBytes, helloLast,
+                      keyShareAt, p256At,
+                      mlKemAt ))
+  {
+  delete tlsMainCl;
+  StIO::putS(
+        "OfflineVec the ClientHello wasn't cached." );
+  return false;
+  }
+
+if( (group == P256::GroupID) && (p256At < 0))
+  {
+  delete tlsMainCl;
+  StIO::putS(
+        "OfflineVec the template has no P-256." );
+  return false;
+  }
+
+if( (group == MlKem768::HybridGroupID) &&
+    (mlKemAt < 0))
+  {
+  delete tlsMainCl;
+  StIO::putS(
+        "OfflineVec the template has no ML-KEM." );
+  return false;
+  }
+
+tlsMainCl->reset();
+const bool good = loopHandshake( *tlsMainCl,
+                                 nameBuf, group,
+                                 clientAllocs );
+delete tlsMainCl;
+if( !good )
+  {
+  StIO::putS(
+        "OfflineVec handshake from the cache." );
+  return false;
+  }
+
+return true;
+}
+
+
+
+bool OfflineVec::poolCheck( void )
+{
+// How many times the client calls
+// operator new for one connection, with a
+// new TlsMainCl and with one that was
+// reset().  Both are HelloCache hits, so
+// the only difference is the reuse.
+
+HelloCache::clear();
+
+CharBuf nameBuf( "pool.loopback.test" );
+Uint64 clientAllocs = 0;
+
+TlsMainCl* firstCl = new TlsMainCl;
+const bool firstGood = loopHandshake( *firstCl,
+                            nameBuf,
+                            CurveCtx::GroupID,
+                            clientAllocs );
+delete firstCl;
+if( !firstGood )
+  {
+  StIO::putS( "OfflineVec pool first handshake." );
+  return false;
+  }
+
+Uint64 allocStart = AllocCount::get();
+TlsMainCl* tlsMainCl = new TlsMainCl;
+const Uint64 newAllocs = AllocCount::get() -
+                                   allocStart;
+
+if( !loopHandshake( *tlsMainCl, nameBuf,
+                    CurveCtx::GroupID,
+                    clientAllocs ))
+  {
+  delete tlsMainCl;
+  StIO::putS( "OfflineVec pool new handshake." );
+  return false;
+  }
+
+const Uint64 freshAllocs = newAllocs +
+                                  clientAllocs;
+
+// A few times, so it shows a reused one
+// doesn't grow.
+Uint64 pooledAllocs = 0;
+Uint64 resetAllocs = 0;
+for( Int32 count = 0; count < 3; count++ )
+  {
+  allocStart = AllocCount::get();
+  tlsMainCl->reset();
+  resetAllocs = AllocCount::get() - allocStart;
+
+  if( !loopHandshake( *tlsMainCl, nameBuf,
+                      CurveCtx::GroupID,
+                      clientAllocs ))
+    {
+    delete tlsMainCl;
+    StIO::putS(
+          "OfflineVec pool reused handshake." );
+    return false;
+    }
+
+  pooledAllocs = resetAllocs + clientAllocs;
+  }
+
+delete tlsMainCl;
+HelloCache::clear();
+
+char showS[200];
+::snprintf( showS, sizeof( showS ),
+     "OfflineVec: allocations for each connection:"
+     " new %llu, reset %llu.",
+     static_cast<unsigned long long>( freshAllocs ),
+     static_cast<unsigned long long>(
+                                 pooledAllocs ));
+StIO::putS( showS );
+
+if( resetAllocs != 0 )
+  {
+  StIO::putS( "OfflineVec reset() allocated." );
+  return false;
+  }
+
+if( pooledAllocs >= freshAllocs )
+  {
+  StIO::putS(
+       "OfflineVec reuse didn't save anything." );
+  return false;
+  }
+
+return true;
+}
+
+
+
+bool OfflineVec::bench( const Int32 howMany )
+{
+if( howMany < 1 )
+  return false;
+
+double* nsEach = new double[howMany];
+double* ticksEach = new double[howMany];
+
+for( Int32 count = 0; count < howMany; count++ )
+  {
+  TlsMainCl* tlsMainCl = new TlsMainCl;
+  CircleBuf appOutBuf;
+  CircleBuf appInBuf;
+  appOutBuf.setSize( 1024 * 64 );
+  appInBuf.setSize( 1024 * 64 );
+
+  timespec startTime;
+  ::clock_gettime( CLOCK_MONOTONIC, &startTime );
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+  const Uint64 startTicks = __rdtsc();
+#else
+  const Uint64 startTicks = 0;
+#endif
+
+  const bool good = doHandshake( *tlsMainCl,
+                                 appOutBuf,
+                                 appInBuf );
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+  const Uint64 endTicks = __rdtsc();
+#else
+  const Uint64 endTicks = 0;
+#endif
+
+  timespec endTime;
+  ::clock_gettime( CLOCK_MONOTONIC, &endTime );
+
+  delete tlsMainCl;
+
+  if( !good )
+    {
+    delete[] nsEach;
+    delete[] ticksEach;
+    return false;
+    }
+
+  nsEach[count] = (static_cast<double>(
+             endTime.tv_sec - startTime.tv_sec ) *
+             1.0e9) + static_cast<double>(
+             endTime.tv_nsec - startTime.tv_nsec );
+  ticksEach[count] = static_cast<double>(
+                       endTicks - startTicks );
+  }
+
+std::sort( nsEach, nsEach + howMany );
+std::sort( ticksEach, ticksEach + howMany );
+
+char lineChars[256];
+::snprintf( lineChars, sizeof( lineChars ),
+      "OfflineVec %d handshakes: median %.1f us, "
+      "min %.1f us, max %.1f us, "
+      "median %.0f ticks",
+      howMany, nsEach[howMany / 2] / 1000.0,
+      nsEach[0] / 1000.0,
+      nsEach[howMany - 1] / 1000.0,
+      ticksEach[howMany / 2] );
+
+StIO::putS( lineChars );
+
+delete[] nsEach;
+delete[] ticksEach;
+return true;
+}
@@ -0,0 +1,109 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The RFC 8448 handshake with no network.
+// The client runs startTestVecHandshake()
+// over the in-memory transport.  This gives
+// it the server's records from RFC 8448 and
+// checks that every record the client sends
+// is byte for byte what the RFC has.  That
+// covers the whole key schedule and the
+// record layer in both directions.
+
+// cacheCheck() has MemSrv make real keys,
+// so it can run the ClientHello that
+// startHandshake() makes, from the cache or
+// not.
+
+// bench() does the same handshake over and
+// over and shows the time and the TSC ticks
+// for each one.
+
+// The app's main() calls these.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "../CppBase/CircleBuf.h"
+
+
+class TlsMainCl;
+
+
+
+class OfflineVec
+  {
+  private:
+  bool testForCopy = false;
+
+  static bool sameBytes( const char* what,
+                         const CharBuf& got,
+                         const CharBuf& want );
+  static void feedAll( TlsMainCl& tlsMainCl,
+                       const CharBuf& inBuf,
+                       CircleBuf& appOutBuf,
+                       CircleBuf& appInBuf );
+  static bool doHandshake( TlsMainCl& tlsMainCl,
+                           CircleBuf& appOutBuf,
+                           CircleBuf& appInBuf );
+  static bool loopHandshake(
+                        TlsMainCl& tlsMainCl,
+                        const CharBuf& serverName,
+                        const Uint32 group,
+                        Uint64& clientAllocs );
+  static bool cacheTwice( const CharBuf& nameBuf,
+                          const Uint32 group );
+
+  public:
+  OfflineVec( void )
+    {
+    }
+
+  OfflineVec( const OfflineVec& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "OfflineVec copy constructor.";
+    }
+
+  ~OfflineVec( void )
+    {
+    }
+
+  // True if everything matched.  It does
+  // cacheCheck() and poolCheck() too.
+  static bool runCheck( void );
+
+  // Two handshakes with MemSrv to the same
+  // name, so the second ClientHello comes
+  // from the HelloCache template.  It does
+  // that for X25519, P-256 and the
+  // X25519MLKEM768 hybrid.
+  static bool cacheCheck( void );
+
+  // The allocations for one connection with
+  // a new TlsMainCl and with a reset() one,
+  // from AllocCount.
+  static bool poolCheck( void );
+
+  static bool bench( const Int32 howMany );
+
+  };
@@ -0,0 +1,714 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "P256.h"
+#include "ChaChaRand.h"
+
+#include <mutex>
+#include <string.h>
+
+
+
+typedef unsigned __int128 Uint128;
+
+
+// The limbs are little endian.
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+static const Uint64 Prime[4] = {
+                 0xFFFFFFFFFFFFFFFFULL,
+                 0x00000000FFFFFFFFULL,
+                 0x0000000000000000ULL,
+                 0xFFFFFFFF00000001ULL };
+
+// The order of G, big endian.
+static const Uint8 Order[32] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84,
+  0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51 };
+
+// R^2 mod p, to get in to Montgomery form.
+static const P256::Fe RSquared = { {
+                 0x0000000000000003ULL,
+                 0xFFFFFFFBFFFFFFFFULL,
+                 0xFFFFFFFFFFFFFFFEULL,
+                 0x00000004FFFFFFFDULL } };
+
+// R mod p, which is 1 in Montgomery form.
+static const P256::Fe FeOne = { {
+                 0x0000000000000001ULL,
+                 0xFFFFFFFF00000000ULL,
+                 0xFFFFFFFFFFFFFFFFULL,
+                 0x00000000FFFFFFFEULL } };
+
+// The curve b in Montgomery form.
+static const P256::Fe CurveB = { {
+                 0xD89CDF6229C4BDDFULL,
+                 0xACF005CD78843090ULL,
+                 0xE5A220ABF7212ED6ULL,
+                 0xDC30061D04874834ULL } };
+
+// G, not in Montgomery form.
+static const P256::Fe BaseX = { {
+                 0xF4A13945D898C296ULL,
+                 0x77037D812DEB33A0ULL,
+                 0xF8BCE6E563A440F2ULL,
+                 0x6B17D1F2E12C4247ULL } };
+
+static const P256::Fe BaseY = { {
+                 0xCBB6406837BF51F5ULL,
+                 0x2BCE33576B315ECEULL,
+                 0x8EE7EB4A7C0F9E16ULL,
+                 0x4FE342E2FE1A7F9BULL } };
+
+
+// j * 16^i * G for j = 1 to 15, in affine
+// form with Z set to one.
+static P256::Point baseTable[64][15];
+static std::once_flag baseTableOnce;
+
+
+
+// Subtract p if a + top * 2^256 is at least
+// p.  It reads the same either way.
+static inline void reduceOnce( P256::Fe& result,
+                               const Uint64* a,
+                               const Uint64 top )
+{
+Uint64 diff[4];
+Uint64 borrow = 0;
+for( Int32 count = 0; count < 4; count++ )
+  {
+  const Uint128 sub = static_cast<Uint128>(
+                               a[count] ) -
+                      Prime[count] - borrow;
+  diff[count] = static_cast<Uint64>( sub );
+  borrow = static_cast<Uint64>( sub >> 64 ) & 1;
+  }
+
+// It was less than p if the top word
+// borrowed.
+const Uint64 keep = static_cast<Uint64>( 0 ) -
+           static_cast<Uint64>( top < borrow );
+
+for( Int32 count = 0; count < 4; count++ )
+  result.v[count] = (a[count] & keep) |
+                    (diff[count] & ~keep);
+
+}
+
+
+
+void P256::feAdd( Fe& result, const Fe& a,
+                  const Fe& b )
+{
+Uint64 sum[4];
+Uint64 carry = 0;
+for( Int32 count = 0; count < 4; count++ )
+  {
+  const Uint128 add = static_cast<Uint128>(
+                               a.v[count] ) +
+                      b.v[count] + carry;
+  sum[count] = static_cast<Uint64>( add );
+  carry = static_cast<Uint64>( add >> 64 );
+  }
+
+reduceOnce( result, sum, carry );
+}
+
+
+
+void P256::feSub( Fe& result, const Fe& a,
+                  const Fe& b )
+{
+Uint64 diff[4];
+Uint64 borrow = 0;
+for( Int32 count = 0; count < 4; count++ )
+  {
+  const Uint128 sub = static_cast<Uint128>(
+                               a.v[count] ) -
+                      b.v[count] - borrow;
+  diff[count] = static_cast<Uint64>( sub );
+  borrow = static_cast<Uint64>( sub >> 64 ) & 1;
+  }
+
+// Add p back if it went below zero.
+const Uint64 mask = static_cast<Uint64>( 0 ) -
+                                       borrow;
+Uint64 carry = 0;
+for( Int32 count = 0; count < 4; count++ )
+  {
+  const Uint128 add = static_cast<Uint128>(
+                               diff[count] ) +
+                      (Prime[count] & mask) + carry;
+  result.v[count] = static_cast<Uint64>( add );
+  carry = static_cast<Uint64>( add >> 64 );
+  }
+}
+
+
+
+void P256::feMul( Fe& result, const Fe& a,
+                  const Fe& b )
+{
+// Montgomery multiplication, one word of b
+// at a time.  -1/p mod 2^64 is 1 for this
+// p, so the multiplier is just the low
+// word.
+
+Uint64 t[6] = { 0, 0, 0, 0, 0, 0 };
+
+for( Int32 row = 0; row < 4; row++ )
+  {
+  Uint64 carry = 0;
+  for( Int32 col = 0; col < 4; col++ )
+    {
+    const Uint128 prod = static_cast<Uint128>(
+                              a.v[col] ) * b.v[row] +
+                         t[col] + carry;
+    t[col] = static_cast<Uint64>( prod );
+    carry = static_cast<Uint64>( prod >> 64 );
+    }
+
+  Uint128 sum = static_cast<Uint128>( t[4] ) +
+                                       carry;
+  t[4] = static_cast<Uint64>( sum );
+  t[5] = static_cast<Uint64>( sum >> 64 );
+
+  const Uint64 m = t[0];
+  Uint128 prod = static_cast<Uint128>( m ) *
+                             Prime[0] + t[0];
+  carry = static_cast<Uint64>( prod >> 64 );
+  for( Int32 col = 1; col < 4; col++ )
+    {
+    prod = static_cast<Uint128>( m ) *
+                     Prime[col] + t[col] + carry;
+    t[col - 1] = static_cast<Uint64>( prod );
+    carry = static_cast<Uint64>( prod >> 64 );
+    }
+
+  sum = static_cast<Uint128>( t[4] ) + carry;
+  t[3] = static_cast<Uint64>( sum );
+  t[4] = t[5] + static_cast<Uint64>( sum >> 64 );
+  }
+
+// It is less than 2p here.
+reduceOnce( result, t, t[4] );
+}
+
+
+
+void P256::feInvert( Fe& result, const Fe& a )
+{
+// Fermat: a^(p - 2).  The exponent is not a
+// secret so it can go by its bits.
+
+static const Uint64 Exponent[4] = {
+                 0xFFFFFFFFFFFFFFFDULL,
+                 0x00000000FFFFFFFFULL,
+                 0x0000000000000000ULL,
+                 0xFFFFFFFF00000001ULL };
+
+Fe power = FeOne;
+for( Int32 word = 3; word >= 0; word-- )
+  {
+  for( Int32 bit = 63; bit >= 0; bit-- )
+    {
+    feMul( power, power, power );
+    if( ((Exponent[word] >> bit) & 1) != 0 )
+      feMul( power, power, a );
+
+    }
+  }
+
+result = power;
+}
+
+
+
+bool P256::feFromBytes( Fe& result,
+                        const Uint8* bytes )
+{
+// Big endian bytes to Montgomery form.  It
+// is false if it is not less than p.
+
+Fe plain;
+for( Int32 word = 0; word < 4; word++ )
+  {
+  Uint64 value = 0;
+  for( Int32 count = 0; count < 8; count++ )
+    {
+    value <<= 8;
+    value |= bytes[(3 - word) * 8 + count];
+    }
+
+  plain.v[word] = value;
+  }
+
+bool isLess = false;
+for( Int32 word = 3; word >= 0; word-- )
+  {
+  if( plain.v[word] == Prime[word] )
+    continue;
+
+  isLess = plain.v[word] < Prime[word];
+  break;
+  }
+
+if( !isLess )
+  return false;
+
+feMul( result, plain, RSquared );
+return true;
+}
+
+
+
+void P256::feToBytes( Uint8* bytes, const Fe& a )
+{
+static const Fe PlainOne = { { 1, 0, 0, 0 } };
+
+Fe plain;
+feMul( plain, a, PlainOne );
+
+for( Int32 word = 0; word < 4; word++ )
+  {
+  Uint64 value = plain.v[word];
+  for( Int32 count = 7; count >= 0; count-- )
+    {
+    bytes[(3 - word) * 8 + count] =
+                     static_cast<Uint8>( value );
+    value >>= 8;
+    }
+  }
+}
+
+
+
+bool P256::feIsEqual( const Fe& a, const Fe& b )
+{
+// Montgomery form is fully reduced, so the
+// limbs are the same if the values are.
+Uint64 diff = 0;
+for( Int32 count = 0; count < 4; count++ )
+  diff |= a.v[count] ^ b.v[count];
+
+return diff == 0;
+}
+
+
+
+void P256::setIdentity( Point& result )
+{
+// (0 : 1 : 0) in projective form.
+for( Int32 count = 0; count < 4; count++ )
+  {
+  result.x.v[count] = 0;
+  result.z.v[count] = 0;
+  }
+
+result.y = FeOne;
+}
+
+
+
+void P256::pointAdd( Point& result,
+                     const Point& a,
+                     const Point& b )
+{
+// Algorithm 4 in Renes, Costello and
+// Batina, for a = -3.  It works for any
+// two points, the same or not.
+
+Fe t0, t1, t2, t3, t4;
+Fe x3, y3, z3;
+
+feMul( t0, a.x, b.x );
+feMul( t1, a.y, b.y );
+feMul( t2, a.z, b.z );
+feAdd( t3, a.x, a.y );
+feAdd( t4, b.x, b.y );
+feMul( t3, t3, t4 );
+feAdd( t4, t0, t1 );
+feSub( t3, t3, t4 );
+feAdd( t4, a.y, a.z );
+feAdd( x3, b.y, b.z );
+feMul( t4, t4, x3 );
+feAdd( x3, t1, t2 );
+feSub( t4, t4, x3 );
+feAdd( x3, a.x, a.z );
+feAdd( y3, b.x, b.z );
+feMul( x3, x3, y3 );
+feAdd( y3, t0, t2 );
+feSub( y3, x3, y3 );
+feMul( z3, CurveB, t2 );
+feSub( x3, y3, z3 );
+feAdd( z3, x3, x3 );
+feAdd( x3, x3, z3 );
+feSub( z3, t1, x3 );
+feAdd( x3, t1, x3 );
+feMul( y3, CurveB, y3 );
+feAdd( t1, t2, t2 );
+feAdd( t2, t1, t2 );
+feSub( y3, y3, t2 );
+feSub( y3, y3, t0 );
+feAdd( t1, y3, y3 );
+feAdd( y3, t1, y3 );
+feAdd( t1, t0, t0 );
+feAdd( t0, t1, t0 );
+feSub( t0, t0, t2 );
+feMul( t1, t4, y3 );
+feMul( t2, t0, y3 );
+feMul( y3, x3, z3 );
+feAdd( y3, y3, t2 );
+feMul( x3, t3, x3 );
+feSub( x3, x3, t1 );
+feMul( z3, t4, z3 );
+feMul( t1, t3, t0 );
+feAdd( z3, z3, t1 );
+
+result.x = x3;
+result.y = y3;
+result.z = z3;
+}
+
+
+
+void P256::pointDouble( Point& result,
+                        const Point& a )
+{
+// Algorithm 6, doubling for a = -3.
+
+Fe t0, t1, t2, t3;
+Fe x3, y3, z3;
+
+feMul( t0, a.x, a.x );
+feMul( t1, a.y, a.y );
+feMul( t2, a.z, a.z );
+feMul( t3, a.x, a.y );
+feAdd( t3, t3, t3 );
+feMul( z3, a.x, a.z );
+feAdd( z3, z3, z3 );
+feMul( y3, CurveB, t2 );
+feSub( y3, y3, z3 );
+feAdd( x3, y3, y3 );
+feAdd( y3, x3, y3 );
+feSub( x3, t1, y3 );
+feAdd( y3, t1, y3 );
+feMul( y3, x3, y3 );
+feMul( x3, x3, t3 );
+feAdd( t3, t2, t2 );
+feAdd( t2, t2, t3 );
+feMul( z3, CurveB, z3 );
+feSub( z3, z3, t2 );
+feSub( z3, z3, t0 );
+feAdd( t3, z3, z3 );
+feAdd( z3, z3, t3 );
+feAdd( t3, t0, t0 );
+feAdd( t0, t3, t0 );
+feSub( t0, t0, t2 );
+feMul( t0, t0, z3 );
+feAdd( y3, y3, t0 );
+feMul( t0, a.y, a.z );
+feAdd( t0, t0, t0 );
+feMul( z3, t0, z3 );
+feSub( x3, x3, z3 );
+feMul( z3, t0, t1 );
+feAdd( z3, z3, z3 );
+feAdd( z3, z3, z3 );
+
+result.x = x3;
+result.y = y3;
+result.z = z3;
+}
+
+
+
+void P256::selectPoint( Point& result,
+                        const Point* table,
+                        const Uint32 index )
+{
+// table[0] is for index 1.  Index 0 gives
+// the identity.  Every entry gets read.
+
+setIdentity( result );
+
+for( Uint32 which = 1; which <= 15; which++ )
+  {
+  const Uint32 diff = which ^ index;
+  // All ones if diff is zero.
+  const Uint64 mask = static_cast<Uint64>(
+         (static_cast<Uint64>( diff ) - 1) >> 63 )
+                                        * ~0ULL;
+  const Point& entry = table[which - 1];
+  for( Int32 count = 0; count < 4; count++ )
+    {
+    result.x.v[count] ^= (result.x.v[count] ^
+                     entry.x.v[count]) & mask;
+    result.y.v[count] ^= (result.y.v[count] ^
+                     entry.y.v[count]) & mask;
+    result.z.v[count] ^= (result.z.v[count] ^
+                     entry.z.v[count]) & mask;
+    }
+  }
+}
+
+
+
+static inline Uint32 getNibble(
+                           const Uint8* scalar,
+                           const Int32 which )
+{
+// Nibble 0 is the lowest 4 bits.
+const Uint8 aByte = scalar[31 - (which >> 1)];
+if( (which & 1) != 0 )
+  return aByte >> 4;
+
+return aByte & 0x0F;
+}
+
+
+
+bool P256::toAffine( Uint8* xBytes,
+                     Uint8* yBytes,
+                     const Point& a )
+{
+static const Fe Zero = { { 0, 0, 0, 0 } };
+
+if( feIsEqual( a.z, Zero ))
+  return false;
+
+Fe zInv;
+feInvert( zInv, a.z );
+
+Fe x;
+feMul( x, a.x, zInv );
+feToBytes( xBytes, x );
+
+if( yBytes != nullptr )
+  {
+  Fe y;
+  feMul( y, a.y, zInv );
+  feToBytes( yBytes, y );
+  }
+
+return true;
+}
+
+
+
+void P256::makeBaseTable( void )
+{
+// This is done once.  Each entry gets its
+// own inversion to make Z one, which takes
+// a few milliseconds in all.
+
+Point rowBase;
+feMul( rowBase.x, BaseX, RSquared );
+feMul( rowBase.y, BaseY, RSquared );
+rowBase.z = FeOne;
+
+for( Int32 row = 0; row < 64; row++ )
+  {
+  Point multiple = rowBase;
+  for( Int32 col = 0; col < 15; col++ )
+    {
+    if( col > 0 )
+      pointAdd( multiple, multiple, rowBase );
+
+    Fe zInv;
+    feInvert( zInv, multiple.z );
+
+    Point& entry = baseTable[row][col];
+    feMul( entry.x, multiple.x, zInv );
+    feMul( entry.y, multiple.y, zInv );
+    entry.z = FeOne;
+    }
+
+  // Times 16 for the next row.
+  for( Int32 count = 0; count < 4; count++ )
+    pointDouble( rowBase, rowBase );
+
+  }
+}
+
+
+
+void P256::baseMult( Point& result,
+                     const Uint8* scalar )
+{
+std::call_once( baseTableOnce, makeBaseTable );
+
+setIdentity( result );
+
+Point entry;
+for( Int32 row = 0; row < 64; row++ )
+  {
+  selectPoint( entry, baseTable[row],
+               getNibble( scalar, row ));
+  pointAdd( result, result, entry );
+  }
+}
+
+
+
+void P256::varMult( Point& result,
+                    const Point& point,
+                    const Uint8* scalar )
+{
+// 1 to 15 times the point.
+Point table[15];
+table[0] = point;
+for( Int32 count = 1; count < 15; count++ )
+  {
+  if( (count & 1) != 0 )
+    pointDouble( table[count],
+                 table[count >> 1] );
+  else
+    pointAdd( table[count], table[count - 1],
+              point );
+
+  }
+
+setIdentity( result );
+
+Point entry;
+for( Int32 which = 63; which >= 0; which-- )
+  {
+  pointDouble( result, result );
+  pointDouble( result, result );
+  pointDouble( result, result );
+  pointDouble( result, result );
+
+  selectPoint( entry, table,
+               getNibble( scalar, which ));
+  pointAdd( result, result, entry );
+  }
+}
+
+
+
+bool P256::scalarIsGood( const Uint8* scalar )
+{
+// From 1 to n - 1.
+
+Uint8 anyBits = 0;
+for( Int32 count = 0; count < 32; count++ )
+  anyBits |= scalar[count];
+
+if( anyBits == 0 )
+  return false;
+
+for( Int32 count = 0; count < 32; count++ )
+  {
+  if( scalar[count] == Order[count] )
+    continue;
+
+  return scalar[count] < Order[count];
+  }
+
+// It is equal to n.
+return false;
+}
+
+
+
+bool P256::decodePoint( Point& result,
+                        const Uint8* pointBytes )
+{
+// Only the uncompressed form is allowed in
+// TLS 1.3.
+if( pointBytes[0] != 4 )
+  return false;
+
+if( !feFromBytes( result.x, pointBytes + 1 ))
+  return false;
+
+if( !feFromBytes( result.y, pointBytes + 33 ))
+  return false;
+
+result.z = FeOne;
+
+// y^2 = x^3 - 3x + b
+Fe left;
+feMul( left, result.y, result.y );
+
+Fe right;
+feMul( right, result.x, result.x );
+feMul( right, right, result.x );
+
+Fe threeX;
+feAdd( threeX, result.x, result.x );
+feAdd( threeX, threeX, result.x );
+feSub( right, right, threeX );
+feAdd( right, right, CurveB );
+
+return feIsEqual( left, right );
+}
+
+
+
+bool P256::pubFromPriv( const Uint8* privKey,
+                        Uint8* pubKey )
+{
+if( !scalarIsGood( privKey ))
+  return false;
+
+Point pubPoint;
+baseMult( pubPoint, privKey );
+
+pubKey[0] = 4;
+return toAffine( pubKey + 1, pubKey + 33,
+                 pubPoint );
+}
+
+
+
+void P256::makeKeyPair( Uint8* privKey,
+                        Uint8* pubKey )
+{
+// Try again if it is not less than n.
+// That is about one in 2^32.
+for( ;; )
+  {
+  ChaChaRand::fillBytes( privKey, ScalarBytes );
+  if( pubFromPriv( privKey, pubKey ))
+    return;
+
+  }
+}
+
+
+
+bool P256::sharedSecret( const Uint8* privKey,
+                         const Uint8* peerPub,
+                         Uint8* secret )
+{
+if( !scalarIsGood( privKey ))
+  return false;
+
+Point peerPoint;
+if( !decodePoint( peerPoint, peerPub ))
+  return false;
+
+Point sharedPoint;
+varMult( sharedPoint, peerPoint, privKey );
+
+// The point at infinity can't happen with a
+// good peer point since n is prime.
+return toAffine( secret, nullptr, sharedPoint );
+}
@@ -0,0 +1,127 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// ECDHE with the NIST P-256 curve,
+// secp256r1, for servers that won't do
+// x25519.  RFC 8446 Section 4.2.8.2.
+
+// A field element is 4 limbs of 64 bits in
+// Montgomery form.  The points use the
+// complete formulas from Renes, Costello
+// and Batina, "Complete addition formulas
+// for prime order elliptic curves", 2016.
+// There are no special cases for the point
+// at infinity or for doubling, so there is
+// no branch that depends on a secret.  Table
+// lookups read every entry.
+
+// Making a key uses a table of j * 16^i * G
+// that is made the first time it is used.
+// Then it is 64 additions with no doubling.
+// The shared secret uses a 4 bit window.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+
+
+class P256
+  {
+  public:
+  // The NamedGroup for secp256r1.
+  static const Uint32 GroupID = 0x0017;
+
+  static const Int32 ScalarBytes = 32;
+
+  // Uncompressed: 4, then X, then Y.
+  static const Int32 PointBytes = 65;
+
+  class Fe
+    {
+    public:
+    Uint64 v[4];
+    };
+
+  class Point
+    {
+    public:
+    Fe x;
+    Fe y;
+    Fe z;
+    };
+
+  private:
+  static void feAdd( Fe& result, const Fe& a,
+                     const Fe& b );
+  static void feSub( Fe& result, const Fe& a,
+                     const Fe& b );
+  static void feMul( Fe& result, const Fe& a,
+                     const Fe& b );
+  static void feInvert( Fe& result,
+                        const Fe& a );
+  static bool feFromBytes( Fe& result,
+                           const Uint8* bytes );
+  static void feToBytes( Uint8* bytes,
+                         const Fe& a );
+  static bool feIsEqual( const Fe& a,
+                         const Fe& b );
+
+  static void pointAdd( Point& result,
+                        const Point& a,
+                        const Point& b );
+  static void pointDouble( Point& result,
+                           const Point& a );
+  static void setIdentity( Point& result );
+  static void selectPoint( Point& result,
+                           const Point* table,
+                           const Uint32 index );
+  static bool toAffine( Uint8* xBytes,
+                        Uint8* yBytes,
+                        const Point& a );
+
+  static void makeBaseTable( void );
+  static void baseMult( Point& result,
+                        const Uint8* scalar );
+  static void varMult( Point& result,
+                       const Point& point,
+                       const Uint8* scalar );
+  static bool scalarIsGood(
+                        const Uint8* scalar );
+  static bool decodePoint( Point& result,
+                           const Uint8* pointBytes );
+
+  public:
+  // A new private key from ChaChaRand and
+  // its public point.
+  static void makeKeyPair( Uint8* privKey,
+                           Uint8* pubKey );
+
+  static bool pubFromPriv( const Uint8* privKey,
+                           Uint8* pubKey );
+
+  // The X coordinate of privKey times the
+  // peer point, which is what TLS uses.  It
+  // is false if the peer point is not on the
+  // curve.
+  static bool sharedSecret( const Uint8* privKey,
+                            const Uint8* peerPub,
+                            Uint8* secret );
+
+  };
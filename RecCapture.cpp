@@ -0,0 +1,181 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "RecCapture.h"
+#include "LogCl.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+
+
+
+Int64 RecCapture::getNanoSec( void )
+{
+timespec now;
+::clock_gettime( CLOCK_MONOTONIC, &now );
+
+Int64 result = now.tv_sec;
+result *= 1000000000LL;
+result += now.tv_nsec;
+return result;
+}
+
+
+
+bool RecCapture::openFile( const CharBuf& fileName )
+{
+closeFile();
+
+char pathName[4096];
+const Int32 last = fileName.getLast();
+if( last >= 4096 )
+  throw "RecCapture file name is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  pathName[count] = static_cast<char>(
+                       fileName.getU8( count ));
+
+pathName[last] = 0;
+
+// It has the private key in it.
+fileHandle = ::open( pathName,
+                O_WRONLY | O_CREAT | O_TRUNC |
+                O_CLOEXEC, 0600 );
+if( fileHandle < 0 )
+  {
+  LogCl::error(
+         "RecCapture could not open file:",
+         errno );
+  return false;
+  }
+
+writeBuf = new Uint8[WriteBufSize];
+writeLast = 0;
+startNs = getNanoSec();
+
+const Uint8 magic[8] = { 'T', 'L', 'S', 'C',
+                         'A', 'P', '1', 0 };
+appendBytes( magic, 8 );
+return true;
+}
+
+
+
+void RecCapture::closeFile( void )
+{
+if( fileHandle < 0 )
+  return;
+
+flushBuf();
+::close( fileHandle );
+fileHandle = -1;
+
+delete[] writeBuf;
+writeBuf = nullptr;
+writeLast = 0;
+}
+
+
+
+bool RecCapture::flushBuf( void )
+{
+Int32 where = 0;
+while( where < writeLast )
+  {
+  ssize_t howMany = ::write( fileHandle,
+                 writeBuf + where,
+                 static_cast<size_t>(
+                        writeLast - where ));
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    LogCl::error( "RecCapture write error:",
+                  errno );
+    writeLast = 0;
+    return false;
+    }
+
+  where += static_cast<Int32>( howMany );
+  }
+
+writeLast = 0;
+return true;
+}
+
+
+
+void RecCapture::appendBytes( const Uint8* bytes,
+                              const Int32 howMany )
+{
+for( Int32 count = 0; count < howMany; count++ )
+  {
+  if( writeLast >= WriteBufSize )
+    flushBuf();
+
+  writeBuf[writeLast] = bytes[count];
+  writeLast++;
+  }
+}
+
+
+
+void RecCapture::addEntry( const Uint8 type,
+                           const CharBuf& bytes )
+{
+if( fileHandle < 0 )
+  return;
+
+const Int32 last = bytes.getLast();
+if( last == 0 )
+  return;
+
+Uint8 header[13];
+header[0] = type;
+
+Uint64 timeNs = static_cast<Uint64>(
+                     getNanoSec() - startNs );
+for( Int32 count = 0; count < 8; count++ )
+  {
+  header[1 + count] = static_cast<Uint8>(
+                                   timeNs );
+  timeNs >>= 8;
+  }
+
+Uint32 length = static_cast<Uint32>( last );
+for( Int32 count = 0; count < 4; count++ )
+  {
+  header[9 + count] = static_cast<Uint8>(
+                                   length );
+  length >>= 8;
+  }
+
+appendBytes( header, 13 );
+
+for( Int32 count = 0; count < last; count++ )
+  {
+  if( writeLast >= WriteBufSize )
+    flushBuf();
+
+  writeBuf[writeLast] = bytes.getU8( count );
+  writeLast++;
+  }
+}
@@ -0,0 +1,98 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This writes what goes in and out of the
+// socket for one connection to a file, so
+// the session can be run again later with
+// RecReplay and ReplayTool without the
+// server.
+
+// The file starts with the 8 bytes
+// "TLSCAP1" and a zero.  Then each entry is
+// one type byte, an 8 byte time in
+// nanoseconds since the file was opened, a
+// 4 byte length and then that many bytes.
+// The numbers are little endian.
+
+// The file has the client's private key
+// for the key exchange in it.  Anyone who
+// has the file can decrypt the session.
+// So it is only for testing, and the file
+// is made so only the owner can read it.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class RecCapture
+  {
+  private:
+  bool testForCopy = false;
+  Int32 fileHandle = -1;
+  Int64 startNs = 0;
+  Uint8* writeBuf = nullptr;
+  Int32 writeLast = 0;
+
+  static const Int32 WriteBufSize = 1024 * 64;
+
+  void appendBytes( const Uint8* bytes,
+                    const Int32 howMany );
+  bool flushBuf( void );
+
+  public:
+  static const Uint8 TypeServerName = 1;
+  static const Uint8 TypeClHello = 2;
+  static const Uint8 TypePrivKey = 3;
+  static const Uint8 TypeIn = 4;
+  static const Uint8 TypeOut = 5;
+
+  RecCapture( void )
+    {
+    }
+
+  RecCapture( const RecCapture& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "RecCapture copy constructor.";
+    }
+
+  ~RecCapture( void )
+    {
+    closeFile();
+    }
+
+  bool openFile( const CharBuf& fileName );
+  void closeFile( void );
+
+  bool isOpen( void ) const
+    {
+    return fileHandle >= 0;
+    }
+
+  void addEntry( const Uint8 type,
+                 const CharBuf& bytes );
+
+  static Int64 getNanoSec( void );
+
+  };
@@ -0,0 +1,145 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "RecCipher.h"
+#include "../Network/TlsOuterRec.h"
+
+#include <string.h>
+
+
+
+void RecCipher::setKey( const CharBuf& key,
+                        const CharBuf& iv )
+{
+if( (key.getLast() != AesGcm::KeySize) ||
+    (iv.getLast() != AesGcm::IVSize))
+  throw "RecCipher key or IV size is wrong.";
+
+Uint8 keyBytes[AesGcm::KeySize];
+Uint8 ivBytes[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  keyBytes[count] = key.getU8( count );
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  ivBytes[count] = iv.getU8( count );
+
+aesGcm.setKey( keyBytes, ivBytes );
+::explicit_bzero( keyBytes, sizeof( keyBytes ));
+::explicit_bzero( ivBytes, sizeof( ivBytes ));
+
+seqNum = 0;
+keySet = true;
+}
+
+
+
+void RecCipher::clear( void )
+{
+aesGcm.clearKey();
+seqNum = 0;
+keySet = false;
+
+// The plain text of the last record.
+::explicit_bzero( inBytes, sizeof( inBytes ));
+::explicit_bzero( outBytes, sizeof( outBytes ));
+}
+
+
+
+void RecCipher::seal( const CharBuf& plainBuf,
+                      const Uint8 recType,
+                      CharBuf& outerRecBuf )
+{
+if( !keySet )
+  throw "RecCipher seal with no key.";
+
+const Int32 plainLast = plainBuf.getLast();
+
+// The content type goes on the end.
+const Int32 innerLast = plainLast + 1;
+const Int32 cipherLast = innerLast +
+                              AesGcm::TagSize;
+if( cipherLast > MaxCipher )
+  throw "RecCipher seal record is too long.";
+
+for( Int32 count = 0; count < plainLast; count++ )
+  inBytes[count] = plainBuf.getU8( count );
+
+inBytes[plainLast] = recType;
+
+// The outer header is the additional data.
+// It always says application data, version
+// 3.3.
+Uint8 header[5];
+header[0] = TlsOuterRec::ApplicationData;
+header[1] = 3;
+header[2] = 3;
+header[3] = static_cast<Uint8>( cipherLast >> 8 );
+header[4] = static_cast<Uint8>( cipherLast );
+
+aesGcm.seal( seqNum, header, 5, inBytes,
+             innerLast, outBytes );
+seqNum++;
+
+for( Int32 count = 0; count < 5; count++ )
+  outerRecBuf.appendU8( header[count] );
+
+for( Int32 count = 0; count < cipherLast; count++ )
+  outerRecBuf.appendU8( outBytes[count] );
+
+}
+
+
+
+bool RecCipher::open( const CharBuf& recordBytes,
+                      CharBuf& plainBuf )
+{
+plainBuf.clear();
+
+if( !keySet )
+  return false;
+
+// At least the content type and the tag.
+const Int32 cipherLast = recordBytes.getLast();
+if( (cipherLast < (1 + AesGcm::TagSize)) ||
+    (cipherLast > MaxCipher))
+  return false;
+
+Uint8 header[5];
+header[0] = TlsOuterRec::ApplicationData;
+header[1] = 3;
+header[2] = 3;
+header[3] = static_cast<Uint8>( cipherLast >> 8 );
+header[4] = static_cast<Uint8>( cipherLast );
+
+for( Int32 count = 0; count < cipherLast; count++ )
+  inBytes[count] = recordBytes.getU8( count );
+
+if( !aesGcm.open( seqNum, header, 5, inBytes,
+                  cipherLast, outBytes ))
+  return false;
+
+seqNum++;
+
+const Int32 plainLast = cipherLast -
+                              AesGcm::TagSize;
+for( Int32 count = 0; count < plainLast; count++ )
+  plainBuf.appendU8( outBytes[count] );
+
+return true;
+}
@@ -0,0 +1,102 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The record protection for one direction,
+// RFC 8446 Section 5.2.  It has the key
+// from KeySched and counts the sequence
+// number.  setKey() starts it at zero again,
+// like it has to for each new key.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "AesGcm.h"
+
+
+
+class RecCipher
+  {
+  private:
+  bool testForCopy = false;
+  AesGcm aesGcm;
+  bool keySet = false;
+  Uint64 seqNum = 0;
+
+  // The biggest record that can come in.
+  // Section 5.2 allows 2^14 + 256.
+  static const Int32 MaxCipher = (1024 * 16) +
+                                           256;
+
+  // So a record doesn't need any memory
+  // from the heap.
+  Uint8 inBytes[MaxCipher] = { 0 };
+  Uint8 outBytes[MaxCipher] = { 0 };
+
+  public:
+  RecCipher( void )
+    {
+    }
+
+  RecCipher( const RecCipher& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "RecCipher copy constructor.";
+    }
+
+  ~RecCipher( void )
+    {
+    clear();
+    }
+
+  void setKey( const CharBuf& key,
+               const CharBuf& iv );
+
+  // Writes over the key.
+  void clear( void );
+
+  bool getKeySet( void ) const
+    {
+    return keySet;
+    }
+
+  Uint64 getSeqNum( void ) const
+    {
+    return seqNum;
+    }
+
+  // It appends the whole outer record, with
+  // the inner content type after the plain
+  // text and no padding.
+  void seal( const CharBuf& plainBuf,
+             const Uint8 recType,
+             CharBuf& outerRecBuf );
+
+  // recordBytes is the record without the
+  // five header bytes, like TlsOuterRec
+  // gives it.  plainBuf gets the inner plain
+  // text with the content type and the
+  // padding still on it.  It is false, with
+  // plainBuf empty, if it didn't decrypt.
+  bool open( const CharBuf& recordBytes,
+             CharBuf& plainBuf );
+
+  };
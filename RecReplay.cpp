@@ -0,0 +1,187 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "RecReplay.h"
+#include "LogCl.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+
+
+bool RecReplay::openFile( const CharBuf& fileName )
+{
+delete[] fileBytes;
+fileBytes = nullptr;
+fileLast = 0;
+where = 0;
+
+char pathName[4096];
+const Int32 last = fileName.getLast();
+if( last >= 4096 )
+  throw "RecReplay file name is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  pathName[count] = static_cast<char>(
+                       fileName.getU8( count ));
+
+pathName[last] = 0;
+
+Int32 fileHandle = ::open( pathName,
+                           O_RDONLY | O_CLOEXEC );
+if( fileHandle < 0 )
+  {
+  LogCl::error(
+         "RecReplay could not open file:",
+         errno );
+  return false;
+  }
+
+struct stat fileStat;
+if( ::fstat( fileHandle, &fileStat ) != 0 )
+  {
+  ::close( fileHandle );
+  return false;
+  }
+
+fileLast = fileStat.st_size;
+fileBytes = new Uint8[fileLast + 1];
+
+Int64 readLast = 0;
+while( readLast < fileLast )
+  {
+  ssize_t howMany = ::read( fileHandle,
+                 fileBytes + readLast,
+                 static_cast<size_t>(
+                        fileLast - readLast ));
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    break;
+    }
+
+  if( howMany == 0 )
+    break;
+
+  readLast += howMany;
+  }
+
+::close( fileHandle );
+
+if( readLast != fileLast )
+  {
+  LogCl::error( "RecReplay could not read file." );
+  return false;
+  }
+
+const Uint8 magic[8] = { 'T', 'L', 'S', 'C',
+                         'A', 'P', '1', 0 };
+if( fileLast < 8 )
+  return false;
+
+for( Int32 count = 0; count < 8; count++ )
+  {
+  if( fileBytes[count] != magic[count] )
+    {
+    LogCl::error(
+           "RecReplay not a capture file." );
+    return false;
+    }
+  }
+
+rewind();
+return true;
+}
+
+
+
+void RecReplay::rewind( void )
+{
+// Past the magic bytes.
+where = 8;
+}
+
+
+
+bool RecReplay::getNext( Uint8& type,
+                         Int64& timeNs,
+                         CharBuf& bytes )
+{
+bytes.clear();
+
+if( (where + 13) > fileLast )
+  return false;
+
+type = fileBytes[where];
+
+Uint64 timeRead = 0;
+for( Int32 count = 7; count >= 0; count-- )
+  {
+  timeRead <<= 8;
+  timeRead |= fileBytes[where + 1 + count];
+  }
+
+Uint32 length = 0;
+for( Int32 count = 3; count >= 0; count-- )
+  {
+  length <<= 8;
+  length |= fileBytes[where + 9 + count];
+  }
+
+if( (where + 13 + length) > fileLast )
+  {
+  LogCl::error( "RecReplay entry is cut off." );
+  return false;
+  }
+
+timeNs = static_cast<Int64>( timeRead );
+
+const Int64 start = where + 13;
+for( Uint32 count = 0; count < length; count++ )
+  bytes.appendU8( fileBytes[start + count] );
+
+where = start + length;
+return true;
+}
+
+
+
+bool RecReplay::findFirst( const Uint8 type,
+                           CharBuf& bytes )
+{
+const Int64 whereWas = where;
+rewind();
+
+bool found = false;
+Uint8 typeRead = 0;
+Int64 timeNs = 0;
+while( getNext( typeRead, timeNs, bytes ))
+  {
+  if( typeRead == type )
+    {
+    found = true;
+    break;
+    }
+  }
+
+where = whereWas;
+return found;
+}
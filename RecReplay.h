@@ -0,0 +1,72 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This reads a file that RecCapture wrote.
+// The whole file is read in to memory when
+// it is opened, so the replay doesn't wait
+// on the disk.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class RecReplay
+  {
+  private:
+  bool testForCopy = false;
+  Uint8* fileBytes = nullptr;
+  Int64 fileLast = 0;
+  Int64 where = 0;
+
+  public:
+  RecReplay( void )
+    {
+    }
+
+  RecReplay( const RecReplay& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "RecReplay copy constructor.";
+    }
+
+  ~RecReplay( void )
+    {
+    delete[] fileBytes;
+    }
+
+  bool openFile( const CharBuf& fileName );
+
+  // Go back to the first entry.
+  void rewind( void );
+
+  // False at the end of the file.
+  bool getNext( Uint8& type, Int64& timeNs,
+                CharBuf& bytes );
+
+  // The first entry of that type.  It
+  // doesn't change where getNext() is.
+  bool findFirst( const Uint8 type,
+                  CharBuf& bytes );
+
+  };
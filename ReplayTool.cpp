@@ -0,0 +1,159 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "ReplayTool.h"
+#include "TlsMainCl.h"
+#include "RecReplay.h"
+#include "RecCapture.h"
+#include "SinkCallBack.h"
+#include "../CppBase/CircleBuf.h"
+#include "../CppBase/StIO.h"
+
+#include <time.h>
+#include <stdio.h>
+
+
+
+bool ReplayTool::countAppData(
+                        const CharBuf& plainBuf,
+                        void* context )
+{
+Int64* appBytes = static_cast<Int64*>( context );
+*appBytes += plainBuf.getLast();
+return true;
+}
+
+
+
+bool ReplayTool::run( const CharBuf& fileName,
+                      const bool realTime )
+{
+RecReplay replay;
+if( !replay.openFile( fileName ))
+  return false;
+
+// It is too big for the stack.
+TlsMainCl* tlsMainCl = new TlsMainCl;
+
+Int64 appBytes = 0;
+SinkCallBack sink;
+sink.setFunction( countAppData, &appBytes );
+tlsMainCl->setAppSink( &sink );
+
+if( !tlsMainCl->startReplay( replay ))
+  {
+  delete tlsMainCl;
+  return false;
+  }
+
+CircleBuf appOutBuf;
+CircleBuf appInBuf;
+appOutBuf.setSize( 1024 * 64 );
+appInBuf.setSize( 1024 * 64 );
+
+Int64 inBytes = 0;
+Int64 inEntries = 0;
+bool closed = false;
+
+const Int64 start = RecCapture::getNanoSec();
+
+Uint8 type = 0;
+Int64 timeNs = 0;
+CharBuf bytes;
+CharBuf outBuf;
+while( !closed && replay.getNext( type, timeNs,
+                                  bytes ))
+  {
+  if( type != RecCapture::TypeIn )
+    continue;
+
+  if( realTime )
+    {
+    const Int64 waitNs = timeNs -
+             (RecCapture::getNanoSec() - start);
+    if( waitNs > 0 )
+      {
+      timespec waitTime;
+      waitTime.tv_sec = waitNs / 1000000000LL;
+      waitTime.tv_nsec = waitNs % 1000000000LL;
+      ::nanosleep( &waitTime, nullptr );
+      }
+    }
+
+  inEntries++;
+  inBytes += bytes.getLast();
+  tlsMainCl->memIn( bytes );
+
+  // processIncoming() does one record for
+  // each handshake message, so keep going
+  // until it used all of it.
+  for( Int32 count = 0; count < 100000; count++ )
+    {
+    if( tlsMainCl->processIncoming(
+                              appInBuf ) < 0 )
+      {
+      closed = true;
+      break;
+      }
+
+    if( tlsMainCl->processOutgoing(
+                              appOutBuf ) < 0 )
+      {
+      closed = true;
+      break;
+      }
+
+    // The replay doesn't use what it sends.
+    tlsMainCl->memTakeOut( outBuf );
+
+    if( !tlsMainCl->hasIncoming())
+      break;
+
+    }
+  }
+
+// Let it see the connection close.
+tlsMainCl->memClose();
+if( !closed )
+  tlsMainCl->processIncoming( appInBuf );
+
+const Int64 elapsedNs = RecCapture::getNanoSec() -
+                                        start;
+
+double mbPerSec = 0;
+if( elapsedNs > 0 )
+  mbPerSec = (static_cast<double>( inBytes ) *
+             1000.0) / static_cast<double>(
+                                   elapsedNs );
+
+char lineChars[256];
+::snprintf( lineChars, sizeof( lineChars ),
+      "Replay: %lld entries, %lld bytes in, "
+      "%lld app bytes, %lld us, %.1f MB/s, "
+      "handshake %s",
+      static_cast<long long>( inEntries ),
+      static_cast<long long>( inBytes ),
+      static_cast<long long>( appBytes ),
+      static_cast<long long>( elapsedNs / 1000 ),
+      mbPerSec,
+      tlsMainCl->isHandshakeDone() ? "done" :
+                                     "not done" );
+
+StIO::putS( lineChars );
+
+delete tlsMainCl;
+return true;
+}
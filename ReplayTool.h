@@ -0,0 +1,65 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This runs a captured session through
+// TlsMainCl::processIncoming() again with
+// no socket.  It can go as fast as it can,
+// which is what you want under a profiler,
+// or it can wait so the bytes come in at
+// the times they did in the capture.
+
+// The app's main() calls run().
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class ReplayTool
+  {
+  private:
+  bool testForCopy = false;
+
+  static bool countAppData(
+                        const CharBuf& plainBuf,
+                        void* context );
+
+  public:
+  ReplayTool( void )
+    {
+    }
+
+  ReplayTool( const ReplayTool& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "ReplayTool copy constructor.";
+    }
+
+  ~ReplayTool( void )
+    {
+    }
+
+  static bool run( const CharBuf& fileName,
+                   const bool realTime );
+
+  };
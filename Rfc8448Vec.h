@@ -0,0 +1,76 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The records and keys from the simple 1-RTT
+// handshake in RFC 8448 Section 3.  The
+// client private key for this is in
+// TlsMainCl::startTestVecHandshake().
+
+// These are used by the loopback server
+// stand-in so there is something to run
+// the client against without a real server.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class Rfc8448Vec
+  {
+  private:
+  static void fromHex( const char* hexString,
+                       CharBuf& outBuf );
+
+  public:
+  static void getClHelloRec( CharBuf& outBuf );
+  static void getSrvHelloRec( CharBuf& outBuf );
+
+  // EncryptedExtensions, Certificate,
+  // CertificateVerify and Finished in one
+  // record with the server handshake key.
+  static void getSrvHsRec( CharBuf& outBuf );
+
+  // EncryptedExtensions, Certificate and
+  // CertificateVerify as plain text.  The
+  // loopback checks send these with their
+  // own keys.
+  static void getSrvHsPlain( CharBuf& outBuf );
+
+  static void getClFinishedRec(
+                             CharBuf& outBuf );
+
+  // The NewSessionTicket is the first record
+  // with the server application key.
+  static void getSrvTicketRec(
+                             CharBuf& outBuf );
+
+  // 50 bytes of 0 to 49.  The first record
+  // with the client application key.
+  static void getClAppDataRec(
+                             CharBuf& outBuf );
+
+  static void getSrvAppKey( CharBuf& key,
+                            CharBuf& iv );
+
+  static void getClAppKey( CharBuf& key,
+                           CharBuf& iv );
+
+  };
@@ -0,0 +1,101 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "SessionPool.h"
+
+
+
+SessionPool::SessionPool( const Int32 keepMax )
+{
+if( keepMax < 1 )
+  throw "SessionPool keepMax is too small.";
+
+maxFree = keepMax;
+freeList = new ClientTls*[maxFree];
+}
+
+
+
+SessionPool::~SessionPool( void )
+{
+for( Int32 count = 0; count < freeLast; count++ )
+  delete freeList[count];
+
+delete[] freeList;
+}
+
+
+
+void SessionPool::fill( const Int32 howMany )
+{
+std::unique_lock<std::mutex> lock( poolMutex );
+
+while( (freeLast < howMany) &&
+       (freeLast < maxFree))
+  {
+  freeList[freeLast] = new ClientTls;
+  freeLast++;
+  }
+}
+
+
+
+ClientTls* SessionPool::take( void )
+{
+std::unique_lock<std::mutex> lock( poolMutex );
+
+if( freeLast > 0 )
+  {
+  freeLast--;
+  return freeList[freeLast];
+  }
+
+lock.unlock();
+return new ClientTls;
+}
+
+
+
+void SessionPool::give( ClientTls* session )
+{
+if( session == nullptr )
+  return;
+
+// Resetting it closes the socket and might
+// wait for decrypt threads, so it isn't
+// done with the lock held.
+session->reset();
+
+std::unique_lock<std::mutex> lock( poolMutex );
+
+if( freeLast < maxFree )
+  {
+  freeList[freeLast] = session;
+  freeLast++;
+  return;
+  }
+
+lock.unlock();
+delete session;
+}
+
+
+
+Int32 SessionPool::getFreeLast( void )
+{
+std::unique_lock<std::mutex> lock( poolMutex );
+return freeLast;
+}
@@ -0,0 +1,83 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// ClientTls sessions to use again.
+
+// A ClientTls has megabytes of buffers in
+// it, so making one for each connection and
+// freeing it at close costs a lot when
+// connections come and go fast.  take()
+// gives out a session that was given back
+// before, or a new one if there are none.
+// give() resets it and keeps it for the
+// next take(), so after the pool has
+// enough of them a new connection doesn't
+// allocate anything big.
+
+// Any thread can call take() and give().
+// The lock is only held to take one off or
+// put one on the list.  A session is only
+// used by one thread at a time, like
+// before.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "ClientTls.h"
+
+#include <mutex>
+
+
+
+class SessionPool
+  {
+  private:
+  bool testForCopy = false;
+  std::mutex poolMutex;
+  ClientTls** freeList = nullptr;
+  Int32 freeLast = 0;
+  Int32 maxFree = 0;
+
+  public:
+  // It keeps up to keepMax of them.  give()
+  // deletes the ones past that.
+  SessionPool( const Int32 keepMax );
+
+  SessionPool( const SessionPool& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "SessionPool copy constructor.";
+    }
+
+  ~SessionPool( void );
+
+  // Make howMany ahead of time so the first
+  // connections don't have to.
+  void fill( const Int32 howMany );
+
+  ClientTls* take( void );
+
+  // The caller doesn't use it after this.
+  void give( ClientTls* session );
+
+  Int32 getFreeLast( void );
+
+  };
@@ -0,0 +1,274 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "Sha256Cl.h"
+
+#include <string.h>
+
+
+
+// FIPS 180-4 Section 4.2.2.
+static const Uint32 RoundConst[64] = {
+         0x428a2f98, 0x71374491, 0xb5c0fbcf,
+         0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+         0x923f82a4, 0xab1c5ed5, 0xd807aa98,
+         0x12835b01, 0x243185be, 0x550c7dc3,
+         0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+         0xc19bf174, 0xe49b69c1, 0xefbe4786,
+         0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+         0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+         0x983e5152, 0xa831c66d, 0xb00327c8,
+         0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+         0x06ca6351, 0x14292967, 0x27b70a85,
+         0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+         0x650a7354, 0x766a0abb, 0x81c2c92e,
+         0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+         0xc24b8b70, 0xc76c51a3, 0xd192e819,
+         0xd6990624, 0xf40e3585, 0x106aa070,
+         0x19a4c116, 0x1e376c08, 0x2748774c,
+         0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+         0x5b9cca4f, 0x682e6ff3, 0x748f82ee,
+         0x78a5636f, 0x84c87814, 0x8cc70208,
+         0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+         0xc67178f2 };
+
+
+
+static inline Uint32 rotRight( const Uint32 x,
+                               const Int32 by )
+{
+return (x >> by) | (x << (32 - by));
+}
+
+
+
+Sha256Cl::~Sha256Cl( void )
+{
+// It might have had an HMAC key in it.
+::explicit_bzero( state, sizeof( state ));
+::explicit_bzero( block, sizeof( block ));
+}
+
+
+
+void Sha256Cl::start( void )
+{
+// Section 5.3.3.
+state[0] = 0x6a09e667;
+state[1] = 0xbb67ae85;
+state[2] = 0x3c6ef372;
+state[3] = 0xa54ff53a;
+state[4] = 0x510e527f;
+state[5] = 0x9b05688c;
+state[6] = 0x1f83d9ab;
+state[7] = 0x5be0cd19;
+
+::explicit_bzero( block, sizeof( block ));
+blockLast = 0;
+totalBytes = 0;
+}
+
+
+
+void Sha256Cl::compress( Uint32* toState,
+                         const Uint8* fromBlock )
+{
+// Section 6.2.2.
+Uint32 w[64];
+for( Int32 count = 0; count < 16; count++ )
+  {
+  const Uint8* at = fromBlock + (count * 4);
+  w[count] = (static_cast<Uint32>( at[0] ) << 24) |
+             (static_cast<Uint32>( at[1] ) << 16) |
+             (static_cast<Uint32>( at[2] ) << 8) |
+              static_cast<Uint32>( at[3] );
+  }
+
+for( Int32 count = 16; count < 64; count++ )
+  {
+  const Uint32 s0 = rotRight( w[count - 15], 7 ) ^
+                    rotRight( w[count - 15], 18 ) ^
+                    (w[count - 15] >> 3);
+  const Uint32 s1 = rotRight( w[count - 2], 17 ) ^
+                    rotRight( w[count - 2], 19 ) ^
+                    (w[count - 2] >> 10);
+  w[count] = w[count - 16] + s0 +
+             w[count - 7] + s1;
+  }
+
+Uint32 a = toState[0];
+Uint32 b = toState[1];
+Uint32 c = toState[2];
+Uint32 d = toState[3];
+Uint32 e = toState[4];
+Uint32 f = toState[5];
+Uint32 g = toState[6];
+Uint32 h = toState[7];
+
+for( Int32 count = 0; count < 64; count++ )
+  {
+  const Uint32 sum1 = rotRight( e, 6 ) ^
+                      rotRight( e, 11 ) ^
+                      rotRight( e, 25 );
+  const Uint32 choose = (e & f) ^ (~e & g);
+  const Uint32 temp1 = h + sum1 + choose +
+                       RoundConst[count] + w[count];
+  const Uint32 sum0 = rotRight( a, 2 ) ^
+                      rotRight( a, 13 ) ^
+                      rotRight( a, 22 );
+  const Uint32 major = (a & b) ^ (a & c) ^
+                                 (b & c);
+  const Uint32 temp2 = sum0 + major;
+
+  h = g;
+  g = f;
+  f = e;
+  e = d + temp1;
+  d = c;
+  c = b;
+  b = a;
+  a = temp1 + temp2;
+  }
+
+toState[0] += a;
+toState[1] += b;
+toState[2] += c;
+toState[3] += d;
+toState[4] += e;
+toState[5] += f;
+toState[6] += g;
+toState[7] += h;
+
+::explicit_bzero( w, sizeof( w ));
+}
+
+
+
+void Sha256Cl::add( const Uint8* inBytes,
+                    const Int32 howMany )
+{
+totalBytes += static_cast<Uint64>( howMany );
+
+Int32 where = 0;
+while( where < howMany )
+  {
+  Int32 toCopy = BlockSize - blockLast;
+  if( toCopy > (howMany - where))
+    toCopy = howMany - where;
+
+  ::memcpy( block + blockLast, inBytes + where,
+            static_cast<size_t>( toCopy ));
+  blockLast += toCopy;
+  where += toCopy;
+
+  if( blockLast == BlockSize )
+    {
+    compress( state, block );
+    blockLast = 0;
+    }
+  }
+}
+
+
+
+void Sha256Cl::addCharBuf( const CharBuf& inBuf )
+{
+// CharBuf only gives out one byte at a
+// time, so it goes through a chunk.
+Uint8 chunk[256];
+const Int32 last = inBuf.getLast();
+Int32 where = 0;
+while( where < last )
+  {
+  Int32 chunkLast = last - where;
+  if( chunkLast > 256 )
+    chunkLast = 256;
+
+  for( Int32 count = 0; count < chunkLast;
+                                    count++ )
+    chunk[count] = inBuf.getU8( where + count );
+
+  add( chunk, chunkLast );
+  where += chunkLast;
+  }
+
+::explicit_bzero( chunk, sizeof( chunk ));
+}
+
+
+
+void Sha256Cl::getHash( Uint8* hash ) const
+{
+// The padding is done on copies so this
+// object can keep going.
+// Section 5.1.1.
+
+Uint32 endState[8];
+Uint8 endBlock[64];
+::memcpy( endState, state, sizeof( endState ));
+::memcpy( endBlock, block, sizeof( endBlock ));
+
+Int32 endLast = blockLast;
+endBlock[endLast] = 0x80;
+endLast++;
+
+if( endLast > (BlockSize - 8))
+  {
+  ::memset( endBlock + endLast, 0,
+            static_cast<size_t>(
+                        BlockSize - endLast ));
+  compress( endState, endBlock );
+  endLast = 0;
+  }
+
+::memset( endBlock + endLast, 0,
+          static_cast<size_t>(
+                  BlockSize - 8 - endLast ));
+
+const Uint64 totalBits = totalBytes * 8;
+for( Int32 count = 0; count < 8; count++ )
+  endBlock[BlockSize - 8 + count] =
+             static_cast<Uint8>( totalBits >>
+                           (8 * (7 - count)));
+
+compress( endState, endBlock );
+
+for( Int32 count = 0; count < 8; count++ )
+  {
+  hash[(count * 4)] = static_cast<Uint8>(
+                         endState[count] >> 24 );
+  hash[(count * 4) + 1] = static_cast<Uint8>(
+                         endState[count] >> 16 );
+  hash[(count * 4) + 2] = static_cast<Uint8>(
+                         endState[count] >> 8 );
+  hash[(count * 4) + 3] = static_cast<Uint8>(
+                         endState[count] );
+  }
+
+::explicit_bzero( endState, sizeof( endState ));
+::explicit_bzero( endBlock, sizeof( endBlock ));
+}
+
+
+
+void Sha256Cl::hash( const Uint8* inBytes,
+                     const Int32 howMany,
+                     Uint8* hash )
+{
+Sha256Cl sha;
+sha.add( inBytes, howMany );
+sha.getHash( hash );
+}
@@ -0,0 +1,78 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// SHA-256 from FIPS 180-4, for the TLS 1.3
+// key schedule in KeySched.
+
+// Call add() as many times as needed.
+// getHash() doesn't change anything, so the
+// transcript hash can be taken after one
+// message and more can be added after that.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class Sha256Cl
+  {
+  private:
+  bool testForCopy = false;
+  Uint32 state[8] = { 0 };
+  Uint8 block[64] = { 0 };
+  Int32 blockLast = 0;
+  Uint64 totalBytes = 0;
+
+  static void compress( Uint32* toState,
+                        const Uint8* fromBlock );
+
+  public:
+  static const Int32 HashSize = 32;
+  static const Int32 BlockSize = 64;
+
+  Sha256Cl( void )
+    {
+    start();
+    }
+
+  Sha256Cl( const Sha256Cl& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "Sha256Cl copy constructor.";
+    }
+
+  ~Sha256Cl( void );
+
+  void start( void );
+
+  void add( const Uint8* inBytes,
+            const Int32 howMany );
+  void addCharBuf( const CharBuf& inBuf );
+
+  void getHash( Uint8* hash ) const;
+
+  static void hash( const Uint8* inBytes,
+                    const Int32 howMany,
+                    Uint8* hash );
+
+  };
@@ -0,0 +1,58 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "SinkBuffer.h"
+#include "LogCl.h"
+
+#include <string.h>
+
+
+
+bool SinkBuffer::write( const CharBuf& plainBuf )
+{
+const Int32 last = plainBuf.getLast();
+if( (bufLast + last) > bufSize )
+  {
+  LogCl::error( "SinkBuffer is full." );
+  return false;
+  }
+
+Uint8* toPoint = buffer + bufLast;
+for( Int32 count = 0; count < last; count++ )
+  toPoint[count] = plainBuf.getU8( count );
+
+bufLast += last;
+return true;
+}
+
+
+
+void SinkBuffer::consumed( const Int64 howMany )
+{
+if( howMany >= bufLast )
+  {
+  bufLast = 0;
+  return;
+  }
+
+if( howMany <= 0 )
+  return;
+
+::memmove( buffer, buffer + howMany,
+           static_cast<size_t>(
+                         bufLast - howMany ));
+bufLast -= howMany;
+}
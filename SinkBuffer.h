@@ -0,0 +1,94 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This writes decrypted data in to memory
+// that the app set up ahead of time.  The
+// app reads from the front of it and then
+// calls consumed() to make room.  If it
+// gets full, TlsMainCl stops reading from
+// the network until there is room for
+// another record.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "AppSink.h"
+
+
+
+class SinkBuffer: public AppSink
+  {
+  private:
+  bool testForCopy = false;
+  Uint8* buffer = nullptr;
+  Int64 bufSize = 0;
+  Int64 bufLast = 0;
+
+  public:
+  SinkBuffer( void )
+    {
+    }
+
+  SinkBuffer( const SinkBuffer& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "SinkBuffer copy constructor.";
+    }
+
+  ~SinkBuffer( void ) override
+    {
+    }
+
+  void setBuffer( Uint8* setTo,
+                  const Int64 setSize )
+    {
+    // The app still owns this memory.
+    buffer = setTo;
+    bufSize = setSize;
+    bufLast = 0;
+    }
+
+  const Uint8* getBuffer( void ) const
+    {
+    return buffer;
+    }
+
+  Int64 getHowMany( void ) const
+    {
+    return bufLast;
+    }
+
+  void consumed( const Int64 howMany );
+
+  bool write( const CharBuf& plainBuf ) override;
+
+  Int64 getRoom( void ) override
+    {
+    return bufSize - bufLast;
+    }
+
+  bool flush( void ) override
+    {
+    return true;
+    }
+
+  };
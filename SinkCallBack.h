@@ -0,0 +1,87 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This hands each decrypted record to a
+// function.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "AppSink.h"
+
+
+
+// Return false to shut the connection down.
+typedef bool (*SinkFunction)(
+                       const CharBuf& plainBuf,
+                       void* context );
+
+
+
+class SinkCallBack: public AppSink
+  {
+  private:
+  bool testForCopy = false;
+  SinkFunction function = nullptr;
+  void* context = nullptr;
+
+  public:
+  SinkCallBack( void )
+    {
+    }
+
+  SinkCallBack( const SinkCallBack& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "SinkCallBack copy constructor.";
+    }
+
+  ~SinkCallBack( void ) override
+    {
+    }
+
+  void setFunction( SinkFunction setTo,
+                    void* setContext )
+    {
+    function = setTo;
+    context = setContext;
+    }
+
+  bool write( const CharBuf& plainBuf ) override
+    {
+    if( function == nullptr )
+      return false;
+
+    return function( plainBuf, context );
+    }
+
+  Int64 getRoom( void ) override
+    {
+    return 0x7FFFFFFFFFFFFFFFLL;
+    }
+
+  bool flush( void ) override
+    {
+    return true;
+    }
+
+  };
@@ -0,0 +1,143 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "SinkFd.h"
+#include "LogCl.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+
+
+SinkFd::SinkFd( void )
+{
+void* alignedPoint = nullptr;
+if( ::posix_memalign( &alignedPoint, BlockSize,
+                      BatchSize ) != 0 )
+  throw "SinkFd could not get the buffer.";
+
+batchBuf = static_cast<Uint8*>( alignedPoint );
+}
+
+
+SinkFd::SinkFd( const SinkFd& in )
+{
+if( in.testForCopy )
+  return;
+
+throw "SinkFd copy constructor.";
+}
+
+
+SinkFd::~SinkFd( void )
+{
+::free( batchBuf );
+}
+
+
+
+bool SinkFd::writeOut( const Int32 howMany )
+{
+// This writes the first howMany bytes of
+// the batch and moves the rest down.
+
+if( fileHandle < 0 )
+  return false;
+
+Int32 where = 0;
+while( where < howMany )
+  {
+  ssize_t result = ::write( fileHandle,
+                     batchBuf + where,
+                     static_cast<size_t>(
+                             howMany - where ));
+  if( result < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    LogCl::error( "SinkFd write error:",
+                  errno );
+    return false;
+    }
+
+  where += static_cast<Int32>( result );
+  }
+
+written += howMany;
+
+const Int32 rest = batchLast - howMany;
+if( rest > 0 )
+  ::memmove( batchBuf, batchBuf + howMany,
+             static_cast<size_t>( rest ));
+
+batchLast = rest;
+return true;
+}
+
+
+
+bool SinkFd::write( const CharBuf& plainBuf )
+{
+const Int32 last = plainBuf.getLast();
+for( Int32 count = 0; count < last; count++ )
+  {
+  if( batchLast >= BatchSize )
+    {
+    if( !writeOut( BatchSize ))
+      return false;
+
+    }
+
+  batchBuf[batchLast] = plainBuf.getU8( count );
+  batchLast++;
+  }
+
+return true;
+}
+
+
+
+Int64 SinkFd::getRoom( void )
+{
+// It writes out when the batch is full, so
+// there is always room.
+return 0x7FFFFFFFFFFFFFFFLL;
+}
+
+
+
+bool SinkFd::flush( void )
+{
+if( batchLast == 0 )
+  return true;
+
+// Write the whole blocks first so the
+// writes stay aligned, then the tail.
+
+const Int32 whole = (batchLast / BlockSize) *
+                                   BlockSize;
+if( whole > 0 )
+  {
+  if( !writeOut( whole ))
+    return false;
+
+  }
+
+return writeOut( batchLast );
+}
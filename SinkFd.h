@@ -0,0 +1,69 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This writes the decrypted data to a file
+// handle.  It collects records in a page
+// aligned buffer and writes it out in whole
+// blocks, so the disk gets big aligned
+// writes instead of one write per record.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "AppSink.h"
+
+
+
+class SinkFd: public AppSink
+  {
+  private:
+  bool testForCopy = false;
+  Int32 fileHandle = -1;
+  Uint8* batchBuf = nullptr;
+  Int32 batchLast = 0;
+  Int64 written = 0;
+
+  static const Int32 BlockSize = 4096;
+
+  // One megabyte.
+  static const Int32 BatchSize = 1024 * 1024;
+
+  bool writeOut( const Int32 howMany );
+
+  public:
+  SinkFd( void );
+  SinkFd( const SinkFd& in );
+  ~SinkFd( void );
+
+  void setHandle( const Int32 fd )
+    {
+    fileHandle = fd;
+    }
+
+  Int64 getWritten( void ) const
+    {
+    return written;
+    }
+
+  bool write( const CharBuf& plainBuf ) override;
+  Int64 getRoom( void ) override;
+  bool flush( void ) override;
+
+  };
@@ -0,0 +1,425 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "SrvStandIn.h"
+#include "Rfc8448Vec.h"
+#include "../Network/TlsOuterRec.h"
+#include "../CppBase/StIO.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+
+
+bool SrvStandIn::start( const Int64 download,
+                        const Int64 upload )
+{
+downloadBytes = download;
+uploadBytes = upload;
+
+listenSock = ::socket( AF_INET, SOCK_STREAM, 0 );
+if( listenSock < 0 )
+  return false;
+
+Int32 on = 1;
+::setsockopt( listenSock, SOL_SOCKET,
+              SO_REUSEADDR, &on, sizeof( on ));
+
+sockaddr_in addr;
+::memset( &addr, 0, sizeof( addr ));
+addr.sin_family = AF_INET;
+addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+addr.sin_port = 0; // Any free port.
+
+if( ::bind( listenSock,
+            reinterpret_cast<sockaddr*>( &addr ),
+            sizeof( addr )) != 0 )
+  {
+  ::close( listenSock );
+  listenSock = -1;
+  return false;
+  }
+
+socklen_t addrLen = sizeof( addr );
+::getsockname( listenSock,
+               reinterpret_cast<sockaddr*>( &addr ),
+               &addrLen );
+
+port = ntohs( addr.sin_port );
+
+// So a client with TCP Fast Open on can be
+// measured.  It only does anything if the
+// sysctl has the server bit on.
+Int32 fastOpenQueue = 16;
+::setsockopt( listenSock, IPPROTO_TCP,
+              TCP_FASTOPEN, &fastOpenQueue,
+              sizeof( fastOpenQueue ));
+
+if( ::listen( listenSock, 128 ) != 0 )
+  {
+  ::close( listenSock );
+  listenSock = -1;
+  return false;
+  }
+
+stopping.store( false );
+srvThread = std::thread( &SrvStandIn::serveLoop,
+                         this );
+return true;
+}
+
+
+
+void SrvStandIn::stop( void )
+{
+if( listenSock < 0 )
+  return;
+
+stopping.store( true );
+
+// This makes accept() return.
+::shutdown( listenSock, SHUT_RDWR );
+
+if( srvThread.joinable())
+  srvThread.join();
+
+::close( listenSock );
+listenSock = -1;
+}
+
+
+
+void SrvStandIn::serveLoop( void )
+{
+// One connection at a time is enough for
+// measuring one client.
+
+while( !stopping.load())
+  {
+  Int32 sock = ::accept( listenSock, nullptr,
+                                     nullptr );
+  if( sock < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    return;
+    }
+
+  Int32 noDelay = 1;
+  ::setsockopt( sock, IPPROTO_TCP, TCP_NODELAY,
+                &noDelay, sizeof( noDelay ));
+
+  connections.fetch_add( 1 );
+  serveOne( sock );
+  ::close( sock );
+  }
+}
+
+
+
+bool SrvStandIn::readFull( const Int32 sock,
+                           Uint8* buf,
+                           const Int32 len )
+{
+Int32 where = 0;
+while( where < len )
+  {
+  ssize_t howMany = ::recv( sock, buf + where,
+                 static_cast<size_t>( len - where ),
+                 0 );
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    return false;
+    }
+
+  if( howMany == 0 )
+    return false;
+
+  where += static_cast<Int32>( howMany );
+  }
+
+return true;
+}
+
+
+
+bool SrvStandIn::writeFull( const Int32 sock,
+                            const Uint8* buf,
+                            const Int32 len )
+{
+Int32 where = 0;
+while( where < len )
+  {
+  ssize_t howMany = ::send( sock, buf + where,
+                 static_cast<size_t>( len - where ),
+                 MSG_NOSIGNAL );
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    return false;
+    }
+
+  where += static_cast<Int32>( howMany );
+  }
+
+return true;
+}
+
+
+
+bool SrvStandIn::writeCharBuf( const Int32 sock,
+                               const CharBuf& buf )
+{
+const Int32 last = buf.getLast();
+Uint8* bytes = new Uint8[last + 1];
+for( Int32 count = 0; count < last; count++ )
+  bytes[count] = buf.getU8( count );
+
+bool result = writeFull( sock, bytes, last );
+delete[] bytes;
+return result;
+}
+
+
+
+Int32 SrvStandIn::readRecord( const Int32 sock,
+                              Uint8* buf,
+                              const Int32 bufSize )
+{
+// Returns the whole record length with the
+// header, or -1.
+
+if( !readFull( sock, buf, 5 ))
+  return -1;
+
+Int32 length = buf[3];
+length <<= 8;
+length |= buf[4];
+
+if( (length + 5) > bufSize )
+  return -1;
+
+if( !readFull( sock, buf + 5, length ))
+  return -1;
+
+return length + 5;
+}
+
+
+
+bool SrvStandIn::serveOne( const Int32 sock )
+{
+const Int32 maxRec = (1024 * 16) + 256 + 5;
+Uint8 recBuf[maxRec];
+
+// The ClientHello.
+CharBuf expectBuf;
+Rfc8448Vec::getClHelloRec( expectBuf );
+Int32 recLast = readRecord( sock, recBuf,
+                                  maxRec );
+if( recLast != expectBuf.getLast())
+  return false;
+
+CharBuf flightBuf;
+Rfc8448Vec::getSrvHelloRec( flightBuf );
+CharBuf hsRecBuf;
+Rfc8448Vec::getSrvHsRec( hsRecBuf );
+flightBuf.appendCharBuf( hsRecBuf );
+
+if( !writeCharBuf( sock, flightBuf ))
+  return false;
+
+// The client Finished has to be exactly
+// what RFC 8448 has.
+Rfc8448Vec::getClFinishedRec( expectBuf );
+recLast = readRecord( sock, recBuf, maxRec );
+if( recLast != expectBuf.getLast())
+  {
+  badFinished.fetch_add( 1 );
+  return false;
+  }
+
+for( Int32 count = 0; count < recLast; count++ )
+  {
+  if( recBuf[count] != expectBuf.getU8( count ))
+    {
+    badFinished.fetch_add( 1 );
+    return false;
+    }
+  }
+
+CharBuf ticketBuf;
+Rfc8448Vec::getSrvTicketRec( ticketBuf );
+if( !writeCharBuf( sock, ticketBuf ))
+  return false;
+
+if( !sendDownload( sock ))
+  return false;
+
+return readUpload( sock );
+}
+
+
+
+bool SrvStandIn::sendDownload( const Int32 sock )
+{
+if( downloadBytes <= 0 )
+  return true;
+
+CharBuf key;
+CharBuf iv;
+Rfc8448Vec::getSrvAppKey( key, iv );
+
+Uint8 keyBytes[AesGcm::KeySize];
+Uint8 ivBytes[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  keyBytes[count] = key.getU8( count );
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  ivBytes[count] = iv.getU8( count );
+
+AesGcm aesGcm;
+aesGcm.setKey( keyBytes, ivBytes );
+
+// A full size record is 2^14 bytes of
+// data plus the one byte content type.
+const Int32 fragLength = 1024 * 16;
+Uint8 plain[fragLength + 1];
+Uint8 record[5 + fragLength + 1 +
+                          AesGcm::TagSize];
+
+for( Int32 count = 0; count < fragLength;
+                                     count++ )
+  plain[count] = static_cast<Uint8>( count );
+
+// The NewSessionTicket used sequence
+// number zero.
+Uint64 seqNum = 1;
+Int64 sent = 0;
+while( sent < downloadBytes )
+  {
+  Int32 dataLast = fragLength;
+  if( (downloadBytes - sent) < dataLast )
+    dataLast = static_cast<Int32>(
+                     downloadBytes - sent );
+
+  plain[dataLast] = TlsOuterRec::ApplicationData;
+
+  const Int32 cipherLast = dataLast + 1 +
+                            AesGcm::TagSize;
+  record[0] = TlsOuterRec::ApplicationData;
+  record[1] = 3;
+  record[2] = 3;
+  record[3] = static_cast<Uint8>(
+                              cipherLast >> 8 );
+  record[4] = static_cast<Uint8>( cipherLast );
+
+  aesGcm.seal( seqNum, record, 5, plain,
+               dataLast + 1, record + 5 );
+
+  // Put the counting bytes back where the
+  // content type was.
+  plain[dataLast] = static_cast<Uint8>(
+                                   dataLast );
+
+  if( !writeFull( sock, record, 5 + cipherLast ))
+    return false;
+
+  seqNum++;
+  sent += dataLast;
+  }
+
+return true;
+}
+
+
+
+bool SrvStandIn::readUpload( const Int32 sock )
+{
+if( uploadBytes <= 0 )
+  return true;
+
+CharBuf key;
+CharBuf iv;
+Rfc8448Vec::getClAppKey( key, iv );
+
+Uint8 keyBytes[AesGcm::KeySize];
+Uint8 ivBytes[AesGcm::IVSize];
+for( Int32 count = 0; count < AesGcm::KeySize;
+                                     count++ )
+  keyBytes[count] = key.getU8( count );
+
+for( Int32 count = 0; count < AesGcm::IVSize;
+                                     count++ )
+  ivBytes[count] = iv.getU8( count );
+
+AesGcm aesGcm;
+aesGcm.setKey( keyBytes, ivBytes );
+
+const Int32 maxRec = (1024 * 16) + 256 + 5;
+Uint8 recBuf[maxRec];
+Uint8 plain[maxRec];
+
+Uint64 seqNum = 0;
+Int64 got = 0;
+while( got < uploadBytes )
+  {
+  Int32 recLast = readRecord( sock, recBuf,
+                                    maxRec );
+  if( recLast < (5 + AesGcm::TagSize + 1))
+    return false;
+
+  if( !aesGcm.open( seqNum, recBuf, 5,
+                    recBuf + 5, recLast - 5,
+                    plain ))
+    {
+    StIO::putS(
+        "SrvStandIn upload did not decrypt." );
+    return false;
+    }
+
+  seqNum++;
+
+  // Take off the padding and the content
+  // type.
+  Int32 plainLast = recLast - 5 -
+                             AesGcm::TagSize;
+  while( (plainLast > 0) &&
+         (plain[plainLast - 1] == 0))
+    plainLast--;
+
+  if( plainLast > 0 )
+    plainLast--;
+
+  got += plainLast;
+  }
+
+return true;
+}
@@ -0,0 +1,118 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A TLS 1.3 server stand-in that listens on
+// loopback.  It plays back the server side
+// of the RFC 8448 handshake, so the client
+// has to use startTestVecHandshake() with
+// the RFC 8448 keys.  It checks that the
+// client Finished record is byte for byte
+// what the RFC has.
+
+// After the handshake it can send some
+// amount of application data sealed with
+// the RFC 8448 server application key, and
+// then read some amount from the client.
+// Then it closes the connection.
+
+// This is for measuring the client.  It is
+// not a real server.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "AesGcm.h"
+
+#include <atomic>
+#include <thread>
+
+
+
+class SrvStandIn
+  {
+  private:
+  bool testForCopy = false;
+  Int32 listenSock = -1;
+  Int32 port = 0;
+  Int64 downloadBytes = 0;
+  Int64 uploadBytes = 0;
+  std::thread srvThread;
+  std::atomic<bool> stopping{ false };
+  std::atomic<Int64> connections{ 0 };
+  std::atomic<Int64> badFinished{ 0 };
+
+  void serveLoop( void );
+  bool serveOne( const Int32 sock );
+  bool sendDownload( const Int32 sock );
+  bool readUpload( const Int32 sock );
+
+  static bool readFull( const Int32 sock,
+                        Uint8* buf,
+                        const Int32 len );
+  static bool writeFull( const Int32 sock,
+                         const Uint8* buf,
+                         const Int32 len );
+  static bool writeCharBuf( const Int32 sock,
+                            const CharBuf& buf );
+  static Int32 readRecord( const Int32 sock,
+                           Uint8* buf,
+                           const Int32 bufSize );
+
+  public:
+  SrvStandIn( void )
+    {
+    }
+
+  SrvStandIn( const SrvStandIn& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "SrvStandIn copy constructor.";
+    }
+
+  ~SrvStandIn( void )
+    {
+    stop();
+    }
+
+  // How many bytes of application data to
+  // send and to read on each connection.
+  bool start( const Int64 download,
+              const Int64 upload );
+
+  void stop( void );
+
+  Int32 getPort( void ) const
+    {
+    return port;
+    }
+
+  Int64 getConnections( void ) const
+    {
+    return connections.load();
+    }
+
+  Int64 getBadFinished( void ) const
+    {
+    return badFinished.load();
+    }
+
+  };
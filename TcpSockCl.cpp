@@ -0,0 +1,456 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "TcpSockCl.h"
+#include "LogCl.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+
+#include <mutex>
+
+
+
+static bool tfoSysctl = false;
+static std::once_flag tfoSysctlOnce;
+
+
+
+void TcpSockCl::toCString( const CharBuf& in,
+                           char* out,
+                           const Int32 outSize )
+{
+Int32 last = in.getLast();
+if( last >= outSize )
+  throw "TcpSockCl toCString is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  out[count] = static_cast<char>(
+                             in.getU8( count ));
+
+out[last] = 0;
+}
+
+
+
+bool TcpSockCl::tfoSysctlOn( void )
+{
+std::call_once( tfoSysctlOnce, readTfoSysctl );
+return tfoSysctl;
+}
+
+
+
+void TcpSockCl::readTfoSysctl( void )
+{
+// Bit 1 is for the client side.
+
+Int32 fd = ::open(
+            "/proc/sys/net/ipv4/tcp_fastopen",
+            O_RDONLY );
+
+if( fd < 0 )
+  return;
+
+char buf[16] = { 0 };
+ssize_t howMany = ::read( fd, buf,
+                          sizeof( buf ) - 1 );
+::close( fd );
+
+if( howMany <= 0 )
+  return;
+
+Int32 value = 0;
+for( Int32 count = 0; count < howMany;
+                                   count++ )
+  {
+  if( (buf[count] < '0') || (buf[count] > '9'))
+    break;
+
+  value = (value * 10) + (buf[count] - '0');
+  }
+
+tfoSysctl = (value & 1) != 0;
+}
+
+
+
+bool TcpSockCl::connectOne( const TcpAddr& addr )
+{
+sock = ::socket( addr.family,
+                 addr.sockType,
+                 addr.protocol );
+
+if( sock < 0 )
+  return false;
+
+Int32 noDelay = 1;
+::setsockopt( sock, IPPROTO_TCP, TCP_NODELAY,
+              &noDelay, sizeof( noDelay ));
+
+tfoPending = false;
+tfoTried = false;
+tfoUsed = false;
+sentAny = false;
+
+// If the sysctl has it off the option would
+// be taken but do nothing, and the counts
+// would say it was tried when it wasn't.
+bool useTfo = fastOpen;
+if( useTfo && !tfoSysctlOn())
+  {
+  LogCl::debug( "TCP Fast Open is off in the sysctl." );
+  useTfo = false;
+  }
+
+if( useTfo )
+  {
+  // With this option connect() returns
+  // right away if there is a cookie, and the
+  // first send() goes out with the SYN.
+  // If the kernel doesn't have this option
+  // then it is just a normal connect.
+
+  Int32 on = 1;
+  if( ::setsockopt( sock, IPPROTO_TCP,
+                    TCP_FASTOPEN_CONNECT,
+                    &on, sizeof( on )) == 0 )
+    {
+    tfoPending = true;
+    tfoTried = true;
+    }
+  else
+    {
+    LogCl::warn(
+        "TCP_FASTOPEN_CONNECT not available." );
+    }
+  }
+
+if( nonBlocking )
+  {
+  Int32 flags = ::fcntl( sock, F_GETFL, 0 );
+  if( (flags < 0) || (::fcntl( sock, F_SETFL,
+                     flags | O_NONBLOCK ) != 0))
+    {
+    ::close( sock );
+    sock = -1;
+    tfoPending = false;
+    tfoTried = false;
+    return false;
+    }
+  }
+
+if( ::connect( sock, reinterpret_cast<
+                  const sockaddr*>( addr.bytes ),
+                  addr.length ) != 0 )
+  {
+  // If it is still connecting then send()
+  // and recv() say EAGAIN until it is done.
+  // If it fails they say why.
+  if( nonBlocking && (errno == EINPROGRESS))
+    return true;
+
+  ::close( sock );
+  sock = -1;
+  tfoPending = false;
+  tfoTried = false;
+  return false;
+  }
+
+return true;
+}
+
+
+
+bool TcpSockCl::connect( const CharBuf& urlDomain,
+                         const CharBuf& port )
+{
+closeSock();
+
+char hostName[1024];
+char portName[32];
+toCString( urlDomain, hostName,
+                      sizeof( hostName ));
+toCString( port, portName, sizeof( portName ));
+
+addrinfo hints = {};
+hints.ai_family = AF_UNSPEC;
+hints.ai_socktype = SOCK_STREAM;
+hints.ai_protocol = IPPROTO_TCP;
+
+// This blocks, even for a non-blocking
+// socket.
+addrinfo* addrList = nullptr;
+if( ::getaddrinfo( hostName, portName,
+                   &hints, &addrList ) != 0 )
+  {
+  LogCl::error( "TcpSockCl getaddrinfo failed." );
+  return false;
+  }
+
+for( addrinfo* addr = addrList;
+               addr != nullptr;
+               addr = addr->ai_next )
+  {
+  if( addrLast >= AddrMax )
+    break;
+
+  if( addr->ai_addrlen > TcpAddr::MaxLength )
+    continue;
+
+  TcpAddr& toSet = addrs[addrLast];
+  toSet.family = addr->ai_family;
+  toSet.sockType = addr->ai_socktype;
+  toSet.protocol = addr->ai_protocol;
+  toSet.length = addr->ai_addrlen;
+  ::memcpy( toSet.bytes, addr->ai_addr,
+            addr->ai_addrlen );
+  addrLast++;
+  }
+
+::freeaddrinfo( addrList );
+
+return connectFrom( 0 );
+}
+
+
+
+bool TcpSockCl::connectFrom( const Int32 start )
+{
+for( Int32 count = start; count < addrLast;
+                                      count++ )
+  {
+  if( connectOne( addrs[count] ))
+    {
+    addrNext = count + 1;
+    connected = true;
+    return true;
+    }
+  }
+
+addrNext = addrLast;
+LogCl::error( "TcpSockCl could not connect." );
+return false;
+}
+
+
+
+bool TcpSockCl::isConnectFail( const Int32 err )
+{
+// What send() and recv() say when a
+// non-blocking connect didn't work.
+return (err == ECONNREFUSED) ||
+       (err == ETIMEDOUT) ||
+       (err == EHOSTUNREACH) ||
+       (err == ENETUNREACH);
+}
+
+
+
+bool TcpSockCl::connectNext( const Int32 err )
+{
+// Nothing went out on this socket, so the
+// caller still has all of it and it can
+// start over on the next address.
+
+LogCl::warn(
+     "TcpSockCl connect failed, next address:",
+     err );
+
+::close( sock );
+sock = -1;
+connected = false;
+tfoPending = false;
+
+return connectFrom( addrNext );
+}
+
+
+
+void TcpSockCl::checkTfoResult( void )
+{
+// This gets called after the server has
+// sent something back, so the connection
+// is established and the kernel knows if
+// the data in the SYN was acked.
+
+tfoPending = false;
+
+tcp_info info = {};
+socklen_t infoLen = sizeof( info );
+if( ::getsockopt( sock, IPPROTO_TCP, TCP_INFO,
+                  &info, &infoLen ) != 0 )
+  return;
+
+if( (info.tcpi_options & TCPI_OPT_SYN_DATA)
+                                       != 0 )
+  {
+  tfoUsed = true;
+  }
+}
+
+
+
+Int32 TcpSockCl::sendCharBuf(
+                       const CharBuf& sendBuf )
+{
+if( !connected )
+  return -1;
+
+char chunk[ChunkSize];
+
+const Int32 last = sendBuf.getLast();
+Int32 where = 0;
+while( where < last )
+  {
+  Int32 chunkLast = last - where;
+  if( chunkLast > ChunkSize )
+    chunkLast = ChunkSize;
+
+  for( Int32 count = 0; count < chunkLast;
+                                    count++ )
+    chunk[count] = static_cast<char>(
+               sendBuf.getU8( where + count ));
+
+  Int32 chunkWhere = 0;
+  while( chunkWhere < chunkLast )
+    {
+    ssize_t howMany = ::send( sock,
+                        chunk + chunkWhere,
+                        chunkLast - chunkWhere,
+                        MSG_NOSIGNAL );
+
+    if( howMany < 0 )
+      {
+      if( errno == EINTR )
+        continue;
+
+      // The caller keeps the rest.  With
+      // TCP_FASTOPEN_CONNECT and no cookie
+      // yet, the first send only starts the
+      // connect and says EINPROGRESS.  That
+      // is the same as EAGAIN here.
+      if( nonBlocking && ((errno == EAGAIN) ||
+                       (errno == EWOULDBLOCK) ||
+                       (errno == EINPROGRESS)))
+        return where + chunkWhere;
+
+      if( nonBlocking && !sentAny &&
+          isConnectFail( errno ))
+        {
+        // where + chunkWhere is zero.
+        connectNext( errno );
+        return 0;
+        }
+
+      LogCl::error( "TcpSockCl send error:",
+                    errno );
+      connected = false;
+      return where + chunkWhere;
+      }
+
+    if( howMany > 0 )
+      sentAny = true;
+
+    chunkWhere += static_cast<Int32>( howMany );
+    }
+
+  where += chunkLast;
+  }
+
+return where;
+}
+
+
+
+void TcpSockCl::receiveCharBuf( CharBuf& recvBuf )
+{
+if( !connected )
+  return;
+
+char chunk[ChunkSize];
+
+// Get whatever is there now without
+// blocking.
+for( Int32 loops = 0; loops < 64; loops++ )
+  {
+  ssize_t howMany = ::recv( sock, chunk,
+                            ChunkSize,
+                            MSG_DONTWAIT );
+  if( howMany == 0 )
+    {
+    // The server closed it.
+    connected = false;
+    return;
+    }
+
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    if( (errno == EAGAIN) ||
+        (errno == EWOULDBLOCK))
+      return;
+
+    if( nonBlocking && !sentAny &&
+        isConnectFail( errno ))
+      {
+      connectNext( errno );
+      return;
+      }
+
+    LogCl::error( "TcpSockCl recv error:",
+                  errno );
+    connected = false;
+    return;
+    }
+
+  if( tfoPending )
+    checkTfoResult();
+
+  for( Int32 count = 0; count < howMany;
+                                    count++ )
+    recvBuf.appendU8( static_cast<Uint8>(
+                                chunk[count] ));
+
+  if( howMany < ChunkSize )
+    return;
+
+  }
+}
+
+
+
+void TcpSockCl::closeSock( void )
+{
+if( sock >= 0 )
+  ::close( sock );
+
+sock = -1;
+connected = false;
+tfoPending = false;
+sentAny = false;
+addrLast = 0;
+addrNext = 0;
+}
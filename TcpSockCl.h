@@ -0,0 +1,191 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A client TCP socket that this client owns
+// directly, so it can set socket options
+// that NetClient doesn't know about.
+// Like TCP Fast Open.
+
+// With TCP Fast Open the ClientHello rides
+// in the SYN if the kernel has a cookie for
+// that server from an earlier connection.
+// If it has no cookie it does a normal
+// three-way handshake and asks for a cookie
+// for next time.
+
+// To test it over loopback the sysctl has
+// to allow both the client and the server
+// side:
+// sysctl -w net.ipv4.tcp_fastopen=3
+// And the listening socket has to set
+// TCP_FASTOPEN, like SrvStandIn does.
+// LoopBench::setFastOpen() runs it, and
+// with setNonBlocking() too it runs the
+// two together.
+
+// If the sysctl doesn't have the client
+// bit on it connects the normal way.
+// getTfoTried() and getTfoUsed() say what
+// happened for this connection, and
+// TlsMainCl counts them in TrafficStats.
+
+// connect() keeps the addresses that
+// getaddrinfo() gave it.  A blocking
+// connect tries them in order.  A
+// non-blocking connect starts on the first
+// one and returns.  If send() or recv()
+// later says that connect failed, and
+// nothing has been sent on it yet, it
+// closes that socket and starts on the next
+// address.  getaddrinfo() itself still
+// blocks, so a non-blocking caller that
+// can't wait for DNS should pass an IP
+// address.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+class TcpAddr
+  {
+  public:
+  Int32 family = 0;
+  Int32 sockType = 0;
+  Int32 protocol = 0;
+  Uint32 length = 0;
+
+  // The size of a sockaddr_storage.
+  static const Int32 MaxLength = 128;
+  Uint8 bytes[MaxLength] = { 0 };
+  };
+
+
+
+class TcpSockCl
+  {
+  private:
+  bool testForCopy = false;
+  Int32 sock = -1;
+  bool connected = false;
+  bool fastOpen = false;
+  bool nonBlocking = false;
+  bool tfoPending = false;
+  bool tfoTried = false;
+  bool tfoUsed = false;
+  bool sentAny = false;
+
+  static const Int32 ChunkSize = 1024 * 16;
+
+  static const Int32 AddrMax = 8;
+  TcpAddr addrs[AddrMax];
+  Int32 addrLast = 0;
+  Int32 addrNext = 0;
+
+  static void toCString( const CharBuf& in,
+                         char* out,
+                         const Int32 outSize );
+
+  static void readTfoSysctl( void );
+  static bool isConnectFail( const Int32 err );
+  bool connectOne( const TcpAddr& addr );
+  bool connectFrom( const Int32 start );
+  bool connectNext( const Int32 err );
+  void checkTfoResult( void );
+
+  public:
+  TcpSockCl( void )
+    {
+    }
+
+  TcpSockCl( const TcpSockCl& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TcpSockCl copy constructor.";
+    }
+
+  ~TcpSockCl( void )
+    {
+    closeSock();
+    }
+
+  void setFastOpen( const bool setTo )
+    {
+    fastOpen = setTo;
+    }
+
+  bool getFastOpen( void ) const
+    {
+    return fastOpen;
+    }
+
+  // With this set, connect() doesn't wait
+  // for the connection, and sendCharBuf()
+  // returns what it sent so far when the
+  // kernel won't take any more.
+  void setNonBlocking( const bool setTo )
+    {
+    nonBlocking = setTo;
+    }
+
+  bool getNonBlocking( void ) const
+    {
+    return nonBlocking;
+    }
+
+  bool connect( const CharBuf& urlDomain,
+                const CharBuf& port );
+
+  Int32 sendCharBuf( const CharBuf& sendBuf );
+  void receiveCharBuf( CharBuf& recvBuf );
+
+  bool isConnected( void ) const
+    {
+    return connected;
+    }
+
+  Int32 getSock( void ) const
+    {
+    return sock;
+    }
+
+  void closeSock( void );
+
+  // If the SYN for this connection was sent
+  // with TCP_FASTOPEN_CONNECT.
+  bool getTfoTried( void ) const
+    {
+    return tfoTried;
+    }
+
+  // If the server took the data in the SYN.
+  // It is known after the first recv().
+  bool getTfoUsed( void ) const
+    {
+    return tfoUsed;
+    }
+
+  // If the sysctl has the client bit on.
+  // It is read once for the process.
+  static bool tfoSysctlOn( void );
+
+  };
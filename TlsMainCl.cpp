@@ -15,31 +15,394 @@
 
 #include "TlsMainCl.h"
 #include "../CppBase/StIO.h"
+#include "LogCl.h"
+#include "CurveCtx.h"
+
+#include <string.h>
+
+
+
+static void wipeKeyBuf( CharBuf& keyBuf )
+{
+// clear() only sets the length to zero, so
+// the key bytes are written over first.
+
+const Int32 last = keyBuf.getLast();
+for( Int32 count = 0; count < last; count++ )
+  keyBuf.setU8( count, 0 );
+
+keyBuf.clear();
+}
+
+
+
+void TlsMainCl::setFastOpen( const bool setTo )
+{
+// TCP Fast Open needs a socket option that
+// NetClient doesn't set, so it uses its
+// own socket for this.
+
+sockTrans.setFastOpen( setTo );
+if( setTo )
+  transport = &sockTrans;
+
+}
+
+
+
+void TlsMainCl::setNonBlocking( const bool setTo )
+{
+sockTrans.setNonBlocking( setTo );
+if( setTo )
+  transport = &sockTrans;
+
+}
+
+
+
+void TlsMainCl::setTransport( Transport* setTo )
+{
+if( setTo == nullptr )
+  transport = &netTrans;
+else
+  transport = setTo;
+
+}
+
+
+
+void TlsMainCl::setKernelTls( const bool setTo )
+{
+// Kernel TLS needs the socket handle, so
+// this uses TcpSockCl too.
+
+kTlsWanted = setTo;
+if( setTo )
+  transport = &sockTrans;
+
+}
+
+
+
+void TlsMainCl::reset( void )
+{
+// The sockets get closed and the threads
+// stop, but the big buffers stay.
+
+// NetClient can only be closed by making
+// it over again, so a session that was
+// reset uses TcpSockCl, which closes in
+// place.  Blocking, with no Fast Open, it
+// is the same as NetClient.
+netTrans.reset();
+sockTrans.reset();
+memTrans.reset();
+transport = &sockTrans;
+
+while( !circBufIn.isEmpty())
+  circBufIn.getU8();
+
+recordBytes.clear();
+outgoingBuf.clear();
+tlsOuterRead.clear();
+handshakeCl.reset();
+
+// TlsMain and EncryptTls are in ../Network
+// and have no clear(), but they are kept.
+// What the client puts in TlsMain, the
+// server name, the randoms and the last
+// messages, is set again on each handshake.
+// EncryptTls only has the public key share
+// now, and makeKeyShare() sets that again.
+// No secret is in either one.
+
+clWrite.clear();
+srvRead.clear();
+appKeysSet = false;
+kernelTls.clear();
+kTlsWanted = false;
+hsKeysSet = false;
+recBoundary = true;
+appRecsIn = 0;
+appRecsOut = 0;
+
+fileSend.reset();
+uploadPlain.clear();
+uploadPending.clear();
+appSink = nullptr;
+decryptPool.stop();
+decryptThreads = 0;
+
+hsTiming.clear();
+trafficStats.retire();
+capture = nullptr;
+}
+
+
+
+void TlsMainCl::tryKernelTx( void )
+{
+// This gets called after outgoingBuf was
+// sent, so the client Finished message
+// has already gone out with the handshake
+// keys.
+
+if( !kTlsWanted )
+  return;
+
+if( kernelTls.getTxOn())
+  return;
+
+if( !appKeysSet )
+  return;
+
+// Anything the transport still has was
+// sealed here, so it has to go out before
+// the kernel seals anything.
+if( transport->getPendingOut() > 0 )
+  return;
+
+CharBuf key;
+CharBuf iv;
+handshakeCl.keySched.getClAppKey( key, iv );
+
+const bool txOn = kernelTls.installTx(
+                       transport->getSock(),
+                       key, iv, appRecsOut );
+wipeKeyBuf( key );
+wipeKeyBuf( iv );
+
+if( !txOn )
+  {
+  // Don't keep trying it.
+  kTlsWanted = false;
+  return;
+  }
+
+LogCl::info( "Kernel TLS send is on." );
+}
+
+
+
+void TlsMainCl::tryKernelRx( void )
+{
+if( !kTlsWanted )
+  return;
+
+if( kernelTls.getRxOn())
+  return;
+
+if( decryptPool.isStarted())
+  return;
+
+if( !appKeysSet )
+  return;
+
+// If there are bytes from the socket that
+// are already in user space, then those
+// records have to be decrypted here first.
+// The kernel starts at the next record.
+
+if( !circBufIn.isEmpty())
+  return;
+
+if( !recBoundary )
+  return;
+
+CharBuf key;
+CharBuf iv;
+handshakeCl.keySched.getSrvAppKey( key, iv );
+
+const bool rxOn = kernelTls.installRx(
+                       transport->getSock(),
+                       key, iv, appRecsIn );
+wipeKeyBuf( key );
+wipeKeyBuf( iv );
+
+if( !rxOn )
+  {
+  kTlsWanted = false;
+  return;
+  }
+
+LogCl::info( "Kernel TLS receive is on." );
+}
+
+
+
+Int32 TlsMainCl::processKernelIn(
+                          CircleBuf& appInBuf )
+{
+// The kernel took off the outer record,
+// decrypted it, and took off the padding
+// and the inner content type.
+
+CharBuf plainBuf;
+Uint8 recType = 0;
+Int32 howMany = kernelTls.recvRec(
+                          transport->getSock(),
+                          plainBuf, recType );
+
+if( howMany == -2 )
+  {
+  trafficStats.add( TrafficSnap::DecryptFails, 1 );
+  sendAlert( Alerts::BadRecordMac );
+  return -1;
+  }
+
+if( howMany < 0 )
+  {
+  flushSink();
+  return -1;
+  }
+
+if( howMany == 0 )
+  return 1;
+
+// The kernel reads the socket, so this
+// counts the plain text bytes.
+trafficStats.add( TrafficSnap::RecordsIn, 1 );
+trafficStats.add( TrafficSnap::BytesIn,
+                  static_cast<Uint64>( howMany ));
+
+if( recType == TlsOuterRec::ApplicationData )
+  return deliverAppData( plainBuf, appInBuf );
+
+if( recType == TlsOuterRec::Handshake )
+  {
+  // Post handshake messages like
+  // NewSessionTicket.
+  return processHandshake( plainBuf );
+  }
+
+if( recType == TlsOuterRec::Alert )
+  {
+  LogCl::warn( "Got an Alert." );
+  if( howMany == 2 )
+    {
+    trafficStats.alertIn( plainBuf.getU8( 1 ));
+    Alerts::showAlert( plainBuf.getU8( 1 ));
+    }
+
+  if( !isHandshakeDone())
+    trafficStats.setHsOutcome( false );
+
+  flushSink();
+  return -1; // Shut it down.
+  }
+
+sendAlert( Alerts::UnexpectedMessage );
+return -1;
+}
+
+
+
+bool TlsMainCl::netConnect(
+                        const CharBuf& urlDomain,
+                        const CharBuf& port )
+{
+if( !transport->connect( urlDomain, port ))
+  return false;
+
+if( (transport == &sockTrans) &&
+    sockTrans.getTfoTried())
+  trafficStats.add( TrafficSnap::TfoAttempts, 1 );
+
+return true;
+}
+
+
+
+Int32 TlsMainCl::netSend( const CharBuf& sendBuf )
+{
+if( capture != nullptr )
+  capture->addEntry( RecCapture::TypeOut,
+                     sendBuf );
+
+Int32 howMany = transport->sendCharBuf( sendBuf );
+
+if( howMany > 0 )
+  trafficStats.add( TrafficSnap::BytesOut,
+                    static_cast<Uint64>( howMany ));
+
+return howMany;
+}
+
+
+
+void TlsMainCl::netReceive( CharBuf& recvBuf )
+{
+transport->receiveCharBuf( recvBuf );
+
+if( capture != nullptr )
+  capture->addEntry( RecCapture::TypeIn,
+                     recvBuf );
+
+trafficStats.add( TrafficSnap::BytesIn,
+       static_cast<Uint64>( recvBuf.getLast()));
+}
+
+
+
+bool TlsMainCl::netIsConnected( void )
+{
+return transport->isConnected();
+}
 
 
 
 Int32 TlsMainCl::processOutgoing(
                          CircleBuf& appOutBuf )
 {
+// A non-blocking transport might still
+// have some from last time.
+if( !transport->flushOut())
+  {
+  LogCl::error( "TlsMainCl transport is closed." );
+  return -1;
+  }
+
 CharBuf sendOutBuf;
 copyOutBuf( sendOutBuf );
 Int32 outLast = sendOutBuf.getLast();
 Int32 howMany = 0;
 if( outLast > 0 )
   {
-  howMany = netClient.sendCharBuf( sendOutBuf );
+  howMany = netSend( sendOutBuf );
   }
 
 if( howMany < outLast )
   {
-  StIO::putS(
+  LogCl::error(
           "TlsMainCl could not write all data." );
   // Then do what about this?
   // Use a CircleBuf to write it?
   return -1;
   }
 
-if( encryptTls.getAppKeysSet())
+if( (outLast > 0) && appKeysSet )
+  {
+  // That was the client Finished.
+  hsTiming.mark( HsTiming::ClFinishedSent );
+  hsTiming.finish();
+  trafficStats.setHsOutcome( true );
+
+  // The server has answered by now, so the
+  // socket knows if the SYN data was taken.
+  if( (transport == &sockTrans) &&
+      sockTrans.getTfoUsed())
+    trafficStats.add( TrafficSnap::TfoSuccesses,
+                      1 );
+  }
+
+tryKernelTx();
+
+// Backpressure.  Don't seal any more records
+// until the transport sent the ones it has.
+if( transport->getPendingOut() > 0 )
+  return 1;
+
+if( appKeysSet )
   {
   CharBuf plainBuf;
   const Int32 last =
@@ -53,44 +416,216 @@ if( encryptTls.getAppKeysSet())
     plainBuf.appendU8( appOutBuf.getU8());
     }
 
+  if( kernelTls.getTxOn())
+    {
+    // The kernel makes the record.
+    if( plainBuf.getLast() > 0 )
+      {
+      if( kernelTls.sendRec( transport->getSock(),
+                plainBuf,
+                TlsOuterRec::ApplicationData ) < 0 )
+        return -1;
+
+      trafficStats.add( TrafficSnap::RecordsOut, 1 );
+      trafficStats.add( TrafficSnap::BytesOut,
+           static_cast<Uint64>( plainBuf.getLast()));
+
+      }
+
+    return processUpload();
+    }
+
+  // Nothing to send is not an empty record.
   CharBuf outerRecBuf;
-  encryptTls.clWriteMakeOuterRec( plainBuf,
-              outerRecBuf,
-              TlsOuterRec::ApplicationData );
+  if( plainBuf.getLast() > 0 )
+    clWrite.seal( plainBuf,
+                  TlsOuterRec::ApplicationData,
+                  outerRecBuf );
 
   outLast = outerRecBuf.getLast();
   if( outLast > 0 )
     {
-    StIO::putS( "Sending app data." );
+    appRecsOut++;
+    trafficStats.add( TrafficSnap::RecordsOut, 1 );
+    LogCl::trace( "Sending app data." );
     // outerRecBuf.showHex();
     // plainBuf.showAscii();
     // StIO::putLF();
 
-    howMany = netClient.sendCharBuf(
-                            outerRecBuf );
+    howMany = netSend( outerRecBuf );
     }
 
   if( howMany < outLast )
     {
-    StIO::putS(
+    LogCl::error(
         "TlsMainCl could not write all data." );
     // Then do what about this?
     // Use a CircleBuf to write it?
     return -1;
     }
 
+  return processUpload();
+  }
+
+return 1;
+}
+
+
+
+bool TlsMainCl::startFileUpload(
+                      const CharBuf& fileName )
+{
+uploadPending.clear();
+return fileSend.openPath( fileName );
+}
+
+
+
+bool TlsMainCl::startFileUploadFd(
+                             const Int32 fd )
+{
+uploadPending.clear();
+return fileSend.openHandle( fd );
+}
+
+
+
+void TlsMainCl::setUploadProgress(
+                     UploadProgress callBack,
+                     void* context )
+{
+fileSend.setProgress( callBack, context );
+}
+
+
+
+bool TlsMainCl::sendUploadPending( void )
+{
+const Int32 last = uploadPending.getLast();
+Int32 howMany = netSend( uploadPending );
+if( howMany < 0 )
+  return false;
+
+if( howMany >= last )
+  {
+  uploadPending.clear();
+  return true;
+  }
+
+// Keep what the socket didn't take.
+CharBuf restBuf;
+for( Int32 count = howMany; count < last;
+                                     count++ )
+  restBuf.appendU8( uploadPending.getU8( count ));
+
+uploadPending.copy( restBuf );
+return true;
+}
+
+
+
+Int32 TlsMainCl::processUpload( void )
+{
+// The file data goes from the memory
+// mapped file straight in to full size
+// records.  It doesn't go through appOutBuf.
+
+if( !fileSend.isActive())
+  return 1;
+
+// Backpressure.  It doesn't seal any more
+// records until the socket took all of
+// the last ones.
+
+if( uploadPending.getLast() > 0 )
+  {
+  if( !sendUploadPending())
+    return -1;
+
+  if( uploadPending.getLast() > 0 )
+    return 1;
+
+  }
+
+const Int32 recLength =
+            tlsMain.getMaxFragLength() - 1024;
+
+if( kernelTls.getTxOn())
+  {
+  if( fileSend.sendFileTo( transport->getSock(),
+          recLength * UploadRecsPerCall ) < 0 )
+    return -1;
+
+  }
+else
+  {
+  for( Int32 count = 0;
+             count < UploadRecsPerCall; count++ )
+    {
+    if( fileSend.isDone())
+      break;
+
+    uploadPlain.clear();
+    if( fileSend.getChunk( uploadPlain,
+                           recLength ) <= 0 )
+      {
+      // Without this it would seal empty
+      // records forever, since it never gets
+      // to isDone().
+      LogCl::error(
+            "The upload file could not be read." );
+      fileSend.closeFile();
+      sendAlert( Alerts::InternalError );
+      return -1;
+      }
+
+    // uploadPending is empty here, so the
+    // record is sealed right in to it.
+    clWrite.seal( uploadPlain,
+                  TlsOuterRec::ApplicationData,
+                  uploadPending );
+
+    appRecsOut++;
+    trafficStats.add( TrafficSnap::RecordsOut, 1 );
+
+    if( !sendUploadPending())
+      return -1;
+
+    if( uploadPending.getLast() > 0 )
+      break;
+
+    }
+  }
+
+fileSend.reportProgress();
+
+if( fileSend.isDone() &&
+    (uploadPending.getLast() == 0))
+  {
+  LogCl::info( "File upload is done." );
+  fileSend.closeFile();
   }
 
 return 1;
 }
 
 
+
 Int32 TlsMainCl::processIncoming(
                           CircleBuf& appInBuf )
 {
+// If the sink is full then leave the data
+// in the socket until there is room.
+if( !sinkHasRoom())
+  return 1;
+
+tryKernelRx();
+if( kernelTls.getRxOn())
+  return processKernelIn( appInBuf );
+
 CharBuf recvBuf;
-if( netClient.isConnected())
-  netClient.receiveCharBuf( recvBuf );
+if( netIsConnected())
+  netReceive( recvBuf );
 
 const Int32 recvLast = recvBuf.getLast();
 
@@ -106,6 +641,9 @@ if( recvLast > 0 )
                                       count++ )
     circBufIn.addU8( recvBuf.getU8( count ));
 
+  trafficStats.setHigh( TrafficSnap::CircBufInHigh,
+        static_cast<Uint64>(
+                     circBufIn.getHowMany()));
   }
 
 const Int32 max = circBufIn.getSize();
@@ -118,20 +656,25 @@ for( Int32 count = 0; count < max; count++ )
   Uint32 accumResult = tlsOuterRead.
                            accumByte( aByte );
   if( accumResult == Results::Continue )
+    {
+    recBoundary = false;
     continue; // Get more bytes.
+    }
+
+  recBoundary = true;
 
   if( accumResult < Results::AlertTop )
     {
-    StIO::putS(
+    LogCl::error(
              "tlsOuterRead.accumByte error." );
-    sendPlainAlert( accumResult & 0xFF );
+    sendAlert( accumResult & 0xFF );
     tlsOuterRead.clear();
-    // Cause it to time out with read closed.
-    return 0;
+    return -1;
     }
 
   if( accumResult == Results::Done )
     {
+    trafficStats.add( TrafficSnap::RecordsIn, 1 );
     recordBytes.clear();
     tlsOuterRead.copyBytes( recordBytes );
     Int32 recBytesLast = recordBytes.getLast();
@@ -139,89 +682,373 @@ for( Int32 count = 0; count < max; count++ )
     // StIO::printFD( recBytesLast );
     // StIO::putLF();
 
-    Uint8 recType = tlsOuterRead.getRecordType();
-    tlsOuterRead.clear();
+    Uint8 recType = tlsOuterRead.getRecordType();
+    tlsOuterRead.clear();
+
+    if( recType == TlsOuterRec::Handshake )
+      {
+      return processHandshake( recordBytes );
+      }
+
+    if( recType == TlsOuterRec::ChangeCipherSpec )
+      {
+      LogCl::debug( "Got a ChangeCipherSpec." );
+      LogCl::debug( "Ignoring ChangeCipherSpec." );
+      // Don't do anything.  Just ignore it.
+      return true;
+      }
+
+    if( recType == TlsOuterRec::Alert )
+      {
+      if( recBytesLast != 2 )
+        {
+        sendAlert( Alerts::DecodeError );
+        return -1;
+        }
+
+      // An alert is the outer record alert
+      // record type, then legacy version 3.3,
+      // then length for 2 bytes, and it's
+      // always a length of 2. Then the
+      // level and then description.
+
+      LogCl::warn( "Got an Alert." );
+
+      // Get the second byte:
+      const Uint8 descript = recordBytes.
+                                    getU8( 1 );
+      trafficStats.alertIn( descript );
+      if( !isHandshakeDone())
+        trafficStats.setHsOutcome( false );
+
+      Alerts::showAlert( descript );
+      flushSink();
+      return -1; // Shut it down.
+      }
+
+    if( recType == TlsOuterRec::ApplicationData )
+      {
+      // StIO::putS( "Got ApplicationData." );
+
+      // Int32 appBytesLast =
+      //       recordBytes.getLast();
+      // StIO::printF( "appBytes last: " );
+      // StIO::printFD( appBytesLast );
+      // StIO::putLF();
+
+      // recordBytes is everything except
+      // the 5 starting bytes.
+      // The five bytes are:
+      // 23, 3, 3, recordBytes.getLast()
+
+      if( useDecryptPool())
+        {
+        // The worker threads decrypt it and
+        // drainDecryptPool() puts them back
+        // in order.
+        decryptPool.submit( recordBytes );
+        appRecsIn++;
+        if( !decryptPool.canTake())
+          break;
+
+        continue;
+        }
+
+      // Count the records that used the
+      // application keys so the kernel can
+      // start at the right sequence number.
+      if( appKeysSet )
+        appRecsIn++;
+
+      // If it didn't decrypt then plainBuf
+      // is empty, and processAppData() sends
+      // the alert.
+      CharBuf plainBuf;
+      if( !srvRead.open( recordBytes, plainBuf ))
+        trafficStats.add(
+                  TrafficSnap::DecryptFails, 1 );
+
+      return processAppData( plainBuf,
+                             appInBuf );
+      }
+
+
+    //  RFC 6520
+    if( recType == TlsOuterRec::HeartBeat )
+      {
+      LogCl::debug( "Got a HeartBeat." );
+      return 1;
+      }
+
+    // It didn't find any matching type.
+    sendAlert( Alerts::UnexpectedMessage );
+    return -1;
+    }
+  }
+
+if( decryptPool.isStarted())
+  {
+  Int32 status = drainDecryptPool( appInBuf );
+  if( status <= 0 )
+    return status;
+
+  }
+
+if( circBufIn.isEmpty())
+  {
+  // Do this after processing data in circBuf.
+  if( !netIsConnected())
+    {
+    // Get the rest of them out first.
+    if( decryptPool.hasPending())
+      return 1;
+
+    flushSink();
+    return -1;
+    }
+
+  }
+
+return 1;
+}
+
+
+
+void TlsMainCl::setParallelDecrypt(
+                       const Int32 howManyThreads )
+{
+// This is not used with kernel TLS
+// receive.  Whichever one starts first
+// is the one it uses.
+
+decryptThreads = howManyThreads;
+}
+
+
+
+bool TlsMainCl::useDecryptPool( void )
+{
+if( decryptThreads <= 0 )
+  return false;
+
+if( kernelTls.getRxOn())
+  return false;
+
+if( !appKeysSet )
+  return false;
+
+if( decryptPool.isStarted())
+  return true;
+
+CharBuf key;
+CharBuf iv;
+handshakeCl.keySched.getSrvAppKey( key, iv );
+
+// The first record for the pool has the
+// next sequence number after the ones
+// srvRead already did.
+decryptPool.start( decryptThreads, key, iv,
+                                  appRecsIn );
+
+wipeKeyBuf( key );
+wipeKeyBuf( iv );
+
+LogCl::info( "Parallel decrypt is on." );
+return true;
+}
+
+
+
+Int32 TlsMainCl::drainDecryptPool(
+                          CircleBuf& appInBuf )
+{
+// If the ring is full then wait for the
+// oldest one so it can make progress.
+if( !decryptPool.canTake())
+  decryptPool.waitNext();
+
+for( Int32 count = 0; count < 1000; count++ )
+  {
+  // This points in to the pool's slot,
+  // so it is not copied again.
+  const CharBuf* plainBuf = nullptr;
+  Int32 result = decryptPool.peekNext(
+                                   plainBuf );
+  if( result == 0 )
+    return 1;
+
+  if( result < 0 )
+    {
+    LogCl::error( "A record did not decrypt." );
+    trafficStats.add( TrafficSnap::DecryptFails, 1 );
+    sendAlert( Alerts::BadRecordMac );
+    return -1;
+    }
+
+  Int32 status = processAppData( *plainBuf,
+                                 appInBuf );
+  decryptPool.releaseNext();
+  if( status <= 0 )
+    return status;
+
+  }
+
+return 1;
+}
+
+
+
+bool TlsMainCl::isHandshakeDone( void )
+{
+// The client Finished record has to be
+// sent too, not just made.
+
+if( !appKeysSet )
+  return false;
+
+return outgoingBuf.getLast() == 0;
+}
+
+
+
+// The jump table for the HsState actions.
+const TlsMainCl::HsHandler TlsMainCl::hsHandlers[
+                          HsState::ActLast] = {
+                &TlsMainCl::onServerHello,
+                &TlsMainCl::onEncExten,
+                &TlsMainCl::onCertificate,
+                &TlsMainCl::onCertRequest,
+                &TlsMainCl::onCertVerify,
+                &TlsMainCl::onFinished,
+                &TlsMainCl::onNewTicket,
+                &TlsMainCl::onKeyUpdate };
+
+
+
+Int32 TlsMainCl::onServerHello( void )
+{
+LogCl::debug( "Got a ServerHello." );
+
+// ServerHello was marked when the record
+// came in, in processHandshake().
+
+// HandshakeCl made the shared secret for
+// whichever group it was when the
+// ServerHello came in.
+hsTiming.mark( HsTiming::SharedSecret );
+
+handshakeCl.keySched.setHsSecret(
+                handshakeCl.getGroupSecret());
+handshakeCl.wipeGroupSecret();
+
+CharBuf key;
+CharBuf iv;
+handshakeCl.keySched.getClHsKey( key, iv );
+clWrite.setKey( key, iv );
+handshakeCl.keySched.getSrvHsKey( key, iv );
+srvRead.setKey( key, iv );
+wipeKeyBuf( key );
+wipeKeyBuf( iv );
+hsKeysSet = true;
+
+hsTiming.mark( HsTiming::HsKeys );
 
-    if( recType == TlsOuterRec::Handshake )
-      {
-      return processHandshake( recordBytes );
-      }
+// The next records are encrypted.
+return 1;
+}
 
-    if( recType == TlsOuterRec::ChangeCipherSpec )
-      {
-      StIO::putS( "Got a ChangeCipherSpec." );
-      StIO::putS( "Ignoring ChangeCipherSpec." );
-      // Don't do anything.  Just ignore it.
-      return true;
-      }
 
-    if( recType == TlsOuterRec::Alert )
-      {
-      if( recBytesLast != 2 )
-        throw "Alert recBytesLast is not right.";
 
-      // An alert is the outer record alert
-      // record type, then legacy version 3.3,
-      // then length for 2 bytes, and it's
-      // always a length of 2. Then the
-      // level and then description.
+Int32 TlsMainCl::onEncExten( void )
+{
+LogCl::debug( "Got an EncryptedExtensionsID." );
+hsTiming.mark( HsTiming::EncExtensions );
+return 0;
+}
 
-      StIO::putS( "Got an Alert." );
 
-      // Get the second byte:
-      const Uint8 descript = recordBytes.
-                                    getU8( 1 );
-      Alerts::showAlert( descript );
-      return -1; // Shut it down.
-      }
 
-    if( recType == TlsOuterRec::ApplicationData )
-      {
-      // StIO::putS( "Got ApplicationData." );
+Int32 TlsMainCl::onCertificate( void )
+{
+LogCl::debug( "Got a CertificateID." );
+hsTiming.mark( HsTiming::Certificate );
+return 0;
+}
 
-      // Int32 appBytesLast =
-      //       recordBytes.getLast();
-      // StIO::printF( "appBytes last: " );
-      // StIO::printFD( appBytesLast );
-      // StIO::putLF();
 
-      // recordBytes is everything except
-      // the 5 starting bytes.
-      // The five bytes are:
-      // 23, 3, 3, recordBytes.getLast()
 
-      CharBuf plainBuf;
-      encryptTls.srvWriteDecryptCharBuf(
-                  recordBytes,
-                  plainBuf );
+Int32 TlsMainCl::onCertRequest( void )
+{
+LogCl::debug( "Got a CertificateRequestID." );
+return 0;
+}
 
-      return processAppData( plainBuf,
-                             appInBuf );
-      }
 
 
-    //  RFC 6520
-    if( recType == TlsOuterRec::HeartBeat )
-      {
-      StIO::putS( "Got a HeartBeat." );
-      return 1;
-      }
+Int32 TlsMainCl::onCertVerify( void )
+{
+LogCl::debug( "Got a CertificateVerifyID." );
+hsTiming.mark( HsTiming::CertVerify );
+return 0;
+}
 
-    // It didn't find any matching type.
-    sendPlainAlert( Alerts::UnexpectedMessage );
-    return -1;
-    }
-  }
 
-if( circBufIn.isEmpty())
-  {
-  // Do this after processing data in circBuf.
-  if( !netClient.isConnected())
-    return -1;
 
-  }
+Int32 TlsMainCl::onFinished( void )
+{
+LogCl::debug( "Got a FinishedID." );
+hsTiming.mark( HsTiming::SrvFinished );
+
+// Just received the Server's Finished
+// Message, so send the client's
+// Finished message.
+
+// HandshakeCl already checked the server
+// Finished and put it in the transcript.
+CharBuf finished;
+handshakeCl.keySched.makeClFinished( finished );
+
+// It still goes out with the client
+// handshake key.
+CharBuf outerRecBuf;
+clWrite.seal( finished, TlsOuterRec::Handshake,
+              outerRecBuf );
+
+outgoingBuf.appendCharBuf( outerRecBuf );
+trafficStats.add( TrafficSnap::RecordsOut, 1 );
+
+handshakeCl.keySched.setAppSecrets();
+
+CharBuf key;
+CharBuf iv;
+handshakeCl.keySched.getClAppKey( key, iv );
+clWrite.setKey( key, iv );
+handshakeCl.keySched.getSrvAppKey( key, iv );
+srvRead.setKey( key, iv );
+wipeKeyBuf( key );
+wipeKeyBuf( iv );
+appKeysSet = true;
+
+hsTiming.mark( HsTiming::AppKeys );
+return 0;
+}
 
-return 1;
+
+
+Int32 TlsMainCl::onNewTicket( void )
+{
+// RFC 8446 Section 4.6.1.  It is not used
+// for resumption yet.
+LogCl::debug( "Got a NewSessionTicketID." );
+return 0;
+}
+
+
+
+Int32 TlsMainCl::onKeyUpdate( void )
+{
+LogCl::debug( "Got a KeyUpdateID." );
+return 0;
 }
 
 
@@ -229,7 +1056,15 @@ return 1;
 Int32 TlsMainCl::processHandshake(
                      const CharBuf& inBuf )
 {
-StIO::putS( "TlsMainCl.processHandshake()" );
+LogCl::trace( "TlsMainCl.processHandshake()" );
+
+// Before the handshake keys, the only thing
+// that comes here is the ServerHello.  Mark
+// it now, since HandshakeCl makes the
+// shared secret while it parses it, and
+// that is SharedSecret time.
+if( !hsKeysSet )
+  hsTiming.mark( HsTiming::ServerHello );
 
 CharBuf inBufOnce;
 inBufOnce.copy( inBuf );
@@ -253,184 +1088,38 @@ for( Int32 count = 0; count < 100; count++ )
 
   if( hResult < Results::AlertTop )
     {
-    StIO::putS( "Handshake processInbuf error." );
-    sendPlainAlert( hResult & 0xFF );
-    // Cause it to time out with read closed.
-    return 0;
+    LogCl::error( "Handshake processInbuf error." );
+    sendAlert( hResult & 0xFF );
+    return -1;
     }
 
   if( hResult == Results::Continue )
     return 1;
 
-  // StIO::printF( "msgID: " );
-  // StIO::printFUD( msgID );
-  // StIO::putLF();
-
-  // This isn't right.
-  // NewSessionTicketID can be out of order.
-  // This would be a more complex function
-  // to check the order of these messages.
-  // section-4.6.1
-  // It is not part of the handshake.
-  // It is ordinary app data.
-  // At any time after
-  // the server has received
-  // the client Finished
-  //  message, it MAY send a NewSessionTicket
-  // message.
-
-  // if( tlsMain.getLastHandshakeID() >= msgID )
-    // {
-    // StIO::putS(
-    //    "Handshake message out of order." );
-    // Which alert is this?
-    // sendPlainAlert(
-    //       Alerts::UnexpectedMessage );
-    // return -1;
-    // }
-
-  // HelloRequestRESERVED = 0;
-
-  if( msgID == Handshake::ClientHelloID )
+  // HandshakeCl already checked the order
+  // with the HsState table, so this is the
+  // move it took.
+  const Uint8 action = handshakeCl.getAction();
+  if( action >= HsState::ActLast )
     {
-    StIO::putS(
-           "Client got a ClientHello." );
-    // sendPlainAlert(
-    //        Alerts::UnexpectedMessage );
+    LogCl::error( "Handshake action is bad:",
+                  msgID );
+    sendAlert( Alerts::UnexpectedMessage );
     return -1;
     }
 
-  if( msgID == Handshake::ServerHelloID )
-    {
-    StIO::putS( "Got a ServerHello." );
-    tlsMain.setLastHandshakeID(
-                   Handshake::ServerHelloID );
-
-    Integer sharedS;
-    encryptTls.setDiffHelmOnClient(
-                          tlsMain, sharedS );
-
-    encryptTls.setHandshakeKeys( tlsMain,
-                                 sharedS );
-    return 1;
-    }
-
-  // HelloVerifyRequestRESERVED = 3;
-
-  if( msgID == Handshake::NewSessionTicketID )
-    {
-    StIO::putS( "Got a NewSessionTicketID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::NewSessionTicketID );
-    continue;
-    }
-
-  if( msgID == Handshake::EndOfEarlyDataID )
-    {
-    StIO::putS( "Got a EndOfEarlyDataID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::EndOfEarlyDataID );
-    continue;
-    }
-
-  if( msgID ==
-         Handshake::HelloRetryRequestRESERVED )
-    {
-    StIO::putS(
-          "Got a HelloRetryRequestRESERVED." );
-    tlsMain.setLastHandshakeID(
-         Handshake::HelloRetryRequestRESERVED );
-    continue;
-    }
-
-  if( msgID == Handshake::EncryptedExtensionsID )
-    {
-    StIO::putS( "Got an EncryptedExtensionsID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::EncryptedExtensionsID );
-
-    continue;
-    }
-
-  if( msgID == Handshake::CertificateID )
-    {
-    StIO::putS(
-         "Got a CertificateID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::CertificateID );
-    continue;
-    }
-
-  if( msgID == Handshake::CertificateRequestID )
-    {
-    StIO::putS( "Got a CertificateRequestID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::CertificateRequestID );
-    continue;
-    }
-
-  if( msgID == Handshake::CertificateVerifyID )
-    {
-    StIO::putS( "Got a CertificateVerifyID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::CertificateVerifyID );
-    continue;
-    }
-
-  if( msgID == Handshake::FinishedID )
-    {
-    StIO::putS( "Got a FinishedID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::FinishedID );
-
-    // FinishedMesg finished;
-    // finished.
-
-    // Just received the Server's Finished
-    // Message, so send the client's
-    // Finished message.
+  tlsMain.setLastHandshakeID( msgID );
 
-    CharBuf finished;
-    encryptTls.makeClFinishedMsg( tlsMain,
-                                  finished );
+  const Int32 status = (this->*hsHandlers[action])();
+  if( status != 0 )
+    return status;
 
-    CharBuf outerRecBuf;
-    encryptTls.clWriteMakeOuterRec( finished,
-                      outerRecBuf,
-                      TlsOuterRec::Handshake );
-
-    outgoingBuf.appendCharBuf( outerRecBuf );
-
-    // if( !sendTestVecFinished())
-      // return -1;
-
-    encryptTls.setAppDataKeys( tlsMain );
-    continue;
-    }
-
-  if( msgID == Handshake::KeyUpdateID )
-    {
-    StIO::putS( "Got a KeyUpdateID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::KeyUpdateID );
-    continue;
-    }
-
-  if( msgID == Handshake::MessageHashID )
-    {
-    StIO::putS( "Got a MessageHashID." );
-    tlsMain.setLastHandshakeID(
-             Handshake::MessageHashID );
-    continue;
-    }
-
-  throw "Handshake message unknown.";
   }
 
 // If someone put over 100 handshake messages
 // in to one outer record.
 
-StIO::putS( "It should never loop 100 times." );
+LogCl::error( "It should never loop 100 times." );
 return -1;
 }
 
@@ -451,9 +1140,12 @@ const Int32 max = plainText.getLast();
 
 if( max == 0 )
   {
-  StIO::putS(
+  // There is always at least the content
+  // type, so it didn't decrypt.
+  LogCl::warn(
        "processAppData messages was empty." );
-  return 0;
+  sendAlert( Alerts::BadRecordMac );
+  return -1;
   }
 
 for( Int32 count = max - 1; count >= 0; count-- )
@@ -468,9 +1160,11 @@ for( Int32 count = max - 1; count >= 0; count-- )
 
 if( paddingLast == 0 )
   {
-  StIO::putS(
+  // RFC 8446 Section 5.4.
+  LogCl::warn(
      "processAppData Message was all padding." );
-  return 0;
+  sendAlert( Alerts::UnexpectedMessage );
+  return -1;
   }
 
 messages.truncateLast( paddingLast );
@@ -495,16 +1189,34 @@ if( messageType == TlsOuterRec::Handshake )
 
 if( messageType == TlsOuterRec::ChangeCipherSpec )
   {
-  StIO::putS(
+  // RFC 8446 Section 5.  It is only ever
+  // sent in plain text.
+  LogCl::warn(
            "messageType is ChangeCipherSpec." );
-
-  return 0;
+  sendAlert( Alerts::UnexpectedMessage );
+  return -1;
   }
 
 if( messageType == TlsOuterRec::Alert )
   {
-  StIO::putS( "messageType is Alert." );
-  return 1;
+  LogCl::warn( "messageType is Alert." );
+  if( messages.getLast() != 2 )
+    {
+    sendAlert( Alerts::DecodeError );
+    return -1;
+    }
+
+  const Uint8 descript = messages.getU8( 1 );
+  trafficStats.alertIn( descript );
+  if( !isHandshakeDone())
+    trafficStats.setHsOutcome( false );
+
+  Alerts::showAlert( descript );
+  flushSink();
+
+  // It might be close_notify, but either
+  // way the server is done sending.
+  return -1;
   }
 
 if( messageType == TlsOuterRec::ApplicationData )
@@ -513,53 +1225,113 @@ if( messageType == TlsOuterRec::ApplicationData )
   // messages.showHex();
   // messages.showAscii();
 
-  appInBuf.addCharBuf( messages );
-
   // StIO::printF( "appInBuf size:: " );
   // Int32 appLast = appInBuf.getHowMany();
   // StIO::printFD( appLast );
   // StIO::putLF();
 
-  return 1;
+  return deliverAppData( messages, appInBuf );
   }
 
 if( messageType == TlsOuterRec::HeartBeat )
   {
-  StIO::putS( "messageType is HeartBeat." );
+  LogCl::debug( "messageType is HeartBeat." );
   return 1;
   }
 
-throw "Application messageType is unknown.";
-// return -1;
+LogCl::warn( "Application messageType is unknown." );
+sendAlert( Alerts::UnexpectedMessage );
+return -1;
 }
 
 
 
-void TlsMainCl::sendPlainAlert(
-                           const Uint8 descript )
+Int32 TlsMainCl::deliverAppData(
+                       const CharBuf& plainBuf,
+                       CircleBuf& appInBuf )
 {
-// An alert sent in Plain Text.
+if( appSink == nullptr )
+  {
+  appInBuf.addCharBuf( plainBuf );
+  trafficStats.setHigh( TrafficSnap::AppInBufHigh,
+          static_cast<Uint64>(
+                      appInBuf.getHowMany()));
+  return 1;
+  }
 
-// ======
-// This has to be sent as an encrypted
-// record sometimes.
+if( !appSink->write( plainBuf ))
+  {
+  LogCl::error( "The app sink didn't take it." );
+  return -1;
+  }
 
-// Pretend the parameter is being used.
-if( descript == 0xFF ) // Doesn't happen.
-  StIO::printF( "Parameter is being used." );
-else
-  throw "Send plain alert needs work.";
+return 1;
+}
 
 
-/*
-StIO::printF( "Sending Alert: " );
-StIO::printFUD( descript );
-StIO::putLF();
 
-const Uint8 level = Alerts::getMatchingLevel(
-                                     descript );
+bool TlsMainCl::sinkHasRoom( void )
+{
+if( appSink == nullptr )
+  return true;
+
+// Room for one whole record.
+return appSink->getRoom() >=
+                  tlsMain.getMaxFragLength();
+}
+
+
+
+void TlsMainCl::flushSink( void )
+{
+if( appSink == nullptr )
+  return;
+
+appSink->flush();
+}
+
+
+
+bool TlsMainCl::sendCloseNotify( void )
+{
+// RFC 8446 Section 6.1.  After this the
+// client doesn't send any more, but it can
+// still read what the server sends.
+
+if( !appKeysSet )
+  return false;
+
+CharBuf plainBuf;
+plainBuf.appendU8( 1 ); // Warning
+plainBuf.appendU8( 0 ); // close_notify
+
+trafficStats.add( TrafficSnap::AlertsSent, 1 );
+trafficStats.add( TrafficSnap::RecordsOut, 1 );
+
+if( kernelTls.getTxOn())
+  return kernelTls.sendRec( transport->getSock(),
+                  plainBuf, TlsOuterRec::Alert ) >= 0;
+
+CharBuf outerRecBuf;
+clWrite.seal( plainBuf, TlsOuterRec::Alert,
+              outerRecBuf );
+appRecsOut++;
+
+return netSend( outerRecBuf ) ==
+                       outerRecBuf.getLast();
+}
+
 
+
+void TlsMainCl::sendPlainAlert(
+                           const Uint8 descript )
+{
 // Alerts are in RFC 8446, Section 6.
+// This is before there are any handshake
+// keys, so it goes in plain text.
+
+const Uint8 level = Alerts::getMatchingLevel(
+                                     descript );
 
 outgoingBuf.appendU8( TlsOuterRec::Alert );
 
@@ -573,10 +1345,65 @@ outgoingBuf.appendU8( 2 );
 
 outgoingBuf.appendU8( level );
 outgoingBuf.appendU8( descript );
-*/
 }
 
 
+
+void TlsMainCl::sendAlert( const Uint8 descript )
+{
+// This is for a protocol error in what the
+// server sent.  It sends the alert right
+// away because the caller closes after
+// this returns.  Nothing gets thrown, so
+// bad input from the network costs about
+// the same as good input.
+
+LogCl::warn( "Sending an alert." );
+
+trafficStats.add( TrafficSnap::AlertsSent, 1 );
+trafficStats.add( TrafficSnap::RecordsOut, 1 );
+if( !isHandshakeDone())
+  trafficStats.setHsOutcome( false );
+
+if( !hsKeysSet )
+  {
+  sendPlainAlert( descript );
+  }
+else
+  {
+  // After the ServerHello every record the
+  // client sends is encrypted.
+  CharBuf plainBuf;
+  plainBuf.appendU8( Alerts::getMatchingLevel(
+                                   descript ));
+  plainBuf.appendU8( descript );
+
+  if( kernelTls.getTxOn())
+    {
+    kernelTls.sendRec( transport->getSock(),
+                  plainBuf, TlsOuterRec::Alert );
+    return;
+    }
+
+  CharBuf outerRecBuf;
+  clWrite.seal( plainBuf, TlsOuterRec::Alert,
+                outerRecBuf );
+  if( appKeysSet )
+    appRecsOut++;
+
+  outgoingBuf.appendCharBuf( outerRecBuf );
+  }
+
+// Whatever was not sent yet goes first.
+CharBuf sendOutBuf;
+copyOutBuf( sendOutBuf );
+if( netIsConnected())
+  netSend( sendOutBuf );
+
+}
+
+
+
 void TlsMainCl::copyOutBuf( CharBuf& sendOutBuf )
 {
 sendOutBuf.copy( outgoingBuf );
@@ -588,7 +1415,7 @@ outgoingBuf.clear();
 
 bool TlsMainCl::sendTestVecFinished( void )
 {
-StIO::putS( "Sending test vec finished." );
+LogCl::debug( "Sending test vec finished." );
 
 // This includes the handshake header.
 const char* vecFinishedMsgString =
@@ -602,9 +1429,12 @@ CharBuf testVecMsgBuf( vecFinishedMsgString );
 CharBuf finMsgBuf;
 finMsgBuf.setFromHexTo256( testVecMsgBuf );
 
-StIO::putS( "finMsgBuf:" );
-finMsgBuf.showHex();
-StIO::putLF();
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "finMsgBuf:" );
+  finMsgBuf.showHex();
+  StIO::putLF();
+  }
 
 tlsMain.setClWriteFinishedMsg( finMsgBuf );
 
@@ -620,9 +1450,12 @@ CharBuf testVecBuf( vecFinishedString );
 CharBuf finRecBuf;
 finRecBuf.setFromHexTo256( testVecBuf );
 
-StIO::putS( "finRecBuf:" );
-finRecBuf.showHex();
-StIO::putLF();
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "finRecBuf:" );
+  finRecBuf.showHex();
+  StIO::putLF();
+  }
 
 
 outgoingBuf.appendCharBuf( finRecBuf );
@@ -637,11 +1470,16 @@ bool TlsMainCl::startTestVecHandshake(
                         const CharBuf& urlDomain,
                         const CharBuf& port )
 {
-StIO::putS( "Connecting to server." );
+LogCl::info( "Connecting to server." );
 
-if( !netClient.connect( urlDomain, port ))
+hsTiming.clear();
+hsTiming.mark( HsTiming::Start );
+
+if( !netConnect( urlDomain, port ))
   return false;
 
+hsTiming.mark( HsTiming::Connected );
+
 Integer k;
 Integer pubKey;
 
@@ -661,55 +1499,62 @@ const char* pubKeyString =
       "b3 c0 6e 51 c1 3c ae 4d"
       "54 13 69 1e 52 9a af 2c";
 
-StIO::putS( "Private key:" );
 CharBuf privKeyStrBuf( privKeyString );
 CharBuf privKeyBuf;
 privKeyBuf.setFromHexTo256( privKeyStrBuf );
-privKeyBuf.showHex();
-ByteArray cArray;
-privKeyBuf.copyToCharArray( cArray );
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "Private key:" );
+  privKeyBuf.showHex();
+  }
 
-// This clampK has to be done.
-tlsMain.mCurve.clampK( cArray );
+Uint8 keyBytes[32];
+for( Int32 count = 0; count < 32; count++ )
+  keyBytes[count] = privKeyBuf.getU8( count );
 
-tlsMain.mCurve.cArrayToInt( cArray, k );
+handshakeCl.clientHello.setX25519Priv(
+                                    keyBytes );
+
+// This clamps it, which has to be done.
+CurveCtx::privKeyToInt( keyBytes, k );
 
-StIO::putS( "Public key:" );
 CharBuf pubKeyStrBuf( pubKeyString );
 CharBuf pubKeyBuf;
 pubKeyBuf.setFromHexTo256( pubKeyStrBuf );
-pubKeyBuf.showHex();
-pubKeyBuf.copyToCharArray( cArray );
-tlsMain.mCurve.cArrayToInt( cArray, pubKey );
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "Public key:" );
+  pubKeyBuf.showHex();
+  }
+
+for( Int32 count = 0; count < 32; count++ )
+  keyBytes[count] = pubKeyBuf.getU8( count );
+
+CurveCtx::bytesToInt( keyBytes, pubKey );
 
 // Raise 9 to k and see if I get pubkey.
 
-Integer U;
-U.setFromLong48( 9 );
 Integer pubKeyTest;
-tlsMain.mCurve.montLadder1(
-                     pubKeyTest, U, k,
-                     tlsMain.intMath,
-                     tlsMain.mod );
-
-tlsMain.mCurve.uCoordTo32Bytes( pubKeyTest,
-                        cArray, tlsMain.mod,
-                        tlsMain.intMath );
+CurveCtx::baseMult( pubKeyTest, k );
 
-StIO::putS( "pubKeyTest:" );
-CharBuf testBuf;
-testBuf.appendCharArray( cArray, 32 );
-testBuf.showHex();
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "pubKeyTest:" );
+  CharBuf testBuf;
+  CurveCtx::intToBytes( pubKeyTest, testBuf );
+  testBuf.showHex();
+  }
 
 if( !pubKey.isEqual( pubKeyTest ))
   throw
     "startTestVecHandshake Test keys not right.";
 
-StIO::putS( "Got the keys right." );
+LogCl::debug( "Got the keys right." );
 
-// This is the clamped value.
-encryptTls.setClientPrivKey( k );
-encryptTls.setClientPubKey( pubKey );
+// HandshakeCl makes the shared secret from
+// what setX25519Priv() was given.  The
+// ClientHello is the RFC one, so nothing
+// else needs the keys.
 
 
 // tlsMain.setServerName( urlDomain );
@@ -749,10 +1594,13 @@ CharBuf clHelloBuf( clHelloString );
 CharBuf clRecBuf;
 clRecBuf.setFromHexTo256( clHelloBuf );
 
-StIO::putS( "clRecBuf:" );
-clRecBuf.showHex();
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "clRecBuf:" );
+  clRecBuf.showHex();
+  }
 
-tlsMain.setClientHelloMsg( clRecBuf );
+handshakeCl.setClHelloSent( clRecBuf );
 
 
 // The client Hello message.  This is the
@@ -784,19 +1632,96 @@ CharBuf clHelloRecBuf( clHelloRecString );
 CharBuf recordBuf;
 recordBuf.setFromHexTo256( clHelloRecBuf );
 
-StIO::putS( "recordBuf:" );
+if( LogCl::isOn( LogCl::Debug ))
+  {
+  StIO::putS( "recordBuf:" );
+  recordBuf.showHex();
+  StIO::putS( "End of recordBuf." );
+  }
+
+Int32 sentBytes = netSend( recordBuf );
+trafficStats.add( TrafficSnap::RecordsOut, 1 );
+hsTiming.mark( HsTiming::HelloSent );
+
+LogCl::debug( "Sent bytes:", sentBytes );
+
+return true;
+}
+
+
+
+void TlsMainCl::captureSecrets(
+                      const CharBuf& urlDomain,
+                      const CharBuf& cHelloBuf )
+{
+// What it needs to get the same keys when
+// it replays the server's records.
+
+capture->addEntry( RecCapture::TypeServerName,
+                   urlDomain );
+capture->addEntry( RecCapture::TypeClHello,
+                   cHelloBuf );
+
+// The X25519 scalar as ClientHello made
+// it.  privKeyToInt() clamps it again on
+// the replay.
+const Uint8* keyBytes =
+         handshakeCl.clientHello.getX25519Priv();
+
+CharBuf keyBuf;
+for( Int32 count = 0; count < 32; count++ )
+  keyBuf.appendU8( keyBytes[count] );
+
+capture->addEntry( RecCapture::TypePrivKey,
+                   keyBuf );
+wipeKeyBuf( keyBuf );
+}
+
 
-recordBuf.showHex();
 
-StIO::putS( "End of recordBuf." );
+bool TlsMainCl::startReplay( RecReplay& replay )
+{
+// This sets up the same client state that
+// the captured session had, then the
+// server's bytes come from memIn().
+
+CharBuf nameBuf;
+CharBuf cHelloBuf;
+CharBuf keyBuf;
+if( !replay.findFirst( RecCapture::TypeServerName,
+                       nameBuf ) ||
+    !replay.findFirst( RecCapture::TypeClHello,
+                       cHelloBuf ) ||
+    !replay.findFirst( RecCapture::TypePrivKey,
+                       keyBuf ))
+  {
+  StIO::putS(
+        "The capture doesn't have the secrets." );
+  return false;
+  }
+
+if( keyBuf.getLast() != 32 )
+  return false;
+
+useMemTransport();
+hsTiming.clear();
+hsTiming.mark( HsTiming::Start );
+
+tlsMain.setServerName( nameBuf );
+
+Uint8 keyBytes[32];
+for( Int32 count = 0; count < 32; count++ )
+  keyBytes[count] = keyBuf.getU8( count );
 
-Int32 sentBytes = netClient.sendCharBuf(
-                                 recordBuf );
+wipeKeyBuf( keyBuf );
+handshakeCl.clientHello.setX25519Priv(
+                                    keyBytes );
+::explicit_bzero( keyBytes, sizeof( keyBytes ));
 
-StIO::printF( "Sent bytes: " );
-StIO::printFD( sentBytes );
-StIO::putLF();
+handshakeCl.setClHelloSent( cHelloBuf );
 
+hsTiming.mark( HsTiming::Connected );
+hsTiming.mark( HsTiming::HelloSent );
 return true;
 }
 
@@ -806,25 +1731,36 @@ bool TlsMainCl::startHandshake(
                       const CharBuf& urlDomain,
                       const CharBuf& port )
 {
-StIO::putS( "Connecting to server." );
+LogCl::info( "Connecting to server." );
 
-if( !netClient.connect( urlDomain, port ))
+// With TCP Fast Open the connect returns
+// right away and the ClientHello record
+// below goes out in the SYN.
+
+hsTiming.clear();
+hsTiming.mark( HsTiming::Start );
+
+if( !netConnect( urlDomain, port ))
   return false;
 
+hsTiming.mark( HsTiming::Connected );
+
 tlsMain.setServerName( urlDomain );
 
 CharBuf cHelloBuf;
 
-handshakeCl.makeClHelloBuf( cHelloBuf,
-                            tlsMain,
-                            encryptTls );
+handshakeCl.makeClHelloCached( cHelloBuf,
+                               urlDomain,
+                               tlsMain,
+                               encryptTls );
+
+handshakeCl.setClHelloSent( cHelloBuf );
 
-tlsMain.setClientHelloMsg( cHelloBuf );
+if( capture != nullptr )
+  captureSecrets( urlDomain, cHelloBuf );
 
 Int32 cHelloBufLen = cHelloBuf.getLast();
-StIO::printF( "cHelloBufLen: " );
-StIO::printFD( cHelloBufLen );
-StIO::putLF();
+LogCl::debug( "cHelloBufLen:", cHelloBufLen );
 
 CharBuf recBuf;
 TlsOuterRec outerRec;
@@ -839,11 +1775,11 @@ Int32 howMany = outerRec.makeHandshakeRec(
 if( (cHelloBufLen + 5) != howMany )
   throw "Fix cHelloBuf not all sent.";
 
-Int32 sentBytes = netClient.sendCharBuf( recBuf );
+Int32 sentBytes = netSend( recBuf );
+trafficStats.add( TrafficSnap::RecordsOut, 1 );
+hsTiming.mark( HsTiming::HelloSent );
 
-StIO::printF( "Sent bytes: " );
-StIO::printFD( sentBytes );
-StIO::putLF();
+LogCl::debug( "Sent bytes:", sentBytes );
 
 // Fix this up.
 if( sentBytes != howMany )
@@ -27,7 +27,19 @@
 #include "../Network/Results.h"
 #include "../Network/TlsOuterRec.h"
 #include "../Network/EncryptTls.h"
-#include "../Network/NetClient.h"
+#include "Transport.h"
+#include "TransportNet.h"
+#include "TransportSock.h"
+#include "TransportMem.h"
+#include "KernelTls.h"
+#include "FileSend.h"
+#include "AppSink.h"
+#include "DecryptPool.h"
+#include "HsTiming.h"
+#include "TrafficStats.h"
+#include "RecCapture.h"
+#include "RecReplay.h"
+#include "RecCipher.h"
 
 
 
@@ -36,13 +48,88 @@ class TlsMainCl
   private:
   bool testForCopy = false;
   TlsMain tlsMain;
-  NetClient netClient;
+  TransportNet netTrans;
+  TransportSock sockTrans;
+  TransportMem memTrans;
+  // This points to one of the three above
+  // or to one that the app owns.
+  Transport* transport = &netTrans;
   CircleBuf circBufIn;
   CharBuf recordBytes;
   CharBuf outgoingBuf;
   TlsOuterRec tlsOuterRead;
   HandshakeCl handshakeCl;
+  // ExtenList and ServerHello still take
+  // one of these.  The keys and the records
+  // are done with handshakeCl.keySched and
+  // the two below.
   EncryptTls encryptTls;
+  RecCipher clWrite;
+  RecCipher srvRead;
+  bool appKeysSet = false;
+  KernelTls kernelTls;
+  bool kTlsWanted = false;
+  // The ServerHello was processed so the
+  // client sends encrypted records.
+  bool hsKeysSet = false;
+  bool recBoundary = true;
+  Uint64 appRecsIn = 0;
+  Uint64 appRecsOut = 0;
+  FileSend fileSend;
+  // The plain text for one upload record.
+  // It is kept so it doesn't grow again for
+  // every record.
+  CharBuf uploadPlain;
+  CharBuf uploadPending;
+  AppSink* appSink = nullptr;
+  DecryptPool decryptPool;
+  Int32 decryptThreads = 0;
+  HsTiming hsTiming;
+  TrafficStats trafficStats;
+  RecCapture* capture = nullptr;
+
+  // How many records it seals for a file
+  // upload each time processOutgoing()
+  // is called.
+  static const Int32 UploadRecsPerCall = 8;
+
+  void tryKernelTx( void );
+  void tryKernelRx( void );
+  Int32 processKernelIn( CircleBuf& appInBuf );
+  bool sendUploadPending( void );
+  Int32 processUpload( void );
+  Int32 deliverAppData( const CharBuf& plainBuf,
+                        CircleBuf& appInBuf );
+  bool sinkHasRoom( void );
+  void flushSink( void );
+  bool useDecryptPool( void );
+  Int32 drainDecryptPool( CircleBuf& appInBuf );
+
+  bool netConnect( const CharBuf& urlDomain,
+                   const CharBuf& port );
+  Int32 netSend( const CharBuf& sendBuf );
+  void netReceive( CharBuf& recvBuf );
+  bool netIsConnected( void );
+
+  void captureSecrets( const CharBuf& urlDomain,
+                       const CharBuf& cHelloBuf );
+
+  // The handlers for the HsState actions.
+  // They return 0 to go on to the next
+  // message, or else what processHandshake()
+  // returns.
+  typedef Int32 (TlsMainCl::*HsHandler)( void );
+  static const HsHandler hsHandlers[
+                              HsState::ActLast];
+
+  Int32 onServerHello( void );
+  Int32 onEncExten( void );
+  Int32 onCertificate( void );
+  Int32 onCertRequest( void );
+  Int32 onCertVerify( void );
+  Int32 onFinished( void );
+  Int32 onNewTicket( void );
+  Int32 onKeyUpdate( void );
 
   public:
   TlsMainCl( void )
@@ -66,7 +153,142 @@ class TlsMainCl
     {
     }
 
+  // Like a new one, for the next connection,
+  // but it doesn't free and make again the
+  // buffers it has.  Everything that was set
+  // goes back to how it starts.
+  void reset( void );
+
+  void setFastOpen( const bool setTo );
+  void setKernelTls( const bool setTo );
+
+  // Offer a P-256 key share after the
+  // x25519 one.
+  void setOfferP256( const bool setTo )
+    {
+    handshakeCl.clientHello.setOfferP256( setTo );
+    }
+
+  // Offer the X25519MLKEM768 hybrid share
+  // too.
+  void setOfferMlKem( const bool setTo )
+    {
+    handshakeCl.clientHello.setOfferMlKem( setTo );
+    }
+
+  bool startFileUpload(
+                      const CharBuf& fileName );
+  bool startFileUploadFd( const Int32 fd );
+  void setUploadProgress(
+                     UploadProgress callBack,
+                     void* context );
+
+  bool uploadIsActive( void ) const
+    {
+    return fileSend.isActive();
+    }
+
+  void setAppSink( AppSink* setTo )
+    {
+    // The caller owns the sink.  Set it to
+    // nullptr to go back to appInBuf.
+    appSink = setTo;
+    }
+
+  void setParallelDecrypt(
+                     const Int32 howManyThreads );
+
+  bool isHandshakeDone( void );
+
+  Int64 getHsPhaseNs( const Int32 phase ) const
+    {
+    return hsTiming.getPhaseNs( phase );
+    }
+
+  void getTrafficSnap( TrafficSnap& snap ) const
+    {
+    trafficStats.getSnap( snap );
+    }
+
+  // The certificates the server sent.  The
+  // end-entity one is 0.  They are read
+  // where they are in the Certificate
+  // message, so a CertView from this is good
+  // until reset() or the next handshake.
+  Int32 getPeerCertLast( void ) const
+    {
+    return handshakeCl.getCertChain().
+                                 getCertLast();
+    }
+
+  Uint32 getPeerCert( const Int32 which,
+                      CertView& cert ) const
+    {
+    return handshakeCl.getCertChain().getCert(
+                                  which, cert );
+    }
+
+  void setCapture( RecCapture* setTo )
+    {
+    // The caller owns it and opens the file
+    // before startHandshake().
+    capture = setTo;
+    }
+
+  bool startReplay( RecReplay& replay );
+
+  // Set the transport before startHandshake().
+  // The caller owns it.  Set it to nullptr
+  // to go back to NetClient.
+  void setTransport( Transport* setTo );
+
+  // A TcpSockCl socket that doesn't block.
+  void setNonBlocking( const bool setTo );
+
+  Int32 getPendingOut( void ) const
+    {
+    return transport->getPendingOut();
+    }
+
+  void useMemTransport( void )
+    {
+    transport = &memTrans;
+    memTrans.setOpen();
+    }
+
+  // What the client sent since the last
+  // time this was called.
+  void memTakeOut( CharBuf& outBuf )
+    {
+    memTrans.takeOut( outBuf );
+    }
+
+  void memIn( const CharBuf& inBuf )
+    {
+    memTrans.putIn( inBuf );
+    }
+
+  void memClose( void )
+    {
+    memTrans.close();
+    }
+
+  bool hasIncoming( void )
+    {
+    return (!circBufIn.isEmpty()) ||
+           (memTrans.getInLast() > 0);
+    }
+
   void sendPlainAlert( const Uint8 descript );
+  // Plain or encrypted, whichever is right
+  // for where the handshake is.
+  void sendAlert( const Uint8 descript );
+  bool sendCloseNotify( void );
+
+  Int32 getSock( void ) const
+    {
+    return transport->getSock();
+    }
 
   Int32 processIncoming( CircleBuf& appInBuf );
 
@@ -0,0 +1,272 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "TrafficStats.h"
+
+#include <mutex>
+#include <stdio.h>
+
+
+
+static std::mutex statsListMutex;
+static TrafficStats* statsList = nullptr;
+
+// What the destroyed ones had.
+static TrafficSnap closedSnap;
+
+
+
+void TrafficSnap::clear( void )
+{
+for( Int32 count = 0; count < CounterLast;
+                                     count++ )
+  counters[count] = 0;
+
+for( Int32 count = 0; count < HighLast; count++ )
+  highs[count] = 0;
+
+for( Int32 count = 0; count < AlertLast; count++ )
+  alertsIn[count] = 0;
+
+}
+
+
+
+void TrafficSnap::addFrom( const TrafficSnap& in )
+{
+for( Int32 count = 0; count < CounterLast;
+                                     count++ )
+  counters[count] += in.counters[count];
+
+// The high water mark for the process is
+// the highest one for any connection.
+for( Int32 count = 0; count < HighLast; count++ )
+  {
+  if( in.highs[count] > highs[count] )
+    highs[count] = in.highs[count];
+
+  }
+
+for( Int32 count = 0; count < AlertLast; count++ )
+  alertsIn[count] += in.alertsIn[count];
+
+}
+
+
+
+TrafficStats::TrafficStats( void )
+{
+clear();
+
+std::unique_lock<std::mutex> lock(
+                             statsListMutex );
+next = statsList;
+if( statsList != nullptr )
+  statsList->previous = this;
+
+statsList = this;
+}
+
+
+
+TrafficStats::~TrafficStats( void )
+{
+TrafficSnap snap;
+getSnap( snap );
+
+std::unique_lock<std::mutex> lock(
+                             statsListMutex );
+closedSnap.addFrom( snap );
+
+if( previous != nullptr )
+  previous->next = next;
+else
+  statsList = next;
+
+if( next != nullptr )
+  next->previous = previous;
+
+}
+
+
+
+void TrafficStats::clear( void )
+{
+for( Int32 count = 0;
+        count < TrafficSnap::CounterLast; count++ )
+  counters[count].store( 0,
+                     std::memory_order_relaxed );
+
+for( Int32 count = 0;
+        count < TrafficSnap::HighLast; count++ )
+  highs[count].store( 0,
+                     std::memory_order_relaxed );
+
+for( Int32 count = 0;
+        count < TrafficSnap::AlertLast; count++ )
+  alertsIn[count].store( 0,
+                     std::memory_order_relaxed );
+
+outcomeSet = false;
+}
+
+
+
+void TrafficStats::retire( void )
+{
+// Under the lock so the totals don't count
+// it twice or miss it.
+TrafficSnap snap;
+
+std::unique_lock<std::mutex> lock(
+                             statsListMutex );
+getSnap( snap );
+closedSnap.addFrom( snap );
+clear();
+}
+
+
+
+void TrafficStats::setHsOutcome( const bool good )
+{
+if( outcomeSet )
+  return;
+
+outcomeSet = true;
+if( good )
+  add( TrafficSnap::HandshakesDone, 1 );
+else
+  add( TrafficSnap::HandshakesFailed, 1 );
+
+}
+
+
+
+void TrafficStats::getSnap(
+                     TrafficSnap& snap ) const
+{
+for( Int32 count = 0;
+        count < TrafficSnap::CounterLast; count++ )
+  snap.counters[count] = counters[count].load(
+                     std::memory_order_relaxed );
+
+for( Int32 count = 0;
+        count < TrafficSnap::HighLast; count++ )
+  snap.highs[count] = highs[count].load(
+                     std::memory_order_relaxed );
+
+for( Int32 count = 0;
+        count < TrafficSnap::AlertLast; count++ )
+  snap.alertsIn[count] = alertsIn[count].load(
+                     std::memory_order_relaxed );
+
+}
+
+
+
+void TrafficStats::getTotalSnap(
+                            TrafficSnap& snap )
+{
+snap.clear();
+
+std::unique_lock<std::mutex> lock(
+                             statsListMutex );
+snap.addFrom( closedSnap );
+
+TrafficSnap liveSnap;
+for( TrafficStats* stats = statsList;
+         stats != nullptr; stats = stats->next )
+  {
+  stats->getSnap( liveSnap );
+  snap.addFrom( liveSnap );
+  }
+}
+
+
+
+static void appendLine( CharBuf& outBuf,
+                        const char* line )
+{
+CharBuf lineBuf( line );
+outBuf.appendCharBuf( lineBuf );
+}
+
+
+
+void TrafficStats::makePromText( CharBuf& outBuf )
+{
+TrafficSnap snap;
+getTotalSnap( snap );
+
+static const char* const counterNames[] = {
+              "tlscl_bytes_in_total",
+              "tlscl_bytes_out_total",
+              "tlscl_records_in_total",
+              "tlscl_records_out_total",
+              "tlscl_decrypt_failures_total",
+              "tlscl_alerts_sent_total",
+              "tlscl_handshakes_done_total",
+              "tlscl_handshakes_failed_total",
+              "tlscl_tfo_attempts_total",
+              "tlscl_tfo_successes_total" };
+
+static const char* const highNames[] = {
+              "tlscl_circbufin_high_bytes",
+              "tlscl_appinbuf_high_bytes" };
+
+char lineChars[160];
+
+for( Int32 count = 0;
+        count < TrafficSnap::CounterLast; count++ )
+  {
+  ::snprintf( lineChars, sizeof( lineChars ),
+              "# TYPE %s counter\n%s %llu\n",
+              counterNames[count],
+              counterNames[count],
+              static_cast<unsigned long long>(
+                       snap.counters[count] ));
+  appendLine( outBuf, lineChars );
+  }
+
+for( Int32 count = 0;
+        count < TrafficSnap::HighLast; count++ )
+  {
+  ::snprintf( lineChars, sizeof( lineChars ),
+              "# TYPE %s gauge\n%s %llu\n",
+              highNames[count], highNames[count],
+              static_cast<unsigned long long>(
+                       snap.highs[count] ));
+  appendLine( outBuf, lineChars );
+  }
+
+appendLine( outBuf,
+     "# TYPE tlscl_alerts_received_total counter\n" );
+
+for( Int32 count = 0;
+        count < TrafficSnap::AlertLast; count++ )
+  {
+  if( snap.alertsIn[count] == 0 )
+    continue;
+
+  ::snprintf( lineChars, sizeof( lineChars ),
+              "tlscl_alerts_received_total"
+              "{description=\"%d\"} %llu\n",
+              count,
+              static_cast<unsigned long long>(
+                       snap.alertsIn[count] ));
+  appendLine( outBuf, lineChars );
+  }
+}
@@ -0,0 +1,154 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// Traffic counters for one connection.
+// Only the thread that runs the connection
+// changes them, so adding to one is a
+// relaxed load and a relaxed store, not a
+// locked add.  Any thread can read them.
+
+// Each TrafficStats is in a list for the
+// whole process, so the totals are the
+// live connections added up plus what the
+// closed ones had.  The list lock is only
+// taken when one is made or destroyed, and
+// for the totals.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+#include <atomic>
+
+
+
+class TrafficSnap
+  {
+  public:
+  static const Int32 BytesIn = 0;
+  static const Int32 BytesOut = 1;
+  static const Int32 RecordsIn = 2;
+  static const Int32 RecordsOut = 3;
+  static const Int32 DecryptFails = 4;
+  static const Int32 AlertsSent = 5;
+  static const Int32 HandshakesDone = 6;
+  static const Int32 HandshakesFailed = 7;
+  // Connections that sent the SYN with TCP
+  // Fast Open, and the ones where the server
+  // took the data in it.
+  static const Int32 TfoAttempts = 8;
+  static const Int32 TfoSuccesses = 9;
+  static const Int32 CounterLast = 10;
+
+  // High water marks in bytes.
+  static const Int32 CircBufInHigh = 0;
+  static const Int32 AppInBufHigh = 1;
+  static const Int32 HighLast = 2;
+
+  static const Int32 AlertLast = 256;
+
+  Uint64 counters[CounterLast] = { 0 };
+  Uint64 highs[HighLast] = { 0 };
+
+  // Alerts received by description.
+  Uint64 alertsIn[AlertLast] = { 0 };
+
+  void clear( void );
+  void addFrom( const TrafficSnap& in );
+  };
+
+
+
+class TrafficStats
+  {
+  private:
+  bool testForCopy = false;
+  std::atomic<Uint64> counters[
+                     TrafficSnap::CounterLast];
+  std::atomic<Uint64> highs[
+                     TrafficSnap::HighLast];
+  std::atomic<Uint64> alertsIn[
+                     TrafficSnap::AlertLast];
+  bool outcomeSet = false;
+
+  // The list of live ones.
+  TrafficStats* previous = nullptr;
+  TrafficStats* next = nullptr;
+
+  public:
+  TrafficStats( void );
+
+  TrafficStats( const TrafficStats& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TrafficStats copy constructor.";
+    }
+
+  ~TrafficStats( void );
+
+  void add( const Int32 which,
+            const Uint64 howMany )
+    {
+    const Uint64 value = counters[which].load(
+                     std::memory_order_relaxed );
+    counters[which].store( value + howMany,
+                     std::memory_order_relaxed );
+    }
+
+  void setHigh( const Int32 which,
+                const Uint64 value )
+    {
+    if( value > highs[which].load(
+                     std::memory_order_relaxed ))
+      highs[which].store( value,
+                     std::memory_order_relaxed );
+
+    }
+
+  void alertIn( const Uint8 descript )
+    {
+    const Uint64 value = alertsIn[descript].load(
+                     std::memory_order_relaxed );
+    alertsIn[descript].store( value + 1,
+                     std::memory_order_relaxed );
+    }
+
+  // A handshake only counts once, the first
+  // time it is known how it went.
+  void setHsOutcome( const bool good );
+
+  void clear( void );
+
+  // The same as if it was destroyed and made
+  // again, for a session that gets used
+  // again.  What it had goes in the closed
+  // totals.
+  void retire( void );
+
+  void getSnap( TrafficSnap& snap ) const;
+
+  static void getTotalSnap( TrafficSnap& snap );
+
+  // In the Prometheus text format.
+  static void makePromText( CharBuf& outBuf );
+
+  };
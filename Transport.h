@@ -0,0 +1,96 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// TlsMainCl sends and receives through one
+// of these.  It gets chosen for each
+// connection before startHandshake().
+
+// TransportNet is the blocking NetClient.
+// TransportSock is a socket this client
+// owns, and it can be blocking or
+// non-blocking.  TransportMem is an
+// in-memory pipe with no socket at all.
+// The app can make its own too.
+
+// Every call takes a whole buffer, so it is
+// one virtual call per record or per read,
+// never one per byte.
+
+// Who owns what:
+// sendCharBuf() only reads sendBuf during
+// the call.  If the transport can't send all
+// of it right now it copies the rest in to
+// a buffer that it owns, and the caller can
+// reuse sendBuf right away.
+// receiveCharBuf() appends to recvBuf, which
+// the caller owns.  The transport doesn't
+// keep a pointer to it.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+
+
+
+class Transport
+  {
+  public:
+  virtual ~Transport( void )
+    {
+    }
+
+  virtual bool connect( const CharBuf& urlDomain,
+                        const CharBuf& port ) = 0;
+
+  // Returns how many bytes it took, counting
+  // what it kept to send later, or -1 if the
+  // connection is broken.
+  virtual Int32 sendCharBuf(
+                    const CharBuf& sendBuf ) = 0;
+
+  // This doesn't wait for data.  If there is
+  // nothing there it adds nothing.
+  virtual void receiveCharBuf(
+                          CharBuf& recvBuf ) = 0;
+
+  virtual bool isConnected( void ) = 0;
+
+  // Try to send what it kept from before.
+  // Returns false if the connection is broken.
+  virtual bool flushOut( void )
+    {
+    return true;
+    }
+
+  // How many bytes it is holding that haven't
+  // gone out yet.
+  virtual Int32 getPendingOut( void ) const
+    {
+    return 0;
+    }
+
+  // Kernel TLS and sendfile() need a real
+  // socket.  This is -1 if there isn't one.
+  virtual Int32 getSock( void ) const
+    {
+    return -1;
+    }
+
+  };
@@ -0,0 +1,131 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// An in-memory pipe.  Nothing goes to a
+// socket.  The other end is whoever calls
+// putIn() and takeOut(), like a test or
+// the replay tool or a server in the same
+// process.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "Transport.h"
+
+
+
+class TransportMem: public Transport
+  {
+  private:
+  bool testForCopy = false;
+  bool open = false;
+  CharBuf inBuf;
+  CharBuf outBuf;
+
+  public:
+  TransportMem( void )
+    {
+    }
+
+  TransportMem( const TransportMem& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TransportMem copy constructor.";
+    }
+
+  ~TransportMem( void ) override
+    {
+    }
+
+  // There is nothing to look up, so the
+  // name and port don't matter.
+  bool connect( const CharBuf&,
+                const CharBuf& ) override
+    {
+    setOpen();
+    return true;
+    }
+
+  void setOpen( void )
+    {
+    open = true;
+    inBuf.clear();
+    outBuf.clear();
+    }
+
+  Int32 sendCharBuf(
+             const CharBuf& sendBuf ) override
+    {
+    if( !open )
+      return -1;
+
+    outBuf.appendCharBuf( sendBuf );
+    return sendBuf.getLast();
+    }
+
+  void receiveCharBuf(
+                   CharBuf& recvBuf ) override
+    {
+    recvBuf.appendCharBuf( inBuf );
+    inBuf.clear();
+    }
+
+  bool isConnected( void ) override
+    {
+    // It is still connected after close()
+    // until it gave out what was in inBuf.
+    return open || (inBuf.getLast() > 0);
+    }
+
+  // The other end's side of the pipe.
+
+  void putIn( const CharBuf& fromBuf )
+    {
+    inBuf.appendCharBuf( fromBuf );
+    }
+
+  // What was sent since the last time this
+  // was called.
+  void takeOut( CharBuf& toBuf )
+    {
+    toBuf.copy( outBuf );
+    outBuf.clear();
+    }
+
+  Int32 getInLast( void ) const
+    {
+    return inBuf.getLast();
+    }
+
+  void close( void )
+    {
+    open = false;
+    }
+
+  void reset( void )
+    {
+    open = false;
+    inBuf.clear();
+    outBuf.clear();
+    }
+
+  };
@@ -0,0 +1,99 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The blocking NetClient socket from the
+// Network directory.  This is what
+// TlsMainCl uses if nothing else was set.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "../Network/NetClient.h"
+#include "Transport.h"
+
+#include <new>
+
+
+
+class TransportNet: public Transport
+  {
+  private:
+  bool testForCopy = false;
+  NetClient netClient;
+  bool used = false;
+
+  public:
+  TransportNet( void )
+    {
+    }
+
+  TransportNet( const TransportNet& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TransportNet copy constructor.";
+    }
+
+  ~TransportNet( void ) override
+    {
+    }
+
+  bool connect( const CharBuf& urlDomain,
+                const CharBuf& port ) override
+    {
+    used = true;
+    return netClient.connect( urlDomain, port );
+    }
+
+  // NetClient has no close, so this makes
+  // it over again in the same place.  Its
+  // destructor closes the socket.  A
+  // TlsMainCl that was reset uses TcpSockCl,
+  // so after the first time this has
+  // nothing to do.
+  void reset( void )
+    {
+    if( !used )
+      return;
+
+    netClient.~NetClient();
+    new( &netClient ) NetClient;
+    used = false;
+    }
+
+  Int32 sendCharBuf(
+             const CharBuf& sendBuf ) override
+    {
+    return netClient.sendCharBuf( sendBuf );
+    }
+
+  void receiveCharBuf(
+                   CharBuf& recvBuf ) override
+    {
+    netClient.receiveCharBuf( recvBuf );
+    }
+
+  bool isConnected( void ) override
+    {
+    return netClient.isConnected();
+    }
+
+  };
@@ -0,0 +1,109 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "TransportSock.h"
+
+
+
+bool TransportSock::connect(
+                        const CharBuf& urlDomain,
+                        const CharBuf& port )
+{
+pendingOut.clear();
+return tcpSock.connect( urlDomain, port );
+}
+
+
+
+bool TransportSock::keepRest(
+                       const CharBuf& fromBuf,
+                       const Int32 start )
+{
+// This copy is what makes it safe for the
+// caller to reuse its buffer.
+
+const Int32 last = fromBuf.getLast();
+CharBuf restBuf;
+for( Int32 count = start; count < last; count++ )
+  restBuf.appendU8( fromBuf.getU8( count ));
+
+pendingOut.copy( restBuf );
+return true;
+}
+
+
+
+bool TransportSock::flushOut( void )
+{
+if( pendingOut.getLast() == 0 )
+  return true;
+
+const Int32 howMany = tcpSock.sendCharBuf(
+                                  pendingOut );
+if( howMany < 0 )
+  return false;
+
+if( !tcpSock.isConnected())
+  return false;
+
+if( howMany >= pendingOut.getLast())
+  {
+  pendingOut.clear();
+  return true;
+  }
+
+return keepRest( pendingOut, howMany );
+}
+
+
+
+Int32 TransportSock::sendCharBuf(
+                       const CharBuf& sendBuf )
+{
+const Int32 last = sendBuf.getLast();
+
+// Records have to go out in order, so if
+// some are still waiting this goes in
+// after them.
+if( pendingOut.getLast() > 0 )
+  {
+  if( !flushOut())
+    return -1;
+
+  if( pendingOut.getLast() > 0 )
+    {
+    pendingOut.appendCharBuf( sendBuf );
+    return last;
+    }
+  }
+
+const Int32 howMany = tcpSock.sendCharBuf(
+                                     sendBuf );
+if( howMany < 0 )
+  return -1;
+
+if( howMany >= last )
+  return howMany;
+
+// A blocking socket only sends less than
+// all of it if the connection broke.
+if( !tcpSock.getNonBlocking() ||
+    !tcpSock.isConnected())
+  return howMany;
+
+keepRest( sendBuf, howMany );
+return last;
+}
@@ -0,0 +1,140 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// A TcpSockCl socket.  This is the one to
+// use for TCP Fast Open and for kernel TLS,
+// since those need the socket handle.
+
+// If it is blocking then sendCharBuf()
+// waits until the kernel took all of it.
+// If it is non-blocking then connect()
+// returns before the connection is made,
+// and sendCharBuf() sends what the kernel
+// will take and keeps the rest in
+// pendingOut.  The app can wait for the
+// socket from getSock() to be writable
+// while getPendingOut() is not zero.
+
+// A non-blocking connect() only starts on
+// the first address.  If that one fails
+// before anything was sent, TcpSockCl goes
+// on to the next one the next time this is
+// sent on or read from, and what is in
+// pendingOut goes out on the new socket.
+// So getSock() can change while it is
+// connecting.  The name lookup in connect()
+// blocks either way.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "Transport.h"
+#include "TcpSockCl.h"
+
+
+
+class TransportSock: public Transport
+  {
+  private:
+  bool testForCopy = false;
+  TcpSockCl tcpSock;
+  CharBuf pendingOut;
+
+  bool keepRest( const CharBuf& fromBuf,
+                 const Int32 start );
+
+  public:
+  TransportSock( void )
+    {
+    }
+
+  TransportSock( const TransportSock& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TransportSock copy constructor.";
+    }
+
+  ~TransportSock( void ) override
+    {
+    }
+
+  void setFastOpen( const bool setTo )
+    {
+    tcpSock.setFastOpen( setTo );
+    }
+
+  // Set this before connect().
+  void setNonBlocking( const bool setTo )
+    {
+    tcpSock.setNonBlocking( setTo );
+    }
+
+  bool getNonBlocking( void ) const
+    {
+    return tcpSock.getNonBlocking();
+    }
+
+  // Closed, with the settings it starts
+  // with.
+  void reset( void )
+    {
+    tcpSock.closeSock();
+    tcpSock.setFastOpen( false );
+    tcpSock.setNonBlocking( false );
+    pendingOut.clear();
+    }
+
+  bool connect( const CharBuf& urlDomain,
+                const CharBuf& port ) override;
+
+  Int32 sendCharBuf(
+             const CharBuf& sendBuf ) override;
+
+  void receiveCharBuf(
+                   CharBuf& recvBuf ) override
+    {
+    tcpSock.receiveCharBuf( recvBuf );
+    }
+
+  bool isConnected( void ) override
+    {
+    return tcpSock.isConnected();
+    }
+
+  bool flushOut( void ) override;
+
+  Int32 getPendingOut( void ) const override
+    {
+    return pendingOut.getLast();
+    }
+
+  Int32 getSock( void ) const override
+    {
+    return tcpSock.getSock();
+    }
+
+  bool getTfoTried( void ) const
+    {
+    return tcpSock.getTfoTried();
+    }
+
+  bool getTfoUsed( void ) const
+    {
+    return tcpSock.getTfoUsed();
+    }
+
+  };
@@ -0,0 +1,310 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "TransportUring.h"
+#include "LogCl.h"
+
+#include <errno.h>
+
+
+
+TransportUring::~TransportUring( void )
+{
+closeSession();
+}
+
+
+
+void TransportUring::closeSession( void )
+{
+// The loop still gives back the slots for
+// sends that are in flight when they
+// complete.
+
+if( (loop != nullptr) && (index >= 0))
+  {
+  loop->dropSession( index );
+
+  for( Int32 count = 0; count < partCount;
+                                     count++ )
+    {
+    const Int32 where = (partFirst + count) %
+                             UringLoop::SendSlots;
+    if( !partBusy[where] )
+      loop->giveSendSlot( partSlot[where] );
+
+    partBusy[where] = false;
+    }
+  }
+
+index = -1;
+open = false;
+partFirst = 0;
+partCount = 0;
+inFlight = 0;
+pendingBytes = 0;
+tcpSock.closeSock();
+}
+
+
+
+bool TransportUring::connect(
+                        const CharBuf& urlDomain,
+                        const CharBuf& port )
+{
+closeSession();
+inBuf.clear();
+
+if( loop == nullptr )
+  throw "TransportUring has no loop.";
+
+if( !loop->setup())
+  return false;
+
+if( !tcpSock.connect( urlDomain, port ))
+  return false;
+
+index = loop->addSession( this );
+if( index < 0 )
+  {
+  LogCl::error( "UringLoop has no free sessions." );
+  tcpSock.closeSock();
+  return false;
+  }
+
+if( !loop->armRecv( index, tcpSock.getSock()))
+  {
+  closeSession();
+  return false;
+  }
+
+open = true;
+return true;
+}
+
+
+
+bool TransportUring::queuePart(
+                         const CharBuf& sendBuf,
+                         const Int32 start,
+                         const Int32 howMany )
+{
+Int32 slot = loop->takeSendSlot();
+while( slot < 0 )
+  {
+  // Wait for a send to finish.
+  if( !loop->poll( true ))
+    return false;
+
+  if( !open )
+    return false;
+
+  slot = loop->takeSendSlot();
+  }
+
+// The bytes get copied straight in to the
+// registered send slot.
+Uint8* slotBytes = loop->getSendSlot( slot );
+for( Int32 count = 0; count < howMany; count++ )
+  slotBytes[count] = sendBuf.getU8( start + count );
+
+const Int32 where = (partFirst + partCount) %
+                             UringLoop::SendSlots;
+partSlot[where] = slot;
+partStart[where] = 0;
+partLast[where] = howMany;
+partBusy[where] = false;
+partCount++;
+pendingBytes += howMany;
+return true;
+}
+
+
+
+Int32 TransportUring::sendCharBuf(
+                       const CharBuf& sendBuf )
+{
+if( !open )
+  return -1;
+
+const Int32 last = sendBuf.getLast();
+Int32 where = 0;
+while( where < last )
+  {
+  Int32 chunkLast = last - where;
+  if( chunkLast > UringLoop::SendSlotSize )
+    chunkLast = UringLoop::SendSlotSize;
+
+  if( !queuePart( sendBuf, where, chunkLast ))
+    return -1;
+
+  where += chunkLast;
+  }
+
+if( linkSend )
+  {
+  while( open && (partCount > 0))
+    {
+    if( !loop->poll( true ))
+      return -1;
+
+    }
+
+  if( !open )
+    return -1;
+
+  }
+
+return last;
+}
+
+
+
+void TransportUring::submitSends( void )
+{
+// Only one chain at a time is in flight, so
+// the records go out in order.  If one is
+// short the rest of the chain gets canceled
+// and it all goes again from where it
+// stopped.
+
+if( !open || (inFlight > 0) || (partCount == 0))
+  return;
+
+for( Int32 count = 0; count < partCount; count++ )
+  {
+  const Int32 where = (partFirst + count) %
+                             UringLoop::SendSlots;
+  const bool link = count < (partCount - 1);
+
+  if( !loop->prepSend( index, tcpSock.getSock(),
+                       partSlot[where],
+                       partStart[where],
+                       partLast[where], link ))
+    {
+    // The chain ends at the last one that
+    // got in.  The ring is big enough that
+    // this doesn't happen.
+    break;
+    }
+
+  partBusy[where] = true;
+  inFlight++;
+  }
+}
+
+
+
+bool TransportUring::onSendDone( const Int32 slot,
+                                 const Int32 result )
+{
+Int32 where = -1;
+for( Int32 count = 0; count < partCount; count++ )
+  {
+  const Int32 check = (partFirst + count) %
+                             UringLoop::SendSlots;
+  if( partBusy[check] && (partSlot[check] == slot))
+    {
+    where = check;
+    break;
+    }
+  }
+
+if( where < 0 )
+  return true;
+
+partBusy[where] = false;
+inFlight--;
+
+// The rest of a chain gets canceled after
+// a short one.  They stay in the queue and
+// go again.
+if( result == -ECANCELED )
+  return false;
+
+if( result <= 0 )
+  {
+  LogCl::error( "TransportUring send error." );
+  open = false;
+  return false;
+  }
+
+partStart[where] += result;
+pendingBytes -= result;
+
+if( partStart[where] < partLast[where] )
+  return false;
+
+// Completions in a chain come back in order,
+// so this is the oldest one.
+partFirst = (partFirst + 1) % UringLoop::SendSlots;
+partCount--;
+return true;
+}
+
+
+
+void TransportUring::onRecv( const Uint8* bytes,
+                             const Int32 howMany )
+{
+for( Int32 count = 0; count < howMany; count++ )
+  inBuf.appendU8( bytes[count] );
+
+}
+
+
+
+void TransportUring::onRecvEnd( const Int32 result )
+{
+// The multishot receive stopped.  If it ran
+// out of receive slots, or the kernel just
+// stopped it, start it again.
+
+if( (result > 0) || (result == -ENOBUFS))
+  {
+  if( loop->armRecv( index, tcpSock.getSock()))
+    return;
+
+  }
+
+// Zero means the server closed it.
+open = false;
+}
+
+
+
+void TransportUring::receiveCharBuf(
+                              CharBuf& recvBuf )
+{
+if( autoPoll && open )
+  loop->poll( false );
+
+recvBuf.appendCharBuf( inBuf );
+inBuf.clear();
+}
+
+
+
+bool TransportUring::flushOut( void )
+{
+if( !open )
+  return pendingBytes == 0;
+
+if( autoPoll && (partCount > 0))
+  return loop->poll( false );
+
+return true;
+}
@@ -0,0 +1,154 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// A connection that does its network I/O
+// through a shared UringLoop.  Set it with
+// ClientTls::setTransport().
+
+// sendCharBuf() copies the record in to
+// send slots and queues them.  They go out
+// on the next UringLoop::poll() along with
+// the sends and receives of every other
+// connection on that loop.  The sends for
+// one connection are linked in the ring so
+// they go out in order.
+
+// With setLinkSend( true ) the send is
+// submitted right after the record is sealed
+// and sendCharBuf() waits for its completion.
+// That is one io_uring_enter() per record,
+// but the caller knows it went out.
+
+// By default receiveCharBuf() calls
+// UringLoop::poll() itself.  With many
+// connections, set setAutoPoll( false ) and
+// call poll() once for all of them.
+
+// The connect is a normal blocking connect
+// on a TcpSockCl socket.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "Transport.h"
+#include "TcpSockCl.h"
+#include "UringLoop.h"
+
+
+
+class TransportUring: public Transport
+  {
+  private:
+  bool testForCopy = false;
+  UringLoop* loop = nullptr;
+  Int32 index = -1;
+  TcpSockCl tcpSock;
+  CharBuf inBuf;
+  bool open = false;
+  bool autoPoll = true;
+  bool linkSend = false;
+
+  // The sends that are queued or in flight,
+  // oldest first.  Each one has its own
+  // send slot.  Busy means it is in the ring.
+  Int32 partSlot[UringLoop::SendSlots] = { 0 };
+  Int32 partStart[UringLoop::SendSlots] = { 0 };
+  Int32 partLast[UringLoop::SendSlots] = { 0 };
+  bool partBusy[UringLoop::SendSlots] = { false };
+  Int32 partFirst = 0;
+  Int32 partCount = 0;
+  Int32 inFlight = 0;
+  Int32 pendingBytes = 0;
+
+  bool queuePart( const CharBuf& sendBuf,
+                  const Int32 start,
+                  const Int32 howMany );
+
+  public:
+  TransportUring( void )
+    {
+    }
+
+  TransportUring( const TransportUring& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TransportUring copy constructor.";
+    }
+
+  ~TransportUring( void ) override;
+
+  // Set this before connect().  The caller
+  // owns the loop and it has to outlive this.
+  void setLoop( UringLoop* setTo )
+    {
+    loop = setTo;
+    }
+
+  void setAutoPoll( const bool setTo )
+    {
+    autoPoll = setTo;
+    }
+
+  void setLinkSend( const bool setTo )
+    {
+    linkSend = setTo;
+    }
+
+  bool connect( const CharBuf& urlDomain,
+                const CharBuf& port ) override;
+
+  Int32 sendCharBuf(
+             const CharBuf& sendBuf ) override;
+
+  void receiveCharBuf(
+                   CharBuf& recvBuf ) override;
+
+  bool isConnected( void ) override
+    {
+    return open || (inBuf.getLast() > 0);
+    }
+
+  bool flushOut( void ) override;
+
+  Int32 getPendingOut( void ) const override
+    {
+    return pendingBytes;
+    }
+
+  Int32 getSock( void ) const override
+    {
+    // Kernel TLS would have the kernel and
+    // the ring both framing records.
+    return -1;
+    }
+
+  void closeSession( void );
+
+  // UringLoop calls these.
+  void onRecv( const Uint8* bytes,
+               const Int32 howMany );
+  void onRecvEnd( const Int32 result );
+  bool onSendDone( const Int32 slot,
+                   const Int32 result );
+  void submitSends( void );
+
+  };
@@ -0,0 +1,603 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "TrustCompile.h"
+#include "TrustStore.h"
+#include "DerView.h"
+#include "LogCl.h"
+#include "../Network/Alerts.h"
+#include "../Network/Results.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+
+
+
+// The OID contents, without the tag and
+// length.
+static const Uint8 OidRsa[9] = { 0x2A, 0x86,
+               0x48, 0x86, 0xF7, 0x0D, 0x01,
+               0x01, 0x01 };
+
+static const Uint8 OidEcKey[7] = { 0x2A, 0x86,
+               0x48, 0xCE, 0x3D, 0x02, 0x01 };
+
+static const Uint8 OidP256[8] = { 0x2A, 0x86,
+               0x48, 0xCE, 0x3D, 0x03, 0x01,
+               0x07 };
+
+static const Uint8 OidP384[5] = { 0x2B, 0x81,
+               0x04, 0x00, 0x22 };
+
+static const char PemBegin[] =
+                "-----BEGIN CERTIFICATE-----";
+static const char PemEnd[] = "-----END";
+
+
+
+Uint8* TrustCompile::readFile(
+                      const CharBuf& fileName,
+                      Int64& fileLast )
+{
+fileLast = 0;
+
+char pathName[4096];
+const Int32 last = fileName.getLast();
+if( last >= 4096 )
+  throw "TrustCompile file name is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  pathName[count] = static_cast<char>(
+                       fileName.getU8( count ));
+
+pathName[last] = 0;
+
+Int32 fileHandle = ::open( pathName,
+                           O_RDONLY | O_CLOEXEC );
+if( fileHandle < 0 )
+  {
+  LogCl::error(
+         "TrustCompile could not open file:",
+         errno );
+  return nullptr;
+  }
+
+struct stat fileStat;
+if( ::fstat( fileHandle, &fileStat ) != 0 )
+  {
+  ::close( fileHandle );
+  return nullptr;
+  }
+
+const Int64 sizeLast = fileStat.st_size;
+Uint8* fileBytes = new Uint8[sizeLast + 1];
+
+Int64 readLast = 0;
+while( readLast < sizeLast )
+  {
+  ssize_t howMany = ::read( fileHandle,
+                 fileBytes + readLast,
+                 static_cast<size_t>(
+                        sizeLast - readLast ));
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    break;
+    }
+
+  if( howMany == 0 )
+    break;
+
+  readLast += howMany;
+  }
+
+::close( fileHandle );
+
+if( readLast != sizeLast )
+  {
+  LogCl::error( "TrustCompile could not read file." );
+  delete[] fileBytes;
+  return nullptr;
+  }
+
+fileLast = sizeLast;
+return fileBytes;
+}
+
+
+
+bool TrustCompile::writeFile(
+                      const CharBuf& fileName,
+                      const CharBuf& outBuf )
+{
+char pathName[4096];
+char tempName[4096 + 8];
+const Int32 last = fileName.getLast();
+if( last >= 4096 )
+  throw "TrustCompile file name is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  {
+  pathName[count] = static_cast<char>(
+                       fileName.getU8( count ));
+  tempName[count] = pathName[count];
+  }
+
+pathName[last] = 0;
+::snprintf( tempName + last, 8, ".tmp" );
+
+Int32 fileHandle = ::open( tempName,
+                O_WRONLY | O_CREAT | O_TRUNC |
+                O_CLOEXEC, 0644 );
+if( fileHandle < 0 )
+  {
+  LogCl::error(
+         "TrustCompile could not open file:",
+         errno );
+  return false;
+  }
+
+const Int32 outLast = outBuf.getLast();
+Uint8* outBytes = new Uint8[outLast + 1];
+for( Int32 count = 0; count < outLast; count++ )
+  outBytes[count] = outBuf.getU8( count );
+
+Int32 where = 0;
+while( where < outLast )
+  {
+  ssize_t howMany = ::write( fileHandle,
+                 outBytes + where,
+                 static_cast<size_t>(
+                        outLast - where ));
+  if( howMany < 0 )
+    {
+    if( errno == EINTR )
+      continue;
+
+    break;
+    }
+
+  where += static_cast<Int32>( howMany );
+  }
+
+delete[] outBytes;
+
+// It has to be on the disk before the
+// rename makes it the one that gets used.
+bool allGood = (where == outLast) &&
+               (::fsync( fileHandle ) == 0);
+
+::close( fileHandle );
+
+if( allGood )
+  allGood = ::rename( tempName, pathName ) == 0;
+
+if( !allGood )
+  {
+  LogCl::error( "TrustCompile could not write file." );
+  ::unlink( tempName );
+  return false;
+  }
+
+return true;
+}
+
+
+
+Int32 TrustCompile::getBase64( const Uint8 letter )
+{
+if( (letter >= 'A') && (letter <= 'Z'))
+  return letter - 'A';
+
+if( (letter >= 'a') && (letter <= 'z'))
+  return letter - 'a' + 26;
+
+if( (letter >= '0') && (letter <= '9'))
+  return letter - '0' + 52;
+
+if( letter == '+' )
+  return 62;
+
+if( letter == '/' )
+  return 63;
+
+return -1;
+}
+
+
+
+bool TrustCompile::nextPem( const Uint8* fileBytes,
+                            const Int64 fileLast,
+                            Int64& where,
+                            CharBuf& derBuf )
+{
+// RFC 7468.  It gives back false when
+// there are no more.  If the base64 isn't
+// right derBuf is empty.
+
+derBuf.clear();
+
+const Int64 beginLast = sizeof( PemBegin ) - 1;
+bool found = false;
+while( (where + beginLast) <= fileLast )
+  {
+  Int64 count = 0;
+  for( ; count < beginLast; count++ )
+    {
+    if( fileBytes[where + count] !=
+          static_cast<Uint8>( PemBegin[count] ))
+      break;
+
+    }
+
+  where++;
+  if( count == beginLast )
+    {
+    where += beginLast - 1;
+    found = true;
+    break;
+    }
+  }
+
+if( !found )
+  return false;
+
+Uint32 bits = 0;
+Int32 bitCount = 0;
+bool padded = false;
+for( ; where < fileLast; where++ )
+  {
+  const Uint8 letter = fileBytes[where];
+  if( letter == '-' )
+    break;
+
+  if( (letter == ' ') || (letter == '\t') ||
+      (letter == '\r') || (letter == '\n'))
+    continue;
+
+  if( letter == '=' )
+    {
+    padded = true;
+    continue;
+    }
+
+  const Int32 value = getBase64( letter );
+  if( (value < 0) || padded )
+    {
+    derBuf.clear();
+    return true;
+    }
+
+  bits = (bits << 6) | static_cast<Uint32>( value );
+  bitCount += 6;
+  if( bitCount >= 8 )
+    {
+    bitCount -= 8;
+    derBuf.appendU8( static_cast<Uint8>(
+                        (bits >> bitCount) & 0xFF ));
+    }
+  }
+
+const Int64 endLast = sizeof( PemEnd ) - 1;
+if( (where + endLast) > fileLast )
+  {
+  derBuf.clear();
+  return true;
+  }
+
+for( Int64 count = 0; count < endLast; count++ )
+  {
+  if( fileBytes[where + count] !=
+          static_cast<Uint8>( PemEnd[count] ))
+    {
+    derBuf.clear();
+    return true;
+    }
+  }
+
+where += endLast;
+return true;
+}
+
+
+
+void TrustCompile::appendU32( CharBuf& toAdd,
+                              const Uint32 value )
+{
+toAdd.appendU8( static_cast<Uint8>( value ));
+toAdd.appendU8( static_cast<Uint8>( value >> 8 ));
+toAdd.appendU8( static_cast<Uint8>( value >> 16 ));
+toAdd.appendU8( static_cast<Uint8>( value >> 24 ));
+}
+
+
+
+void TrustCompile::appendU64( CharBuf& toAdd,
+                              const Uint64 value )
+{
+appendU32( toAdd, static_cast<Uint32>( value ));
+appendU32( toAdd, static_cast<Uint32>(
+                                 value >> 32 ));
+}
+
+
+
+void TrustCompile::appendView( CharBuf& toAdd,
+                               const DerView& view )
+{
+const Int32 last = view.getLength();
+for( Int32 count = 0; count < last; count++ )
+  toAdd.appendU8( view.getU8( count ));
+
+}
+
+
+
+bool TrustCompile::addRoot( const CertView& cert,
+                            CharBuf& rootsBuf,
+                            CharBuf& dataBuf )
+{
+// Everything gets read before anything is
+// added, so a bad one adds nothing.
+
+Int64 notBefore = 0;
+Int64 notAfter = 0;
+if( !cert.getValidity( notBefore, notAfter ))
+  return false;
+
+DerView algOid;
+DerView params;
+DerView keyBytes;
+if( !cert.getPublicKey( algOid, params,
+                        keyBytes ))
+  return false;
+
+Uint32 keyType = TrustStore::KeyOther;
+DerView key = keyBytes;
+DerView exponent;
+
+if( algOid.isEqual( OidRsa, 9 ))
+  {
+  // RFC 8017 Appendix A.1.1.
+  DerView outer = keyBytes;
+  DerView rsaKey;
+  if( !outer.nextTag( DerView::TagSequence,
+                      rsaKey ))
+    return false;
+
+  if( !rsaKey.nextTag( DerView::TagInteger, key ))
+    return false;
+
+  if( !rsaKey.nextTag( DerView::TagInteger,
+                       exponent ))
+    return false;
+
+  // The zero in front that keeps it
+  // positive isn't part of the modulus.
+  if( (key.getLength() > 1) &&
+      (key.getU8( 0 ) == 0))
+    key.dropFront( 1 );
+
+  keyType = TrustStore::KeyRsa;
+  }
+
+if( algOid.isEqual( OidEcKey, 7 ))
+  {
+  DerView curveOid;
+  if( !params.nextTag( DerView::TagOid,
+                       curveOid ))
+    return false;
+
+  // The point is the key bytes as they are.
+  if( curveOid.isEqual( OidP256, 8 ))
+    keyType = TrustStore::KeyP256;
+
+  if( curveOid.isEqual( OidP384, 5 ))
+    keyType = TrustStore::KeyP384;
+
+  }
+
+Uint8 subjectHash[TrustStore::HashSize];
+Uint8 spkiHash[TrustStore::HashSize];
+TrustStore::hashView( cert.getSubject(),
+                      subjectHash );
+TrustStore::hashView( cert.getSpki(), spkiHash );
+
+for( Int32 count = 0; count < TrustStore::HashSize;
+                                    count++ )
+  rootsBuf.appendU8( subjectHash[count] );
+
+for( Int32 count = 0; count < TrustStore::HashSize;
+                                    count++ )
+  rootsBuf.appendU8( spkiHash[count] );
+
+appendU32( rootsBuf, static_cast<Uint32>(
+                          dataBuf.getLast()));
+appendU32( rootsBuf, static_cast<Uint32>(
+                cert.getSubject().getLength()));
+appendView( dataBuf, cert.getSubject());
+
+appendU32( rootsBuf, static_cast<Uint32>(
+                          dataBuf.getLast()));
+appendU32( rootsBuf, static_cast<Uint32>(
+                             key.getLength()));
+appendView( dataBuf, key );
+
+appendU32( rootsBuf, static_cast<Uint32>(
+                          dataBuf.getLast()));
+appendU32( rootsBuf, static_cast<Uint32>(
+                        exponent.getLength()));
+appendView( dataBuf, exponent );
+
+appendU32( rootsBuf, keyType );
+appendU32( rootsBuf, 0 );
+appendU64( rootsBuf, static_cast<Uint64>(
+                                   notBefore ));
+appendU64( rootsBuf, static_cast<Uint64>(
+                                   notAfter ));
+return true;
+}
+
+
+
+void TrustCompile::appendTable( CharBuf& outBuf,
+                         const CharBuf& rootsBuf,
+                         const Int32 rootCount,
+                         const Uint32 tableSize,
+                         const Int32 hashAt )
+{
+// The same probing that TrustStore does.
+
+Uint32* table = new Uint32[tableSize];
+for( Uint32 count = 0; count < tableSize; count++ )
+  table[count] = 0;
+
+const Uint32 mask = tableSize - 1;
+for( Int32 which = 0; which < rootCount; which++ )
+  {
+  const Int32 at = (which * TrustStore::RootSize) +
+                                        hashAt;
+  Uint32 slot =
+       static_cast<Uint32>( rootsBuf.getU8( at )) |
+       (static_cast<Uint32>(
+                rootsBuf.getU8( at + 1 )) << 8) |
+       (static_cast<Uint32>(
+                rootsBuf.getU8( at + 2 )) << 16) |
+       (static_cast<Uint32>(
+                rootsBuf.getU8( at + 3 )) << 24);
+  slot &= mask;
+
+  while( table[slot] != 0 )
+    slot = (slot + 1) & mask;
+
+  table[slot] = static_cast<Uint32>( which + 1 );
+  }
+
+for( Uint32 count = 0; count < tableSize; count++ )
+  appendU32( outBuf, table[count] );
+
+delete[] table;
+}
+
+
+
+bool TrustCompile::run( const CharBuf& pemFile,
+                        const CharBuf& outFile )
+{
+Int64 fileLast = 0;
+Uint8* fileBytes = readFile( pemFile, fileLast );
+if( fileBytes == nullptr )
+  return false;
+
+CharBuf derBuf;
+CharBuf rootsBuf;
+CharBuf dataBuf;
+Int32 rootCount = 0;
+Int32 skipped = 0;
+
+Int64 where = 0;
+while( nextPem( fileBytes, fileLast, where,
+                derBuf ))
+  {
+  // The CertView points in to derBuf, and
+  // addRoot() copies what it needs before
+  // derBuf gets the next one.
+  CertView cert;
+  Uint32 result = Alerts::BadCertificate;
+  if( derBuf.getLast() > 0 )
+    {
+    DerView whole;
+    whole.setView( derBuf, 0, derBuf.getLast());
+    result = cert.setFromView( whole );
+    }
+
+  if( (result != Results::Done) ||
+      !addRoot( cert, rootsBuf, dataBuf ))
+    {
+    skipped++;
+    continue;
+    }
+
+  rootCount++;
+  }
+
+delete[] fileBytes;
+
+if( skipped > 0 )
+  {
+  LogCl::warn( "TrustCompile left out:",
+               skipped );
+  }
+
+if( rootCount == 0 )
+  {
+  LogCl::error( "TrustCompile found no roots." );
+  return false;
+  }
+
+// Twice as many slots as roots, at least.
+Uint32 tableSize = 2;
+while( tableSize < static_cast<Uint32>(
+                               rootCount * 2 ))
+  tableSize <<= 1;
+
+const Uint32 rootsAt = TrustStore::HeaderSize;
+const Uint32 nameTableAt = rootsAt +
+             static_cast<Uint32>( rootsBuf.getLast());
+const Uint32 spkiTableAt = nameTableAt +
+                                (tableSize * 4);
+const Uint32 dataAt = spkiTableAt +
+                                (tableSize * 4);
+const Uint32 dataLength = static_cast<Uint32>(
+                            dataBuf.getLast());
+
+CharBuf outBuf;
+const char magic[8] = { 'T', 'L', 'S', 'R',
+                        'O', 'O', 'T', '1' };
+for( Int32 count = 0; count < 8; count++ )
+  outBuf.appendU8( static_cast<Uint8>(
+                               magic[count] ));
+
+appendU32( outBuf, static_cast<Uint32>(
+                                  rootCount ));
+appendU32( outBuf, tableSize );
+appendU32( outBuf, rootsAt );
+appendU32( outBuf, nameTableAt );
+appendU32( outBuf, spkiTableAt );
+appendU32( outBuf, dataAt );
+appendU32( outBuf, dataLength );
+appendU32( outBuf, dataAt + dataLength );
+appendU64( outBuf, 0 );
+
+outBuf.appendCharBuf( rootsBuf );
+appendTable( outBuf, rootsBuf, rootCount,
+             tableSize, 0 );
+appendTable( outBuf, rootsBuf, rootCount,
+             tableSize, TrustStore::HashSize );
+outBuf.appendCharBuf( dataBuf );
+
+if( !writeFile( outFile, outBuf ))
+  return false;
+
+LogCl::info( "TrustCompile roots:", rootCount );
+return true;
+}
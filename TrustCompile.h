@@ -0,0 +1,92 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// This makes the file that TrustStore maps
+// out of a PEM bundle of root certificates,
+// like /etc/ssl/certs/ca-certificates.crt.
+// All of the parsing and hashing is done
+// here, once, and not every time a process
+// starts.
+
+// A certificate it can't read is left out
+// and it says so.  It writes to a temp file
+// and renames it, so a process that opens
+// the file at the same time gets the old
+// one or the new one and never half of one.
+
+// The app's main() calls run().
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "CertView.h"
+
+
+
+class TrustCompile
+  {
+  private:
+  bool testForCopy = false;
+
+  static Uint8* readFile( const CharBuf& fileName,
+                          Int64& fileLast );
+  static bool writeFile( const CharBuf& fileName,
+                         const CharBuf& outBuf );
+  static Int32 getBase64( const Uint8 letter );
+  static bool nextPem( const Uint8* fileBytes,
+                       const Int64 fileLast,
+                       Int64& where,
+                       CharBuf& derBuf );
+  static bool addRoot( const CertView& cert,
+                       CharBuf& rootsBuf,
+                       CharBuf& dataBuf );
+  static void appendU32( CharBuf& toAdd,
+                         const Uint32 value );
+  static void appendU64( CharBuf& toAdd,
+                         const Uint64 value );
+  static void appendView( CharBuf& toAdd,
+                          const DerView& view );
+  static void appendTable( CharBuf& outBuf,
+                           const CharBuf& rootsBuf,
+                           const Int32 rootCount,
+                           const Uint32 tableSize,
+                           const Int32 hashAt );
+
+  public:
+  TrustCompile( void )
+    {
+    }
+
+  TrustCompile( const TrustCompile& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TrustCompile copy constructor.";
+    }
+
+  ~TrustCompile( void )
+    {
+    }
+
+  static bool run( const CharBuf& pemFile,
+                   const CharBuf& outFile );
+
+  };
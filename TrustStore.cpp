@@ -0,0 +1,435 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "TrustStore.h"
+#include "Keccak.h"
+#include "LogCl.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+
+
+static const Uint8 Magic[8] = { 'T', 'L', 'S', 'R',
+                                'O', 'O', 'T', '1' };
+
+
+
+bool TrustStore::openFile( const CharBuf& fileName )
+{
+closeFile();
+
+char pathName[4096];
+const Int32 last = fileName.getLast();
+if( last >= 4096 )
+  throw "TrustStore file name is too long.";
+
+for( Int32 count = 0; count < last; count++ )
+  pathName[count] = static_cast<char>(
+                       fileName.getU8( count ));
+
+pathName[last] = 0;
+
+Int32 fileHandle = ::open( pathName,
+                           O_RDONLY | O_CLOEXEC );
+if( fileHandle < 0 )
+  {
+  LogCl::error(
+         "TrustStore could not open file:",
+         errno );
+  return false;
+  }
+
+struct stat fileStat;
+if( ::fstat( fileHandle, &fileStat ) != 0 )
+  {
+  LogCl::error( "TrustStore could not stat file:",
+                errno );
+  ::close( fileHandle );
+  return false;
+  }
+
+// The offsets are Uint32 but a real one is
+// a lot smaller than this.
+if( (fileStat.st_size < HeaderSize) ||
+    (fileStat.st_size > 0x7FFFFFFF))
+  {
+  ::close( fileHandle );
+  LogCl::error(
+         "TrustStore file is the wrong size." );
+  return false;
+  }
+
+void* mapPoint = ::mmap( nullptr,
+               static_cast<size_t>( fileStat.st_size ),
+               PROT_READ, MAP_SHARED,
+               fileHandle, 0 );
+
+// The mapping stays after the handle is
+// closed.
+::close( fileHandle );
+
+if( mapPoint == MAP_FAILED )
+  {
+  LogCl::error(
+         "TrustStore could not map file:",
+         errno );
+  return false;
+  }
+
+mapped = static_cast<const Uint8*>( mapPoint );
+mapLength = fileStat.st_size;
+
+if( !checkFile())
+  {
+  closeFile();
+  LogCl::error( "TrustStore file is not right." );
+  return false;
+  }
+
+return true;
+}
+
+
+
+void TrustStore::closeFile( void )
+{
+if( mapped != nullptr )
+  ::munmap( const_cast<Uint8*>( mapped ),
+            static_cast<size_t>( mapLength ));
+
+mapped = nullptr;
+mapLength = 0;
+rootCount = 0;
+tableSize = 0;
+roots = nullptr;
+nameTable = nullptr;
+spkiTable = nullptr;
+data = nullptr;
+dataLength = 0;
+}
+
+
+
+bool TrustStore::checkFile( void )
+{
+// Everything a lookup reads gets checked
+// here, once.
+
+if( ::memcmp( mapped, Magic, 8 ) != 0 )
+  return false;
+
+const Int64 count = getU32( mapped + 8 );
+const Int64 size = getU32( mapped + 12 );
+const Int64 rootsAt = getU32( mapped + 16 );
+const Int64 nameAt = getU32( mapped + 20 );
+const Int64 spkiAt = getU32( mapped + 24 );
+const Int64 dataAt = getU32( mapped + 28 );
+const Int64 dataLast = getU32( mapped + 32 );
+const Int64 fileLength = getU32( mapped + 36 );
+
+if( fileLength != mapLength )
+  return false;
+
+// Reserved.
+if( (getU32( mapped + 40 ) != 0) ||
+    (getU32( mapped + 44 ) != 0))
+  return false;
+
+// At least twice as many slots as roots so
+// the probes stay short, and it always
+// has an empty slot to stop at.
+if( (size < 2) || ((size & (size - 1)) != 0) ||
+    (size < (count * 2)))
+  return false;
+
+if( (rootsAt + (count * RootSize)) > mapLength )
+  return false;
+
+if( ((nameAt + (size * 4)) > mapLength) ||
+    ((spkiAt + (size * 4)) > mapLength))
+  return false;
+
+if( (dataAt + dataLast) > mapLength )
+  return false;
+
+rootCount = static_cast<Int32>( count );
+tableSize = static_cast<Uint32>( size );
+roots = mapped + rootsAt;
+nameTable = mapped + nameAt;
+spkiTable = mapped + spkiAt;
+data = mapped + dataAt;
+dataLength = static_cast<Uint32>( dataLast );
+
+for( Int32 which = 0; which < rootCount; which++ )
+  {
+  const Uint8* root = getRoot( which );
+  for( Int32 field = 0; field < 3; field++ )
+    {
+    const Int64 at = getU32( root + 64 +
+                             (field * 8));
+    const Int64 length = getU32( root + 68 +
+                                 (field * 8));
+    if( (at + length) > dataLast )
+      return false;
+
+    }
+
+  if( getU32( root + 88 ) > KeyP384 )
+    return false;
+
+  }
+
+// The lookups stop at an empty slot, so
+// each table has to have one.  Having twice
+// as many slots as roots doesn't make sure
+// of that if the file was changed.
+Uint32 nameEmpty = 0;
+Uint32 spkiEmpty = 0;
+for( Uint32 slot = 0; slot < tableSize; slot++ )
+  {
+  const Uint32 nameEntry = getU32( nameTable +
+                                   (slot * 4));
+  const Uint32 spkiEntry = getU32( spkiTable +
+                                   (slot * 4));
+  if( nameEntry > static_cast<Uint32>( rootCount ))
+    return false;
+
+  if( spkiEntry > static_cast<Uint32>( rootCount ))
+    return false;
+
+  if( nameEntry == 0 )
+    nameEmpty++;
+
+  if( spkiEntry == 0 )
+    spkiEmpty++;
+
+  }
+
+if( (nameEmpty == 0) || (spkiEmpty == 0))
+  return false;
+
+return true;
+}
+
+
+
+void TrustStore::hashView( const DerView& view,
+                           Uint8* hash )
+{
+Keccak keccak;
+keccak.start( Keccak::RateSha3256,
+              Keccak::PadSha3 );
+
+Uint8 chunk[128];
+const Int32 last = view.getLength();
+Int32 where = 0;
+while( where < last )
+  {
+  Int32 howMany = last - where;
+  if( howMany > 128 )
+    howMany = 128;
+
+  for( Int32 count = 0; count < howMany; count++ )
+    chunk[count] = view.getU8( where + count );
+
+  keccak.absorb( chunk, howMany );
+  where += howMany;
+  }
+
+keccak.squeeze( hash, HashSize );
+}
+
+
+
+const Uint8* TrustStore::getRoot(
+                      const Int32 which ) const
+{
+if( (which < 0) || (which >= rootCount))
+  throw "TrustStore root is out of range.";
+
+return roots + (which * RootSize);
+}
+
+
+
+bool TrustStore::sameSubject(
+                      const Int32 which,
+                      const DerView& name ) const
+{
+// The hash matched.  This makes sure.
+Int32 nameLength = 0;
+const Uint8* subject = getSubject( which,
+                                   nameLength );
+if( nameLength != name.getLength())
+  return false;
+
+for( Int32 count = 0; count < nameLength; count++ )
+  {
+  if( subject[count] != name.getU8( count ))
+    return false;
+
+  }
+
+return true;
+}
+
+
+
+Int32 TrustStore::findBySubject(
+                       const DerView& name,
+                       Int32* indexes,
+                       const Int32 maxIndexes ) const
+{
+if( rootCount == 0 )
+  return 0;
+
+Uint8 hash[HashSize];
+hashView( name, hash );
+
+const Uint32 mask = tableSize - 1;
+Uint32 slot = getU32( hash ) & mask;
+Int32 found = 0;
+
+// checkFile() made sure there is an empty
+// slot, so this stops there.  It can't go
+// past tableSize either way.
+for( Uint32 probes = 0; probes < tableSize;
+                                     probes++ )
+  {
+  const Uint32 entry = getU32( nameTable +
+                               (slot * 4));
+  if( entry == 0 )
+    break;
+
+  const Int32 which = static_cast<Int32>(
+                                  entry - 1 );
+  if( (::memcmp( getRoot( which ), hash,
+                 HashSize ) == 0) &&
+      sameSubject( which, name ))
+    {
+    if( found >= maxIndexes )
+      break;
+
+    indexes[found] = which;
+    found++;
+    }
+
+  slot = (slot + 1) & mask;
+  }
+
+return found;
+}
+
+
+
+Int32 TrustStore::findBySpki(
+                    const Uint8* spkiHash ) const
+{
+if( rootCount == 0 )
+  return -1;
+
+const Uint32 mask = tableSize - 1;
+Uint32 slot = getU32( spkiHash ) & mask;
+
+for( Uint32 probes = 0; probes < tableSize;
+                                     probes++ )
+  {
+  const Uint32 entry = getU32( spkiTable +
+                               (slot * 4));
+  if( entry == 0 )
+    return -1;
+
+  const Int32 which = static_cast<Int32>(
+                                  entry - 1 );
+  if( ::memcmp( getRoot( which ) + HashSize,
+                spkiHash, HashSize ) == 0 )
+    return which;
+
+  slot = (slot + 1) & mask;
+  }
+
+return -1;
+}
+
+
+
+Uint32 TrustStore::getKeyType(
+                      const Int32 which ) const
+{
+return getU32( getRoot( which ) + 88 );
+}
+
+
+
+const Uint8* TrustStore::getKey(
+                      const Int32 which,
+                      Int32& keyLength ) const
+{
+const Uint8* root = getRoot( which );
+keyLength = static_cast<Int32>(
+                        getU32( root + 76 ));
+return data + getU32( root + 72 );
+}
+
+
+
+const Uint8* TrustStore::getExponent(
+                      const Int32 which,
+                      Int32& expLength ) const
+{
+const Uint8* root = getRoot( which );
+expLength = static_cast<Int32>(
+                        getU32( root + 84 ));
+return data + getU32( root + 80 );
+}
+
+
+
+const Uint8* TrustStore::getSubject(
+                      const Int32 which,
+                      Int32& nameLength ) const
+{
+const Uint8* root = getRoot( which );
+nameLength = static_cast<Int32>(
+                        getU32( root + 68 ));
+return data + getU32( root + 64 );
+}
+
+
+
+void TrustStore::getValidity( const Int32 which,
+                              Int64& notBefore,
+                              Int64& notAfter ) const
+{
+const Uint8* root = getRoot( which );
+
+Uint64 before = 0;
+Uint64 after = 0;
+for( Int32 count = 7; count >= 0; count-- )
+  {
+  before = (before << 8) | root[96 + count];
+  after = (after << 8) | root[104 + count];
+  }
+
+notBefore = static_cast<Int64>( before );
+notAfter = static_cast<Int64>( after );
+}
@@ -0,0 +1,198 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// The trusted roots, from a file that
+// TrustCompile made out of a PEM bundle.
+
+// The file is memory mapped read only and
+// shared, so opening it costs about the same
+// for ten roots or a thousand, and every
+// process that maps it uses the same pages.
+// Nothing in it gets parsed when it is
+// opened.  The header and the offsets get
+// checked once so a lookup doesn't have to.
+
+// Each root has the SHA3-256 of its subject
+// Name, the SHA3-256 of its whole
+// SubjectPublicKeyInfo, its validity, and
+// its public key already taken out of the
+// DER: the modulus and the exponent for
+// RSA, or the point for EC.  There are two
+// hash tables, one for each hash, with
+// linear probing.  So finding the issuer of
+// a certificate is one hash of its issuer
+// Name and a probe or two.
+
+// This is only a lookup.  It is NOT chain
+// validation, and the handshake doesn't use
+// it.  Matching a name or a key hash says
+// nothing until the signatures, the dates,
+// the server name and the rest are checked,
+// so nothing here refuses a connection.
+
+// After openFile() any number of threads
+// can use it at the same time.
+
+// The file, with the numbers little endian:
+
+// Header, 48 bytes:
+//   "TLSROOT1"
+//   Uint32 rootCount
+//   Uint32 tableSize, a power of 2
+//   Uint32 rootsAt
+//   Uint32 nameTableAt
+//   Uint32 spkiTableAt
+//   Uint32 dataAt
+//   Uint32 dataLength
+//   Uint32 fileLength
+//   8 bytes of zero
+
+// Each root, RootSize bytes:
+//   32 byte subject hash
+//   32 byte SPKI hash
+//   Uint32 subjectAt, subjectLength
+//   Uint32 keyAt, keyLength
+//   Uint32 expAt, expLength
+//   Uint32 keyType
+//   Uint32 zero
+//   Int64 notBefore, notAfter
+
+// Each table is tableSize Uint32s.  Zero is
+// an empty slot, or else it is the root
+// index plus one.
+
+// The offsets in a root are from dataAt.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+#include "../CppBase/CharBuf.h"
+#include "DerView.h"
+#include "CertView.h"
+
+
+
+class TrustStore
+  {
+  private:
+  bool testForCopy = false;
+  const Uint8* mapped = nullptr;
+  Int64 mapLength = 0;
+  Int32 rootCount = 0;
+  Uint32 tableSize = 0;
+  const Uint8* roots = nullptr;
+  const Uint8* nameTable = nullptr;
+  const Uint8* spkiTable = nullptr;
+  const Uint8* data = nullptr;
+  Uint32 dataLength = 0;
+
+  static Uint32 getU32( const Uint8* from )
+    {
+    return static_cast<Uint32>( from[0] ) |
+           (static_cast<Uint32>( from[1] ) << 8) |
+           (static_cast<Uint32>( from[2] ) << 16) |
+           (static_cast<Uint32>( from[3] ) << 24);
+    }
+
+  bool checkFile( void );
+  const Uint8* getRoot( const Int32 which ) const;
+  bool sameSubject( const Int32 which,
+                    const DerView& name ) const;
+
+  public:
+  static const Int32 HeaderSize = 48;
+  static const Int32 RootSize = 112;
+  static const Int32 HashSize = 32;
+
+  static const Uint32 KeyOther = 0;
+  static const Uint32 KeyRsa = 1;
+  static const Uint32 KeyP256 = 2;
+  static const Uint32 KeyP384 = 3;
+
+  TrustStore( void )
+    {
+    }
+
+  TrustStore( const TrustStore& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "TrustStore copy constructor.";
+    }
+
+  ~TrustStore( void )
+    {
+    closeFile();
+    }
+
+  bool openFile( const CharBuf& fileName );
+  void closeFile( void );
+
+  // SHA3-256 of the bytes in a view.
+  // TrustCompile uses this too, so the two
+  // always hash the same way.
+  static void hashView( const DerView& view,
+                        Uint8* hash );
+
+  Int32 getRootCount( void ) const
+    {
+    return rootCount;
+    }
+
+  // The roots with this subject Name.  There
+  // can be more than one, like a root and a
+  // newer one with the same name.  It gives
+  // back how many it put in indexes.
+  Int32 findBySubject( const DerView& name,
+                       Int32* indexes,
+                       const Int32 maxIndexes ) const;
+
+  // The roots that could have signed cert.
+  Int32 findIssuer( const CertView& cert,
+                    Int32* indexes,
+                    const Int32 maxIndexes ) const
+    {
+    return findBySubject( cert.getIssuer(),
+                          indexes, maxIndexes );
+    }
+
+  // The root with this SPKI hash, or -1.
+  Int32 findBySpki( const Uint8* spkiHash ) const;
+
+  Uint32 getKeyType( const Int32 which ) const;
+
+  // The modulus for RSA or the point for EC.
+  const Uint8* getKey( const Int32 which,
+                       Int32& keyLength ) const;
+
+  // The RSA public exponent.  The length is
+  // zero for anything else.
+  const Uint8* getExponent( const Int32 which,
+                            Int32& expLength ) const;
+
+  // The DER of the subject Name.
+  const Uint8* getSubject( const Int32 which,
+                           Int32& nameLength ) const;
+
+  void getValidity( const Int32 which,
+                    Int64& notBefore,
+                    Int64& notAfter ) const;
+
+  };
@@ -0,0 +1,620 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+#include "UringLoop.h"
+#include "TransportUring.h"
+#include "LogCl.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+
+
+static Int32 uringSetup( const Uint32 entries,
+                         io_uring_params* params )
+{
+return static_cast<Int32>( ::syscall(
+           __NR_io_uring_setup, entries, params ));
+}
+
+
+
+static Int32 uringEnter( const Int32 fd,
+                         const Uint32 toSubmit,
+                         const Uint32 minComplete,
+                         const Uint32 flags )
+{
+return static_cast<Int32>( ::syscall(
+           __NR_io_uring_enter, fd, toSubmit,
+           minComplete, flags, nullptr, 0 ));
+}
+
+
+
+static Int32 uringRegister( const Int32 fd,
+                            const Uint32 opcode,
+                            void* arg,
+                            const Uint32 howMany )
+{
+return static_cast<Int32>( ::syscall(
+           __NR_io_uring_register, fd, opcode,
+           arg, howMany ));
+}
+
+
+
+Uint64 UringLoop::makeUserData( const Uint8 op,
+                                const Int32 slot,
+                                const Int32 index,
+                                const Uint16 gen )
+{
+// Bits 0 to 7 are the op, 8 to 23 are the
+// slot, 24 to 39 are the session index and
+// 40 to 55 are its generation.  The
+// generation is so a completion for a
+// session that was dropped doesn't go to
+// a new one in the same index.
+
+Uint64 userData = op;
+userData |= static_cast<Uint64>( slot & 0xFFFF )
+                                          << 8;
+userData |= static_cast<Uint64>( index & 0xFFFF )
+                                          << 24;
+userData |= static_cast<Uint64>( gen ) << 40;
+return userData;
+}
+
+
+
+bool UringLoop::mapRings(
+                   const io_uring_params& params )
+{
+sqRingSize = params.sq_off.array +
+             (params.sq_entries * sizeof( Uint32 ));
+cqRingSize = params.cq_off.cqes +
+             (params.cq_entries *
+                       sizeof( io_uring_cqe ));
+
+const bool singleMap = (params.features &
+                  IORING_FEAT_SINGLE_MMAP) != 0;
+if( singleMap && (cqRingSize > sqRingSize))
+  sqRingSize = cqRingSize;
+
+sqRingPtr = ::mmap( nullptr, sqRingSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    ringFd, IORING_OFF_SQ_RING );
+if( sqRingPtr == MAP_FAILED )
+  {
+  sqRingPtr = nullptr;
+  return false;
+  }
+
+if( singleMap )
+  {
+  cqRingPtr = sqRingPtr;
+  }
+else
+  {
+  cqRingPtr = ::mmap( nullptr, cqRingSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    ringFd, IORING_OFF_CQ_RING );
+  if( cqRingPtr == MAP_FAILED )
+    {
+    cqRingPtr = nullptr;
+    return false;
+    }
+  }
+
+sqesSize = params.sq_entries *
+                     sizeof( io_uring_sqe );
+void* sqesPtr = ::mmap( nullptr, sqesSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    ringFd, IORING_OFF_SQES );
+if( sqesPtr == MAP_FAILED )
+  return false;
+
+sqes = static_cast<io_uring_sqe*>( sqesPtr );
+
+Uint8* sqBytes = static_cast<Uint8*>( sqRingPtr );
+sqHead = reinterpret_cast<Uint32*>(
+                  sqBytes + params.sq_off.head );
+sqTail = reinterpret_cast<Uint32*>(
+                  sqBytes + params.sq_off.tail );
+sqArray = reinterpret_cast<Uint32*>(
+                  sqBytes + params.sq_off.array );
+sqMask = *reinterpret_cast<Uint32*>(
+             sqBytes + params.sq_off.ring_mask );
+sqEntries = params.sq_entries;
+
+Uint8* cqBytes = static_cast<Uint8*>( cqRingPtr );
+cqHead = reinterpret_cast<Uint32*>(
+                  cqBytes + params.cq_off.head );
+cqTail = reinterpret_cast<Uint32*>(
+                  cqBytes + params.cq_off.tail );
+cqMask = *reinterpret_cast<Uint32*>(
+             cqBytes + params.cq_off.ring_mask );
+cqes = reinterpret_cast<io_uring_cqe*>(
+                  cqBytes + params.cq_off.cqes );
+
+return true;
+}
+
+
+
+bool UringLoop::setupBuffers( void )
+{
+bufAreaSize = (static_cast<size_t>(
+                  RecvSlots ) * RecvSlotSize) +
+              (static_cast<size_t>(
+                  SendSlots ) * SendSlotSize);
+
+void* areaPtr = ::mmap( nullptr, bufAreaSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS |
+                    MAP_POPULATE, -1, 0 );
+if( areaPtr == MAP_FAILED )
+  return false;
+
+bufArea = static_cast<Uint8*>( areaPtr );
+
+// Register it as two fixed buffers.
+// Index 0 is the receive ring and index 1
+// is the send slots.
+iovec iov[2];
+iov[0].iov_base = bufArea;
+iov[0].iov_len = static_cast<size_t>(
+                     RecvSlots ) * RecvSlotSize;
+iov[1].iov_base = bufArea + iov[0].iov_len;
+iov[1].iov_len = static_cast<size_t>(
+                     SendSlots ) * SendSlotSize;
+
+if( uringRegister( ringFd,
+                   IORING_REGISTER_BUFFERS,
+                   iov, 2 ) != 0 )
+  {
+  LogCl::warn(
+        "UringLoop could not register buffers." );
+  return false;
+  }
+
+// The ring that tells the kernel which
+// receive slots are free.
+bufRingSize = static_cast<size_t>(
+            RecvSlots ) * sizeof( io_uring_buf );
+void* ringPtr = ::mmap( nullptr, bufRingSize,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0 );
+if( ringPtr == MAP_FAILED )
+  return false;
+
+bufRing = static_cast<io_uring_buf_ring*>(
+                                   ringPtr );
+
+io_uring_buf_reg reg;
+::memset( &reg, 0, sizeof( reg ));
+reg.ring_addr = reinterpret_cast<Uint64>(
+                                   bufRing );
+reg.ring_entries = RecvSlots;
+reg.bgid = BufGroup;
+
+if( uringRegister( ringFd,
+                   IORING_REGISTER_PBUF_RING,
+                   &reg, 1 ) != 0 )
+  {
+  LogCl::warn(
+        "UringLoop no provided buffer ring." );
+  ::munmap( bufRing, bufRingSize );
+  bufRing = nullptr;
+  return false;
+  }
+
+bufRingTail = 0;
+for( Int32 count = 0; count < RecvSlots; count++ )
+  recycleRecvBuf( static_cast<Uint16>( count ));
+
+freeSendLast = 0;
+for( Int32 count = SendSlots - 1; count >= 0;
+                                     count-- )
+  {
+  freeSend[freeSendLast] = count;
+  freeSendLast++;
+  }
+
+return true;
+}
+
+
+
+bool UringLoop::setup( void )
+{
+if( ringFd >= 0 )
+  return true;
+
+io_uring_params params;
+::memset( &params, 0, sizeof( params ));
+
+ringFd = uringSetup( Entries, &params );
+if( ringFd < 0 )
+  {
+  ringFd = -1;
+  LogCl::warn( "io_uring_setup failed." );
+  return false;
+  }
+
+if( !mapRings( params ) || !setupBuffers())
+  {
+  freeAll();
+  return false;
+  }
+
+toSubmit = 0;
+return true;
+}
+
+
+
+void UringLoop::freeAll( void )
+{
+// Closing the ring fd first cancels whatever
+// is still in flight, so the kernel is done
+// with the buffers before they get unmapped.
+if( ringFd >= 0 )
+  ::close( ringFd );
+
+ringFd = -1;
+
+if( bufRing != nullptr )
+  {
+  ::munmap( bufRing, bufRingSize );
+  bufRing = nullptr;
+  }
+
+if( bufArea != nullptr )
+  {
+  ::munmap( bufArea, bufAreaSize );
+  bufArea = nullptr;
+  }
+
+if( sqes != nullptr )
+  {
+  ::munmap( sqes, sqesSize );
+  sqes = nullptr;
+  }
+
+if( (cqRingPtr != nullptr) &&
+    (cqRingPtr != sqRingPtr))
+  ::munmap( cqRingPtr, cqRingSize );
+
+cqRingPtr = nullptr;
+
+if( sqRingPtr != nullptr )
+  {
+  ::munmap( sqRingPtr, sqRingSize );
+  sqRingPtr = nullptr;
+  }
+}
+
+
+
+void UringLoop::recycleRecvBuf( const Uint16 bufId )
+{
+// This doesn't use bufRing->bufs because in
+// C++ the empty struct in front of it in the
+// kernel header has a size, so it would be
+// at the wrong offset.  The tail field is
+// where the kernel has it.
+const Uint32 mask = RecvSlots - 1;
+io_uring_buf* bufs = reinterpret_cast<
+                       io_uring_buf*>( bufRing );
+io_uring_buf& buf = bufs[bufRingTail & mask];
+
+buf.addr = reinterpret_cast<Uint64>( bufArea +
+                 (static_cast<size_t>( bufId ) *
+                                 RecvSlotSize));
+buf.len = RecvSlotSize;
+buf.bid = bufId;
+
+bufRingTail++;
+
+// The kernel reads the tail without a lock,
+// so the entry has to be written first.
+__atomic_store_n( &bufRing->tail, bufRingTail,
+                  __ATOMIC_RELEASE );
+}
+
+
+
+Int32 UringLoop::addSession(
+                       TransportUring* session )
+{
+for( Int32 count = 0; count < MaxSessions;
+                                     count++ )
+  {
+  if( sessions[count] == nullptr )
+    {
+    sessions[count] = session;
+    sessionGen[count]++;
+    return count;
+    }
+  }
+
+return -1;
+}
+
+
+
+void UringLoop::dropSession( const Int32 index )
+{
+if( (index < 0) || (index >= MaxSessions))
+  return;
+
+// Cancel the multishot receive.  Sends that
+// are in flight give their slots back when
+// they complete.
+io_uring_sqe* sqe = getSqe();
+if( sqe != nullptr )
+  {
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = makeUserData( OpRecv, 0, index,
+                            sessionGen[index] );
+  sqe->user_data = makeUserData( OpCancel, 0,
+                     index, sessionGen[index] );
+  }
+
+// Submit it before the caller closes the
+// socket.
+if( toSubmit > 0 )
+  {
+  if( uringEnter( ringFd, toSubmit, 0, 0 ) >= 0 )
+    toSubmit = 0;
+
+  }
+
+sessions[index] = nullptr;
+}
+
+
+
+io_uring_sqe* UringLoop::getSqe( void )
+{
+if( ringFd < 0 )
+  return nullptr;
+
+Uint32 tail = *sqTail;
+Uint32 head = __atomic_load_n( sqHead,
+                               __ATOMIC_ACQUIRE );
+if( (tail - head) >= sqEntries )
+  {
+  // Full, so give these to the kernel now.
+  if( uringEnter( ringFd, toSubmit, 0, 0 ) < 0 )
+    return nullptr;
+
+  toSubmit = 0;
+  head = __atomic_load_n( sqHead,
+                          __ATOMIC_ACQUIRE );
+  if( (tail - head) >= sqEntries )
+    return nullptr;
+
+  }
+
+const Uint32 where = tail & sqMask;
+io_uring_sqe* sqe = &sqes[where];
+::memset( sqe, 0, sizeof( io_uring_sqe ));
+sqArray[where] = where;
+
+__atomic_store_n( sqTail, tail + 1,
+                  __ATOMIC_RELEASE );
+toSubmit++;
+return sqe;
+}
+
+
+
+bool UringLoop::armRecv( const Int32 index,
+                         const Int32 sock )
+{
+io_uring_sqe* sqe = getSqe();
+if( sqe == nullptr )
+  return false;
+
+sqe->opcode = IORING_OP_RECV;
+sqe->fd = sock;
+sqe->ioprio = IORING_RECV_MULTISHOT;
+sqe->flags = IOSQE_BUFFER_SELECT;
+sqe->buf_group = BufGroup;
+sqe->user_data = makeUserData( OpRecv, 0, index,
+                               sessionGen[index] );
+return true;
+}
+
+
+
+bool UringLoop::prepSend( const Int32 index,
+                          const Int32 sock,
+                          const Int32 slot,
+                          const Int32 start,
+                          const Int32 last,
+                          const bool link )
+{
+io_uring_sqe* sqe = getSqe();
+if( sqe == nullptr )
+  return false;
+
+sqe->opcode = IORING_OP_WRITE_FIXED;
+sqe->fd = sock;
+sqe->addr = reinterpret_cast<Uint64>(
+                    getSendSlot( slot ) + start );
+sqe->len = static_cast<Uint32>( last - start );
+// A socket has no file position.
+sqe->off = static_cast<Uint64>( -1 );
+sqe->buf_index = 1;
+if( link )
+  sqe->flags = IOSQE_IO_LINK;
+
+sqe->user_data = makeUserData( OpSend, slot,
+                     index, sessionGen[index] );
+return true;
+}
+
+
+
+Int32 UringLoop::takeSendSlot( void )
+{
+if( freeSendLast == 0 )
+  return -1;
+
+freeSendLast--;
+return freeSend[freeSendLast];
+}
+
+
+
+void UringLoop::giveSendSlot( const Int32 slot )
+{
+if( freeSendLast >= SendSlots )
+  throw "UringLoop giveSendSlot too many.";
+
+freeSend[freeSendLast] = slot;
+freeSendLast++;
+}
+
+
+
+void UringLoop::handleCqe( const io_uring_cqe& cqe )
+{
+const Uint8 op = static_cast<Uint8>(
+                         cqe.user_data & 0xFF );
+const Int32 slot = static_cast<Int32>(
+                (cqe.user_data >> 8) & 0xFFFF );
+const Int32 index = static_cast<Int32>(
+               (cqe.user_data >> 24) & 0xFFFF );
+const Uint16 gen = static_cast<Uint16>(
+               (cqe.user_data >> 40) & 0xFFFF );
+
+TransportUring* session = nullptr;
+if( (index < MaxSessions) &&
+    (sessionGen[index] == gen))
+  session = sessions[index];
+
+if( op == OpRecv )
+  {
+  if( (cqe.flags & IORING_CQE_F_BUFFER) != 0 )
+    {
+    const Uint16 bufId = static_cast<Uint16>(
+               cqe.flags >> IORING_CQE_BUFFER_SHIFT );
+
+    if( (session != nullptr) && (cqe.res > 0))
+      session->onRecv( bufArea +
+                (static_cast<size_t>( bufId ) *
+                                 RecvSlotSize),
+                cqe.res );
+
+    recycleRecvBuf( bufId );
+    }
+
+  if( ((cqe.flags & IORING_CQE_F_MORE) == 0) &&
+      (session != nullptr))
+    session->onRecvEnd( cqe.res );
+
+  return;
+  }
+
+if( op == OpSend )
+  {
+  bool done = true;
+  if( session != nullptr )
+    done = session->onSendDone( slot, cqe.res );
+
+  if( done )
+    giveSendSlot( slot );
+
+  return;
+  }
+
+// OpCancel has nothing to do.
+}
+
+
+
+bool UringLoop::poll( const bool wait )
+{
+if( ringFd < 0 )
+  return false;
+
+for( Int32 count = 0; count < MaxSessions;
+                                     count++ )
+  {
+  if( sessions[count] != nullptr )
+    sessions[count]->submitSends();
+
+  }
+
+Uint32 flags = 0;
+Uint32 minComplete = 0;
+if( wait )
+  {
+  flags = IORING_ENTER_GETEVENTS;
+  minComplete = 1;
+  }
+
+if( (toSubmit > 0) || wait )
+  {
+  Int32 result = uringEnter( ringFd, toSubmit,
+                             minComplete, flags );
+  if( result < 0 )
+    {
+    if( (errno != EINTR) && (errno != EAGAIN) &&
+        (errno != EBUSY))
+      {
+      LogCl::error( "io_uring_enter failed." );
+      return false;
+      }
+    }
+  else
+    {
+    if( static_cast<Uint32>( result ) >= toSubmit )
+      toSubmit = 0;
+    else
+      toSubmit -= static_cast<Uint32>( result );
+
+    }
+  }
+
+Uint32 head = *cqHead;
+const Uint32 tail = __atomic_load_n( cqTail,
+                              __ATOMIC_ACQUIRE );
+while( head != tail )
+  {
+  // Copy it and move the head first, so the
+  // kernel can use that entry again.
+  const io_uring_cqe cqe = cqes[head & cqMask];
+  head++;
+  __atomic_store_n( cqHead, head,
+                    __ATOMIC_RELEASE );
+  handleCqe( cqe );
+  }
+
+return true;
+}
@@ -0,0 +1,188 @@
+// Copyright Eric Chauvin 2024.
+
+
+
+// This is licensed under the GNU General
+// Public License (GPL).  It is the
+// same license that Linux has.
+// https://www.gnu.org/licenses/gpl-3.0.html
+
+
+
+// For information and guides see:
+// https://ericssourcecode.github.io/
+
+
+
+// One io_uring that is shared by many
+// TransportUring connections.  One thread
+// owns it and all of its connections.
+
+// This uses the system calls directly, so
+// it doesn't need liburing.
+
+// There is one big memory area that is
+// registered with the kernel as fixed
+// buffers, so the kernel doesn't map the
+// pages for each I/O.  The first part of it
+// is the receive ring.  Those slots are
+// given to the kernel as a provided buffer
+// ring, and each connection has one
+// multishot receive that picks a free slot
+// each time bytes come in.  The bytes get
+// copied out of the slot and the slot goes
+// right back in the ring.
+
+// The second part has the send slots.  A
+// sealed record gets copied in to a send
+// slot and sent with WRITE_FIXED.
+
+// poll() does one io_uring_enter() for the
+// reads and writes of all connections, then
+// it goes through all of the completions.
+
+// This needs Linux 6.0 or later for the
+// multishot receive.  If setup() returns
+// false use a socket transport instead.
+
+
+
+#pragma once
+
+
+#include "../CppBase/BasicTypes.h"
+
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+
+class TransportUring;
+
+
+
+class UringLoop
+  {
+  public:
+  static const Int32 RecvSlots = 64;
+  static const Int32 RecvSlotSize = 1024 * 16;
+  static const Int32 SendSlots = 64;
+  // A whole record with the outer header.
+  static const Int32 SendSlotSize =
+                           (1024 * 16) + 512;
+  static const Int32 MaxSessions = 256;
+
+  static const Uint8 OpRecv = 1;
+  static const Uint8 OpSend = 2;
+  static const Uint8 OpCancel = 3;
+
+  private:
+  bool testForCopy = false;
+  static const Uint32 Entries = 256;
+  static const Uint16 BufGroup = 0;
+
+  Int32 ringFd = -1;
+
+  void* sqRingPtr = nullptr;
+  size_t sqRingSize = 0;
+  void* cqRingPtr = nullptr;
+  size_t cqRingSize = 0;
+  io_uring_sqe* sqes = nullptr;
+  size_t sqesSize = 0;
+
+  Uint32* sqHead = nullptr;
+  Uint32* sqTail = nullptr;
+  Uint32* sqArray = nullptr;
+  Uint32 sqMask = 0;
+  Uint32 sqEntries = 0;
+  Uint32 toSubmit = 0;
+
+  Uint32* cqHead = nullptr;
+  Uint32* cqTail = nullptr;
+  Uint32 cqMask = 0;
+  io_uring_cqe* cqes = nullptr;
+
+  Uint8* bufArea = nullptr;
+  size_t bufAreaSize = 0;
+  io_uring_buf_ring* bufRing = nullptr;
+  size_t bufRingSize = 0;
+  Uint16 bufRingTail = 0;
+
+  Int32 freeSend[SendSlots] = { 0 };
+  Int32 freeSendLast = 0;
+
+  TransportUring* sessions[MaxSessions] =
+                                    { nullptr };
+  Uint16 sessionGen[MaxSessions] = { 0 };
+
+  static Uint64 makeUserData( const Uint8 op,
+                              const Int32 slot,
+                              const Int32 index,
+                              const Uint16 gen );
+
+  bool mapRings( const io_uring_params& params );
+  bool setupBuffers( void );
+  void recycleRecvBuf( const Uint16 bufId );
+  void handleCqe( const io_uring_cqe& cqe );
+  void freeAll( void );
+
+  public:
+  UringLoop( void )
+    {
+    }
+
+  UringLoop( const UringLoop& in )
+    {
+    if( in.testForCopy )
+      return;
+
+    throw "UringLoop copy constructor.";
+    }
+
+  ~UringLoop( void )
+    {
+    freeAll();
+    }
+
+  bool setup( void );
+
+  bool isReady( void ) const
+    {
+    return ringFd >= 0;
+    }
+
+  Int32 addSession( TransportUring* session );
+  void dropSession( const Int32 index );
+
+  // It returns nullptr only if the kernel
+  // won't take any more, which doesn't
+  // happen with the sizes here.
+  io_uring_sqe* getSqe( void );
+
+  bool armRecv( const Int32 index,
+                const Int32 sock );
+
+  bool prepSend( const Int32 index,
+                 const Int32 sock,
+                 const Int32 slot,
+                 const Int32 start,
+                 const Int32 last,
+                 const bool link );
+
+  Int32 takeSendSlot( void );
+  void giveSendSlot( const Int32 slot );
+
+  Uint8* getSendSlot( const Int32 slot )
+    {
+    return bufArea + (static_cast<size_t>(
+                    RecvSlots) * RecvSlotSize) +
+           (static_cast<size_t>( slot ) *
+                                 SendSlotSize);
+    }
+
+  // Submit everything that is waiting for
+  // every connection and handle whatever
+  // completed.  If wait is true it waits for
+  // at least one completion.
+  bool poll( const bool wait );
+
+  };